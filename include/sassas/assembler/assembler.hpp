@@ -0,0 +1,311 @@
+#ifndef SASSAS_ASSEMBLER_ASSEMBLER_HPP
+#define SASSAS_ASSEMBLER_ASSEMBLER_HPP
+
+#include "sassas/assembler/incremental_state.hpp"
+#include "sassas/assembler/instruction_memo.hpp"
+#include "sassas/assembler/instruction_matcher.hpp"
+#include "sassas/assembler/label_table.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/encoder/encoder.hpp"
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/parser/sass_parser.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// Receives the output of `Assembler` as it is produced.
+class AssemblySink {
+public:
+    virtual ~AssemblySink() = default;
+
+    /// Called when a section such as `.text.kernel:` starts. The instructions emitted after it
+    /// belong to the section. `name` is only valid during the call. The sections are begun in the
+    /// order of the source, except that a section that refers to a function or label of a later
+    /// section is placed after it, if the sink places the sections one after another (see
+    /// `flat_offset()`).
+    virtual void begin_section(std::string_view name) = 0;
+
+    /// Called for each encoded instruction of the current section, in the order of the source.
+    virtual void emit(InstructionWord const &word) = 0;
+
+    /// Called for each diagnostic. The strings referenced by `diag` are only valid during the
+    /// call, so the diagnostic must be rendered (or copied) right away.
+    virtual void report(Diag diag) = 0;
+
+    /// Returns the offset in bytes where the next instruction is placed, if the sections are placed
+    /// one after another in the order they are begun, as in a dump of the raw instruction words. A
+    /// reference to a label of another section is resolved to its offset in that layout. Returns
+    /// `std::nullopt` if each section is placed on its own, as in a cubin, in which case a section
+    /// cannot refer to the labels of the others.
+    virtual auto flat_offset() const -> std::optional<std::uint64_t> {
+        return std::nullopt;
+    }
+};
+
+/// Assembles SASS source into instruction words.
+///
+/// The source is read from a stream in chunks of `CHUNK_SIZE` characters, and each chunk is parsed,
+/// matched and encoded before the next one is read, so the memory used does not depend on the size
+/// of the source, apart from the names of its functions and labels, the section being assembled,
+/// and the sections held back by the linker below. A statement cut by the end of a chunk is
+/// carried over to the next chunk. The buffer only grows if a single statement is longer than the
+/// buffer.
+///
+/// Labels may be referenced before they are defined, as in `` BRA `(.L_x_1) ``. Such an
+/// instruction is encoded with a placeholder target and held back, together with the instructions
+/// after it, until the label is defined and the target is patched into the encoded instruction,
+/// whose conditions that depend on the target are then checked again. So the source is processed
+/// in a single pass. A label that is still undefined at the end of the section is handed over with
+/// its fixups to a linker, which looks it up among the functions (e.g. `kernel` for
+/// `.text.kernel`) and labels of the other sections. The targets are offsets in the layout of the
+/// sink (see `AssemblySink::flat_offset()`), which continues after the files assembled into it
+/// before. A section is passed on as soon as the sections it refers to are placed, so only the
+/// sections that refer to later ones are held back, and the others are passed on in the meantime.
+/// A name defined in several other sections is ambiguous, and a sink that places each section on
+/// its own, such as a cubin, cannot have references between sections at all, so both are reported.
+///
+/// Generated code tends to repeat the same instructions over and over, e.g. in unrolled loops. An
+/// instruction without labels is encoded to the same word wherever it is, so the words of such
+/// instructions are memoized by their tokens, and a repeated instruction skips matching and
+/// encoding. The memo belongs to the scratch storage of a thread, which it keeps across the
+/// sections it assembles, so it is only ever used by one thread at a time.
+class Assembler {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+    /// Identifies how instructions are matched and encoded, and changes whenever the same source
+    /// and ISA may be assembled into different words, so that an `IncrementalState` saved by an
+    /// older `sassas` is discarded rather than reused.
+    static constexpr std::uint32_t VERSION = 1;
+    /// The number of instructions memoized at once by a thread. When the memo is full, the least
+    /// recently used instruction is evicted for each new one.
+    static constexpr std::size_t MEMO_CAPACITY = 1 << 12;
+
+    /// An assembler, and the sink that receives its output. It is used to assemble one source for
+    /// several architectures with `assemble_targets()`.
+    struct Target {
+        Assembler const *assembler;
+        AssemblySink *sink;
+    };
+
+    /// Creates an assembler for `isa`, whose frozen form is `frozen_isa`. Both must outlive the
+    /// assembler.
+    Assembler(ISA const &isa, FrozenISA const &frozen_isa) :
+        encoder_(isa, frozen_isa), matcher_(isa) { }
+
+    auto isa() const -> ISA const & {
+        return encoder_.isa();
+    }
+
+    /// Assembles the SASS source read from `input`, whose name used in diagnostics is `origin`.
+    /// The conditions of the instructions are checked according to `level`, and `chunk_size` is the
+    /// initial size of the read buffer. Returns `false` if an error is reported.
+    auto assemble(
+        std::istream &input,
+        std::string_view origin,
+        ValidationLevel level,
+        AssemblySink &sink,
+        std::size_t chunk_size = CHUNK_SIZE
+    ) const -> bool;
+
+    /// Assembles `source`, which is a whole SASS file in memory, on up to `thread_count` threads.
+    ///
+    /// A cheap pre-scan splits the source at the sections (i.e. the functions), which are then
+    /// parsed, matched and encoded independently on a work-stealing thread pool. The results are
+    /// passed to `sink` in the order of the source after all sections are done, so the sink sees
+    /// the same sections and instructions as with `assemble()`, and the output does not depend on
+    /// `thread_count`.
+    auto assemble_parallel(
+        std::string_view source,
+        std::string_view origin,
+        ValidationLevel level,
+        AssemblySink &sink,
+        unsigned thread_count
+    ) const -> bool;
+
+    /// Assembles `source` as `assemble_parallel()` does, except for the pieces (i.e. the functions)
+    /// whose output is in `previous`, which is passed to `sink` from there without parsing or
+    /// encoding them again. The output of every piece that was assembled or reused without
+    /// diagnostics or references to the labels of other pieces is added to `next`, which can be
+    /// saved as `previous` for the next run. So the cost of assembling an edited file grows with
+    /// the functions that were edited, not with the size of the file.
+    auto assemble_incremental(
+        std::string_view source,
+        std::string_view origin,
+        ValidationLevel level,
+        AssemblySink &sink,
+        unsigned thread_count,
+        IncrementalState const &previous,
+        IncrementalState &next
+    ) const -> bool;
+
+    /// Assembles `source`, which is a whole SASS file in memory, for several architectures at once
+    /// on up to `thread_count` threads.
+    ///
+    /// The source is split and parsed once, as in `assemble_parallel()`. The parsed statements do
+    /// not depend on the architecture, so they are then matched and encoded by the assembler of
+    /// each target, with the pieces of all targets spread over the thread pool. So the cost of
+    /// lexing and parsing does not grow with the number of targets.
+    ///
+    /// Each sink sees the same calls as with `assemble_parallel()`, except that syntax errors,
+    /// which are the same for all targets, are only reported to the first one. Returns `false` if
+    /// an error is reported for any target.
+    static auto assemble_targets(
+        std::string_view source,
+        std::string_view origin,
+        ValidationLevel level,
+        std::span<Target const> targets,
+        unsigned thread_count
+    ) -> bool;
+
+private:
+    Encoder encoder_;
+    InstructionMatcher matcher_;
+
+    struct FinishedSection;
+    class SectionSink;
+    class RecordingSink;
+    class Linker;
+
+    /// The state of the section being assembled.
+    struct SectionState {
+        /// The name of the section, or empty before the first section.
+        std::string name;
+        LabelTable labels;
+        /// The offset of the next instruction in the section, in bytes.
+        std::uint64_t offset = 0;
+        /// The instructions held back while there are fixups to patch, the first of which is at
+        /// `held_offset`.
+        std::vector<InstructionWord> held_words;
+        std::uint64_t held_offset = 0;
+        /// The labels whose first pending reference is in the current chunk. Their diagnostics
+        /// must be created before the chunk is discarded, if they are still undefined by then.
+        std::vector<std::uint32_t> chunk_references;
+        /// The first references to the labels referenced in previous chunks, where the labels are
+        /// reported if no other section defines them either.
+        std::vector<std::pair<std::uint32_t, ants::AnnotatedSource>> undefined_labels;
+    };
+
+    /// The storage used while assembling a file, or the sections a thread takes from it, so that
+    /// the vectors are allocated only once per thread.
+    struct Scratch {
+        std::vector<std::int64_t> operands;
+        std::vector<LabelOperand> labels;
+        std::vector<EncodeIssue> issues;
+        std::vector<EncodeIssue> failed_issues;
+        SectionState section;
+        /// The time spent matching and encoding the instructions of the current chunk, which is
+        /// only measured while metrics are recorded.
+        std::chrono::nanoseconds match_time {};
+        std::chrono::nanoseconds encode_time {};
+        /// The words of the instructions encoded recently, by `memo_key()` of their statements.
+        InstructionMemo memo { MEMO_CAPACITY };
+        /// The key of the current instruction, which is kept to reuse its memory.
+        std::string memo_key;
+    };
+
+    /// The scratch storage of the threads that assemble the sections of a file with one assembler,
+    /// since the words in a memo are only valid for the assembler that encoded them. A thread takes
+    /// a scratch for each section and gives it back afterwards, so there are at most as many as
+    /// threads, and the memo of each one is shared by all the sections assembled with it.
+    class ScratchPool {
+    public:
+        auto take() -> std::unique_ptr<Scratch>;
+        void give_back(std::unique_ptr<Scratch> scratch);
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::unique_ptr<Scratch>> free_;
+    };
+
+    /// Returns the size of an instruction in bytes.
+    auto instruction_size() const -> unsigned {
+        return isa().functional_unit.encoding_width() / 8;
+    }
+
+    /// Processes the statements parsed from a chunk, and passes the diagnostics of `parser` to
+    /// `output`. Returns `false` if an error is reported.
+    auto process_chunk(
+        SassParser &parser,
+        ParsedChunk const &parsed,
+        ValidationLevel level,
+        SectionSink &output,
+        Scratch &scratch
+    ) const -> bool;
+
+    /// Defines the label of `statement` at the current offset, and patches the instructions
+    /// waiting for it, whose conditions are checked again according to `level`. Returns `false` if
+    /// an error is reported.
+    auto define_label(
+        SassParser &parser,
+        SassStatement const &statement,
+        ValidationLevel level,
+        AssemblySink &sink,
+        Scratch &scratch
+    ) const -> bool;
+
+    /// Passes the held instructions of the current section to `output`, and ends the section
+    /// with the symbols it defines and the labels that are still undefined, whose fixups are left
+    /// to the linker. Then starts a new section.
+    void finish_section(SassParser &parser, SectionSink &output, Scratch &scratch) const;
+
+    /// Checks the conditions of `instruction_class` that use the operand in `slot` according to
+    /// `level`, once a label is patched into it. An instruction that refers to a label before it is
+    /// defined is encoded with a placeholder target, so these conditions have not seen the real one
+    /// yet. The violated conditions are appended to `issues`. Returns `false` if a condition of
+    /// kind `ConditionType::Error` is violated.
+    auto check_label_conditions(
+        ValidationLevel level,
+        InstructionClass const &instruction_class,
+        std::uint32_t slot,
+        std::span<std::int64_t const> operands,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+
+    /// Annotates the first reference to the undefined label `index`, where it is reported if it
+    /// cannot be resolved. It must be called before the chunk containing the reference is
+    /// discarded.
+    static auto reference(
+        SassParser &parser,
+        SectionState const &section,
+        std::uint32_t index
+    ) -> ants::AnnotatedSource;
+
+    /// Passes `word` to `sink`, or holds it back if there are fixups to patch.
+    void emit(InstructionWord const &word, AssemblySink &sink, SectionState &section) const;
+
+    /// Matches and encodes an instruction, and passes the result to `sink`. Returns `false` if an
+    /// error is reported.
+    auto assemble_instruction(
+        SassParser &parser,
+        SassStatement const &statement,
+        std::span<SassToken const> tokens,
+        ValidationLevel level,
+        AssemblySink &sink,
+        Scratch &scratch
+    ) const -> bool;
+
+    /// Reports `issues` found while encoding `statement` as diagnostics. Returns `false` if any of
+    /// them is an error.
+    static auto report_issues(
+        SassParser &parser,
+        SassStatement const &statement,
+        std::span<EncodeIssue const> issues,
+        AssemblySink &sink
+    ) -> bool;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ASSEMBLER_ASSEMBLER_HPP
@@ -0,0 +1,77 @@
+#ifndef SASSAS_ASSEMBLER_INCREMENTAL_STATE_HPP
+#define SASSAS_ASSEMBLER_INCREMENTAL_STATE_HPP
+
+#include "sassas/isa/functional_unit.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// The encoded functions of the previous assembly of a file, which let
+/// `Assembler::assemble_incremental()` assemble only the functions whose text changed.
+///
+/// A file is split into pieces at its sections (i.e. its functions), as for parallel assembly.
+/// The output of a piece that only refers to its own labels depends on nothing but its text, the
+/// validation level and the ISA. The state maps a hash of the text and the level of each piece to
+/// its output, and to the symbols it defines, which the pieces that are assembled again may refer
+/// to; the ISA, and anything else the output depends on, is identified by the `context` of the
+/// whole state, and a state with another context is discarded.
+///
+/// Only pieces that were assembled without any diagnostic are kept, since their diagnostics could
+/// not be reported again without assembling them, nor are pieces that refer to the labels of
+/// other pieces, since their output depends on where those end up.
+class IncrementalState {
+public:
+    /// Identifies the layout of the image, and changes whenever it changes.
+    static constexpr std::uint32_t MAGIC = 0x434e4953;  // "SINC"
+    static constexpr std::uint32_t VERSION = 3;
+
+    /// A function or label defined in a section, and its offset from the start of the section, in
+    /// bytes.
+    struct Symbol {
+        std::string name;
+        std::uint64_t offset;
+    };
+
+    /// A section started in a piece, the instructions emitted after it, and the symbols it
+    /// defines. The instructions of the first piece of a file may come before any section, in
+    /// which case `name` is empty.
+    struct Run {
+        std::optional<std::string> name;
+        std::vector<InstructionWord> words;
+        std::vector<Symbol> symbols;
+    };
+
+    explicit IncrementalState(std::string context) : context_(std::move(context)) { }
+
+    /// Reads the state written by `write()`. Returns an empty state if the image is malformed or
+    /// its context is not `context`.
+    static auto read(std::span<std::byte const> image, std::string context) -> IncrementalState;
+
+    /// Returns the image of the state.
+    auto write() const -> std::vector<std::byte>;
+
+    /// Returns the output of the piece with the key `key`, or `nullptr` if it is unknown.
+    auto find(std::string_view key) const -> std::vector<Run> const *;
+
+    void add(std::string key, std::vector<Run> runs);
+
+    auto size() const -> std::size_t {
+        return pieces_.size();
+    }
+
+private:
+    std::string context_;
+    std::map<std::string, std::vector<Run>, std::less<>> pieces_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ASSEMBLER_INCREMENTAL_STATE_HPP
@@ -0,0 +1,137 @@
+#ifndef SASSAS_ASSEMBLER_INSTRUCTION_MATCHER_HPP
+#define SASSAS_ASSEMBLER_INSTRUCTION_MATCHER_HPP
+
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/parser/sass_parser.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sassas {
+/// Describes why the tokens of an instruction do not match the format of an instruction class.
+struct BindFailure {
+    /// The value of `token_index` if the guard predicate does not match.
+    static constexpr std::size_t PREDICATE = ~static_cast<std::size_t>(0);
+
+    /// The index of the offending token in the tokens of the instruction, or `PREDICATE`. It is
+    /// equal to the number of tokens if the instruction ends too early.
+    std::size_t token_index = 0;
+    std::string_view message;
+    /// The register category, the immediate type or the literal expected by the format, if any.
+    std::string_view subject;
+};
+
+/// An immediate operand written as a label reference, such as `` `(.L_x_0) ``. The address of the
+/// label is unknown to the matcher, so the operand is bound to 0, and the caller fills it in.
+struct LabelOperand {
+    /// The operand slot of the immediate.
+    std::uint32_t slot;
+    /// The index of the label reference in the tokens of the instruction.
+    std::uint32_t token_index;
+    /// Whether the immediate is relative to the address of the next instruction (see
+    /// `FormatItem::is_relative_immediate()`), rather than an offset in the section.
+    bool is_relative;
+};
+
+/// Binds the tokens of SASS instructions to the instruction classes of an `ISA`, producing the
+/// operand values that `Encoder` consumes.
+///
+/// A mnemonic is usually shared by several classes (e.g. `FADD` with a register, an immediate or a
+/// constant bank operand), so the matcher first finds the candidate classes of the mnemonic, and
+/// the caller tries to bind the operands to each of them in turn. All name lookups are done through
+/// hash tables built when the matcher is constructed.
+class InstructionMatcher {
+public:
+    /// An instruction class that has an opcode with the given mnemonic.
+    struct Candidate {
+        std::uint32_t class_index;
+        std::uint64_t opcode;
+    };
+
+    explicit InstructionMatcher(ISA const &isa);
+
+    auto isa() const -> ISA const & {
+        return isa_;
+    }
+
+    /// Finds the candidate classes of the instruction whose tokens are `tokens`. The mnemonic is
+    /// the first token, possibly joined with the modifiers after it (some opcodes contain dots).
+    /// The longest joined name that is an opcode wins, and the number of tokens it spans is stored
+    /// in `mnemonic_size`. The candidates are in the order of `ISA::classes`. Returns an empty span
+    /// if there is no such opcode.
+    auto find_candidates(std::span<SassToken const> tokens, std::size_t &mnemonic_size) const
+        -> std::span<Candidate const>;
+
+    /// Binds the operands of an instruction to the format of `candidate`, and stores the operand
+    /// values into `operands`, indexed by the operand slots of the class. The operands that are not
+    /// written in the instruction get their default values. `tokens` are the tokens of the
+    /// instruction, whose first `mnemonic_size` tokens form the mnemonic. The immediates written as
+    /// label references are stored in `labels`.
+    ///
+    /// Returns `false` if the instruction does not match the format, in which case the reason is
+    /// stored in `failure`.
+    auto bind(
+        Candidate candidate,
+        SassStatement const &statement,
+        std::span<SassToken const> tokens,
+        std::size_t mnemonic_size,
+        std::vector<std::int64_t> &operands,
+        std::vector<LabelOperand> &labels,
+        BindFailure &failure
+    ) const -> bool;
+
+private:
+    /// A hash function for `std::string` keys that can be looked up with `std::string_view`.
+    struct StringHash {
+        using is_transparent = void;
+
+        auto operator()(std::string_view str) const -> std::size_t {
+            return std::hash<std::string_view>()(str);
+        }
+    };
+
+    template <class T>
+    using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+    /// Maps the lowercase names of the registers in a `RegisterGroup` to their values. If several
+    /// registers have the same name, the value chosen by `RegisterGroup::find` is used.
+    using NameMap = StringMap<std::int64_t>;
+
+    /// The information of a format item that is needed for binding, computed when the matcher is
+    /// constructed.
+    struct ItemInfo {
+        /// The names of the register category of a register or a modifier, or `nullptr`.
+        NameMap const *names = nullptr;
+        /// The slots of the `[-]`, `[||]`, `[!]` and `[~]` prefixes of the operand, or `NO_SLOT`
+        /// if the operand does not have the prefix.
+        std::array<std::uint32_t, 4> prefix_slots { NO_SLOT, NO_SLOT, NO_SLOT, NO_SLOT };
+    };
+
+    static constexpr std::uint32_t NO_SLOT = ~static_cast<std::uint32_t>(0);
+    /// The longest name we look up. Longer names cannot be registers, so they are rejected without
+    /// a lookup.
+    static constexpr std::size_t MAX_NAME_SIZE = 64;
+
+    ISA const &isa_;
+    StringMap<std::vector<Candidate>> candidates_;
+    StringMap<NameMap> name_maps_;
+    /// The `ItemInfo` of each format item of each class, indexed by the class index and the index
+    /// of the item in `InstructionClass::format`.
+    std::vector<std::vector<ItemInfo>> item_infos_;
+
+    /// Looks up `name` in `names` case-insensitively.
+    static auto find_name(NameMap const &names, std::string_view name)
+        -> std::optional<std::int64_t>;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ASSEMBLER_INSTRUCTION_MATCHER_HPP
@@ -0,0 +1,52 @@
+#ifndef SASSAS_ASSEMBLER_INSTRUCTION_MEMO_HPP
+#define SASSAS_ASSEMBLER_INSTRUCTION_MEMO_HPP
+
+#include "sassas/isa/functional_unit.hpp"
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sassas {
+/// The words of the instructions encoded recently by an `Assembler`, by the keys of their
+/// statements, which hold at most a fixed number of instructions.
+///
+/// When the memo is full, the instruction that was least recently used is evicted to make room for
+/// a new one, so the memo follows the instructions of the part of the source being assembled. The
+/// index refers to the keys owned by the entries, so a lookup does not allocate, and an insertion
+/// into a full memo reuses the storage of the evicted entry.
+class InstructionMemo {
+public:
+    explicit InstructionMemo(std::size_t capacity) : capacity_(capacity) { }
+
+    // The index refers to the keys of the entries.
+    InstructionMemo(InstructionMemo const &) = delete;
+    auto operator=(InstructionMemo const &) -> InstructionMemo & = delete;
+
+    /// Returns the word of the instruction `key`, or `nullptr` if it is not memoized. The
+    /// instruction becomes the most recently used one.
+    auto find(std::string_view key) -> InstructionWord const *;
+
+    /// Memoizes `word` as the word of the instruction `key`, which is not memoized yet.
+    void insert(std::string_view key, InstructionWord const &word);
+
+    auto size() const -> std::size_t {
+        return entries_.size();
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        InstructionWord word;
+    };
+
+    std::size_t capacity_;
+    /// The entries, from the most recently used to the least recently used one.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ASSEMBLER_INSTRUCTION_MEMO_HPP
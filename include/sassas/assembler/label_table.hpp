@@ -0,0 +1,158 @@
+#ifndef SASSAS_ASSEMBLER_LABEL_TABLE_HPP
+#define SASSAS_ASSEMBLER_LABEL_TABLE_HPP
+
+#include "sassas/lexer/token.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// An encoded instruction that refers to a label which is not defined yet. Once the label is
+/// defined, its address is patched into the instruction.
+struct Fixup {
+    /// The offset of the instruction in its section, in bytes.
+    std::uint64_t offset;
+    /// The class of the instruction, and the operand slot of the label reference.
+    std::uint32_t class_index;
+    std::uint32_t slot;
+    /// Whether the operand is relative to the address of the next instruction.
+    bool is_relative;
+};
+
+/// The labels of a section, together with the instructions waiting for them to be defined.
+///
+/// A label is looked up for every branch, so the table is a flat open-addressing hash table of
+/// label indices with linear probing. The names are interned into a pool owned by the table, since
+/// the chunks of source they come from are discarded. Each undefined label has a backpatch list of
+/// fixups, which is threaded through a single vector shared by all labels, so a forward branch
+/// costs no allocation once the vectors have grown. When a label is defined, its fixups are
+/// patched right away, so the instruction stream is never walked again.
+///
+/// `clear()` keeps all the storage, so one table is reused for all the sections of a file.
+class LabelTable {
+public:
+    static constexpr std::uint32_t NO_FIXUP = ~static_cast<std::uint32_t>(0);
+
+    struct Label {
+        /// The name of the label is `name_size` characters at `name_offset` in the name pool.
+        std::uint32_t name_offset;
+        std::uint32_t name_size;
+        std::size_t hash;
+        /// The offset of the label in its section, or `std::nullopt` if it is not defined yet.
+        std::optional<std::uint64_t> offset {};
+        /// The first fixup in the backpatch list of the label, or `NO_FIXUP`.
+        std::uint32_t first_fixup = NO_FIXUP;
+        /// The first reference waiting for the label, which is used to report an undefined label.
+        /// It is a range in the chunk where the reference appears.
+        TokenRange reference {};
+    };
+
+    LabelTable() : slots_(INITIAL_CAPACITY, NO_LABEL) { }
+
+    /// Returns the index of the label named `name`, adding an undefined label if there is none.
+    auto intern(std::string_view name) -> std::uint32_t;
+
+    auto operator[](std::uint32_t index) -> Label & {
+        return labels_[index];
+    }
+
+    auto operator[](std::uint32_t index) const -> Label const & {
+        return labels_[index];
+    }
+
+    auto name(std::uint32_t index) const -> std::string_view {
+        Label const &label = labels_[index];
+        return { names_.data() + label.name_offset, label.name_size };
+    }
+
+    /// Returns the number of labels, whose indices are `[0, size())`.
+    auto size() const -> std::uint32_t {
+        return static_cast<std::uint32_t>(labels_.size());
+    }
+
+    /// Returns the number of fixups that have not been patched yet.
+    auto pending_fixup_count() const -> std::size_t {
+        return pending_fixup_count_;
+    }
+
+    /// Adds `fixup` to the backpatch list of the undefined label `index`. `operands` are the
+    /// operand values of the instruction, which are copied, since the fields of the instruction are
+    /// computed again when the label is defined.
+    void add_fixup(std::uint32_t index, Fixup const &fixup, std::span<std::int64_t const> operands);
+
+    /// Defines the label `index` at `offset`, and calls `patch(fixup, operands)` for each fixup
+    /// waiting for it, where `operands` are the operand values passed to `add_fixup()`. `patch`
+    /// may modify the operands.
+    template <class Patch>
+    void define(std::uint32_t index, std::uint64_t offset, Patch &&patch) {
+        Label &label = labels_[index];
+        label.offset = offset;
+
+        for (std::uint32_t i = label.first_fixup; i != NO_FIXUP; i = entries_[i].next) {
+            FixupEntry const &entry = entries_[i];
+            patch(
+                entry.fixup,
+                std::span(operands_).subspan(entry.first_operand, entry.operand_count)
+            );
+            --pending_fixup_count_;
+        }
+        label.first_fixup = NO_FIXUP;
+
+        // Nothing refers to the backpatch lists anymore, so their storage can be reused.
+        if (pending_fixup_count_ == 0) {
+            entries_.clear();
+            operands_.clear();
+        }
+    }
+
+    /// Calls `visit(fixup, operands)` for each fixup waiting for the undefined label `index`, most
+    /// recent first, without defining the label.
+    template <class Visit>
+    void for_each_fixup(std::uint32_t index, Visit &&visit) const {
+        for (std::uint32_t i = labels_[index].first_fixup; i != NO_FIXUP; i = entries_[i].next) {
+            FixupEntry const &entry = entries_[i];
+            visit(
+                entry.fixup,
+                std::span(operands_).subspan(entry.first_operand, entry.operand_count)
+            );
+        }
+    }
+
+    /// Removes all labels and fixups.
+    void clear();
+
+private:
+    static constexpr std::uint32_t NO_LABEL = ~static_cast<std::uint32_t>(0);
+    /// The number of slots of an empty table. It must be a power of two.
+    static constexpr std::size_t INITIAL_CAPACITY = 64;
+
+    /// A node of a backpatch list.
+    struct FixupEntry {
+        Fixup fixup;
+        /// The operand values of the instruction are `operands_[first_operand, first_operand +
+        /// operand_count)`.
+        std::uint32_t first_operand;
+        std::uint32_t operand_count;
+        /// The next fixup of the same label, or `NO_FIXUP`.
+        std::uint32_t next;
+    };
+
+    std::vector<Label> labels_;
+    /// The hash table, whose slots hold label indices or `NO_LABEL`. Its size is a power of two,
+    /// and at most half of the slots are used.
+    std::vector<std::uint32_t> slots_;
+    std::vector<char> names_;
+    std::vector<FixupEntry> entries_;
+    std::vector<std::int64_t> operands_;
+    std::size_t pending_fixup_count_ = 0;
+
+    /// Doubles the number of slots and re-inserts all labels.
+    void grow();
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ASSEMBLER_LABEL_TABLE_HPP
@@ -0,0 +1,69 @@
+#ifndef SASSAS_ASSEMBLER_OUTPUT_SINK_HPP
+#define SASSAS_ASSEMBLER_OUTPUT_SINK_HPP
+
+#include "sassas/assembler/assembler.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/elf/cubin_writer.hpp"
+#include "sassas/isa/functional_unit.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+/// Passes the assembled instructions to a cubin writer, or writes them through a callback, either
+/// as raw little-endian words or as a hexadecimal listing such as
+///
+///     .text.kernel:
+///         /*0000*/ 0x000fe200078e00ff00000a0000017a02
+///
+/// The callback decides where the output goes, so the same sink serves the command line, which
+/// writes to a file or the standard output, and the daemon, which collects it into a response.
+class OutputSink : public AssemblySink {
+public:
+    /// Receives a piece of the output.
+    using Writer = std::function<void(std::string_view)>;
+    /// Receives a diagnostic reported while assembling.
+    using Reporter = std::function<void(Diag)>;
+
+    enum class Format : std::uint8_t {
+        /// The hexadecimal listing shown above.
+        Listing,
+        /// The instruction words, `word_bytes` little-endian bytes each.
+        Raw,
+    };
+
+    /// Passes the instructions to `cubin`.
+    OutputSink(CubinWriter &cubin, Reporter report) :
+        cubin_(&cubin), report_(std::move(report)) { }
+
+    /// Writes the instructions, of `word_bytes` bytes each, to `write` in `format`.
+    OutputSink(Format format, Writer write, unsigned word_bytes, Reporter report);
+
+    void begin_section(std::string_view name) override;
+    void emit(InstructionWord const &word) override;
+    void report(Diag diag) override;
+
+    /// Returns the number of bytes written so far, since the raw words and the listing place the
+    /// sections one after another. A cubin places each section on its own.
+    auto flat_offset() const -> std::optional<std::uint64_t> override;
+
+private:
+    CubinWriter *cubin_ = nullptr;
+    Format format_ = Format::Listing;
+    Writer write_;
+    Reporter report_;
+    unsigned word_bytes_ = 0;
+    /// The offset of the next instruction in the current section, and in the whole output.
+    std::size_t offset_ = 0;
+    std::uint64_t flat_offset_ = 0;
+    /// The line being written, which is kept to reuse its memory.
+    std::string line_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ASSEMBLER_OUTPUT_SINK_HPP
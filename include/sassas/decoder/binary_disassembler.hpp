@@ -0,0 +1,80 @@
+#ifndef SASSAS_DECODER_BINARY_DISASSEMBLER_HPP
+#define SASSAS_DECODER_BINARY_DISASSEMBLER_HPP
+
+#include "sassas/decoder/disassembler.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/isa_registry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+/// Disassembles binaries of any architecture: a cubin, or a fatbin (on its own or as the
+/// `.nv_fatbin` section of a host executable), of which all uncompressed cubins are disassembled.
+///
+/// The architecture of each cubin is read from the cubin. The ISA of an architecture is taken from
+/// the registry when the first cubin for it is found, so only the instruction descriptions of the
+/// architectures that are actually present are parsed. The disassemblers are kept for later
+/// binaries, and may be used by several threads at once. The one of the current version of each ISA
+/// is kept, so a replaced ISA (see `ISARegistry::replace()`) is picked up by the next binary, and
+/// the disassembler of the old version is freed once the binaries that use it are done.
+class BinaryDisassembler {
+public:
+    /// Receives a piece of the text.
+    using Writer = std::function<void(std::string_view)>;
+    /// Receives a diagnostic about a binary that cannot be disassembled.
+    using Reporter = std::function<void(Diag)>;
+
+    explicit BinaryDisassembler(ISARegistry &registry) : registry_(registry) { }
+
+    /// Disassembles `image` on `thread_count` threads, and passes the text to `write`. `name`
+    /// describes the binary in diagnostics. Returns whether all of its cubins were disassembled.
+    auto disassemble(
+        std::string_view name,
+        std::span<std::byte const> image,
+        unsigned thread_count,
+        Writer const &write,
+        Reporter const &report
+    ) -> bool;
+
+    /// Returns the disassembler of `sm_<sm_version>`, or `nullptr` if its instruction description
+    /// cannot be loaded, which the registry reports once. The disassembler keeps its version of the
+    /// ISA alive.
+    auto get(std::uint32_t sm_version) -> std::shared_ptr<Disassembler const>;
+
+private:
+    /// A disassembler, and the version of the ISA it refers to, which it keeps alive.
+    struct VersionDisassembler {
+        std::shared_ptr<LoadedISA const> isa;
+        Disassembler disassembler;
+
+        explicit VersionDisassembler(std::shared_ptr<LoadedISA const> loaded_isa) :
+            isa(std::move(loaded_isa)), disassembler(isa->isa, isa->frozen) { }
+    };
+
+    ISARegistry &registry_;
+    /// Guards `disassemblers_`. It is not held while a disassembler is created.
+    std::mutex mutex_;
+    /// The disassembler of the current version of each ISA that has been used, by `sm_version`.
+    std::map<std::uint32_t, std::shared_ptr<VersionDisassembler const>> disassemblers_;
+
+    /// Disassembles the cubin in `image`, as `disassemble()` does.
+    auto disassemble_cubin(
+        std::string_view name,
+        std::span<std::byte const> image,
+        unsigned thread_count,
+        Writer const &write,
+        Reporter const &report
+    ) -> bool;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_DECODER_BINARY_DISASSEMBLER_HPP
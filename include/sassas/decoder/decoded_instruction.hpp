@@ -0,0 +1,82 @@
+#ifndef SASSAS_DECODER_DECODED_INSTRUCTION_HPP
+#define SASSAS_DECODER_DECODED_INSTRUCTION_HPP
+
+#include "sassas/decoder/decoder.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sassas {
+/// A view of an encoded instruction.
+///
+/// Only the instruction class and the opcode are identified when the view is created, which is a
+/// walk down the decision trie of the `Decoder`. Everything else is computed on demand: the value
+/// of an operand is extracted from its field (or found by a reverse table lookup) when it is
+/// accessed, and the register name of an operand is resolved only when it is asked for. So tools
+/// that only look at the opcodes pay nothing for the operands.
+///
+/// The view does not own the decoder or the ISA, which must outlive it. It is small and cheap to
+/// copy.
+class DecodedInstruction {
+public:
+    DecodedInstruction(Decoder const &decoder, InstructionWord const &word) :
+        decoder_(&decoder), word_(word), pattern_(decoder.decode(word)) { }
+
+    auto word() const -> InstructionWord const & {
+        return word_;
+    }
+
+    /// Returns whether the instruction matches an instruction class. The other member functions
+    /// must not be called if it returns `false`.
+    auto is_valid() const -> bool {
+        return pattern_ != nullptr;
+    }
+
+    /// Returns the index of the instruction class in `ISA::classes`.
+    auto class_index() const -> unsigned {
+        return pattern_->class_index;
+    }
+
+    auto instruction_class() const -> InstructionClass const & {
+        return decoder_->instruction_class(*pattern_);
+    }
+
+    auto opcode_name() const -> std::string const & {
+        return instruction_class().opcodes[pattern_->opcode_index].first;
+    }
+
+    auto opcode() const -> std::uint64_t {
+        return instruction_class().opcodes[pattern_->opcode_index].second;
+    }
+
+    /// Returns the value of the operand in slot `slot`. Returns `std::nullopt` if the operand is
+    /// not encoded in the instruction, or its value cannot be recovered.
+    auto operand_value(unsigned slot) const -> std::optional<std::int64_t>;
+
+    /// Returns the value of the operand named `slot_name`. Returns `std::nullopt` if there is no
+    /// such operand, or its value cannot be recovered.
+    auto operand_value(std::string_view slot_name) const -> std::optional<std::int64_t> {
+        if (auto const slot = instruction_class().find_slot(slot_name)) {
+            return operand_value(*slot);
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /// Returns the register name of `item`, which must be a register or a modifier in the format of
+    /// the instruction class, e.g. `R2` for `Register:Rd`. Returns `std::nullopt` if the value of
+    /// the operand cannot be recovered or there is no register with that value.
+    auto register_name(FormatItem const &item) const -> std::optional<std::string_view>;
+
+private:
+    Decoder const *decoder_;
+    InstructionWord word_;
+    DecodePattern const *pattern_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_DECODER_DECODED_INSTRUCTION_HPP
@@ -0,0 +1,172 @@
+#ifndef SASSAS_DECODER_DECODER_HPP
+#define SASSAS_DECODER_DECODER_HPP
+
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// The bits that are fixed for one opcode of an instruction class, i.e. the bits assigned by the
+/// opcode field and by the constant assignments (such as `!field;`) in the `ENCODING` section. An
+/// encoded instruction can only belong to the class if it has `value` in all bits set in `mask`.
+struct DecodePattern {
+    InstructionWord mask;
+    InstructionWord value;
+    /// The index of the instruction class in `ISA::classes`.
+    unsigned class_index;
+    /// The index of the opcode in `InstructionClass::opcodes`.
+    unsigned opcode_index;
+
+    auto matches(InstructionWord const &word) const -> bool {
+        return (word.words[0] & mask.words[0]) == value.words[0]
+            && (word.words[1] & mask.words[1]) == value.words[1];
+    }
+};
+
+/// Describes how the value of an operand slot of an instruction class is recovered from an encoded
+/// instruction, by reversing one of the assignments in the `ENCODING` section of the class.
+struct OperandSource {
+    enum Kind : std::uint8_t {
+        /// The operand is not encoded, e.g. it only exists in the assembly text.
+        NotEncoded,
+        /// The operand is the opcode, whose value is known once the instruction is decoded.
+        Opcode,
+        /// The operand is assigned to a field directly, as in `field = operand;`, or with a scale
+        /// factor, as in `field = operand SCALE 4;`.
+        Field,
+        /// The operand is an argument of a table call, as in `field = TABLE(operand, other);`. Its
+        /// value is found by a reverse lookup in the table.
+        TableArgument,
+    };
+
+    Kind kind = NotEncoded;
+    /// Whether the value of the field is sign-extended, which is the case for signed immediates.
+    bool is_signed = false;
+    /// The index of the assignment in `InstructionClass::encodings`.
+    std::uint32_t encoding_index = 0;
+    /// For `TableArgument`, the position of the operand in the argument list.
+    std::uint32_t argument_index = 0;
+    /// For `Field`, the scale factor of the `SCALE` operator, or 1 if there is none.
+    std::int64_t scale = 1;
+};
+
+/// Identifies the instruction class and the opcode of encoded instructions.
+///
+/// When it is constructed, the decoder collects a `DecodePattern` for each opcode of each class
+/// and builds a decision trie over them. Each inner node of the trie tests a few bits of the
+/// instruction, which are chosen so that they split the remaining patterns into groups that are as
+/// small as possible, and uses their value to index its children directly. The leaves hold the few
+/// patterns that cannot be told apart by the bits tested so far, and are checked one by one. So
+/// decoding an instruction takes a few table lookups instead of matching it against every class.
+class Decoder {
+public:
+    /// The maximum number of bits tested by an inner node. A node has `2^MAX_NODE_BITS` children at
+    /// most.
+    static constexpr unsigned MAX_NODE_BITS = 8;
+
+    /// Creates a decoder for `isa`, whose frozen form is `frozen_isa`. Both must outlive the
+    /// decoder.
+    Decoder(ISA const &isa, FrozenISA const &frozen_isa);
+
+    auto isa() const -> ISA const & {
+        return isa_;
+    }
+
+    /// Returns the frozen form of the ISA, in which the tables and registers are looked up while
+    /// instructions are decoded and formatted.
+    auto frozen_isa() const -> FrozenISA const & {
+        return frozen_isa_;
+    }
+
+    auto patterns() const -> std::vector<DecodePattern> const & {
+        return patterns_;
+    }
+
+    /// Returns the pattern of the class and opcode that `word` belongs to, or `nullptr` if `word`
+    /// does not match any of them. If several patterns match, the one with more fixed bits is
+    /// preferred, and then the one that appears first in the description file.
+    auto decode(InstructionWord const &word) const -> DecodePattern const *;
+
+    /// Returns the instruction class of `pattern`.
+    auto instruction_class(DecodePattern const &pattern) const -> InstructionClass const & {
+        return isa_.classes[pattern.class_index];
+    }
+
+    /// Returns how each operand slot of the class at `class_index` is recovered from an encoded
+    /// instruction. It is indexed by the slot index.
+    auto operand_sources(unsigned class_index) const -> std::span<OperandSource const> {
+        return operand_sources_[class_index];
+    }
+
+    /// Returns the table named `name` in the ISA, or `std::nullopt` if there is no such table. It
+    /// is used to reverse the table calls in the `ENCODING` section.
+    auto find_table(std::string_view name) const -> std::optional<TableView> {
+        return frozen_isa_.find_table(name);
+    }
+
+    /// Dumps the statistics of the decision trie to the standard output. It is used for debugging
+    /// purposes.
+    void dump(unsigned indent) const;
+
+private:
+    /// The index used in `children_` for a combination of bits that no pattern matches.
+    static constexpr std::uint32_t NO_NODE = ~static_cast<std::uint32_t>(0);
+
+    /// A run of `size` consecutive bits of the instruction starting at bit `start`, which are
+    /// placed at bit `shift` of the key of a node. A run never crosses the boundary between the two
+    /// 64-bit words of an `InstructionWord`.
+    struct BitRun {
+        std::uint8_t start;
+        std::uint8_t size;
+        std::uint8_t shift;
+    };
+
+    /// A node of the decision trie. A node with `run_count == 0` is a leaf, whose candidate
+    /// patterns are `leaf_patterns_[first, first + count)`. Otherwise, the bits in `runs` form an
+    /// index `key`, and the next node is `children_[first + key]`. The tested bits are usually
+    /// adjacent (e.g. they belong to the opcode field), so grouping them into runs lets us extract
+    /// the key with a few shifts instead of one per bit.
+    struct Node {
+        std::array<BitRun, MAX_NODE_BITS> runs;
+        std::uint8_t run_count;
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    ISA const &isa_;
+    FrozenISA const &frozen_isa_;
+    std::vector<DecodePattern> patterns_;
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> children_;
+    std::vector<std::uint32_t> leaf_patterns_;
+    /// The result of `operand_sources()` for each class.
+    std::vector<std::vector<OperandSource>> operand_sources_;
+
+    /// Collects the patterns of all opcodes of all classes into `patterns_`.
+    void collect_patterns();
+
+    /// Computes the `OperandSource` of each operand slot of each class into `operand_sources_`.
+    void collect_operand_sources();
+
+    /// Builds the subtrie that tells apart the patterns in `candidates`, and returns the index of
+    /// its root node. `built_nodes` maps the candidate lists seen so far to their subtries, so that
+    /// identical subtries are shared.
+    auto build_node(
+        std::span<std::uint32_t const> candidates,
+        std::map<std::vector<std::uint32_t>, std::uint32_t> &built_nodes
+    ) -> std::uint32_t;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_DECODER_DECODER_HPP
@@ -0,0 +1,71 @@
+#ifndef SASSAS_DECODER_DISASSEMBLER_HPP
+#define SASSAS_DECODER_DISASSEMBLER_HPP
+
+#include "sassas/decoder/decoder.hpp"
+#include "sassas/decoder/formatter.hpp"
+#include "sassas/elf/elf_reader.hpp"
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/isa.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace sassas {
+/// Disassembles the executable sections of cubins into SASS text, such as
+///
+///     .text.kernel:
+///             /*0000*/                   IMAD.MOV.U32 R1, RZ, RZ, c[0x0][0x28] ;
+///
+/// which can be assembled again.
+///
+/// The sections are split into chunks of `CHUNK_INSTRUCTIONS` instructions, which are disassembled
+/// in parallel into one string each. The strings are passed to the caller in the order of the
+/// chunks, so the output is the same as if the file were disassembled sequentially. Only a bounded
+/// number of chunks is in memory at once, so the memory used does not grow with the size of the
+/// file.
+class Disassembler {
+public:
+    /// The number of instructions in a chunk, which is the unit of work of `disassemble()`. It is
+    /// large enough that the cost of scheduling a chunk does not matter, and small enough that a
+    /// single large kernel is still spread across all threads.
+    static constexpr std::size_t CHUNK_INSTRUCTIONS = 1 << 14;
+
+    /// Creates a disassembler for `isa`, whose frozen form is `frozen_isa`. Both must outlive the
+    /// disassembler.
+    Disassembler(ISA const &isa, FrozenISA const &frozen_isa) :
+        decoder_(isa, frozen_isa),
+        formatter_(decoder_),
+        instruction_size_(isa.functional_unit.encoding_width() / 8) { }
+
+    // The formatter refers to the decoder.
+    Disassembler(Disassembler const &) = delete;
+    auto operator=(Disassembler const &) -> Disassembler & = delete;
+
+    /// Disassembles the executable sections of `elf` on `thread_count` threads. The text is passed
+    /// to `output` piece by piece, in order.
+    void disassemble(
+        ElfReader const &elf,
+        unsigned thread_count,
+        std::function<void(std::string_view)> const &output
+    ) const;
+
+    /// Disassembles `code`, whose first instruction is at `offset` in its section, and appends the
+    /// text to `text`. Words that are not valid instructions are written as comments.
+    void disassemble(
+        std::span<std::byte const> code,
+        std::uint64_t offset,
+        std::string &text
+    ) const;
+
+private:
+    Decoder decoder_;
+    InstructionFormatter formatter_;
+    unsigned instruction_size_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_DECODER_DISASSEMBLER_HPP
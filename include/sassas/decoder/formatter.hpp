@@ -0,0 +1,91 @@
+#ifndef SASSAS_DECODER_FORMATTER_HPP
+#define SASSAS_DECODER_FORMATTER_HPP
+
+#include "sassas/decoder/decoded_instruction.hpp"
+#include "sassas/decoder/decoder.hpp"
+#include "sassas/isa/register.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// Writes decoded instructions as SASS text, such as
+///
+///     @!P0 FADD.FTZ R2, -R3.reuse, |R4| ;
+///
+/// The formatter is designed for disassembling large binaries, so formatting an instruction does
+/// not allocate. The names of all registers and modifiers are rendered into flat tables once, when
+/// the formatter is constructed, and immediates are written with `std::to_chars`. The text is
+/// written into a buffer supplied by the caller.
+///
+/// The scheduling information (the items in `$(...)$`) is not written. Modifiers and the guard
+/// predicate are omitted if they have their default value.
+class InstructionFormatter {
+public:
+    explicit InstructionFormatter(Decoder const &decoder);
+
+    /// Writes the text of `instruction` into `buffer`, without a trailing newline. Returns the
+    /// number of characters written, or `std::nullopt` if `instruction` is invalid or `buffer` is
+    /// too small.
+    auto format(DecodedInstruction const &instruction, std::span<char> buffer) const
+        -> std::optional<std::size_t>;
+
+private:
+    /// The names of the registers in a `RegisterGroup`, indexed by value. The name of value `v` is
+    /// `storage[offsets[v], offsets[v + 1])`, which is empty if there is no register with that
+    /// value. If several registers have the same value, the name chosen by `RegisterGroup::find`
+    /// is used.
+    struct NameTable {
+        std::string storage;
+        std::vector<std::uint32_t> offsets;
+
+        auto name(std::int64_t value) const -> std::string_view {
+            if (value < 0 || static_cast<std::size_t>(value) + 1 >= offsets.size()) {
+                return {};
+            }
+
+            auto const index = static_cast<std::size_t>(value);
+            return std::string_view(storage).substr(
+                offsets[index],
+                offsets[index + 1] - offsets[index]
+            );
+        }
+    };
+
+    /// The information of a format item that is needed for formatting, computed when the formatter
+    /// is constructed so that no name lookup is needed later.
+    struct ItemInfo {
+        /// The index of the name table of a register or a modifier in `name_tables_`, or
+        /// `NO_TABLE`.
+        std::uint32_t name_table = NO_TABLE;
+        /// The value of the default register of a register or a modifier, if it has one.
+        std::optional<std::int64_t> default_value;
+        /// The slots of the `[-]`, `[||]`, `[!]` and `[~]` prefixes of the operand, or `NO_SLOT`
+        /// if the operand does not have the prefix.
+        std::array<std::uint32_t, 4> prefix_slots { NO_SLOT, NO_SLOT, NO_SLOT, NO_SLOT };
+    };
+
+    static constexpr std::uint32_t NO_TABLE = ~static_cast<std::uint32_t>(0);
+    static constexpr std::uint32_t NO_SLOT = ~static_cast<std::uint32_t>(0);
+    /// The largest register value for which we create a name table. The register categories in the
+    /// description files are small, so this is only a guard against pathological inputs.
+    static constexpr unsigned MAX_TABLE_VALUE = 1 << 16;
+
+    Decoder const &decoder_;
+    std::vector<NameTable> name_tables_;
+    /// The `ItemInfo` of each format item of each class, indexed by the class index and the index
+    /// of the item in `InstructionClass::format`.
+    std::vector<std::vector<ItemInfo>> item_infos_;
+
+    /// Renders the names of `group` into a new `NameTable`.
+    static auto build_name_table(RegisterGroup const &group) -> NameTable;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_DECODER_FORMATTER_HPP
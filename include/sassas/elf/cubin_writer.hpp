@@ -0,0 +1,70 @@
+#ifndef SASSAS_ELF_CUBIN_WRITER_HPP
+#define SASSAS_ELF_CUBIN_WRITER_HPP
+
+#include "sassas/elf/elf_writer.hpp"
+#include "sassas/isa/functional_unit.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// Collects the instructions assembled for one architecture, and writes them as a cubin, i.e. the
+/// ELF file loaded by the CUDA driver. Each section of the source, such as `.text.kernel`, becomes
+/// an executable section of the same name with a global function symbol `kernel`.
+///
+/// The encoded instructions of each section are kept in a buffer of their own, which is passed to
+/// `ElfWriter` as it is. So the output is written with a single gathered write, and never copied
+/// into one big buffer. The symbol names are interned into the `.strtab` table as they come, and
+/// the symbol table refers to them by ID.
+class CubinWriter {
+public:
+    /// `sm_version` is the version of the architecture, e.g. `90` for `sm_90`, and
+    /// `instruction_size` is the size of an instruction in bytes.
+    CubinWriter(unsigned sm_version, unsigned instruction_size) :
+        sm_version_(sm_version), instruction_size_(instruction_size) { }
+
+    /// Returns the version of the architecture `arch` as recorded in a cubin, e.g. `90` for `sm_90`
+    /// and `sm_90a`, or `std::nullopt` if `arch` does not name such an architecture.
+    static auto parse_sm_version(std::string_view arch) -> std::optional<unsigned>;
+
+    /// Starts the section `name`. The instructions appended after it belong to the section.
+    void begin_section(std::string_view name);
+
+    /// Appends an instruction to the current section. If no section has been started, a section
+    /// named `.text` is started.
+    void append(InstructionWord const &word);
+
+    /// Writes the cubin to `path`. Returns `false` if the file cannot be written, in which case
+    /// `errno` describes the problem. No section can be added afterwards, since the string table is
+    /// finalized.
+    auto write(char const *path) -> bool;
+
+    /// Appends the cubin to `output`, e.g. to embed it in a fatbin. No section can be added
+    /// afterwards.
+    void write(std::vector<std::byte> &output);
+
+private:
+    struct Section {
+        std::string name;
+        /// The name of the function symbol in `symbol_names_`.
+        ElfStringTable::Id symbol;
+        /// The encoded instructions, in little-endian byte order.
+        std::vector<std::byte> code;
+    };
+
+    unsigned sm_version_;
+    unsigned instruction_size_;
+    std::vector<Section> sections_;
+    ElfStringTable symbol_names_;
+
+    /// Describes the cubin to an `ElfWriter`, and passes it to `write`. Returns the result of
+    /// `write`.
+    auto lay_out(std::function<bool(ElfWriter const &)> const &write) -> bool;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_CUBIN_WRITER_HPP
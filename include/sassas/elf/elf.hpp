@@ -0,0 +1,74 @@
+#ifndef SASSAS_ELF_ELF_HPP
+#define SASSAS_ELF_ELF_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace sassas {
+/// The ELF constants and structures used by the reader and the writers. Only the values we use are
+/// defined. The structures have the layout of the ELF64 structures, and are read and written as
+/// they are laid out in memory, which needs a little-endian host.
+namespace elf {
+inline constexpr std::uint16_t ET_EXEC = 2;
+inline constexpr std::uint16_t EM_CUDA = 190;
+inline constexpr std::uint8_t ELFOSABI_CUDA = 51;
+
+inline constexpr std::uint32_t SHT_PROGBITS = 1;
+inline constexpr std::uint32_t SHT_SYMTAB = 2;
+inline constexpr std::uint32_t SHT_STRTAB = 3;
+
+inline constexpr std::uint64_t SHF_ALLOC = 0x2;
+inline constexpr std::uint64_t SHF_EXECINSTR = 0x4;
+
+inline constexpr std::uint8_t STB_LOCAL = 0;
+inline constexpr std::uint8_t STB_GLOBAL = 1;
+inline constexpr std::uint8_t STT_FUNC = 2;
+inline constexpr std::uint8_t STT_SECTION = 3;
+
+/// An entry of the symbol table, in the layout of `Elf64_Sym`.
+struct Symbol {
+    std::uint32_t name;
+    std::uint8_t info;
+    std::uint8_t other;
+    std::uint16_t section_index;
+    std::uint64_t value;
+    std::uint64_t size;
+};
+static_assert(sizeof(Symbol) == 24);
+/// The file header, in the layout of `Elf64_Ehdr`.
+struct FileHeader {
+    std::array<std::uint8_t, 16> ident;
+    std::uint16_t type;
+    std::uint16_t machine;
+    std::uint32_t version;
+    std::uint64_t entry;
+    std::uint64_t program_header_offset;
+    std::uint64_t section_header_offset;
+    std::uint32_t flags;
+    std::uint16_t header_size;
+    std::uint16_t program_header_size;
+    std::uint16_t program_header_count;
+    std::uint16_t section_header_size;
+    std::uint16_t section_header_count;
+    std::uint16_t section_name_index;
+};
+static_assert(sizeof(FileHeader) == 64);
+
+/// A section header, in the layout of `Elf64_Shdr`.
+struct SectionHeader {
+    std::uint32_t name;
+    std::uint32_t type;
+    std::uint64_t flags;
+    std::uint64_t address;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint32_t link;
+    std::uint32_t info;
+    std::uint64_t alignment;
+    std::uint64_t entry_size;
+};
+static_assert(sizeof(SectionHeader) == 64);
+}  // namespace elf
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_ELF_HPP
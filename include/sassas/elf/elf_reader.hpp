@@ -0,0 +1,62 @@
+#ifndef SASSAS_ELF_ELF_READER_HPP
+#define SASSAS_ELF_ELF_READER_HPP
+
+#include "sassas/elf/elf.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// A section of a file read by `ElfReader`.
+struct ElfSectionView {
+    std::string_view name;
+    std::uint32_t type;
+    std::uint64_t flags;
+    /// The contents of the section, which point into the image of the file.
+    std::span<std::byte const> data;
+
+    auto is_executable() const -> bool {
+        return (flags & elf::SHF_EXECINSTR) != 0;
+    }
+};
+
+/// Reads a little-endian 64-bit ELF file, such as a cubin, from its image in memory (typically a
+/// `MappedFile`).
+///
+/// The headers are validated where they are, and the sections are views into the image: the names
+/// point into the section header string table, and the contents are never copied. So reading a
+/// large file only touches its headers, and the image must outlive the reader.
+class ElfReader {
+public:
+    /// Reads the headers of the ELF file in `image`. Returns `std::nullopt` if the file is
+    /// malformed, in which case `error` describes the problem.
+    static auto read(std::span<std::byte const> image, std::string_view &error)
+        -> std::optional<ElfReader>;
+
+    auto machine() const -> std::uint16_t {
+        return machine_;
+    }
+
+    /// Returns `e_flags`, whose meaning depends on `machine()`.
+    auto flags() const -> std::uint32_t {
+        return flags_;
+    }
+
+    /// Returns the sections of the file in the order of the section header table, without the null
+    /// section.
+    auto sections() const -> std::span<ElfSectionView const> {
+        return sections_;
+    }
+
+private:
+    std::uint16_t machine_ = 0;
+    std::uint32_t flags_ = 0;
+    std::vector<ElfSectionView> sections_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_ELF_READER_HPP
@@ -0,0 +1,128 @@
+#ifndef SASSAS_ELF_ELF_WRITER_HPP
+#define SASSAS_ELF_ELF_WRITER_HPP
+
+#include "sassas/elf/elf.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sassas {
+/// A string table of an ELF file, such as `.strtab`.
+///
+/// The strings are interned: `add()` returns the ID of a string, and adding the same string again
+/// returns the same ID, so the users (e.g. symbol tables) can refer to strings by ID instead of
+/// keeping copies of them. Once all strings are added, `finalize()` lays out the table with suffix
+/// merging, as linkers do: a string that is a suffix of another one (such as the tail shared by
+/// many mangled names, or `.strtab` in `.shstrtab`) is not stored, but points into the end of the
+/// longer one.
+class ElfStringTable {
+public:
+    using Id = std::uint32_t;
+
+    /// Interns `str` and returns its ID. It must not be called after `finalize()`.
+    auto add(std::string_view str) -> Id;
+
+    /// Returns the string with the given ID.
+    auto str(Id id) const -> std::string_view {
+        return strings_[id];
+    }
+
+    /// Lays out the table. The strings are sorted by their reversed text in descending order, so
+    /// that a string that is a suffix of other strings comes right after one of them, and is
+    /// stored as the tail of that one.
+    void finalize();
+
+    /// Returns the offset of the string with the given ID in the table. It is only valid after
+    /// `finalize()`.
+    auto offset(Id id) const -> std::uint32_t {
+        assert(!offsets_.empty() && "The string table is not finalized");
+        return offsets_[id];
+    }
+
+    /// Returns the contents of the table, whose first byte is the empty string. It is only valid
+    /// after `finalize()`.
+    auto bytes() const -> std::span<std::byte const> {
+        return std::as_bytes(std::span(data_));
+    }
+
+private:
+    /// The interned strings, which are referred to by `strings_` and the keys of `ids_`. A deque
+    /// never moves its elements, so the views stay valid.
+    std::deque<std::string> storage_;
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, Id> ids_;
+    std::vector<std::uint32_t> offsets_;
+    std::string data_;
+};
+
+/// A section to be written by `ElfWriter`.
+struct ElfSection {
+    std::string_view name;
+    std::uint32_t type;
+    std::uint64_t flags = 0;
+    std::uint32_t link = 0;
+    std::uint32_t info = 0;
+    std::uint64_t alignment = 1;
+    std::uint64_t entry_size = 0;
+    /// The contents of the section. It is referenced, not copied, so it must stay valid until the
+    /// file is written.
+    std::span<std::byte const> data {};
+};
+
+/// Writes a little-endian 64-bit ELF file.
+///
+/// The sections are only described to the writer, which never copies their contents. `write()`
+/// lays out the whole file in one pass, computing all offsets up front, and then passes the
+/// header, the contents of each section, the padding between them and the section header table to
+/// a single `writev()` call as a list of buffers. So writing a file costs a few system calls no
+/// matter how many sections it has, and the contents (e.g. the encoded instructions) are never
+/// gathered into one buffer first.
+class ElfWriter {
+public:
+    /// `flags` is stored in `e_flags`, whose meaning depends on `machine`.
+    ElfWriter(
+        std::uint16_t machine,
+        std::uint8_t os_abi,
+        std::uint8_t abi_version,
+        std::uint32_t flags
+    ) :
+        machine_(machine), os_abi_(os_abi), abi_version_(abi_version), flags_(flags) { }
+
+    /// Adds a section and returns its index. The index 0 is the null section, so the first section
+    /// added gets the index 1. The section header string table is added by `write()`.
+    auto add_section(ElfSection const &section) -> std::uint32_t {
+        sections_.push_back(section);
+        return static_cast<std::uint32_t>(sections_.size());
+    }
+
+    /// Writes the file to `path`, replacing it if it exists. Returns `false` if the file cannot be
+    /// written, in which case `errno` describes the problem.
+    auto write(char const *path) const -> bool;
+
+    /// Appends the file to `output`, e.g. to embed it in another file.
+    void write(std::vector<std::byte> &output) const;
+
+private:
+    std::uint16_t machine_;
+    std::uint8_t os_abi_;
+    std::uint8_t abi_version_;
+    std::uint32_t flags_;
+    std::vector<ElfSection> sections_;
+
+    /// Lays out the file, and passes the buffers that make it up, in order, to `write`. Returns the
+    /// result of `write`.
+    auto lay_out(
+        std::function<bool(std::span<std::span<std::byte const> const>)> const &write
+    ) const -> bool;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_ELF_WRITER_HPP
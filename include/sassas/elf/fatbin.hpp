@@ -0,0 +1,53 @@
+#ifndef SASSAS_ELF_FATBIN_HPP
+#define SASSAS_ELF_FATBIN_HPP
+
+#include <cstdint>
+
+namespace sassas {
+/// The layout of a fatbin, as read by `FatbinReader` and written by `FatbinWriter`. A fatbin is a
+/// sequence of containers, each of which is a header followed by images, and each image is a
+/// header followed by its contents. The headers are read and written as they are laid out in
+/// memory, which needs a little-endian host.
+namespace fatbin {
+inline constexpr std::uint32_t MAGIC = 0xba55ed50;
+/// The flags of an image: its code is for a 64-bit host, and its contents are compressed.
+inline constexpr std::uint64_t FLAG_64BIT = 0x1;
+inline constexpr std::uint64_t FLAG_COMPRESSED = 0x2000;
+
+/// The kinds of images.
+inline constexpr std::uint16_t KIND_PTX = 1;
+inline constexpr std::uint16_t KIND_CUBIN = 2;
+
+/// The header of a container, which is followed by the images.
+struct ContainerHeader {
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint16_t header_size;
+    /// The size of the images, excluding this header.
+    std::uint64_t size;
+};
+static_assert(sizeof(ContainerHeader) == 16);
+
+/// The header of an image, which is followed by its contents.
+struct ImageHeader {
+    std::uint16_t kind;
+    std::uint16_t unknown0;
+    std::uint32_t header_size;
+    /// The size of the contents, including padding.
+    std::uint64_t size;
+    std::uint32_t compressed_size;
+    std::uint32_t unknown1;
+    std::uint16_t minor_version;
+    std::uint16_t major_version;
+    std::uint32_t sm_version;
+    std::uint32_t name_offset;
+    std::uint32_t name_size;
+    std::uint64_t flags;
+    std::uint64_t unknown2;
+    std::uint64_t uncompressed_size;
+};
+static_assert(sizeof(ImageHeader) == 64);
+}  // namespace fatbin
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_FATBIN_HPP
@@ -0,0 +1,61 @@
+#ifndef SASSAS_ELF_FATBIN_READER_HPP
+#define SASSAS_ELF_FATBIN_READER_HPP
+
+#include "sassas/elf/fatbin.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// An image embedded in a fatbin.
+struct FatbinImage {
+    std::uint16_t kind;
+    /// The version of the architecture the image is compiled for, e.g. `90` for `sm_90`.
+    std::uint32_t sm_version;
+    /// Whether the image is compressed, in which case `data` cannot be read as it is.
+    bool is_compressed;
+    /// The contents of the image, which point into the image of the fatbin.
+    std::span<std::byte const> data;
+
+    auto is_cubin() const -> bool {
+        return kind == fatbin::KIND_CUBIN;
+    }
+};
+
+/// Reads the index of a fatbin, the container in which the CUDA toolchain bundles the cubins (and
+/// PTX) of several architectures, either as a file of its own or as the `.nv_fatbin` section of a
+/// host executable.
+///
+/// Like `ElfReader`, the reader only looks at the headers: the images are views into the fatbin,
+/// and compressed images are reported as such, not decompressed. So indexing a fatbin is cheap no
+/// matter how many images it holds, and the caller only pays for the ones it uses.
+class FatbinReader {
+public:
+    /// Returns whether `image` starts like a fatbin.
+    static auto is_fatbin(std::span<std::byte const> image) -> bool;
+
+    /// Reads the index of the fatbin in `image`, which may hold several containers back to back.
+    /// Returns `std::nullopt` if the fatbin is malformed, in which case `error` describes the
+    /// problem.
+    static auto read(std::span<std::byte const> image, std::string_view &error)
+        -> std::optional<FatbinReader>;
+
+    /// Returns the images in the order in which they appear in the fatbin.
+    auto images() const -> std::span<FatbinImage const> {
+        return images_;
+    }
+
+    /// Returns the architectures of the cubins in the fatbin, in ascending order and without
+    /// duplicates.
+    auto cubin_architectures() const -> std::vector<std::uint32_t>;
+
+private:
+    std::vector<FatbinImage> images_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_FATBIN_READER_HPP
@@ -0,0 +1,36 @@
+#ifndef SASSAS_ELF_FATBIN_WRITER_HPP
+#define SASSAS_ELF_FATBIN_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sassas {
+/// Writes a fatbin that bundles the cubins of several architectures in one container.
+///
+/// As with `ElfWriter`, the contents of the cubins are only referenced, and the file is written
+/// with a single gathered write.
+class FatbinWriter {
+public:
+    /// Adds the cubin `image` for the architecture `sm_version`, e.g. `90` for `sm_90`. It is
+    /// referenced, not copied, so it must stay valid until the file is written.
+    void add_cubin(std::uint32_t sm_version, std::span<std::byte const> image) {
+        cubins_.push_back({ .sm_version = sm_version, .image = image });
+    }
+
+    /// Writes the fatbin to `path`, replacing it if it exists. Returns `false` if the file cannot
+    /// be written, in which case `errno` describes the problem.
+    auto write(char const *path) const -> bool;
+
+private:
+    struct Cubin {
+        std::uint32_t sm_version;
+        std::span<std::byte const> image;
+    };
+
+    std::vector<Cubin> cubins_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ELF_FATBIN_WRITER_HPP
@@ -0,0 +1,177 @@
+#ifndef SASSAS_ENCODER_ENCODER_HPP
+#define SASSAS_ENCODER_ENCODER_HPP
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// Decides how much of the `CONDITIONS` section of an instruction class is checked when the
+/// instruction is encoded.
+///
+/// Most of the assembly we encode is generated by a compiler that has already validated it, so the
+/// user can trade the checks for throughput. The encoding range checks (i.e. whether a value fits
+/// into its bitmask) are always performed, since a value that does not fit would silently corrupt
+/// the neighboring fields.
+enum class ValidationLevel : std::uint8_t {
+    /// Evaluates all conditions.
+    Full,
+    /// Only evaluates the conditions of kind `ConditionType::Error`.
+    ErrorsOnly,
+    /// Does not evaluate any condition.
+    Trusted,
+};
+
+/// Returns the string representation of `level`, which is also the spelling accepted by
+/// `validation_level_from_string()`.
+inline auto display_string(ValidationLevel level) -> char const * {
+    switch (level) {
+    case ValidationLevel::Full:
+        return "full";
+    case ValidationLevel::ErrorsOnly:
+        return "errors-only";
+    case ValidationLevel::Trusted:
+        return "trusted";
+    default:
+        return "unknown";
+    }
+}
+
+/// Parses a validation level from its string representation. Returns `std::nullopt` if `str` is not
+/// a valid level.
+auto validation_level_from_string(std::string_view str) -> std::optional<ValidationLevel>;
+
+/// Returns a view of the string representations of all validation levels.
+inline auto get_validation_levels() {
+    return std::views::iota(0u, 3u) | std::views::transform([](unsigned level) {
+               return display_string(static_cast<ValidationLevel>(level));
+           });
+}
+
+/// Describes a problem found while encoding an instruction. The encoder does not know where the
+/// instruction comes from, so it reports problems in this form and leaves it to the caller to turn
+/// them into `Diag` objects with the proper source location.
+struct EncodeIssue {
+    enum Kind : std::uint8_t {
+        /// A condition in the `CONDITIONS` section is not satisfied. `message` is the message of
+        /// the condition, and `subject` is the name of its condition type.
+        ConditionViolated,
+        /// The value assigned to a field does not fit into its bitmask. `subject` is the name of
+        /// the field.
+        ValueOutOfRange,
+        /// The value assigned to a field cannot be computed, e.g. because it uses a function we do
+        /// not support. `subject` is the name of the field.
+        EvaluationFailed,
+    };
+
+    Kind kind;
+    DiagLevel level;
+    std::string_view message;
+    std::string_view subject;
+};
+
+/// Encodes instructions of the instruction classes in an `ISA` into `InstructionWord` objects.
+///
+/// The encoder works on the operand values of an instruction, indexed by the operand slots of its
+/// class (see `InstructionClass`). It first checks the conditions of the class according to the
+/// validation level, and then evaluates the `ENCODING` section and writes each value into its
+/// bitmask.
+class Encoder {
+public:
+    /// Creates an encoder for `isa`, whose frozen form is `frozen_isa`. Both must outlive the
+    /// encoder.
+    Encoder(ISA const &isa, FrozenISA const &frozen_isa) : isa_(isa), frozen_isa_(frozen_isa) { }
+
+    auto isa() const -> ISA const & {
+        return isa_;
+    }
+
+    /// Encodes an instruction of class `instruction_class` whose operand values are `operands`.
+    /// The problems found during encoding are appended to `issues`. Returns the encoded
+    /// instruction, or `std::nullopt` if a problem of level `DiagLevel::Error` was found.
+    ///
+    /// The validation level is a template parameter, so that the checks skipped by the level are
+    /// removed at compile time.
+    template <ValidationLevel Level>
+    auto encode(
+        InstructionClass const &instruction_class,
+        std::span<std::int64_t const> operands,
+        std::vector<EncodeIssue> &issues
+    ) const -> std::optional<InstructionWord>;
+
+    /// Encodes an instruction with the validation level selected at runtime. It dispatches to the
+    /// corresponding instantiation of the template version.
+    auto encode(
+        ValidationLevel level,
+        InstructionClass const &instruction_class,
+        std::span<std::int64_t const> operands,
+        std::vector<EncodeIssue> &issues
+    ) const -> std::optional<InstructionWord>;
+
+    /// Rewrites the fields of `word`, an encoded instruction of class `instruction_class`, whose
+    /// values depend on the operand in `slot`, after that operand has been changed in `operands`.
+    /// It is used to patch the target of a forward branch into the instruction once the label is
+    /// defined. The conditions are not checked again. Returns `false` if a field cannot be
+    /// computed or does not fit, in which case the problems are appended to `issues` and `word` is
+    /// left unchanged.
+    auto patch(
+        InstructionClass const &instruction_class,
+        unsigned slot,
+        std::span<std::int64_t const> operands,
+        InstructionWord &word,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+
+    /// Checks one condition of an instruction whose operand values are `operands`, as `encode()`
+    /// checks each of them, and appends it to `issues` if it is violated. Returns `false` if it is
+    /// violated and of kind `ConditionType::Error`. A condition that cannot be evaluated passes.
+    auto check_condition(
+        Condition const &condition,
+        std::span<std::int64_t const> operands,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+
+    /// Returns the table named `name` in the ISA, or `std::nullopt` if there is no such table. It
+    /// is used to evaluate the table calls in expressions.
+    auto find_table(std::string_view name) const -> std::optional<TableView> {
+        return frozen_isa_.find_table(name);
+    }
+
+private:
+    ISA const &isa_;
+    /// The tables are looked up for every table call of every instruction, so they are looked up in
+    /// the frozen form of the ISA, which is shared with the other users of the ISA.
+    FrozenISA const &frozen_isa_;
+
+    /// Checks `conditions` and appends the violated ones to `issues`. Returns `false` if a
+    /// condition of kind `ConditionType::Error` is violated.
+    auto check_conditions(
+        std::span<Condition const> conditions,
+        std::span<std::int64_t const> operands,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+
+    /// Evaluates the value of `encoding` and writes it into its field of `word`. Returns `false`
+    /// if the value cannot be computed or does not fit, in which case the problem is appended to
+    /// `issues`.
+    auto encode_field(
+        EncodingAssignment const &encoding,
+        std::span<std::int64_t const> operands,
+        InstructionWord &word,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ENCODER_ENCODER_HPP
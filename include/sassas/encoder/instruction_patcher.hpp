@@ -0,0 +1,120 @@
+#ifndef SASSAS_ENCODER_INSTRUCTION_PATCHER_HPP
+#define SASSAS_ENCODER_INSTRUCTION_PATCHER_HPP
+
+#include "sassas/decoder/decoder.hpp"
+#include "sassas/encoder/encoder.hpp"
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// A change of one operand of an encoded instruction, prepared by `InstructionPatcher::prepare()`.
+struct OperandPatch {
+    InstructionClass const *instruction_class = nullptr;
+    /// The operand slot that is changed.
+    unsigned slot = 0;
+    /// The values of the operands of the instruction, as recovered from it, indexed by slot. The
+    /// operands that cannot be recovered are 0, and nothing that is evaluated uses them. Applying
+    /// the patch does not change them.
+    std::vector<std::int64_t> operands;
+    /// The indices of the conditions of the class that involve the operand, in ascending order.
+    std::vector<unsigned> conditions;
+};
+
+/// Changes one operand of an already encoded instruction in place, without assembling it again,
+/// e.g. to produce many variants of a kernel that differ in a register, an immediate or a modifier.
+///
+/// `prepare()` decodes the instruction to find its class, and recovers the values of its operands.
+/// `apply()` then sets the operand to a new value: it checks the `CONDITIONS` of the class that
+/// involve the operand, and writes the fields of the `ENCODING` section whose values depend on it
+/// into their `FUNIT` bitmasks, leaving the other bits of the instruction alone. The conditions
+/// that do not involve the operand hold as they did before. A patch can be applied any number of
+/// times, to the same instruction of each copy of a cubin, which costs a few expression
+/// evaluations.
+///
+/// The opcode cannot be changed, since it selects the class, nor can an operand that shares a
+/// field with an operand whose value cannot be recovered from the instruction. A condition that
+/// uses such an operand cannot be evaluated, so it passes, as in `Encoder`.
+class InstructionPatcher {
+public:
+    /// Creates a patcher for `isa`, whose frozen form is `frozen_isa`. Both must outlive the
+    /// patcher.
+    InstructionPatcher(ISA const &isa, FrozenISA const &frozen_isa) :
+        decoder_(isa, frozen_isa), encoder_(isa, frozen_isa),
+        instruction_size_(isa.functional_unit.encoding_width() / 8) { }
+
+    auto isa() const -> ISA const & {
+        return encoder_.isa();
+    }
+
+    /// Returns the size of an instruction word in bytes.
+    auto instruction_size() const -> unsigned {
+        return instruction_size_;
+    }
+
+    /// Prepares to change the operand named `operand` (as in the `FORMAT` section of its class) of
+    /// the instruction at the start of `instruction`. Returns `std::nullopt` if `instruction` holds
+    /// fewer than `instruction_size()` bytes, the instruction cannot be decoded or the operand
+    /// cannot be changed, in which case `error` describes the problem.
+    auto prepare(
+        std::span<std::byte const> instruction,
+        std::string_view operand,
+        std::string_view &error
+    ) const -> std::optional<OperandPatch>;
+
+    /// Returns the value of the register or modifier `name` (e.g. `R2` or `EF`) in the category of
+    /// the operand of `patch`, or `std::nullopt` if the operand is not a register or a modifier or
+    /// its category has no such name.
+    auto register_value(OperandPatch const &patch, std::string_view name) const
+        -> std::optional<std::int64_t>;
+
+    /// Sets the operand of `patch` to `value` in `word`, which must be the instruction `patch` was
+    /// prepared for, or a copy of it. The conditions involving the operand are checked according to
+    /// `level`. Returns `false` if a condition of kind `ConditionType::Error` is violated, or a
+    /// field cannot be computed or does not fit, in which case `word` is left unchanged. The
+    /// problems are appended to `issues` either way.
+    auto apply(
+        OperandPatch const &patch,
+        std::int64_t value,
+        ValidationLevel level,
+        InstructionWord &word,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+
+    /// Sets the operand of `patch` to `value` in the instruction at the start of `instruction`, as
+    /// the other overload does, and writes the changed bytes back in place. Returns `false` without
+    /// adding an issue if `instruction` holds fewer than `instruction_size()` bytes.
+    auto apply(
+        OperandPatch const &patch,
+        std::int64_t value,
+        ValidationLevel level,
+        std::span<std::byte> instruction,
+        std::vector<EncodeIssue> &issues
+    ) const -> bool;
+
+private:
+    Decoder decoder_;
+    Encoder encoder_;
+    unsigned instruction_size_;
+
+    /// Returns the instruction at the start of `instruction`, or `std::nullopt` if it is truncated.
+    auto read_word(std::span<std::byte const> instruction) const
+        -> std::optional<InstructionWord>;
+};
+
+/// Returns the contents of the executable section named `section` (such as `.text.kernel`) of the
+/// cubin in `image`, in which its instructions can be patched in place. Returns `std::nullopt` if
+/// `image` is not a cubin or has no such section, in which case `error` describes the problem.
+auto find_cubin_code(std::span<std::byte> image, std::string_view section, std::string_view &error)
+    -> std::optional<std::span<std::byte>>;
+}  // namespace sassas
+
+#endif  // SASSAS_ENCODER_INSTRUCTION_PATCHER_HPP
@@ -43,6 +43,9 @@ private:
     // clang-format on
 
     ConditionType(Kind kind, std::string name) : kind(kind), name(std::move(name)) { }
+
+    // Rebuilds condition types from their kind rather than from its string representation.
+    friend class ISAImage;
 };
 }  // namespace sassas
 
@@ -0,0 +1,37 @@
+#ifndef SASSAS_ISA_EMBEDDED_ISA_HPP
+#define SASSAS_ISA_EMBEDDED_ISA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace sassas {
+/// The `ISAImage` of an instruction description that is compiled into the executable.
+struct EmbeddedISA {
+    /// The architecture, such as `sm_90`.
+    std::string_view arch;
+    std::span<std::byte const> image;
+};
+
+/// Returns the embedded ISAs, sorted by `arch`.
+///
+/// It is defined in a source file that is generated at build time by `sassas-embed-isa`, which
+/// parses the instruction description files and writes their images as constant arrays, so they
+/// end up in the read-only data of the executable. It only exists in builds configured with
+/// `SASSAS_EMBED_DESCRIPTIONS`, which define `SASSAS_EMBEDDED_ISAS`.
+auto embedded_isas() -> std::span<EmbeddedISA const>;
+
+/// Returns the embedded image of `arch`, or `std::nullopt` if it is not embedded.
+inline auto find_embedded_isa(std::string_view arch) -> std::optional<std::span<std::byte const>> {
+    std::span<EmbeddedISA const> const isas = embedded_isas();
+    auto const iter = std::ranges::lower_bound(isas, arch, {}, &EmbeddedISA::arch);
+    if (iter == isas.end() || iter->arch != arch) {
+        return std::nullopt;
+    }
+    return iter->image;
+}
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_EMBEDDED_ISA_HPP
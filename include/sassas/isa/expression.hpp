@@ -0,0 +1,289 @@
+#ifndef SASSAS_ISA_EXPRESSION_HPP
+#define SASSAS_ISA_EXPRESSION_HPP
+
+#include "sassas/isa/table.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// This class represents an expression that appears in the `CONDITIONS` and `ENCODING` sections of
+/// an instruction class, such as
+///
+///     (((Rd)+((Rd)==`Register@RZ)) % 2) == 0
+///
+/// The expression is stored in postfix order in a single `std::vector`, so that it can be evaluated
+/// with a simple value stack and copied without chasing pointers. All names that can be resolved
+/// when the description file is parsed (registers, parameters and constants) are folded into
+/// integer nodes. Operands of the instruction are referenced by their slot index in the owning
+/// `InstructionClass`, and tables are referenced by name.
+class Expr {
+public:
+    enum class Op : std::uint8_t {
+        /// An integer constant. The value is stored in `Node::value`.
+        Integer,
+        /// A reference to an operand of the instruction. The slot index is stored in `Node::index`.
+        Operand,
+        /// A call to a table in the `TABLES` section. The index of the table name in `names()` is
+        /// stored in `Node::index`, and the number of arguments is stored in `Node::value`.
+        TableCall,
+        /// A name we cannot resolve. Evaluating an expression that contains such a node always
+        /// fails. The index of the name in `names()` is stored in `Node::index`, and the number of
+        /// arguments (if it is a call) is stored in `Node::value`.
+        Unresolved,
+
+        // Unary operators.
+        Negate,
+        LogicalNot,
+        BitwiseNot,
+
+        // Binary operators.
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Rem,
+        Shl,
+        Shr,
+        BitAnd,
+        BitOr,
+        LogicalAnd,
+        LogicalOr,
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        /// The `->` operator, which means "implies", i.e. `!lhs || rhs`.
+        Implies,
+        /// The `SCALE` operator in the `ENCODING` section. When encoding, the value is divided by
+        /// the scale factor.
+        Scale,
+
+        // Ternary operators.
+        Conditional,
+    };
+
+    struct Node {
+        Op op;
+        std::uint32_t index;
+        std::int64_t value;
+    };
+
+    /// The maximum depth of the value stack that can be evaluated without allocation. Expressions
+    /// in the description files are shallow, so this is enough for all of them in practice.
+    static constexpr std::size_t INLINE_STACK_DEPTH = 32;
+
+    void push_integer(std::int64_t value) {
+        push_node({ .op = Op::Integer, .index = 0, .value = value }, 1);
+    }
+
+    void push_operand(unsigned slot) {
+        push_node({ .op = Op::Operand, .index = slot, .value = 0 }, 1);
+    }
+
+    void push_table_call(std::string name, unsigned argument_count) {
+        push_node(
+            { .op = Op::TableCall, .index = add_name(std::move(name)), .value = argument_count },
+            1 - static_cast<int>(argument_count)
+        );
+    }
+
+    void push_unresolved(std::string name, unsigned argument_count) {
+        push_node(
+            { .op = Op::Unresolved, .index = add_name(std::move(name)), .value = argument_count },
+            1 - static_cast<int>(argument_count)
+        );
+    }
+
+    /// Appends an operator node. The operands of the operator must have been pushed before.
+    void push_operator(Op op) {
+        push_node({ .op = op, .index = 0, .value = 0 }, 1 - static_cast<int>(arity(op)));
+    }
+
+    auto nodes() const -> std::vector<Node> const & {
+        return nodes_;
+    }
+
+    auto names() const -> std::vector<std::string> const & {
+        return names_;
+    }
+
+    auto empty() const -> bool {
+        return nodes_.empty();
+    }
+
+    /// Returns the maximum depth of the value stack needed to evaluate this expression.
+    auto max_stack_depth() const -> unsigned {
+        return max_depth_;
+    }
+
+    /// If the whole expression is a single reference to an operand, returns its slot index.
+    auto as_operand() const -> std::optional<unsigned> {
+        if (nodes_.size() == 1 && nodes_.front().op == Op::Operand) {
+            return nodes_.front().index;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /// If the whole expression is a single integer constant, returns its value.
+    auto as_integer() const -> std::optional<std::int64_t> {
+        if (nodes_.size() == 1 && nodes_.front().op == Op::Integer) {
+            return nodes_.front().value;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /// Returns whether the expression refers to the operand in `slot`.
+    auto uses_operand(unsigned slot) const -> bool {
+        return std::ranges::any_of(nodes_, [slot](Node const &node) {
+            return node.op == Op::Operand && node.index == slot;
+        });
+    }
+
+    /// Returns the number of operands consumed by `op`.
+    static auto arity(Op op) -> unsigned;
+
+    /// Applies the unary or binary operator `op` to the given arguments. Returns `std::nullopt` if
+    /// the operation is undefined, e.g. division by zero.
+    static auto apply(Op op, std::int64_t lhs, std::int64_t rhs) -> std::optional<std::int64_t>;
+
+    /// Evaluates the expression. `operands` provides the values of the operand slots of the owning
+    /// instruction class. `resolve_table` is a callable that takes a table name and returns the
+    /// corresponding table, as a `Table const *` or an `std::optional<TableView>`, which is empty
+    /// if there is no such table.
+    ///
+    /// Returns `std::nullopt` if the expression cannot be evaluated, which happens if it contains
+    /// unresolved names, a table lookup has no match, or an operation is undefined.
+    template <class TableResolver>
+    auto evaluate(std::span<std::int64_t const> operands, TableResolver &&resolve_table) const
+        -> std::optional<std::int64_t>;
+
+    /// Dumps the expression in infix form to the standard output. It is used for debugging
+    /// purposes.
+    void dump() const;
+
+private:
+    std::vector<Node> nodes_;
+    /// The names referenced by `TableCall` and `Unresolved` nodes.
+    std::vector<std::string> names_;
+    /// The current and the maximum depth of the value stack, tracked while nodes are pushed.
+    int depth_ = 0;
+    unsigned max_depth_ = 0;
+
+    auto add_name(std::string name) -> std::uint32_t {
+        names_.push_back(std::move(name));
+        return static_cast<std::uint32_t>(names_.size() - 1);
+    }
+
+    // Rebuilds expressions node by node, and thus their stack depth too.
+    friend class ISAImage;
+
+    void push_node(Node node, int stack_effect) {
+        nodes_.push_back(node);
+        depth_ += stack_effect;
+        max_depth_ =
+            std::ranges::max(max_depth_, static_cast<unsigned>(std::ranges::max(depth_, 0)));
+    }
+};
+
+template <class TableResolver>
+auto Expr::evaluate(std::span<std::int64_t const> operands, TableResolver &&resolve_table) const
+    -> std::optional<std::int64_t>  //
+{
+    // Use a fixed-size buffer for the common case, so that evaluating an expression does not
+    // allocate.
+    std::array<std::int64_t, INLINE_STACK_DEPTH> inline_stack;
+    std::vector<std::int64_t> heap_stack;
+    std::int64_t *stack = inline_stack.data();
+    if (max_depth_ > INLINE_STACK_DEPTH) {
+        heap_stack.resize(max_depth_);
+        stack = heap_stack.data();
+    }
+
+    std::size_t top = 0;
+    for (Node const &node : nodes_) {
+        switch (node.op) {
+        case Op::Integer:
+            stack[top++] = node.value;
+            break;
+
+        case Op::Operand:
+            if (node.index >= operands.size()) {
+                return std::nullopt;
+            }
+            stack[top++] = operands[node.index];
+            break;
+
+        case Op::TableCall: {
+            auto const table = resolve_table(names_[node.index]);
+            auto const argument_count = static_cast<std::size_t>(node.value);
+            if (!table || table->key_size() != argument_count
+                || argument_count > INLINE_STACK_DEPTH)
+            {
+                return std::nullopt;
+            }
+
+            std::array<unsigned, INLINE_STACK_DEPTH> keys;
+            top -= argument_count;
+            for (std::size_t i = 0; i != argument_count; ++i) {
+                keys[i] = static_cast<unsigned>(stack[top + i]);
+            }
+
+            if (auto const value = table->get_value(std::span(keys.data(), argument_count))) {
+                stack[top++] = *value;
+            } else {
+                return std::nullopt;
+            }
+            break;
+        }
+
+        case Op::Unresolved:
+            return std::nullopt;
+
+        case Op::Conditional: {
+            top -= 3;
+            stack[top] = stack[top] != 0 ? stack[top + 1] : stack[top + 2];
+            ++top;
+            break;
+        }
+
+        default:
+            if (arity(node.op) == 1) {
+                if (auto const value = apply(node.op, stack[top - 1], 0)) {
+                    stack[top - 1] = *value;
+                } else {
+                    return std::nullopt;
+                }
+            } else {
+                --top;
+                if (auto const value = apply(node.op, stack[top - 1], stack[top])) {
+                    stack[top - 1] = *value;
+                } else {
+                    return std::nullopt;
+                }
+            }
+            break;
+        }
+    }
+
+    if (top != 1) {
+        // Malformed expression.
+        return std::nullopt;
+    }
+
+    return stack[0];
+}
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_EXPRESSION_HPP
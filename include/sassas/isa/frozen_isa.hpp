@@ -0,0 +1,208 @@
+#ifndef SASSAS_ISA_FROZEN_ISA_HPP
+#define SASSAS_ISA_FROZEN_ISA_HPP
+
+#include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// A read-only form of an `ISA` that is laid out for lookups rather than for parsing. It is
+/// produced by `freeze()`.
+///
+/// `ISA` is built from `unordered_map`s, whose nodes are allocated one by one while the description
+/// file is parsed, so a lookup hashes the name and then chases pointers across the heap. Here each
+/// map is a contiguous array sorted by name, with an open-addressing index of 32-bit slots; all
+/// names and strings are stored in one buffer, and entries refer to names and to each other with
+/// 32-bit indices. So a lookup touches a slot, an entry and the name, and the registers of a
+/// category can be found by name or by value with a binary search instead of a linear scan.
+///
+/// Nothing is modified after `freeze()` returns, so a frozen ISA can be read from any number of
+/// threads without synchronization. The instruction classes are not part of it: they are already
+/// stored in a vector, and they refer to the tables by name, which are looked up here.
+class FrozenISA {
+    /// A string in `strings_`.
+    struct StringRef {
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    struct Constant {
+        StringRef name;
+        int value;
+    };
+
+    struct StringMapping {
+        StringRef name;
+        StringRef value;
+    };
+
+    struct FrozenConditionType {
+        StringRef name;
+        ConditionType::Kind kind;
+    };
+
+    struct FrozenRegister {
+        StringRef name;
+        std::uint32_t value;
+    };
+
+    /// A register category, whose registers are `registers_[first, first + size)`. The same range
+    /// of `registers_by_name_` and `registers_by_value_` holds its sorted indices.
+    struct FrozenRegisterGroup {
+        StringRef name;
+        std::uint32_t first;
+        std::uint32_t size;
+    };
+
+    /// A table, whose items are `table_items_[first, first + size)`.
+    struct FrozenTable {
+        StringRef name;
+        std::uint32_t key_size;
+        std::uint32_t first;
+        std::uint32_t size;
+    };
+
+    /// A bitmask, whose ranges are `bit_ranges_[first, first + size)`.
+    struct FrozenBitMask {
+        StringRef name;
+        std::uint32_t first;
+        std::uint32_t size;
+    };
+
+    /// An array of entries sorted by name, and a hash index into it.
+    template <class Entry>
+    struct NameMap {
+        std::vector<Entry> entries;
+        /// An open-addressing hash table with linear probing, whose size is a power of two and at
+        /// least twice the number of entries. A slot holds the index of an entry plus one, or zero
+        /// if it is empty.
+        std::vector<std::uint32_t> slots;
+    };
+
+public:
+    /// The registers of a category, with the same lookups as `RegisterGroup`. Like the other views
+    /// returned by a frozen ISA, it stays valid as long as the frozen ISA exists, even if the
+    /// frozen ISA is moved.
+    class RegisterGroupView {
+    public:
+        auto size() const -> std::size_t {
+            return registers_.size();
+        }
+
+        /// Returns the value of the last register named `name`, which is compared ignoring case,
+        /// or `std::nullopt` if there is no such register.
+        auto find(std::string_view name) const -> std::optional<unsigned>;
+
+        /// Returns the name of the last register whose value is `value`, or `std::nullopt` if
+        /// there is no such register.
+        auto find(unsigned value) const -> std::optional<std::string_view>;
+
+    private:
+        friend class FrozenISA;
+
+        std::span<char const> strings_;
+        /// The registers in the order of the description file.
+        std::span<FrozenRegister const> registers_;
+        /// The indices of `registers_`, sorted by lowercase name and then from the last register
+        /// to the first, so that the first match is the last register with that name.
+        std::span<std::uint32_t const> by_name_;
+        /// The indices of `registers_`, sorted by value and then from the last register to the
+        /// first.
+        std::span<std::uint32_t const> by_value_;
+
+        RegisterGroupView(
+            std::span<char const> strings,
+            std::span<FrozenRegister const> registers,
+            std::span<std::uint32_t const> by_name,
+            std::span<std::uint32_t const> by_value
+        ) :
+            strings_(strings), registers_(registers), by_name_(by_name), by_value_(by_value) { }
+
+        auto name(std::uint32_t index) const -> std::string_view;
+    };
+
+    /// Freezes `isa`. The frozen ISA does not refer to `isa`, which may be destroyed afterwards.
+    static auto freeze(ISA const &isa) -> FrozenISA;
+
+    auto architecture_name() const -> std::string_view {
+        return string(architecture_name_);
+    }
+
+    auto functional_unit_name() const -> std::string_view {
+        return string(functional_unit_name_);
+    }
+
+    auto encoding_width() const -> unsigned {
+        return encoding_width_;
+    }
+
+    /// Returns the value of the entry named `name` in the `PARAMETERS` section.
+    auto find_parameter(std::string_view name) const -> std::optional<int>;
+
+    /// Returns the value of the entry named `name` in the `CONSTANTS` section.
+    auto find_constant(std::string_view name) const -> std::optional<int>;
+
+    /// Returns the string that `key` is mapped to in the `STRING_MAP` section.
+    auto find_string(std::string_view key) const -> std::optional<std::string_view>;
+
+    /// Returns the kind of the condition type named `name`.
+    auto find_condition_type(std::string_view name) const -> std::optional<ConditionType::Kind>;
+
+    /// Returns the registers of the category named `category`.
+    auto find_register_group(std::string_view category) const -> std::optional<RegisterGroupView>;
+
+    /// Returns the items of the table named `name`.
+    auto find_table(std::string_view name) const -> std::optional<TableView>;
+
+    /// Returns the ranges of the bitmask named `name` in the `FUNIT` section, in the order of
+    /// `BitMask`.
+    auto find_bitmask(std::string_view name) const -> std::optional<std::span<BitRange const>>;
+
+private:
+    // The strings are kept in a vector rather than a `std::string`, whose small-string buffer would
+    // move with the object and invalidate the views.
+    std::vector<char> strings_;
+    StringRef architecture_name_ {};
+    StringRef functional_unit_name_ {};
+    unsigned encoding_width_ = 0;
+
+    NameMap<Constant> parameters_;
+    NameMap<Constant> constants_;
+    NameMap<StringMapping> string_map_;
+    NameMap<FrozenConditionType> condition_types_;
+    NameMap<FrozenRegisterGroup> register_groups_;
+    NameMap<FrozenTable> tables_;
+    NameMap<FrozenBitMask> bitmasks_;
+
+    std::vector<FrozenRegister> registers_;
+    std::vector<std::uint32_t> registers_by_name_;
+    std::vector<std::uint32_t> registers_by_value_;
+    std::vector<unsigned> table_items_;
+    std::vector<BitRange> bit_ranges_;
+
+    FrozenISA() = default;
+
+    auto string(StringRef ref) const -> std::string_view {
+        return std::string_view(strings_.data() + ref.offset, ref.size);
+    }
+
+    /// Sorts the entries of `map` by name and builds its index. If several entries have the same
+    /// name, the first one is indexed.
+    template <class Entry>
+    void build_index(NameMap<Entry> &map) const;
+
+    /// Returns the entry of `map` whose name is `name`, or `nullptr` if there is none.
+    template <class Entry>
+    auto find_entry(NameMap<Entry> const &map, std::string_view name) const -> Entry const *;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_FROZEN_ISA_HPP
@@ -1,7 +1,9 @@
 #ifndef SASSAS_ISA_FUNCTIONAL_UNIT_HPP
 #define SASSAS_ISA_FUNCTIONAL_UNIT_HPP
 
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <string>
@@ -11,6 +13,27 @@
 #include <vector>
 
 namespace sassas {
+/// Represents the raw bits of a single encoded instruction. The instructions described by the ISA
+/// description files are at most 128 bits wide, so we store them as two 64-bit words, where
+/// `words[0]` holds bits 0-63 and `words[1]` holds bits 64-127. For narrower encodings, the unused
+/// high bits are always zero.
+struct InstructionWord {
+    std::array<std::uint64_t, 2> words {};
+
+    auto bit(unsigned index) const -> bool {
+        assert(index < 128 && "Bit index out of range");
+        return (words[index / 64] >> (index % 64)) & 1;
+    }
+
+    void set_bit(unsigned index, bool value) {
+        assert(index < 128 && "Bit index out of range");
+        std::uint64_t const mask = static_cast<std::uint64_t>(1) << (index % 64);
+        words[index / 64] = value ? (words[index / 64] | mask) : (words[index / 64] & ~mask);
+    }
+
+    auto operator==(InstructionWord const &other) const -> bool = default;
+};
+
 /// Represents a range of bits in a bitmask.
 struct BitRange {
     unsigned start;
@@ -38,6 +61,20 @@ public:
     /// `one`.
     explicit BitMask(std::string_view str_description, char zero = '.', char one = 'X');
 
+    /// Returns the total number of bits covered by the mask, i.e. the width of the field it
+    /// describes.
+    auto width() const -> unsigned;
+
+    /// Extracts the value of the field described by this mask from `word`. The ranges are stored
+    /// from the most significant part of the field to the least significant part, which is the
+    /// order in which they appear in the bitmask string.
+    auto extract(InstructionWord const &word) const -> std::uint64_t;
+
+    /// Writes the low `width()` bits of `value` into the bits of `word` covered by this mask. Bits
+    /// not covered by the mask are left untouched. The caller is responsible for checking that
+    /// `value` fits into the field.
+    void insert(InstructionWord &word, std::uint64_t value) const;
+
     /// Dumps the contents of the bitmask to the standard output. It prints the ranges in reverse
     /// order, so that the least significant bit is printed first. It is used for debugging
     /// purposes.
@@ -78,6 +115,10 @@ public:
         }
     }
 
+    auto bitmasks() const -> std::unordered_map<std::string, BitMask> const & {
+        return bitmasks_;
+    }
+
     /// Dumps the contents of this object to the standard output. It prints the name and encoding
     /// width of the functional unit, as well as the bitmasks it contains. It is used for debugging
     /// purposes.
@@ -0,0 +1,191 @@
+#ifndef SASSAS_ISA_INSTRUCTION_CLASS_HPP
+#define SASSAS_ISA_INSTRUCTION_CLASS_HPP
+
+#include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/expression.hpp"
+#include "sassas/isa/functional_unit.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// Represents one item in the `FORMAT` section of an instruction class. For example, the format
+///
+///     FORMAT PREDICATE @[!]Predicate(PT):Pg Opcode /FTZ(noFTZ):ftz
+///         Register:Rd ',' [-][||]Register:Ra {/REUSE(noreuse):reuse_src_a}
+///
+/// consists of a predicate operand `Pg`, the opcode, a modifier `ftz`, a register operand `Rd`, the
+/// literal `,`, a register operand `Ra` that may be negated or wrapped in `|...|`, and an optional
+/// modifier `reuse_src_a`.
+struct FormatItem {
+    enum Kind : std::uint8_t {
+        /// The opcode of the instruction, written as `Opcode` in the format.
+        Opcode,
+        /// A modifier written as `/Category(default):name`. In the assembly text, it is written as
+        /// a `.NAME` suffix of the opcode or the preceding operand.
+        Modifier,
+        /// A register operand written as `Category(default):name`. `Category` is a register
+        /// category in the `REGISTERS` section.
+        Register,
+        /// An immediate operand written as `Type(bits/default):name`, such as `SImm(24):imm`.
+        Immediate,
+        /// A literal that must appear verbatim in the assembly text, such as `','` or `'['`.
+        Literal,
+    };
+
+    /// The prefixes that can be applied to an operand, written as `[-]`, `[||]`, `[!]` and `[~]`
+    /// in the format. Each prefix has its own operand slot named `name@negate`, `name@absolute`,
+    /// `name@not` and `name@invert` respectively.
+    enum Prefix : std::uint8_t {
+        NoPrefix = 0,
+        Negate = 1 << 0,
+        Absolute = 1 << 1,
+        Not = 1 << 2,
+        Invert = 1 << 3,
+    };
+
+    Kind kind;
+    /// The combination of `Prefix` values applicable to this operand.
+    std::uint8_t prefixes = NoPrefix;
+    /// Whether the item is enclosed in `{...}`, i.e. it can be omitted in the assembly text.
+    bool is_optional = false;
+    /// Whether the item is enclosed in `$(...)$`. These items describe the scheduling information
+    /// of the instruction and are not written in the instruction text.
+    bool is_scheduling = false;
+    /// Whether this is the guard predicate introduced by `PREDICATE @`.
+    bool is_predicate = false;
+    /// For registers and modifiers, the register category. For immediates, the immediate type
+    /// (e.g. `SImm`). For literals, the literal text.
+    std::string type;
+    /// The name of the operand, which is used to refer to it in the `CONDITIONS` and `ENCODING`
+    /// sections.
+    std::string name;
+    /// The default register name for registers and modifiers, e.g. `PT` in `Predicate(PT):Pg`.
+    std::optional<std::string> default_name;
+    /// The default value for immediates, e.g. `0x7` in `UImm(3/0x7):src_rel_sb`.
+    std::optional<std::int64_t> default_value;
+    /// The width of immediates, e.g. `24` in `SImm(24):imm`.
+    unsigned bits = 0;
+    /// The operand slot of this item in the owning `InstructionClass`.
+    unsigned slot = 0;
+
+    /// Returns whether this is an immediate whose value is interpreted as a signed integer.
+    auto is_signed_immediate() const -> bool {
+        return kind == Immediate && (type.starts_with('S') || type.starts_with("RS"));
+    }
+
+    /// Returns whether this is an immediate whose value is relative to the address of the next
+    /// instruction, such as the `RSImm` target of a branch.
+    auto is_relative_immediate() const -> bool {
+        return kind == Immediate && type.starts_with('R');
+    }
+
+    /// Returns whether this is an immediate whose value is a floating-point number.
+    auto is_float_immediate() const -> bool {
+        return kind == Immediate && type.starts_with('F');
+    }
+};
+
+/// Represents one item in the `CONDITIONS` section of an instruction class, which has the form
+///
+///     condition_type_name expression : "message"
+///
+/// The condition is satisfied if the expression evaluates to a non-zero value.
+struct Condition {
+    /// The kind of the condition, taken from the `ConditionType` named by `type_name`.
+    ConditionType::Kind kind;
+    std::string type_name;
+    Expr expr;
+    std::string message;
+};
+
+/// Represents one assignment in the `ENCODING` section of an instruction class, which has the form
+///
+///     field_name = expression;
+///
+/// where `field_name` is the name of a bitmask in the `FUNIT` section. The form `!field_name;`
+/// means that the field must be zero, and is represented by an integer expression `0`.
+struct EncodingAssignment {
+    std::string field_name;
+    /// A copy of the bitmask named by `field_name`.
+    BitMask field;
+    Expr value;
+};
+
+/// Represents a `CLASS` (or `ALTERNATE CLASS`) section in the instruction description file, which
+/// describes the assembly syntax, the constraints, and the encoding of a group of instructions.
+///
+/// All operands of the class are assigned a slot index, in the order they appear in the `FORMAT`
+/// section. The values of the operands are passed around as a `std::span<std::int64_t const>`
+/// indexed by these slots, so that expressions can refer to them without any lookup by name. The
+/// opcode itself is always in slot `OPCODE_SLOT`.
+struct InstructionClass {
+    static constexpr unsigned OPCODE_SLOT = 0;
+
+    std::string name;
+    /// Whether the class is introduced by `ALTERNATE CLASS`.
+    bool is_alternate = false;
+    std::vector<FormatItem> format;
+    /// The names of the operand slots. The prefixes of an operand have their own slots, named
+    /// `name@negate` and so on.
+    std::vector<std::string> slot_names;
+    /// The conditions of this class. All conditions of kind `ConditionType::Error` are stored
+    /// before the other ones, so that the validation can skip warnings and infos by only looking
+    /// at the first `error_condition_count` items.
+    std::vector<Condition> conditions;
+    unsigned error_condition_count = 0;
+    /// The opcodes in the `OPCODES` section, as a list of name and value pairs.
+    std::vector<std::pair<std::string, std::uint64_t>> opcodes;
+    std::vector<EncodingAssignment> encodings;
+
+    /// Returns the slot index of the operand named `slot_name`, or `std::nullopt` if there is no
+    /// such operand.
+    auto find_slot(std::string_view slot_name) const -> std::optional<unsigned> {
+        if (auto const iter = std::ranges::find(slot_names, slot_name); iter != slot_names.end()) {
+            return static_cast<unsigned>(iter - slot_names.begin());
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /// Returns the slot index of the operand named `slot_name`. If there is no such operand, a new
+    /// slot is created.
+    auto get_or_add_slot(std::string_view slot_name) -> unsigned {
+        if (auto const slot = find_slot(slot_name)) {
+            return *slot;
+        }
+
+        slot_names.emplace_back(slot_name);
+        return static_cast<unsigned>(slot_names.size() - 1);
+    }
+
+    /// Returns the conditions of kind `ConditionType::Error`.
+    auto error_conditions() const -> std::span<Condition const> {
+        return std::span(conditions).first(error_condition_count);
+    }
+
+    /// Returns the value of the opcode named `opcode_name`, or `std::nullopt` if the class has no
+    /// such opcode.
+    auto find_opcode(std::string_view opcode_name) const -> std::optional<std::uint64_t> {
+        auto const iter =
+            std::ranges::find(opcodes, opcode_name, &std::pair<std::string, std::uint64_t>::first);
+        if (iter != opcodes.end()) {
+            return iter->second;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /// Dumps the contents of this object to the standard output. It is used for debugging
+    /// purposes.
+    void dump(unsigned indent) const;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_INSTRUCTION_CLASS_HPP
@@ -4,6 +4,7 @@
 #include "sassas/isa/architecture.hpp"
 #include "sassas/isa/condition_type.hpp"
 #include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
 #include "sassas/isa/register.hpp"
 #include "sassas/isa/table.hpp"
 
@@ -51,6 +52,9 @@ struct ISA {
     std::vector<std::string> operation_properties, operation_predicates;
     /// The `FunctionalUnit` object represents the contents of the `FUNIT` section in the file.
     FunctionalUnit functional_unit;
+    /// The instruction classes parsed from the `CLASS` and `ALTERNATE CLASS` sections, in the order
+    /// they appear in the file.
+    std::vector<InstructionClass> classes;
 
     /// Dumps the contents of this object to the standard output. It is used for debugging purposes.
     void dump() const;
@@ -0,0 +1,38 @@
+#ifndef SASSAS_ISA_ISA_IMAGE_HPP
+#define SASSAS_ISA_ISA_IMAGE_HPP
+
+#include "sassas/isa/isa.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// Converts an `ISA` to and from a flat, relocatable image: a sequence of little-endian integers
+/// and length-prefixed strings with no pointers in it, so it can be copied anywhere, such as into
+/// a shared memory object mapped at a different address in each process.
+///
+/// Reading an image rebuilds the same `ISA` that was written, without lexing, parsing or resolving
+/// any name, which makes it much cheaper than parsing the description file again. The reader
+/// checks every length and index against the image, so a truncated or corrupted image is rejected
+/// rather than trusted.
+class ISAImage {
+public:
+    /// Identifies an image, and changes whenever the layout of the image changes.
+    static constexpr std::uint32_t MAGIC = 0x41534953;  // "SISA"
+    static constexpr std::uint32_t VERSION = 1;
+
+    /// Returns the image of `isa`.
+    static auto write(ISA const &isa) -> std::vector<std::byte>;
+
+    /// Rebuilds the ISA from `image`. Returns `std::nullopt` if the image is malformed, in which
+    /// case `error` describes the problem.
+    static auto read(std::span<std::byte const> image, std::string_view &error)
+        -> std::optional<ISA>;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_ISA_IMAGE_HPP
@@ -0,0 +1,120 @@
+#ifndef SASSAS_ISA_ISA_REGISTRY_HPP
+#define SASSAS_ISA_ISA_REGISTRY_HPP
+
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/structure_pool.hpp"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// A version of the ISA of an architecture in an `ISARegistry`, together with its frozen form. The
+/// ISA is frozen once when it is loaded, and the encoders and decoders created for it share the
+/// frozen form.
+struct LoadedISA {
+    ISA isa;
+    FrozenISA frozen;
+};
+
+/// The ISAs of several architectures, loaded on demand and shared by all threads of a process.
+///
+/// An architecture is identified by the name of its instruction description, such as `sm_90`. The
+/// ISA of an architecture is loaded the first time it is asked for, at most once: when several
+/// threads ask for the same architecture at the same time, one of them loads it and the others
+/// wait for it, while different architectures are loaded concurrently. A failed load is remembered
+/// too, so it is reported only once.
+///
+/// The loaded ISAs are immutable, and are handed out as shared pointers. Lookups of loaded ISAs do
+/// not take the mutex of the registry: it publishes an immutable snapshot of the loaded
+/// architectures through a `std::atomic<std::shared_ptr>`, and replaces it with a new one after
+/// each load. A snapshot is freed once the last reader is done with it. The atomic shared pointer
+/// is not lock-free in the common standard libraries (libstdc++ guards the reference count with a
+/// spin lock held for a few instructions), so a lookup may briefly spin while another thread loads
+/// or stores the pointer, but it never waits for an ISA to be loaded or for the registry's mutex.
+///
+/// An architecture can be given a new version of its ISA with `replace()`, e.g. when its
+/// instruction description is edited. The new version is published atomically: lookups from then
+/// on return it, while whoever got the old version keeps using it. An old version is freed when the
+/// last pointer to it is released, so a reload never pulls an ISA from under a request in flight,
+/// and a daemon that reloads its ISAs for a long time only keeps the versions in use.
+///
+/// The tables and register groups of the loaded ISAs are interned into a `StructurePool`, so the
+/// ones that are the same for several architectures are stored once.
+class ISARegistry {
+public:
+    /// Loads the ISA of an architecture such as `sm_90`. It returns `std::nullopt` if the ISA
+    /// cannot be loaded, after reporting the problem. It may be called from any thread.
+    using Loader = std::function<std::optional<ISA>(std::string_view arch)>;
+
+    explicit ISARegistry(Loader loader);
+
+    ISARegistry(ISARegistry const &) = delete;
+    auto operator=(ISARegistry const &) -> ISARegistry & = delete;
+
+    /// Returns the ISA of `arch`, loading it if it is not loaded yet. Returns `nullptr` if it
+    /// cannot be loaded.
+    auto get(std::string_view arch) -> std::shared_ptr<LoadedISA const>;
+
+    /// Returns the ISA of `arch` if it is already loaded, and `nullptr` otherwise. It never waits
+    /// for a load.
+    auto find(std::string_view arch) const -> std::shared_ptr<LoadedISA const>;
+
+    /// Returns a loaded ISA whose `ARCHITECTURE` section has the name `name` (such as `Hopper`),
+    /// or `nullptr` if there is none. It never waits for a load.
+    auto find_by_architecture_name(std::string_view name) const
+        -> std::shared_ptr<LoadedISA const>;
+
+    /// Publishes `isa` as the new version of the ISA of `arch`, and returns it. If `arch` is being
+    /// loaded, it waits for the load to finish first; if it has not been asked for yet, it is
+    /// never loaded. It may be called from any thread.
+    auto replace(std::string_view arch, ISA isa) -> std::shared_ptr<LoadedISA const>;
+
+private:
+    struct Entry {
+        std::string arch;
+        /// The ISA of the architecture, or `nullptr` if it failed to load.
+        std::shared_ptr<LoadedISA const> isa;
+    };
+
+    /// The architectures that are loaded (or failed to load), sorted by `arch`.
+    using Snapshot = std::vector<Entry>;
+
+    /// The state of an architecture that has been asked for.
+    struct Slot {
+        std::once_flag once;
+    };
+
+    Loader loader_;
+    StructurePool pool_;
+    std::atomic<std::shared_ptr<Snapshot const>> snapshot_;
+
+    /// Guards `slots_`, and serializes the publication of snapshots. It is never held while an ISA
+    /// is loaded.
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Slot>, std::less<>> slots_;
+
+    /// Returns the slot of `arch`, creating it if needed.
+    auto get_slot(std::string_view arch) -> Slot &;
+
+    /// Publishes a snapshot in which the entry of `arch` is `isa`. `mutex_` must be held.
+    void publish(std::string_view arch, std::shared_ptr<LoadedISA const> isa);
+
+    /// Interns the tables of `isa` into `pool_`, and freezes it.
+    auto prepare(ISA isa) -> std::shared_ptr<LoadedISA const>;
+
+    /// Returns the ISA of `arch` in the current snapshot (`nullptr` if it failed to load), or
+    /// `std::nullopt` if it has not been loaded.
+    auto find_entry(std::string_view arch) const
+        -> std::optional<std::shared_ptr<LoadedISA const>>;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_ISA_REGISTRY_HPP
@@ -1,8 +1,11 @@
 #ifndef SASSAS_ISA_REGISTER_HPP
 #define SASSAS_ISA_REGISTER_HPP
 
+#include <cassert>
+#include <cstddef>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -16,6 +19,8 @@ struct Register {
 
     Register() = default;
     Register(std::string name, unsigned value) : name(std::move(name)), value(value) { }
+
+    friend auto operator==(Register const &lhs, Register const &rhs) -> bool = default;
 };
 
 /// This class represents all registers that belong to the same category, where each register name
@@ -23,32 +28,44 @@ struct Register {
 ///
 /// A value may correspond to multiple names, so we must follow a specific search order, which is
 /// why we cannot use `map` or `unordered_map`.
+///
+/// Like the items of a `Table`, the registers are shared by the copies of a group until one of them
+/// is modified, so identical groups of several ISAs can be stored once (see `StructurePool`).
 class RegisterGroup {
 public:
+    RegisterGroup() : registers_(std::make_shared<std::vector<Register>>()) { }
+
+    // A copy shares the registers, so it is almost as cheap as a move, and unlike a move, it never
+    // leaves a group without storage.
+    RegisterGroup(RegisterGroup const &) = default;
+    auto operator=(RegisterGroup const &) -> RegisterGroup & = default;
+
     /// Returns the list of registers in this group. It can be used to dump the contents of this
     /// object.
     auto registers() const -> std::vector<Register> const & {
-        return registers_;
+        return *registers_;
     }
 
     /// Adds a new register to the end of the registers list.
     void append_register(std::string name, unsigned value) {
-        registers_.emplace_back(std::move(name), value);
+        mutable_registers().emplace_back(std::move(name), value);
     }
 
     /// Adds a new register to the end of the registers list. The `value` is optional and defaults
     /// to the last register value + 1. If the list of registers is empty, the default value is 0.
     void append_register(std::string name) {
-        append_register(std::move(name), registers_.empty() ? 0 : registers_.back().value + 1);
+        append_register(std::move(name), registers_->empty() ? 0 : registers_->back().value + 1);
     }
 
     /// Concatenates the contents of another `RegisterGroup` object to this one. The `other` object
     /// is moved into this object. Registers in `other` are appended to the end of this object.
     void concat_with(RegisterGroup other) {
-        registers_.insert(
-            registers_.end(),
-            std::make_move_iterator(other.registers_.begin()),
-            std::make_move_iterator(other.registers_.end())
+        std::vector<Register> &registers = mutable_registers();
+        std::vector<Register> &other_registers = other.mutable_registers();
+        registers.insert(
+            registers.end(),
+            std::make_move_iterator(other_registers.begin()),
+            std::make_move_iterator(other_registers.end())
         );
     }
 
@@ -64,13 +81,41 @@ public:
     /// name that matches the value. If no register is found, returns `std::nullopt`.
     auto find(unsigned value) const -> std::optional<std::reference_wrapper<std::string const>>;
 
+    /// Returns whether the two groups have the same registers in the same order.
+    friend auto operator==(RegisterGroup const &lhs, RegisterGroup const &rhs) -> bool {
+        return lhs.registers_ == rhs.registers_ || *lhs.registers_ == *rhs.registers_;
+    }
+
+    /// Returns a hash of the registers of the group, which is the same for equal groups.
+    auto hash() const -> std::size_t;
+
+    /// Makes this group share the registers of `other`, which must be equal to it, and releases its
+    /// own.
+    void share_registers_with(RegisterGroup const &other) {
+        assert(*this == other && "Only equal register groups can share their registers");
+        registers_ = other.registers_;
+    }
+
+    /// Returns whether another group shares the registers of this one.
+    auto is_shared() const -> bool {
+        return registers_.use_count() > 1;
+    }
+
     /// Dumps the contents of this object to the standard output. It prints the name and value of
     /// each register in the list. This function prints 5 registers per line and aligns the columns.
     /// It is used for debugging purposes.
     void dump(unsigned indent) const;
 
 private:
-    std::vector<Register> registers_;
+    std::shared_ptr<std::vector<Register>> registers_;
+
+    /// Returns the registers for modification, copying them first if they are shared.
+    auto mutable_registers() -> std::vector<Register> & {
+        if (registers_.use_count() != 1) {
+            registers_ = std::make_shared<std::vector<Register>>(*registers_);
+        }
+        return *registers_;
+    }
 };
 }  // namespace sassas
 
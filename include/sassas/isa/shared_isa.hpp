@@ -0,0 +1,33 @@
+#ifndef SASSAS_ISA_SHARED_ISA_HPP
+#define SASSAS_ISA_SHARED_ISA_HPP
+
+#include "sassas/isa/isa.hpp"
+
+#include <functional>
+#include <optional>
+#include <string_view>
+
+namespace sassas {
+/// Returns the ISA of `arch`, whose instruction description file contains `description`, without
+/// parsing it if another process already did.
+///
+/// The first process to ask for a description parses it with `parse`, and publishes the
+/// `ISAImage` of the result in a POSIX shared memory object named after `arch` and a hash of
+/// `description` (and of the image version), so an edited description or a newer `sassas` never
+/// picks up a stale image. Later processes map the object read-only and read the image, which
+/// skips lexing and parsing entirely.
+///
+/// The object is created exclusively, and its header carries a ready flag that is only set, with
+/// release semantics, once the image is complete; so concurrent processes never read a partial
+/// image, and the ones that lose the race simply parse for themselves. Only objects owned by the
+/// current user are trusted. Whenever anything goes wrong (no shared memory on this platform, an
+/// object that is unreadable, corrupted or abandoned half-written), the description is parsed
+/// locally, so sharing only ever saves time.
+auto load_shared_isa(
+    std::string_view arch,
+    std::string_view description,
+    std::function<std::optional<ISA>()> const &parse
+) -> std::optional<ISA>;
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_SHARED_ISA_HPP
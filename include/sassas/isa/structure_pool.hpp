@@ -0,0 +1,44 @@
+#ifndef SASSAS_ISA_STRUCTURE_POOL_HPP
+#define SASSAS_ISA_STRUCTURE_POOL_HPP
+
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/register.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace sassas {
+/// Shares identical tables and register groups between ISAs.
+///
+/// Most of the `TABLES` and `REGISTERS` sections are the same for adjacent architectures. The pool
+/// keeps a copy of each distinct table and register group it has seen, keyed by a hash of its
+/// contents, and `intern()` makes the tables and register groups of an ISA share the storage of
+/// the equal ones in the pool. So each distinct structure is stored once, no matter how many ISAs
+/// use it, and loading another architecture only costs its differences.
+///
+/// A structure that no ISA uses anymore, e.g. a table of a version of an ISA that was replaced, is
+/// dropped from the pool the next time an ISA is interned. So a daemon that reloads its ISAs for a
+/// long time only keeps the structures of the versions in use, and those of the versions retired
+/// since the last reload.
+///
+/// The pool may be used from several threads at once.
+class StructurePool {
+public:
+    /// Makes the tables and register groups of `isa` share the storage of equal ones that were
+    /// interned before, and adds the others to the pool. Drops the structures no ISA uses anymore.
+    void intern(ISA &isa);
+
+private:
+    std::mutex mutex_;
+    /// The distinct tables and register groups, grouped by their hash. The copies share the
+    /// storage of the originals, so a structure whose storage is not shared is only used by the
+    /// pool.
+    std::unordered_map<std::size_t, std::vector<Table>> tables_;
+    std::unordered_map<std::size_t, std::vector<RegisterGroup>> register_groups_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_ISA_STRUCTURE_POOL_HPP
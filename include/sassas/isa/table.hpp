@@ -2,11 +2,42 @@
 #define SASSAS_ISA_TABLE_HPP
 
 #include <cassert>
+#include <cstddef>
+#include <memory>
 #include <optional>
 #include <span>
 #include <vector>
 
 namespace sassas {
+/// A read-only view of the items of a table, laid out as in `Table`. It is what both `Table` and
+/// `FrozenISA` look up their items with.
+class TableView {
+public:
+    TableView(std::span<unsigned const> content, unsigned key_size) :
+        content_(content), key_size_(key_size) { }
+
+    auto key_size() const -> unsigned {
+        return key_size_;
+    }
+
+    /// Returns the keys and the value of each item, one item after the other.
+    auto items() const -> std::span<unsigned const> {
+        return content_;
+    }
+
+    /// Returns the value of the first item whose keys match `keys`, or `std::nullopt` if there is
+    /// no such item.
+    auto get_value(std::span<unsigned const> keys) const -> std::optional<unsigned>;
+
+    /// Returns the keys of the first item whose value is `value`, or `std::nullopt` if there is no
+    /// such item. The returned keys may contain `Table::MATCH_ANY`.
+    auto find_keys(unsigned value) const -> std::optional<std::span<unsigned const>>;
+
+private:
+    std::span<unsigned const> content_;
+    unsigned key_size_;
+};
+
 /// Represents a table in the `TABLES` section of the ISA description file.
 ///
 /// The table is defined as a mapping from an arbitrary number of keys to a single value, where both
@@ -23,10 +54,20 @@ namespace sassas {
 ///     2 1 0 -> 5
 ///
 /// we store it as {1, 0, 0, 2, 2, 0, 5, 2, 1, 0, 5}, where `key_size_` is 3.
+///
+/// The items are shared by the copies of a table until one of them is modified, which only happens
+/// while the table is parsed. This lets identical tables of several ISAs be stored once (see
+/// `StructurePool`).
 class Table {
 public:
-    Table() : key_size_(0) { }
-    explicit Table(unsigned key_size) : key_size_(key_size) { }
+    Table() : Table(0) { }
+    explicit Table(unsigned key_size) :
+        content_(std::make_shared<std::vector<unsigned>>()), key_size_(key_size) { }
+
+    // A copy shares the items, so it is almost as cheap as a move, and unlike a move, it never
+    // leaves a table without storage.
+    Table(Table const &) = default;
+    auto operator=(Table const &) -> Table & = default;
 
     void set_key_size(unsigned key_size) {
         key_size_ = key_size;
@@ -39,20 +80,64 @@ public:
     void append_item(std::span<unsigned const> keys, unsigned value) {
         assert(keys.size() == key_size_ && "Key size mismatch");
 
-        content_.insert(content_.end(), keys.begin(), keys.end());
-        content_.push_back(value);
+        std::vector<unsigned> &content = mutable_content();
+        content.insert(content.end(), keys.begin(), keys.end());
+        content.push_back(value);
     }
 
-    auto get_value(std::span<unsigned const> keys) const -> std::optional<unsigned>;
+    /// Returns a view of the items, which stays valid until the table is modified or destroyed.
+    auto view() const -> TableView {
+        return TableView(*content_, key_size_);
+    }
+
+    auto get_value(std::span<unsigned const> keys) const -> std::optional<unsigned> {
+        return view().get_value(keys);
+    }
+
+    /// Performs a reverse lookup in the table. Returns the keys of the first item whose value is
+    /// `value`, or `std::nullopt` if there is no such item. The returned keys may contain
+    /// `MATCH_ANY`.
+    auto find_keys(unsigned value) const -> std::optional<std::span<unsigned const>> {
+        return view().find_keys(value);
+    }
+
+    /// Returns whether the two tables have the same items.
+    friend auto operator==(Table const &lhs, Table const &rhs) -> bool {
+        return lhs.key_size_ == rhs.key_size_
+            && (lhs.content_ == rhs.content_ || *lhs.content_ == *rhs.content_);
+    }
+
+    /// Returns a hash of the items of the table, which is the same for equal tables.
+    auto hash() const -> std::size_t;
+
+    /// Makes this table share the items of `other`, which must be equal to it, and releases its
+    /// own.
+    void share_items_with(Table const &other) {
+        assert(*this == other && "Only equal tables can share their items");
+        content_ = other.content_;
+    }
+
+    /// Returns whether another table shares the items of this one.
+    auto is_shared() const -> bool {
+        return content_.use_count() > 1;
+    }
 
     /// Dumps the content of the table to the standard output. It will align the output to the
     /// specified indentation level. It is used for debugging purposes.
     void dump(unsigned indent) const;
 
 private:
-    std::vector<unsigned> content_;
+    std::shared_ptr<std::vector<unsigned>> content_;
     unsigned key_size_;
 
+    /// Returns the items for modification, copying them first if they are shared.
+    auto mutable_content() -> std::vector<unsigned> & {
+        if (content_.use_count() != 1) {
+            content_ = std::make_shared<std::vector<unsigned>>(*content_);
+        }
+        return *content_;
+    }
+
 public:
     static constexpr unsigned MATCH_ANY = static_cast<unsigned>(-1);
 };
@@ -11,7 +11,11 @@
 namespace sassas {
 class Lexer {
 public:
-    explicit Lexer(std::string_view source) : source_(source), current_(source.begin()) { }
+    /// Creates a lexer for `source`. If `skip_comments` is `true`, C-style comments (`// ...` and
+    /// `/* ... */`) are skipped like whitespace. The instruction description files have no
+    /// comments, but the SASS source produced by disassemblers uses them for offsets and encodings.
+    explicit Lexer(std::string_view source, bool skip_comments = false) :
+        source_(source), current_(source.begin()), skip_comments_(skip_comments) { }
 
     auto source() const -> std::string_view {
         return source_;
@@ -62,6 +66,11 @@ private:
     std::string_view::const_iterator current_;
     /// Caches the last parsed token.
     Token cur_token_;
+    bool skip_comments_;
+
+    /// Moves `current_` past the whitespace, and also past the comments if `skip_comments_` is
+    /// set. An unterminated block comment extends to the end of the source.
+    void skip_whitespace();
 
     /// Creates a `Token` object of type `kind`. The range of the token is [begin, current_).
     auto form_token(Token::TokenKind kind, std::string_view::const_iterator begin) const -> Token {
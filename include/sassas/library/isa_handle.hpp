@@ -0,0 +1,135 @@
+#ifndef SASSAS_LIBRARY_ISA_HANDLE_HPP
+#define SASSAS_LIBRARY_ISA_HANDLE_HPP
+
+#include "sassas/encoder/encoder.hpp"
+#include "sassas/encoder/instruction_patcher.hpp"
+#include "sassas/isa/isa.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// The outcome of a call of `ISAHandle` that writes into memory provided by the caller.
+struct OutputResult {
+    /// Whether the call succeeded, i.e. no error was reported.
+    bool success = false;
+    /// The size of the whole output, in bytes. It is also set if the output did not fit, in which
+    /// case nothing was written and the call can be repeated with a buffer of this size.
+    std::size_t size = 0;
+    /// Whether the output was written, i.e. it fit into the buffer.
+    bool written = false;
+    /// The diagnostics, rendered as the command line prints them.
+    std::string diagnostics;
+};
+
+/// The entry point for using the assembler as a library, e.g. from a JIT compiler that cannot
+/// afford to launch a `sassas` process for each kernel.
+///
+/// A handle holds an ISA, loaded once from an instruction description file, a description in
+/// memory or an image written by `ISAImage` (see `image()`), or adopted from the caller; together
+/// with the assembler, disassembler and patcher of the ISA, which are created when they are first
+/// used.
+/// Copies of a handle share all of them, and every member function may be called from any number
+/// of threads at once, since none of them changes the handle.
+///
+/// The inputs and outputs are buffers in memory: nothing is read from or written to files, except
+/// the description file named in `load_file()`, and nothing is printed.
+class ISAHandle {
+public:
+    /// Loads the instruction description file at `path`. Returns `std::nullopt` if it cannot be
+    /// read or parsed, and appends the rendered diagnostics to `diagnostics`.
+    static auto load_file(char const *path, std::string &diagnostics) -> std::optional<ISAHandle>;
+
+    /// Parses `description`, the contents of an instruction description file whose name used in
+    /// diagnostics is `origin`, as `load_file()` does.
+    static auto load_description(
+        std::string_view description,
+        std::string_view origin,
+        std::string &diagnostics
+    ) -> std::optional<ISAHandle>;
+
+    /// Reads the ISA from `image`, which was written by `image()` (possibly by another process),
+    /// which skips parsing. Returns `std::nullopt` if the image is malformed or was written by
+    /// another version of the library, and appends the problem to `diagnostics`.
+    static auto load_image(std::span<std::byte const> image, std::string &diagnostics)
+        -> std::optional<ISAHandle>;
+
+    /// Takes over `isa`, which the caller has already loaded.
+    static auto adopt(ISA isa) -> ISAHandle;
+
+    auto isa() const -> ISA const &;
+
+    /// Returns the size of an instruction word in bytes.
+    auto instruction_size() const -> unsigned;
+
+    /// Returns the image of the ISA, which can be stored and passed to `load_image()` later.
+    auto image() const -> std::vector<std::byte>;
+
+    /// Assembles `source`, a SASS file whose name used in diagnostics is `origin`, into `output`,
+    /// on up to `thread_count` threads. The instruction words of all sections are written one after
+    /// another, `instruction_size()` little-endian bytes each, as `sassas -o file` writes them.
+    ///
+    /// Nothing is written if an error is reported, or if the words do not fit into `output`.
+    auto assemble(
+        std::string_view source,
+        std::string_view origin,
+        std::span<std::byte> output,
+        ValidationLevel level = ValidationLevel::Full,
+        unsigned thread_count = 1
+    ) const -> OutputResult;
+
+    /// Disassembles the instruction words in `code`, the first of which is at `offset` in its
+    /// section, into SASS text in `output`. Words that are not valid instructions are written as
+    /// comments, so no error is ever reported; only the size of `output` matters.
+    auto disassemble(
+        std::span<std::byte const> code,
+        std::uint64_t offset,
+        std::span<char> output
+    ) const -> OutputResult;
+
+    /// Disassembles the executable sections of the cubin in `image` into SASS text in `output`, on
+    /// `thread_count` threads, as `sassas --disassemble` does. The cubin is decoded with the ISA of
+    /// the handle, whatever architecture it was built for.
+    auto disassemble_cubin(
+        std::span<std::byte const> image,
+        std::span<char> output,
+        unsigned thread_count = 1
+    ) const -> OutputResult;
+
+    /// Sets the operand named `operand` of the instruction at `offset` in the code section
+    /// `section` (such as `.text.kernel`) of the cubin in `image` to `value`, in place (see
+    /// `InstructionPatcher`). `image` is typically a copy of a mapped cubin. Only the conditions of
+    /// the instruction that involve the operand are checked, at `level`, and nothing is written
+    /// if an error is reported. The size of the result is the size of the instruction.
+    ///
+    /// Each call finds the section and decodes the instruction again; to produce many variants of
+    /// the same instruction, prepare the patch once with `patcher()` and apply it to each copy.
+    auto patch_cubin(
+        std::span<std::byte> image,
+        std::string_view section,
+        std::uint64_t offset,
+        std::string_view operand,
+        std::int64_t value,
+        ValidationLevel level = ValidationLevel::Full
+    ) const -> OutputResult;
+
+    /// Returns the patcher of the ISA, which lives as long as any copy of the handle.
+    auto patcher() const -> InstructionPatcher const &;
+
+private:
+    struct State;
+
+    explicit ISAHandle(std::shared_ptr<State const> state) : state_(std::move(state)) { }
+
+    std::shared_ptr<State const> state_;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_LIBRARY_ISA_HANDLE_HPP
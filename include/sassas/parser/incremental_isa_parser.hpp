@@ -0,0 +1,70 @@
+#ifndef SASSAS_PARSER_INCREMENTAL_ISA_PARSER_HPP
+#define SASSAS_PARSER_INCREMENTAL_ISA_PARSER_HPP
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+/// Parses successive versions of an instruction description file, re-parsing only the top-level
+/// sections whose text changed since the previous version.
+///
+/// The file is split into its top-level sections (`ARCHITECTURE`, `REGISTERS`, `TABLES`, each
+/// `CLASS`, ...), and each section is identified by a hash of its text. An instruction class is
+/// resolved against the other sections before it, so the hash of a class also covers the text of
+/// all sections before it that are not classes; a change to `REGISTERS`, say, re-parses every
+/// class after it, while a change to one class re-parses only that class. The parsed sections of
+/// the last successful parse are kept for the next one.
+///
+/// The result is always the ISA that `ISAParser::parse()` returns for the whole file. Whenever a
+/// section cannot be parsed on its own, the whole file is parsed with `ISAParser` instead, which
+/// also reports the diagnostics against the whole file.
+class IncrementalISAParser {
+public:
+    /// Receives the diagnostics of a failed parse, while the source is still alive.
+    using Reporter = std::function<void(Diag)>;
+
+    struct Statistics {
+        std::size_t sections = 0;
+        /// The sections that were parsed rather than taken from the previous version.
+        std::size_t parsed = 0;
+    };
+
+    /// `origin` names the file in diagnostics.
+    explicit IncrementalISAParser(std::string origin) : origin_(std::move(origin)) { }
+
+    /// Parses `source`, the current contents of the file. Returns `std::nullopt` after reporting
+    /// the diagnostics if it has errors, in which case the sections of the previous version are
+    /// forgotten.
+    auto parse(std::string_view source, Reporter const &report) -> std::optional<ISA>;
+
+    /// Returns the statistics of the last call to `parse()`.
+    auto last_statistics() const -> Statistics {
+        return statistics_;
+    }
+
+private:
+    std::string origin_;
+    /// The sections of the ISA that are not classes, keyed by the hash of the text of all such
+    /// sections up to one. Each value holds what the sections up to that one define, without any
+    /// class.
+    std::map<std::string, ISA, std::less<>> headers_;
+    /// The classes, keyed by the hash of their text and the sections before them.
+    std::map<std::string, InstructionClass, std::less<>> classes_;
+    Statistics statistics_;
+
+    /// Parses `source` section by section. Returns `std::nullopt` if a section cannot be parsed on
+    /// its own, without reporting anything.
+    auto parse_sections(std::string_view source) -> std::optional<ISA>;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_PARSER_INCREMENTAL_ISA_PARSER_HPP
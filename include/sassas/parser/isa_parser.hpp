@@ -3,13 +3,16 @@
 
 #include "sassas/isa/architecture.hpp"
 #include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/expression.hpp"
 #include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
 #include "sassas/isa/isa.hpp"
 #include "sassas/isa/register.hpp"
 #include "sassas/isa/table.hpp"
 #include "sassas/lexer/token.hpp"
 #include "sassas/parser/parser.hpp"
 
+#include <cstdint>
 #include <optional>
 #include <ranges>
 #include <string>
@@ -27,7 +30,28 @@ public:
     /// generated diagnostic information can be obtained through the `take_diagnostics()` method.
     auto parse() -> std::optional<ISA>;
 
+    /// Parses a source that consists of a single top-level section, such as one `CLASS`, into
+    /// `isa`, which holds the sections before it as `parse()` would see them. Returns `true` if
+    /// the section is parsed and nothing follows it. Otherwise `isa` may be partially updated,
+    /// and the diagnostics are those of the section alone.
+    auto parse_single_section(ISA &isa) -> bool;
+
 private:
+    /// The outcome of parsing a top-level section.
+    enum class SectionStatus {
+        /// The section is parsed, and the current token is the one after it.
+        Parsed,
+        /// The section has errors. The caller may recover at the next keyword.
+        Failed,
+        /// The current token cannot start a section, so the parsing cannot continue.
+        Aborted,
+        /// The current token is a keyword we do not parse, which ends the parsing.
+        Finished,
+    };
+
+    /// Parses the top-level section at the current token, and stores its contents in `result`.
+    auto parse_section(ISA &result) -> SectionStatus;
+
     /// This function is used for error recovery. It will lex until it encounters a token of the
     /// specified type. If it does not encounter the token, it generates diagnostic information. The
     /// function always returns `std::nullopt`.
@@ -279,6 +303,99 @@ public:
     /// it is a bitmask, we parse it normally; otherwise, we consider it an irrelevant item and skip
     /// it until we encounter a semicolon.
     auto parse_functional_unit() -> std::optional<FunctionalUnit>;
+
+private:
+    /// Parses the part of a format item after the optional `/` and prefixes, i.e.
+    ///
+    ///     Category(default)*:name
+    ///
+    /// where the parenthesized part, the `*` and the `:name` part are optional. For immediates,
+    /// the parenthesized part has the form `(bits/default)`. The kind of the item is determined by
+    /// looking up `Category` in the `REGISTERS` section of `isa`: register categories produce
+    /// `FormatItem::Register` (or `FormatItem::Modifier` if `is_modifier` is `true`), and names
+    /// ending with `Imm` (or `BITSET`) produce `FormatItem::Immediate`. A category followed by `[`,
+    /// such as `C:Sb[...]`, is the prefix of a constant bank reference and is kept as a literal.
+    ///
+    /// This function assumes that the current token is the category name. When it returns, the
+    /// current token is the token after the item.
+    auto parse_format_operand(ISA const &isa, bool is_modifier) -> std::optional<FormatItem>;
+
+    /// Parses the `FORMAT` section of an instruction class. The section is a sequence of format
+    /// items terminated by a semicolon. `{...}` encloses optional items, and `$(...)$` encloses
+    /// the scheduling items. The operand slots of all items are allocated in `instruction_class`.
+    auto parse_format(InstructionClass &instruction_class, ISA const &isa)
+        -> std::optional<std::vector<FormatItem>>;
+
+    /// Parses the expression starting at the current token and appends it to `expr` in postfix
+    /// order. Only binary operators with a precedence of at least `min_precedence` are consumed.
+    /// Names in the expression are resolved against `instruction_class` and `isa`:
+    ///
+    /// - `%NAME` and `$NAME` refer to items in the `PARAMETERS` and `CONSTANTS` sections.
+    /// - `` `Category@Name `` and `Category@Name` refer to a register value.
+    /// - `name@attribute` and `name` refer to operand slots of the class.
+    /// - `Name(arguments...)` is a lookup in the table `Name`.
+    ///
+    /// Names that cannot be resolved are kept as `Expr::Op::Unresolved` nodes instead of producing
+    /// diagnostics, since some of them (e.g. `%SHADER_TYPE`) describe the compilation environment
+    /// rather than the instruction. Returns `true` if an error occurred.
+    auto parse_expression_impl(
+        InstructionClass const &instruction_class,
+        ISA const &isa,
+        Expr &expr,
+        unsigned min_precedence
+    ) -> bool;
+
+    /// Parses a unary expression, i.e. a primary expression with optional prefix operators. It is
+    /// a helper function for `parse_expression_impl()`. Returns `true` if an error occurred.
+    auto parse_unary_expression(
+        InstructionClass const &instruction_class,
+        ISA const &isa,
+        Expr &expr
+    ) -> bool;
+
+    /// Parses an expression in the `CONDITIONS` or `ENCODING` section. See
+    /// `parse_expression_impl()` for the grammar.
+    auto parse_expression(InstructionClass const &instruction_class, ISA const &isa)
+        -> std::optional<Expr>;
+
+    /// Parses the `CONDITIONS` section of an instruction class. Each item starts with the name of
+    /// a condition type from the `CONDITION TYPES` section, followed by an expression, a colon and
+    /// a string message. The section ends at the next keyword.
+    auto parse_conditions(InstructionClass const &instruction_class, ISA const &isa)
+        -> std::optional<std::vector<Condition>>;
+
+    /// Parses the `OPCODES` section of an instruction class, which is a list of `name = value;`
+    /// items.
+    auto parse_opcodes() -> std::optional<std::vector<std::pair<std::string, std::uint64_t>>>;
+
+    /// Parses the `ENCODING` section of an instruction class. Each item has one of the forms
+    ///
+    ///     field = expression;
+    ///     field = expression SCALE factor;
+    ///     !field;
+    ///     field1, field2 = Function(argument1, argument2);
+    ///
+    /// where the fields are bitmasks in the `FUNIT` section. We do not fully understand the
+    /// functions used in the last form (e.g. `ConstBankAddress2`), so we treat them as assigning
+    /// each argument to the corresponding field.
+    auto parse_encoding(InstructionClass const &instruction_class, ISA const &isa)
+        -> std::optional<std::vector<EncodingAssignment>>;
+
+    /// Skips the contents of a section we do not interpret, such as the `PROPERTIES` and
+    /// `PREDICATES` sections of an instruction class. When the function returns, the current token
+    /// is the next keyword.
+    void skip_section();
+
+public:
+    /// Parses a `CLASS` section in the instruction description file. `isa` contains the sections
+    /// parsed so far, which are used to resolve the names in the class. `is_alternate` indicates
+    /// whether the class is introduced by `ALTERNATE CLASS`.
+    ///
+    /// A class consists of the `FORMAT`, `CONDITIONS`, `PROPERTIES`, `PREDICATES`, `OPCODES` and
+    /// `ENCODING` sections. We do not interpret `PROPERTIES` and `PREDICATES` yet, so they are
+    /// skipped.
+    auto parse_instruction_class(ISA const &isa, bool is_alternate)
+        -> std::optional<InstructionClass>;
 };
 }  // namespace sassas
 
@@ -5,6 +5,8 @@
 #include "sassas/lexer/lexer.hpp"
 #include "sassas/lexer/token.hpp"
 
+#include "annotate_snippets/annotated_source.hpp"
+
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -19,6 +21,7 @@ class Parser {
 public:
     explicit Parser(std::string_view origin, std::string_view source) :
         origin_(origin), lexer_(source) { }
+    virtual ~Parser() = default;
 
     /// Takes the diagnostic information generated during the parsing process and returns it as a
     /// vector of `Diag` objects. The returned vector is moved, so the caller should not expect to
@@ -44,6 +47,13 @@ protected:
     /// lifetime of the string is consistent with that of the `Parser` object.
     auto add_string(std::string_view content) -> std::string_view;
 
+    /// Creates an `ants::AnnotatedSource` of the source code with a primary annotation at the range
+    /// `[begin, end)`, labeled with `label`. All diagnostics of the parser annotate the source
+    /// through this function. It is virtual, so that parsers that only see a part of the source at
+    /// a time can annotate a copy of the relevant part instead.
+    virtual auto annotate_source(unsigned begin, unsigned end, std::string_view label = {})
+        -> ants::AnnotatedSource;
+
     /// Creates a `Diag` object and adds a primary annotation at the range of `target_range`. The
     /// diagnostic has level `level` and carries the message `message`. If `label` is not empty, the
     /// corresponding label is added to the label. If `note` is not empty, an additional diagnostic
@@ -55,7 +65,7 @@ protected:
         std::string_view message,
         std::string_view label = {},
         std::string_view note = {}
-    ) const -> Diag;
+    ) -> Diag;
 
     /// Creates a `Diag` object and adds a primary annotation at the range of `target`. This
     /// function is similar to the previous one, except that it uses the token itself to determine
@@ -66,7 +76,7 @@ protected:
         std::string_view message,
         std::string_view label = {},
         std::string_view note = {}
-    ) const -> Diag {
+    ) -> Diag {
         return create_diag_at_token(target.token_range(), level, message, label, note);
     }
 
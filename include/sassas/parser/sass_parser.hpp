@@ -0,0 +1,189 @@
+#ifndef SASSAS_PARSER_SASS_PARSER_HPP
+#define SASSAS_PARSER_SASS_PARSER_HPP
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/lexer/token.hpp"
+#include "sassas/parser/parser.hpp"
+
+#include "annotate_snippets/annotated_source.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// A token of a SASS instruction, after the raw tokens of the lexer have been normalized so that
+/// they do not depend on how the source is spaced. For example, the identifier `FADD.FTZ` is split
+/// into the name `FADD` and the modifier `FTZ`, and `-0x10` is merged into the integer `-16`.
+struct SassToken {
+    enum Kind : std::uint8_t {
+        /// A name such as a mnemonic, a register or a label. The text is stored in `text`.
+        Name,
+        /// A modifier written as `.NAME` after a name. The text (without the dot) is stored in
+        /// `text`.
+        Modifier,
+        /// An integer, whose value is stored in `value`.
+        Integer,
+        /// A punctuator, whose kind is stored in `punctuator`.
+        Punctuator,
+        /// A reference to a label written as `` `(.L_x_0) ``. The name of the label (with the
+        /// leading dot, if any) is stored in `text`.
+        Label,
+    };
+
+    Kind kind;
+    Token::TokenKind punctuator = Token::Unknown;
+    std::string_view text {};
+    std::int64_t value = 0;
+    TokenRange range {};
+};
+
+/// A statement in the SASS source.
+///
+/// The statement does not depend on the architecture. Instructions are stored as lists of
+/// `SassToken`s, which are bound to an instruction class by `InstructionMatcher`, so that the same
+/// parsed source can be encoded for any ISA.
+struct SassStatement {
+    enum Kind : std::uint8_t {
+        /// An instruction such as `@!P0 FADD.FTZ R2, R3, R4 ;`.
+        Instruction,
+        /// A label such as `.L_x_1:`. The name (with the leading dot, if any) is stored in `name`.
+        Label,
+        /// A label that starts a section of code, such as `.text.kernel:`. The name of the section
+        /// (`.text.kernel`) is stored in `name`.
+        Section,
+    };
+
+    Kind kind;
+    /// The range of the statement in the source, which is used for diagnostics.
+    TokenRange range {};
+    std::string_view name {};
+    /// The name of the guard predicate of an instruction, e.g. `P0` in `@!P0`. It is empty if
+    /// the instruction has no guard predicate.
+    std::string_view predicate {};
+    bool is_predicate_negated = false;
+    /// The tokens of an instruction, starting with its mnemonic, are
+    /// `ParsedChunk::tokens[first_token, first_token + token_count)`.
+    std::uint32_t first_token = 0;
+    std::uint32_t token_count = 0;
+};
+
+/// The statements parsed from a chunk of SASS source. Their tokens refer to the chunk, so they are
+/// valid as long as the chunk is. The object is meant to be reused for all chunks of a file, so
+/// that its storage is allocated only once.
+struct ParsedChunk {
+    std::vector<SassToken> tokens;
+    std::vector<SassStatement> statements;
+
+    void clear() {
+        tokens.clear();
+        statements.clear();
+    }
+
+    auto instruction_tokens(SassStatement const &statement) const
+        -> std::span<SassToken const>  //
+    {
+        return std::span(tokens).subspan(statement.first_token, statement.token_count);
+    }
+};
+
+/// Parses SASS source, such as the output of `cuobjdump` or `nvdisasm`:
+///
+///     .text.kernel:
+///             /*0000*/    MOV R1, c[0x0][0x28] ;
+///     .L_x_0:
+///             /*0010*/    @!P0 BRA `(.L_x_0) ;
+///
+/// SASS source can be huge, so the parser never needs the whole file. The caller feeds it the
+/// source one chunk at a time with `parse_chunk()`, which parses the complete statements at the
+/// beginning of the chunk and reports how much of it was consumed. The rest of the chunk (i.e. a
+/// statement cut by the end of the chunk) must be passed again at the beginning of the next chunk.
+///
+/// Since the chunks are discarded after they are processed, the diagnostics of this parser do not
+/// refer to the chunks. Each diagnostic carries a copy of the line it refers to, and the line
+/// number is part of its origin.
+class SassParser : public Parser {
+public:
+    explicit SassParser(std::string_view origin) : Parser(origin, {}) { }
+
+    /// Parses the complete statements at the beginning of `chunk` into `result`. `first_line` is
+    /// the line number of the first line of `chunk` in the whole source. If `is_last` is `true`,
+    /// `chunk` extends to the end of the source, so that a statement cut by the end of the chunk
+    /// is an error. Returns the number of characters consumed.
+    ///
+    /// Directives such as `.headerflags` and `.section` are skipped.
+    auto parse_chunk(std::string_view chunk, unsigned first_line, bool is_last, ParsedChunk &result)
+        -> std::size_t;
+
+    /// Makes the current chunk of `other` the current chunk of this parser, so that diagnostics can
+    /// be created for the statements parsed from it. Each parser has its own diagnostics and
+    /// strings, so several threads can report problems in the statements of one chunk at once,
+    /// each through a parser of its own.
+    void share_chunk(SassParser const &other) {
+        lexer_ = other.lexer_;
+        first_line_ = other.first_line_;
+        known_line_begin_ = other.known_line_begin_;
+        known_line_ = other.known_line_;
+    }
+
+    /// Creates a diagnostic at `range` of the current chunk. It is used by the users of the parsed
+    /// statements to report problems, and must be called before the chunk is discarded. `message`
+    /// and `label` are copied, so they can be temporary strings.
+    auto create_diag(
+        TokenRange range,
+        DiagLevel level,
+        std::string_view message,
+        std::string_view label = {}
+    ) -> Diag {
+        return create_diag_at_token(range, level, add_string(message), add_string(label));
+    }
+
+    /// Annotates `range` of the current chunk with `label`, for a diagnostic whose message is only
+    /// known after the chunk is discarded, which takes it with `Diag::with_source()`. `label` is
+    /// copied, so it can be a temporary string.
+    auto annotate(TokenRange range, std::string_view label) -> ants::AnnotatedSource {
+        return annotate_source(range.location_begin(), range.location_end(), add_string(label));
+    }
+
+protected:
+    auto annotate_source(unsigned begin, unsigned end, std::string_view label = {})
+        -> ants::AnnotatedSource override;
+
+private:
+    /// The line number of the first line of the current chunk.
+    unsigned first_line_ = 1;
+    /// The beginning of a line in the current chunk whose line number is known, and that line
+    /// number. It is used to compute the line numbers of diagnostics.
+    std::size_t known_line_begin_ = 0;
+    unsigned known_line_ = 1;
+
+    // The functions below parse a statement starting at the current token into `result`, and move
+    // to the first token after it. They return the end location of the statement, or `std::nullopt`
+    // if the chunk ends before the statement does (which is an error if `is_last` is `true`).
+
+    auto parse_instruction(ParsedChunk &result, bool is_last) -> std::optional<unsigned>;
+    auto parse_label(ParsedChunk &result, bool is_last) -> std::optional<unsigned>;
+    /// Parses a statement starting with a `.`, which is a label, a section or a directive.
+    auto parse_dot_statement(ParsedChunk &result, bool is_last) -> std::optional<unsigned>;
+
+    /// Appends the normalized form of the current token to `tokens`, and moves to the next token.
+    /// `is_operand_start` indicates whether the token starts an operand, where a sign followed by
+    /// an integer is part of the integer. Returns `false` if the token cannot appear in an
+    /// instruction, in which case a diagnostic is issued.
+    auto append_token(std::vector<SassToken> &tokens, bool is_operand_start) -> bool;
+
+    /// Appends a label reference such as `` `(.L_x_0) `` starting at the current `` ` `` to
+    /// `tokens`, and moves to the token after it. Returns `false` if the reference is malformed, in
+    /// which case a diagnostic is issued.
+    auto append_label_reference(std::vector<SassToken> &tokens) -> bool;
+
+    /// Skips the current token and the tokens after it on the same line. Returns the end location
+    /// of the last skipped token, or `std::nullopt` if the chunk ends before the end of the line.
+    auto skip_line(bool is_last) -> std::optional<unsigned>;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_PARSER_SASS_PARSER_HPP
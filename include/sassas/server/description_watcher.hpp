@@ -0,0 +1,86 @@
+#ifndef SASSAS_SERVER_DESCRIPTION_WATCHER_HPP
+#define SASSAS_SERVER_DESCRIPTION_WATCHER_HPP
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/isa_registry.hpp"
+#include "sassas/parser/incremental_isa_parser.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sassas {
+/// Keeps the ISAs of a registry up to date with their instruction description files, for
+/// `sassas --serve --watch`.
+///
+/// The ISAs are loaded through `load()`, which remembers the sections of each file. `watch()` then
+/// waits for the files to change (with inotify where the platform provides it, and by polling
+/// their modification times otherwise), parses a changed file again with `IncrementalISAParser`,
+/// which only parses the sections whose text changed, and publishes the result as the new version
+/// of the ISA with `ISARegistry::replace()`. If the new version has errors, they are reported and
+/// the previous version stays in use.
+class DescriptionWatcher {
+public:
+    /// Receives the diagnostics of the descriptions, and a note about each reload.
+    using Reporter = std::function<void(Diag)>;
+
+    /// The description of the architecture `sm_90` is the file `sm_90_instructions.txt`.
+    static constexpr std::string_view FILE_SUFFIX = "_instructions.txt";
+
+    /// Watches the descriptions in `directory`.
+    DescriptionWatcher(std::string directory, Reporter report) :
+        directory_(std::move(directory)), report_(std::move(report)) { }
+
+    DescriptionWatcher(DescriptionWatcher const &) = delete;
+    auto operator=(DescriptionWatcher const &) -> DescriptionWatcher & = delete;
+
+    /// Loads the ISA of `arch` from its description, as the loader of an `ISARegistry`. The
+    /// architecture is watched from then on, even if its description cannot be loaded yet. It may
+    /// be called from any thread.
+    auto load(std::string_view arch) -> std::optional<ISA>;
+
+    /// Reloads the architectures in `registry` whose description changes, until watching fails,
+    /// which is reported by returning `false` with `errno` describing the problem.
+    auto watch(ISARegistry &registry) -> bool;
+
+private:
+    /// A watched architecture.
+    struct Description {
+        /// Serializes the parses of the description.
+        std::mutex mutex;
+        IncrementalISAParser parser;
+        /// The modification time of the file when it was last read.
+        std::filesystem::file_time_type modified;
+
+        explicit Description(std::string path) : parser(std::move(path)) { }
+    };
+
+    std::string directory_;
+    Reporter report_;
+    /// Guards `descriptions_`. It is not held while a description is parsed.
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Description>, std::less<>> descriptions_;
+
+    auto path(std::string_view arch) const -> std::string;
+
+    /// Returns the architecture of the file `name` in the directory, if it is a description.
+    static auto arch_of(std::string_view name) -> std::optional<std::string_view>;
+
+    /// Returns the watched architecture `arch`, or `nullptr` if it is not watched.
+    auto find(std::string_view arch) -> Description *;
+
+    /// Reads and parses the description of `arch`. The mutex of `description` must be held.
+    auto parse(std::string_view arch, Description &description) -> std::optional<ISA>;
+
+    /// Parses the description of `arch` again, and publishes it in `registry` if it has no errors.
+    void reload(ISARegistry &registry, std::string_view arch);
+};
+}  // namespace sassas
+
+#endif  // SASSAS_SERVER_DESCRIPTION_WATCHER_HPP
@@ -0,0 +1,97 @@
+#ifndef SASSAS_SERVER_PROTOCOL_HPP
+#define SASSAS_SERVER_PROTOCOL_HPP
+
+#include "sassas/encoder/encoder.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+/// The messages exchanged between `sassas --serve` and its clients over a Unix domain socket.
+///
+/// Each message is a 32-bit little-endian length followed by that many bytes. The body of a
+/// message is a sequence of little-endian integers and length-prefixed strings, in the order of the
+/// fields below. A connection carries any number of requests, each of which is answered by one
+/// response before the next request is read.
+///
+/// The client sends the contents of the input files rather than their paths, so the daemon never
+/// touches the file system of the client, and relative paths mean the same as for the one-shot
+/// command line.
+
+/// The kind of a request.
+enum class ServiceCommand : std::uint8_t {
+    /// Assembles SASS source for one architecture.
+    Assemble,
+    /// Disassembles cubins and fatbins.
+    Disassemble,
+    /// Describes the ISA of an architecture, or the instruction classes of an opcode.
+    Query,
+};
+
+/// Where the output of a request goes, which mirrors the `-o` option of the command line.
+enum class ServiceOutput : std::uint8_t {
+    /// The text (a listing or a disassembly) goes to the console, i.e. the standard output.
+    Console,
+    /// The output (raw instruction words or a disassembly) goes to a file.
+    File,
+    /// The instructions are written to a file as a cubin.
+    Cubin,
+};
+
+/// An input file of a request, with the validation level that applies to it.
+struct ServiceInput {
+    std::string name;
+    ValidationLevel level = ValidationLevel::Full;
+    std::string contents;
+};
+
+struct ServiceRequest {
+    ServiceCommand command = ServiceCommand::Assemble;
+    /// The architecture to assemble for or to query, e.g. `sm_90`. Disassembling reads the
+    /// architecture from each cubin instead.
+    std::string arch;
+    ServiceOutput output = ServiceOutput::Console;
+    std::vector<ServiceInput> inputs;
+    /// The opcode whose instruction classes a query lists, or empty to describe the whole ISA.
+    std::string opcode;
+
+    auto encode() const -> std::string;
+
+    /// Decodes the body of a request message. Returns `std::nullopt` if it is malformed, in which
+    /// case `error` describes the problem.
+    static auto decode(std::string_view message, std::string_view &error)
+        -> std::optional<ServiceRequest>;
+};
+
+struct ServiceResponse {
+    bool success = false;
+    /// What the one-shot command line would have printed to the standard output: the listing or
+    /// disassembly (unless it goes to a file) and the rendered diagnostics, interleaved as they
+    /// were produced.
+    std::string console;
+    /// The contents of the output file, or `std::nullopt` if no file is written, e.g. because an
+    /// error prevented the cubin from being written.
+    std::optional<std::string> file;
+
+    auto encode() const -> std::string;
+
+    /// Decodes the body of a response message, as `ServiceRequest::decode()` does.
+    static auto decode(std::string_view message, std::string_view &error)
+        -> std::optional<ServiceResponse>;
+};
+
+/// The largest message accepted, which keeps a corrupted length from causing a huge allocation.
+inline constexpr std::uint32_t MAX_MESSAGE_SIZE = 1u << 30;
+
+/// Reads a message from the socket `fd` into `message`. Returns `false` if the peer closed the
+/// connection, the message is too large, or reading fails.
+auto read_message(int fd, std::string &message) -> bool;
+
+/// Writes `message` to the socket `fd`. Returns `false` if it cannot be written completely.
+auto write_message(int fd, std::string_view message) -> bool;
+}  // namespace sassas
+
+#endif  // SASSAS_SERVER_PROTOCOL_HPP
@@ -0,0 +1,75 @@
+#ifndef SASSAS_SERVER_SERVER_HPP
+#define SASSAS_SERVER_SERVER_HPP
+
+#include "sassas/server/protocol.hpp"
+#include "sassas/server/service.hpp"
+
+#include <optional>
+#include <string_view>
+
+namespace sassas {
+/// A Unix domain socket that accepts connections. The socket is only accessible to the current
+/// user.
+class UnixListener {
+public:
+    /// Listens on the socket at `path`. A socket left behind by a process that is no longer
+    /// running is replaced. Returns `std::nullopt` if the socket cannot be set up, in which case
+    /// `errno` describes the problem (`EADDRINUSE` if another process is listening on `path`).
+    static auto open(char const *path) -> std::optional<UnixListener>;
+
+    UnixListener(UnixListener &&other) noexcept;
+    auto operator=(UnixListener &&other) noexcept -> UnixListener &;
+    ~UnixListener();
+
+    /// Waits for the next connection, and returns its socket. Returns -1 if the listener fails, in
+    /// which case `errno` describes the problem. Interruptions and temporary shortages of file
+    /// descriptors are waited out.
+    auto accept() -> int;
+
+private:
+    explicit UnixListener(int fd) : fd_(fd) { }
+
+    int fd_ = -1;
+};
+
+/// Serves the requests of clients on `listener` until it fails, which is reported by returning
+/// `false` with `errno` describing the problem.
+///
+/// The connections are accepted on the calling thread and handed to a pool of `thread_count`
+/// workers. A worker answers the requests of one connection, in order, until the client closes it,
+/// so a client can keep its connection open to avoid connecting for each request; the requests of
+/// different connections are served concurrently. A connection that stays idle between requests
+/// for a few seconds, or whose client stops reading a response, is closed, so that it does not
+/// hold a worker that other connections wait for.
+auto serve(Service &service, UnixListener &listener, unsigned thread_count) -> bool;
+
+/// Answers every connection on `listener` with `Metrics::render()`, and closes it, until the
+/// listener fails. The client does not need to send anything, so the metrics can be read with
+/// e.g. `socat - UNIX-CONNECT:path`. A client that does not read the metrics within a few seconds
+/// is given up.
+auto serve_metrics(UnixListener &listener) -> bool;
+
+/// A connection to a daemon started with `serve()`.
+class ServiceClient {
+public:
+    /// Connects to the daemon serving on `path`. Returns `std::nullopt` if there is none, in which
+    /// case `errno` describes the problem.
+    static auto connect(char const *path) -> std::optional<ServiceClient>;
+
+    ServiceClient(ServiceClient &&other) noexcept;
+    auto operator=(ServiceClient &&other) noexcept -> ServiceClient &;
+    ~ServiceClient();
+
+    /// Sends `request`, and waits for its response. Returns `std::nullopt` if the connection
+    /// fails, in which case `error` describes the problem; the client is then unusable.
+    auto call(ServiceRequest const &request, std::string_view &error)
+        -> std::optional<ServiceResponse>;
+
+private:
+    explicit ServiceClient(int fd) : fd_(fd) { }
+
+    int fd_ = -1;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_SERVER_SERVER_HPP
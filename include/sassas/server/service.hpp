@@ -0,0 +1,90 @@
+#ifndef SASSAS_SERVER_SERVICE_HPP
+#define SASSAS_SERVER_SERVICE_HPP
+
+#include "sassas/assembler/assembler.hpp"
+#include "sassas/decoder/binary_disassembler.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/isa_registry.hpp"
+#include "sassas/server/protocol.hpp"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+/// Answers the requests of `sassas --serve`, with the ISAs, assemblers and disassemblers kept
+/// resident between requests, so a request only pays for the work on its own inputs.
+///
+/// `handle()` may be called from any number of threads at once. The assemblers and disassemblers
+/// are immutable once created, and are shared by all requests; each request works on its inputs
+/// on the calling thread, so concurrency comes from serving several requests at once.
+///
+/// The ISA of an architecture is looked up in the registry for every request, and the assembler of
+/// its current version is kept, so a request sees the ISAs that are current when it starts; an ISA
+/// replaced in the registry is used by the next request, while the ones in flight finish with the
+/// version they started with. The old version and its assembler are freed after the last of them.
+class Service {
+public:
+    explicit Service(ISARegistry &registry) : registry_(registry), disassembler_(registry) { }
+
+    Service(Service const &) = delete;
+    auto operator=(Service const &) -> Service & = delete;
+
+    /// Answers `request` as the one-shot command line would, with its console output and
+    /// diagnostics collected in the response rather than printed.
+    auto handle(ServiceRequest const &request) -> ServiceResponse;
+
+private:
+    /// Receives the diagnostics of a request.
+    using Reporter = std::function<void(Diag)>;
+
+    ISARegistry &registry_;
+    BinaryDisassembler disassembler_;
+    /// An assembler, and the version of the ISA it refers to, which it keeps alive.
+    struct VersionAssembler {
+        std::shared_ptr<LoadedISA const> isa;
+        Assembler assembler;
+
+        explicit VersionAssembler(std::shared_ptr<LoadedISA const> loaded_isa) :
+            isa(std::move(loaded_isa)), assembler(isa->isa, isa->frozen) { }
+    };
+
+    /// Guards `assemblers_`. It is not held while an assembler is created.
+    std::mutex mutex_;
+    /// The assembler of the current version of the ISA of each architecture. The requests share
+    /// it with the map, so the assembler of a replaced version is freed when the last request that
+    /// uses it finishes.
+    std::map<std::string, std::shared_ptr<VersionAssembler const>, std::less<>> assemblers_;
+
+    /// Returns the ISA of `arch`, or reports that it cannot be loaded.
+    auto get_isa(std::string_view arch, Reporter const &report) -> std::shared_ptr<LoadedISA const>;
+
+    /// Returns the assembler of `arch`, or reports that it cannot be created. The assembler keeps
+    /// its version of the ISA alive.
+    auto get_assembler(std::string_view arch, Reporter const &report)
+        -> std::shared_ptr<Assembler const>;
+
+    auto assemble(
+        ServiceRequest const &request,
+        ServiceResponse &response,
+        Reporter const &report
+    ) -> bool;
+    auto disassemble(
+        ServiceRequest const &request,
+        ServiceResponse &response,
+        Reporter const &report
+    ) -> bool;
+    auto query(
+        ServiceRequest const &request,
+        ServiceResponse &response,
+        Reporter const &report
+    ) -> bool;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_SERVER_SERVICE_HPP
@@ -0,0 +1,32 @@
+#ifndef SASSAS_UTIL_CONTENT_HASH_HPP
+#define SASSAS_UTIL_CONTENT_HASH_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sassas {
+/// A hash of some contents, which identifies them e.g. in a cache.
+///
+/// It is a 128-bit hash made of two differently seeded and mixed 64-bit lanes, in the spirit of
+/// FNV-1a. It is not cryptographic: the caches it keys are private to the user, so it only needs
+/// to tell honest inputs apart.
+class ContentHash {
+public:
+    /// Adds `data`. Its size is added first, so that the boundaries between the parts matter.
+    void add(std::string_view data);
+
+    void add(std::uint64_t value);
+
+    /// Returns the hash as 32 hexadecimal digits.
+    auto hex() const -> std::string;
+
+private:
+    std::uint64_t low_ = 0xcbf29ce484222325;
+    std::uint64_t high_ = 0x6c62272e07bb0142;
+
+    void add_bytes(std::string_view bytes);
+};
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_CONTENT_HASH_HPP
@@ -0,0 +1,17 @@
+#ifndef SASSAS_UTIL_GATHERED_WRITE_HPP
+#define SASSAS_UTIL_GATHERED_WRITE_HPP
+
+#include <cstddef>
+#include <span>
+
+namespace sassas {
+/// Writes the concatenation of `buffers` to the file at `path`, replacing it if it exists. Returns
+/// `false` if the file cannot be written, in which case `errno` describes the problem.
+///
+/// Where `writev()` is available, the buffers are passed to the system as they are, in as few
+/// calls as possible, so the caller never needs to gather them into one buffer. Otherwise, they
+/// are written one by one.
+auto write_file(char const *path, std::span<std::span<std::byte const> const> buffers) -> bool;
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_GATHERED_WRITE_HPP
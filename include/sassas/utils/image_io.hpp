@@ -0,0 +1,134 @@
+#ifndef SASSAS_UTIL_IMAGE_IO_HPP
+#define SASSAS_UTIL_IMAGE_IO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// Appends integers and strings to an image.
+class ImageWriter {
+public:
+    void u8(std::uint8_t value) {
+        bytes_.push_back(static_cast<std::byte>(value));
+    }
+
+    void u32(std::uint32_t value) {
+        for (unsigned i = 0; i != 4; ++i) {
+            u8(static_cast<std::uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void u64(std::uint64_t value) {
+        for (unsigned i = 0; i != 8; ++i) {
+            u8(static_cast<std::uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void i64(std::int64_t value) {
+        u64(static_cast<std::uint64_t>(value));
+    }
+
+    void string(std::string_view value) {
+        u32(static_cast<std::uint32_t>(value.size()));
+        auto const bytes = std::as_bytes(std::span(value));
+        bytes_.insert(bytes_.end(), bytes.begin(), bytes.end());
+    }
+
+    auto take() -> std::vector<std::byte> {
+        return std::move(bytes_);
+    }
+
+private:
+    std::vector<std::byte> bytes_;
+};
+
+/// Reads integers and strings from an image. Reading past the end of the image yields zeros and
+/// empty strings, and marks the reader as failed, so a whole structure can be read before checking
+/// `ok()` once.
+class ImageReader {
+public:
+    explicit ImageReader(std::span<std::byte const> bytes) : bytes_(bytes) { }
+
+    auto ok() const -> bool {
+        return ok_;
+    }
+
+    auto at_end() const -> bool {
+        return bytes_.empty();
+    }
+
+    /// Marks the image as malformed.
+    void fail() {
+        ok_ = false;
+        bytes_ = {};
+    }
+
+    auto u8() -> std::uint8_t {
+        if (bytes_.empty()) {
+            fail();
+            return 0;
+        }
+        auto const value = static_cast<std::uint8_t>(bytes_.front());
+        bytes_ = bytes_.subspan(1);
+        return value;
+    }
+
+    auto u32() -> std::uint32_t {
+        std::uint32_t value = 0;
+        for (unsigned i = 0; i != 4; ++i) {
+            value |= static_cast<std::uint32_t>(u8()) << (i * 8);
+        }
+        return value;
+    }
+
+    auto u64() -> std::uint64_t {
+        std::uint64_t value = 0;
+        for (unsigned i = 0; i != 8; ++i) {
+            value |= static_cast<std::uint64_t>(u8()) << (i * 8);
+        }
+        return value;
+    }
+
+    auto i64() -> std::int64_t {
+        return static_cast<std::int64_t>(u64());
+    }
+
+    auto boolean() -> bool {
+        return u8() != 0;
+    }
+
+    auto string() -> std::string {
+        std::uint32_t const size = u32();
+        if (size > bytes_.size()) {
+            fail();
+            return {};
+        }
+        std::string value(reinterpret_cast<char const *>(bytes_.data()), size);
+        bytes_ = bytes_.subspan(size);
+        return value;
+    }
+
+    /// Reads the number of elements of a sequence, each of which takes at least `min_size` bytes.
+    /// A count that cannot fit into the rest of the image fails, so a corrupted count never causes
+    /// a huge allocation.
+    auto count(std::size_t min_size = 1) -> std::uint32_t {
+        std::uint32_t const value = u32();
+        if (value > bytes_.size() / min_size) {
+            fail();
+            return 0;
+        }
+        return value;
+    }
+
+private:
+    std::span<std::byte const> bytes_;
+    bool ok_ = true;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_IMAGE_IO_HPP
@@ -0,0 +1,44 @@
+#ifndef SASSAS_UTIL_MAPPED_FILE_HPP
+#define SASSAS_UTIL_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace sassas {
+/// The read-only contents of a whole file.
+///
+/// Where `mmap()` is available, the file is mapped into memory, so opening a large file costs
+/// nothing up front, and the pages are read by the threads that touch them. Otherwise, the file is
+/// read into a buffer.
+class MappedFile {
+public:
+    /// Opens the file at `path`. Returns `std::nullopt` if the file cannot be read, in which case
+    /// `errno` describes the problem.
+    static auto open(char const *path) -> std::optional<MappedFile>;
+
+    MappedFile(MappedFile &&other) noexcept;
+    auto operator=(MappedFile &&other) noexcept -> MappedFile &;
+    ~MappedFile();
+
+    /// Returns the contents of the file, which stay valid as long as the `MappedFile` exists.
+    auto bytes() const -> std::span<std::byte const> {
+        return { data_, size_ };
+    }
+
+private:
+    MappedFile() = default;
+
+    /// The contents of the file, which are either mapped or point into `buffer_`.
+    std::byte const *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool is_mapped_ = false;
+    std::vector<std::byte> buffer_;
+
+    /// Unmaps the file if it is mapped.
+    void release();
+};
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_MAPPED_FILE_HPP
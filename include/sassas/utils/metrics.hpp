@@ -0,0 +1,151 @@
+#ifndef SASSAS_UTIL_METRICS_HPP
+#define SASSAS_UTIL_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sassas {
+/// A monotonically increasing count.
+enum class Counter : std::uint8_t {
+    AssembleRequests,
+    DisassembleRequests,
+    QueryRequests,
+    FailedRequests,
+    /// Lookups of an ISA in `ISARegistry` that found it loaded, or loaded by another thread.
+    ISACacheHits,
+    /// Lookups of an ISA in `ISARegistry` that loaded it.
+    ISACacheMisses,
+    /// Lookups of a key in an ISA table.
+    TableLookups,
+    /// Instructions encoded by the assembler.
+    Instructions,
+    /// Instructions whose word was found in the memo of the assembler.
+    MemoHits,
+    /// Instructions that could be memoized, but were not found in the memo.
+    MemoMisses,
+    /// New versions of an ISA published after its instruction description changed.
+    ISAReloads,
+    /// Sections of instruction descriptions parsed again when they changed.
+    ReparsedSections,
+};
+inline constexpr std::size_t COUNTER_COUNT = 12;
+
+/// A value that goes up and down.
+enum class Gauge : std::uint8_t {
+    /// The bytes of the requests and responses held by the daemon.
+    RequestBytes,
+};
+inline constexpr std::size_t GAUGE_COUNT = 1;
+
+/// A part of the work whose duration is recorded in a histogram.
+enum class Stage : std::uint8_t {
+    /// A whole request to the daemon, from receiving it to sending the response.
+    Request,
+    /// Lexing and parsing a chunk of source. The lexer runs on demand of the parser, so the two
+    /// cannot be told apart.
+    Parse,
+    /// Finding and binding the instruction classes of the instructions of a chunk.
+    Match,
+    /// Encoding the instructions of a chunk.
+    Encode,
+    /// Laying out and writing the output of a request.
+    Write,
+};
+inline constexpr std::size_t STAGE_COUNT = 5;
+
+/// The metrics of the process, rendered in the Prometheus text format.
+///
+/// Recording is off until `enable()` is called, so the one-shot command line pays only for a
+/// relaxed load of a flag. Once enabled, every thread records into a block of its own, which is
+/// created on its first record: only the owning thread writes to a block, with a plain load and
+/// store rather than a read-modify-write, so the hot paths never contend on a shared atomic or
+/// cache line. `render()` sums the blocks of all live threads under a lock, together with the
+/// totals of the threads that have exited, which fold their blocks in when they do.
+///
+/// The durations are recorded in histograms with exponential buckets from 1 µs to about 4 s. The
+/// match and encode stages are summed over the instructions of a chunk, so their histograms show
+/// the cost of a chunk (a section, when a file is assembled in memory), like the parse stage.
+class Metrics {
+public:
+    /// The upper bounds of the histogram buckets, in microseconds, are `4^i` for `i` below
+    /// `BUCKET_COUNT`. Longer durations only count towards `+Inf`.
+    static constexpr std::size_t BUCKET_COUNT = 12;
+
+    /// Starts recording. It cannot be stopped again.
+    static void enable() {
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    static auto enabled() -> bool {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    static void add(Counter counter, std::uint64_t value = 1) {
+        if (enabled()) {
+            add_local(counter, value);
+        }
+    }
+
+    static void add(Gauge gauge, std::int64_t delta) {
+        if (enabled()) {
+            add_local(gauge, delta);
+        }
+    }
+
+    static void observe(Stage stage, std::chrono::nanoseconds duration) {
+        if (enabled()) {
+            observe_local(stage, duration);
+        }
+    }
+
+    /// Returns the metrics of all threads in the Prometheus text exposition format.
+    static auto render() -> std::string;
+
+    /// Writes `render()` to `path`, replacing the file atomically, so that a collector never reads
+    /// half of it. Returns `false` if it cannot be written, in which case `errno` describes the
+    /// problem.
+    static auto write_file(char const *path) -> bool;
+
+    /// Measures the duration of a stage, from its construction to `stop()` or its destruction. It
+    /// does not read the clock while recording is off.
+    class Timer {
+    public:
+        explicit Timer(Stage stage) : stage_(stage), running_(enabled()) {
+            if (running_) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        Timer(Timer const &) = delete;
+        auto operator=(Timer const &) -> Timer & = delete;
+
+        ~Timer() {
+            stop();
+        }
+
+        void stop() {
+            if (running_) {
+                running_ = false;
+                observe_local(stage_, std::chrono::steady_clock::now() - start_);
+            }
+        }
+
+    private:
+        Stage stage_;
+        bool running_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+private:
+    static std::atomic<bool> enabled_;
+
+    static void add_local(Counter counter, std::uint64_t value);
+    static void add_local(Gauge gauge, std::int64_t delta);
+    static void observe_local(Stage stage, std::chrono::nanoseconds duration);
+};
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_METRICS_HPP
@@ -0,0 +1,78 @@
+#ifndef SASSAS_UTIL_OUTPUT_CACHE_HPP
+#define SASSAS_UTIL_OUTPUT_CACHE_HPP
+
+#include "sassas/utils/content_hash.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+/// A content-addressed cache of output files in a directory, in the spirit of ccache.
+///
+/// An entry is the output file whose inputs hash to a `ContentHash`, stored as `xx/yyyy...` after
+/// the digits of the key. Entries are written to a temporary file and renamed into place, so
+/// several processes can share a cache and never see half of an entry. Fetching an entry clones it
+/// into place where the filesystem supports it (a reflink), and copies it otherwise; either way it
+/// touches the entry, and when the cache grows beyond its maximum size, the entries that were
+/// least recently used are removed.
+///
+/// The hits and misses, and the running size of the entries, are kept in the file `stats` of the
+/// directory, under a lock where the platform provides one. So a store only walks the directory
+/// when the running size exceeds the maximum size.
+class OutputCache {
+public:
+    static constexpr std::uint64_t DEFAULT_MAX_SIZE = std::uint64_t(1) << 30;
+
+    /// Identifies how outputs are produced. It is added to every key, and changes whenever the
+    /// same inputs may be assembled into a different output, so that a newer `sassas` never
+    /// picks up a stale entry.
+    static constexpr std::uint32_t VERSION = 1;
+
+    struct Statistics {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t entries = 0;
+        /// The total size of the entries, in bytes.
+        std::uint64_t size = 0;
+    };
+
+    /// Opens the cache in `directory`, creating the directory if needed. Returns `std::nullopt` if
+    /// it cannot be created.
+    static auto open(std::string directory, std::uint64_t max_size = DEFAULT_MAX_SIZE)
+        -> std::optional<OutputCache>;
+
+    /// Writes the entry of `key` to the file at `path`, and returns whether there is one. Counts a
+    /// hit or a miss.
+    auto fetch(ContentHash const &key, char const *path) -> bool;
+
+    /// Stores the file at `path` as the entry of `key`, and evicts the least recently used entries
+    /// if the cache has grown too large. Returns `false` if the entry cannot be stored.
+    auto store(ContentHash const &key, char const *path) -> bool;
+
+    /// Returns the counters and the current size of the cache.
+    auto statistics() const -> Statistics;
+
+private:
+    std::string directory_;
+    std::uint64_t max_size_;
+
+    OutputCache(std::string directory, std::uint64_t max_size) :
+        directory_(std::move(directory)), max_size_(max_size) { }
+
+    auto entry_path(ContentHash const &key) const -> std::string;
+
+    auto stats_path() const -> std::string;
+
+    /// Adds one to the hits or the misses.
+    void count(bool hit) const;
+
+    /// Removes the least recently used entries until the cache is no larger than its maximum size.
+    /// Returns the size of the entries that are left.
+    auto evict() const -> std::uint64_t;
+};
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_OUTPUT_CACHE_HPP
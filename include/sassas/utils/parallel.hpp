@@ -0,0 +1,23 @@
+#ifndef SASSAS_UTIL_PARALLEL_HPP
+#define SASSAS_UTIL_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace sassas {
+/// Runs `task(i)` for every `i` in `[0, task_count)` on `thread_count` threads, one of which is the
+/// calling thread, and returns when all tasks are finished. `task` must be safe to call from
+/// several threads at once, and must not throw.
+///
+/// The tasks are split into contiguous ranges, one per thread, and each thread runs its range from
+/// the front. A thread that runs out of work steals the back half of the largest remaining range of
+/// another thread. So a few expensive tasks (such as one huge kernel among many small ones) do not
+/// leave the other threads idle, and no scheduling is needed when the tasks cost about the same.
+void parallel_for(
+    unsigned thread_count,
+    std::size_t task_count,
+    std::function<void(std::size_t)> const &task
+);
+}  // namespace sassas
+
+#endif  // SASSAS_UTIL_PARALLEL_HPP
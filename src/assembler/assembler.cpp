@@ -0,0 +1,1249 @@
+#include "sassas/assembler/assembler.hpp"
+
+#include "sassas/assembler/incremental_state.hpp"
+#include "sassas/assembler/instruction_memo.hpp"
+#include "sassas/assembler/instruction_matcher.hpp"
+#include "sassas/assembler/label_table.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/encoder/encoder.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/parser/sass_parser.hpp"
+#include "sassas/utils/content_hash.hpp"
+#include "sassas/utils/metrics.hpp"
+#include "sassas/utils/parallel.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// A part of the source that can be assembled independently.
+struct SourcePiece {
+    std::string_view text;
+    /// The line number of the first line of `text` in the whole source.
+    unsigned first_line;
+};
+
+/// Splits `source` before each line that starts a section (i.e. `.text.name:`), so that each piece
+/// except the first one holds exactly one section. Comments and strings are tracked, so that a
+/// `.text.` in them does not split the source.
+auto split_sections(std::string_view source) -> std::vector<SourcePiece> {
+    enum class State : std::uint8_t {
+        Code,
+        LineComment,
+        BlockComment,
+        String,
+    };
+
+    std::vector<SourcePiece> pieces;
+    std::size_t piece_begin = 0;
+    unsigned piece_line = 1;
+    unsigned line = 1;
+    State state = State::Code;
+    // Whether only whitespace has been seen on the current line.
+    bool at_line_start = true;
+
+    for (std::size_t i = 0; i != source.size(); ++i) {
+        char const ch = source[i];
+        if (ch == '\n') {
+            ++line;
+            if (state != State::BlockComment) {
+                state = State::Code;
+            }
+            at_line_start = state == State::Code;
+            continue;
+        }
+
+        switch (state) {
+        case State::Code:
+            if (at_line_start && ch != ' ' && ch != '\t') {
+                at_line_start = false;
+                if (source.substr(i).starts_with(".text.") && i != piece_begin) {
+                    pieces.push_back({ source.substr(piece_begin, i - piece_begin), piece_line });
+                    piece_begin = i;
+                    piece_line = line;
+                }
+            }
+
+            if (ch == '"') {
+                state = State::String;
+            } else if (ch == '/' && i + 1 != source.size() && source[i + 1] == '/') {
+                state = State::LineComment;
+                ++i;
+            } else if (ch == '/' && i + 1 != source.size() && source[i + 1] == '*') {
+                state = State::BlockComment;
+                ++i;
+            }
+            break;
+
+        case State::BlockComment:
+            if (ch == '*' && i + 1 != source.size() && source[i + 1] == '/') {
+                state = State::Code;
+                ++i;
+            }
+            break;
+
+        case State::String:
+            if (ch == '"') {
+                state = State::Code;
+            }
+            break;
+
+        case State::LineComment:
+            break;
+        }
+    }
+
+    pieces.push_back({ source.substr(piece_begin), piece_line });
+    return pieces;
+}
+
+/// Returns the value of a label operand of the instruction at `offset`, where the label is at
+/// `target`.
+auto label_value(std::uint64_t target, std::uint64_t offset, bool is_relative, unsigned size)
+    -> std::int64_t  //
+{
+    if (is_relative) {
+        // Relative to the address of the next instruction.
+        return static_cast<std::int64_t>(target) - static_cast<std::int64_t>(offset + size);
+    } else {
+        return static_cast<std::int64_t>(target);
+    }
+}
+
+/// Writes the key of an instruction into `key`, which identifies the instruction by its guard
+/// predicate and tokens, but not by where it is in the source. It is only used for instructions
+/// without labels, which are encoded to the same word wherever they are.
+void memo_key(SassStatement const &statement, std::span<SassToken const> tokens, std::string &key) {
+    key.clear();
+    auto const add_text = [&key](std::string_view text) {
+        key += text;
+        key += '\0';
+    };
+
+    key += statement.is_predicate_negated ? '!' : '@';
+    add_text(statement.predicate);
+    for (SassToken const &token : tokens) {
+        key += static_cast<char>(token.kind);
+        switch (token.kind) {
+        case SassToken::Integer:
+            key.append(reinterpret_cast<char const *>(&token.value), sizeof(token.value));
+            break;
+        case SassToken::Punctuator:
+            key += static_cast<char>(token.punctuator);
+            break;
+        default:
+            add_text(token.text);
+            break;
+        }
+    }
+}
+
+/// Splits the time spent on an instruction between matching and encoding, while metrics are
+/// recorded: everything from construction to destruction counts as matching, except what runs
+/// inside `encoding()`.
+class StageClock {
+public:
+    StageClock(std::chrono::nanoseconds &match_time, std::chrono::nanoseconds &encode_time) :
+        match_time_(match_time), encode_time_(encode_time), running_(Metrics::enabled()) {
+        if (running_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    StageClock(StageClock const &) = delete;
+    auto operator=(StageClock const &) -> StageClock & = delete;
+
+    ~StageClock() {
+        if (running_) {
+            match_time_ += std::chrono::steady_clock::now() - start_ - encoded_;
+            encode_time_ += encoded_;
+        }
+    }
+
+    /// Returns `encode()`, counting the time it takes as encoding.
+    template <class Function>
+    auto encoding(Function const &encode) -> decltype(encode()) {
+        if (!running_) {
+            return encode();
+        }
+        auto const start = std::chrono::steady_clock::now();
+        auto result = encode();
+        encoded_ += std::chrono::steady_clock::now() - start;
+        return result;
+    }
+
+private:
+    std::chrono::nanoseconds &match_time_;
+    std::chrono::nanoseconds &encode_time_;
+    bool running_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::nanoseconds encoded_ {};
+};
+}  // namespace
+
+/// The end of a section, as passed to `SectionSink::end_section()`.
+struct Assembler::FinishedSection {
+    /// An instruction that refers to a label of another section, and its operand values.
+    struct DeferredFixup {
+        Fixup fixup;
+        std::vector<std::int64_t> operands;
+    };
+
+    /// A label that is not defined in the section that refers to it.
+    struct DeferredLabel {
+        std::string name;
+        /// The first reference to the label, where it is reported if it cannot be resolved.
+        ants::AnnotatedSource reference;
+        std::vector<DeferredFixup> fixups;
+    };
+
+    /// The functions and labels defined in the section, at offsets from its start.
+    std::vector<IncrementalState::Symbol> symbols;
+    std::vector<DeferredLabel> labels;
+};
+
+/// Receives the output of `process_chunk()` and `finish_section()`, which also tells where each
+/// section ends.
+class Assembler::SectionSink : public AssemblySink {
+public:
+    /// Called at the end of each section, once all its instructions are emitted. The instructions
+    /// that refer to the labels of other sections have placeholder targets.
+    virtual void end_section(FinishedSection section) = 0;
+};
+
+/// Records the calls to a section sink, so that they can be replayed later in the order of the
+/// source.
+class Assembler::RecordingSink final : public SectionSink {
+public:
+    void begin_section(std::string_view name) override {
+        events_.emplace_back(std::in_place_type<std::string>, name);
+    }
+
+    void emit(InstructionWord const &word) override {
+        events_.emplace_back(word);
+    }
+
+    void report(Diag diag) override {
+        events_.emplace_back(std::move(diag));
+    }
+
+    void end_section(FinishedSection section) override {
+        events_.emplace_back(std::move(section));
+    }
+
+    /// Passes the recorded calls to `sink`.
+    void replay(SectionSink &sink) {
+        for (auto &event : events_) {
+            if (auto const *name = std::get_if<std::string>(&event)) {
+                sink.begin_section(*name);
+            } else if (auto const *word = std::get_if<InstructionWord>(&event)) {
+                sink.emit(*word);
+            } else if (auto *diag = std::get_if<Diag>(&event)) {
+                sink.report(std::move(*diag));
+            } else {
+                sink.end_section(std::move(std::get<FinishedSection>(event)));
+            }
+        }
+        events_.clear();
+    }
+
+    /// Returns the recorded sections, or `std::nullopt` if a diagnostic was recorded or a section
+    /// refers to the labels of other sections, since the output then depends on the other sections.
+    auto runs() const -> std::optional<std::vector<IncrementalState::Run>> {
+        std::vector<IncrementalState::Run> runs;
+        for (auto const &event : events_) {
+            if (auto const *name = std::get_if<std::string>(&event)) {
+                runs.emplace_back().name.emplace(*name);
+            } else if (auto const *word = std::get_if<InstructionWord>(&event)) {
+                if (runs.empty()) {
+                    runs.emplace_back();
+                }
+                runs.back().words.push_back(*word);
+            } else if (auto const *section = std::get_if<FinishedSection>(&event)) {
+                if (!section->labels.empty()) {
+                    return std::nullopt;
+                }
+                if (!section->symbols.empty()) {
+                    if (runs.empty()) {
+                        runs.emplace_back();
+                    }
+                    runs.back().symbols = section->symbols;
+                }
+            } else {
+                return std::nullopt;
+            }
+        }
+        return runs;
+    }
+
+private:
+    std::vector<std::variant<std::string, InstructionWord, Diag, FinishedSection>> events_;
+};
+
+/// Places the sections of a file in the output of a sink, and resolves the labels that a section
+/// leaves to the others.
+///
+/// If the sink places each section on its own (see `AssemblySink::flat_offset()`), the calls are
+/// passed through, and the labels a section leaves undefined are reported at its end, since no
+/// other section can define them. Otherwise each section is collected until it ends. It is then
+/// patched and passed on if the functions and labels it refers to are placed already, or are its
+/// own. If not, it is held back until they are, while the sections after it are passed on. So
+/// only the sections that refer to later ones are held, and such a section is placed right after
+/// the last section it waits for. The sections still held at the end of the file are placed in
+/// the order of the source, and the labels no section defines are reported then.
+class Assembler::Linker final : public SectionSink {
+public:
+    Linker(Assembler const &assembler, ValidationLevel level, AssemblySink &sink) :
+        assembler_(assembler), level_(level), sink_(sink), offset_(sink.flat_offset()) { }
+
+    void begin_section(std::string_view name) override {
+        if (offset_) {
+            current_.name.emplace(name);
+        } else {
+            sink_.begin_section(name);
+        }
+    }
+
+    void emit(InstructionWord const &word) override {
+        if (offset_) {
+            current_.words.push_back(word);
+        } else {
+            sink_.emit(word);
+        }
+    }
+
+    void report(Diag diag) override {
+        sink_.report(std::move(diag));
+    }
+
+    void end_section(FinishedSection section) override;
+
+    /// Places the sections still held back, and reports the labels that no section defines. It
+    /// must be called after the last section of the file ends. Returns `false` if an error is
+    /// reported by the linker.
+    auto finish() -> bool;
+
+private:
+    struct Section {
+        std::uint64_t id = 0;
+        std::optional<std::string> name;
+        std::vector<InstructionWord> words;
+        std::vector<IncrementalState::Symbol> symbols;
+        std::vector<FinishedSection::DeferredLabel> labels;
+    };
+
+    struct Symbol {
+        /// The offset of the symbol in the output, once its section is placed.
+        std::optional<std::uint64_t> offset;
+        /// The `Section::id` of the section that defines it first.
+        std::uint64_t section;
+        bool is_duplicate = false;
+        /// Whether a reference from another section has been resolved to it.
+        bool is_referenced = false;
+    };
+
+    Assembler const &assembler_;
+    ValidationLevel level_;
+    AssemblySink &sink_;
+    /// The offset in the output where the next section is placed, or `std::nullopt` if the sink
+    /// places each section on its own.
+    std::optional<std::uint64_t> offset_;
+    /// The section being collected.
+    Section current_;
+    std::uint64_t section_count_ = 0;
+    /// The sections waiting for others to be placed, in the order of the source.
+    std::vector<Section> held_;
+    std::unordered_map<std::string, Symbol> symbols_;
+    std::vector<EncodeIssue> issues_;
+    bool success_ = true;
+
+    /// Adds the symbols of `section`, which is not placed yet.
+    void add_symbols(Section const &section);
+
+    /// Reports the labels of `section` that are defined in more than one other section, which
+    /// are dropped, and returns whether the others can be resolved.
+    auto is_ready(Section &section) -> bool;
+
+    /// Places the held sections that can be resolved, until none can.
+    void place_ready();
+
+    /// Sets the offsets of the symbols of `section`, which is placed at `base`.
+    void place_symbols(Section const &section, std::uint64_t base);
+
+    /// Patches the labels of `section` into its instructions, reporting those that cannot be
+    /// resolved, and passes it to the sink at the current offset. Its symbols must be placed.
+    void link(Section &section);
+
+    void report_duplicate(FinishedSection::DeferredLabel &label);
+};
+
+auto Assembler::assemble(
+    std::istream &input,
+    std::string_view origin,
+    ValidationLevel level,
+    AssemblySink &sink,
+    std::size_t chunk_size
+) const -> bool {
+    SassParser parser(origin);
+    ParsedChunk parsed;
+    Scratch scratch;
+    Linker output(*this, level, sink);
+
+    std::vector<char> buffer(std::max<std::size_t>(chunk_size, 1));
+    // The number of characters in `buffer`, including those carried over from the previous chunk.
+    std::size_t size = 0;
+    // The line number of the first line in `buffer`.
+    unsigned line = 1;
+    bool success = true;
+
+    for (bool is_last = false; !is_last;) {
+        input.read(buffer.data() + size, static_cast<std::streamsize>(buffer.size() - size));
+        size += static_cast<std::size_t>(input.gcount());
+        if (input.bad()) {
+            sink.report(Diag(DiagLevel::Error, fmt::format("Failed to read {}", origin)));
+            return false;
+        }
+        is_last = input.eof();
+
+        std::string_view const chunk(buffer.data(), size);
+        Metrics::Timer parse_timer(Stage::Parse);
+        std::size_t const consumed = parser.parse_chunk(chunk, line, is_last, parsed);
+        parse_timer.stop();
+
+        success &= process_chunk(parser, parsed, level, output, scratch);
+
+        // Carry the unconsumed part over to the next chunk. If it fills the whole buffer, a single
+        // statement is longer than the buffer, so the buffer has to grow.
+        line += static_cast<unsigned>(std::ranges::count(chunk.substr(0, consumed), '\n'));
+        std::ranges::copy(chunk.substr(consumed), buffer.begin());
+        size -= consumed;
+        if (size == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+
+    finish_section(parser, output, scratch);
+    success &= output.finish();
+    return success;
+}
+
+auto Assembler::assemble_parallel(
+    std::string_view source,
+    std::string_view origin,
+    ValidationLevel level,
+    AssemblySink &sink,
+    unsigned thread_count
+) const -> bool {
+    Target const target { .assembler = this, .sink = &sink };
+    return assemble_targets(source, origin, level, std::span(&target, 1), thread_count);
+}
+
+auto Assembler::assemble_incremental(
+    std::string_view source,
+    std::string_view origin,
+    ValidationLevel level,
+    AssemblySink &sink,
+    unsigned thread_count,
+    IncrementalState const &previous,
+    IncrementalState &next
+) const -> bool {
+    std::vector<SourcePiece> const pieces = split_sections(source);
+
+    // The parsers are kept alive until the diagnostics are replayed, since the diagnostics refer
+    // to their string pools.
+    struct PieceResult {
+        std::string key;
+        std::vector<IncrementalState::Run> const *reused = nullptr;
+        std::optional<SassParser> parser;
+        ParsedChunk parsed;
+        RecordingSink recorder;
+        bool success = true;
+    };
+    std::vector<PieceResult> results(pieces.size());
+    for (std::size_t i = 0; i != pieces.size(); ++i) {
+        ContentHash key;
+        key.add(static_cast<std::uint64_t>(level));
+        key.add(pieces[i].text);
+        results[i].key = key.hex();
+        results[i].reused = previous.find(results[i].key);
+    }
+
+    ScratchPool scratches;
+    parallel_for(thread_count, pieces.size(), [&](std::size_t index) {
+        PieceResult &result = results[index];
+        if (result.reused) {
+            return;
+        }
+
+        SourcePiece const &piece = pieces[index];
+        SassParser &parser = result.parser.emplace(origin);
+        Metrics::Timer parse_timer(Stage::Parse);
+        parser.parse_chunk(piece.text, piece.first_line, /*is_last=*/true, result.parsed);
+        parse_timer.stop();
+
+        std::unique_ptr<Scratch> scratch = scratches.take();
+        result.success = process_chunk(parser, result.parsed, level, result.recorder, *scratch);
+        finish_section(parser, result.recorder, *scratch);
+        scratches.give_back(std::move(scratch));
+    });
+
+    Linker linker(*this, level, sink);
+    bool success = true;
+    for (PieceResult &result : results) {
+        if (result.reused) {
+            for (IncrementalState::Run const &run : *result.reused) {
+                if (run.name) {
+                    linker.begin_section(*run.name);
+                }
+                for (InstructionWord const &word : run.words) {
+                    linker.emit(word);
+                }
+                linker.end_section({ .symbols = run.symbols, .labels = {} });
+            }
+            next.add(std::move(result.key), *result.reused);
+            continue;
+        }
+
+        if (std::optional<std::vector<IncrementalState::Run>> runs = result.recorder.runs()) {
+            next.add(std::move(result.key), std::move(*runs));
+        }
+        result.recorder.replay(linker);
+        success &= result.success;
+    }
+    success &= linker.finish();
+    return success;
+}
+
+auto Assembler::assemble_targets(
+    std::string_view source,
+    std::string_view origin,
+    ValidationLevel level,
+    std::span<Target const> targets,
+    unsigned thread_count
+) -> bool {
+    std::vector<SourcePiece> const pieces = split_sections(source);
+
+    // The statements of each piece, and a parser for each target. The parser of the first target
+    // parses the piece, and the others share its chunk, so that each target can create
+    // diagnostics on its own. The parsers are kept alive until the diagnostics are replayed, since
+    // the diagnostics refer to their string pools.
+    struct ParsedPiece {
+        ParsedChunk parsed;
+        std::vector<std::optional<SassParser>> parsers;
+    };
+    std::vector<ParsedPiece> parsed_pieces(pieces.size());
+
+    parallel_for(thread_count, pieces.size(), [&](std::size_t index) {
+        SourcePiece const &piece = pieces[index];
+        ParsedPiece &result = parsed_pieces[index];
+        result.parsers = std::vector<std::optional<SassParser>>(targets.size());
+
+        SassParser &parser = result.parsers.front().emplace(origin);
+        Metrics::Timer parse_timer(Stage::Parse);
+        parser.parse_chunk(piece.text, piece.first_line, /*is_last=*/true, result.parsed);
+        parse_timer.stop();
+        for (std::size_t i = 1; i != targets.size(); ++i) {
+            result.parsers[i].emplace(origin).share_chunk(parser);
+        }
+    });
+
+    // The result of each piece for each target, indexed by `piece * targets.size() + target`.
+    // The syntax errors are only reported to the first target, since they are kept by its parser.
+    struct PieceResult {
+        RecordingSink recorder;
+        bool success = true;
+    };
+    std::vector<PieceResult> results(pieces.size() * targets.size());
+    std::vector<ScratchPool> scratches(targets.size());
+
+    parallel_for(thread_count, results.size(), [&](std::size_t index) {
+        std::size_t const piece = index / targets.size();
+        std::size_t const target = index % targets.size();
+        Assembler const &assembler = *targets[target].assembler;
+        ParsedPiece &parsed_piece = parsed_pieces[piece];
+        SassParser &parser = *parsed_piece.parsers[target];
+        PieceResult &result = results[index];
+
+        std::unique_ptr<Scratch> scratch = scratches[target].take();
+        result.success =
+            assembler.process_chunk(parser, parsed_piece.parsed, level, result.recorder, *scratch);
+        // The labels a piece does not define are left to the linker, so each piece can be
+        // finished on its own.
+        assembler.finish_section(parser, result.recorder, *scratch);
+        scratches[target].give_back(std::move(scratch));
+    });
+
+    bool success = true;
+    for (std::size_t target = 0; target != targets.size(); ++target) {
+        Linker linker(*targets[target].assembler, level, *targets[target].sink);
+        for (std::size_t piece = 0; piece != pieces.size(); ++piece) {
+            PieceResult &result = results[piece * targets.size() + target];
+            result.recorder.replay(linker);
+            success &= result.success;
+        }
+        success &= linker.finish();
+    }
+    return success;
+}
+
+auto Assembler::ScratchPool::take() -> std::unique_ptr<Scratch> {
+    {
+        std::scoped_lock const lock(mutex_);
+        if (!free_.empty()) {
+            std::unique_ptr<Scratch> scratch = std::move(free_.back());
+            free_.pop_back();
+            return scratch;
+        }
+    }
+    return std::make_unique<Scratch>();
+}
+
+void Assembler::ScratchPool::give_back(std::unique_ptr<Scratch> scratch) {
+    std::scoped_lock const lock(mutex_);
+    free_.push_back(std::move(scratch));
+}
+
+auto Assembler::process_chunk(
+    SassParser &parser,
+    ParsedChunk const &parsed,
+    ValidationLevel level,
+    SectionSink &output,
+    Scratch &scratch
+) const -> bool {
+    bool success = true;
+    for (SassStatement const &statement : parsed.statements) {
+        switch (statement.kind) {
+        case SassStatement::Section:
+            finish_section(parser, output, scratch);
+            scratch.section.name = statement.name;
+            output.begin_section(statement.name);
+            break;
+
+        case SassStatement::Label:
+            success &= define_label(parser, statement, level, output, scratch);
+            break;
+
+        case SassStatement::Instruction:
+            success &= assemble_instruction(
+                parser,
+                statement,
+                parsed.instruction_tokens(statement),
+                level,
+                output,
+                scratch
+            );
+            break;
+        }
+    }
+
+    // The chunk is about to be discarded, so create the diagnostics of the labels referenced in it
+    // that are still undefined.
+    SectionState &section = scratch.section;
+    for (std::uint32_t const index : section.chunk_references) {
+        if (!section.labels[index].offset) {
+            section.undefined_labels.emplace_back(index, reference(parser, section, index));
+        }
+    }
+    section.chunk_references.clear();
+
+    if (scratch.match_time != std::chrono::nanoseconds::zero()) {
+        Metrics::observe(Stage::Match, scratch.match_time);
+        Metrics::observe(Stage::Encode, scratch.encode_time);
+        scratch.match_time = scratch.encode_time = std::chrono::nanoseconds::zero();
+    }
+
+    // The parser only reports errors.
+    std::vector<Diag> diags = parser.take_diagnostics();
+    success &= diags.empty();
+    for (Diag &diag : diags) {
+        output.report(std::move(diag));
+    }
+
+    return success;
+}
+
+auto Assembler::define_label(
+    SassParser &parser,
+    SassStatement const &statement,
+    ValidationLevel level,
+    AssemblySink &sink,
+    Scratch &scratch
+) const -> bool {
+    SectionState &section = scratch.section;
+    std::uint32_t const index = section.labels.intern(statement.name);
+    if (auto const offset = section.labels[index].offset) {
+        sink.report(parser.create_diag(
+            statement.range,
+            DiagLevel::Error,
+            "Duplicate label",
+            fmt::format("`{}` is already defined at offset {:#x}", statement.name, *offset)
+        ));
+        return false;
+    }
+
+    bool success = true;
+    section.labels.define(
+        index,
+        section.offset,
+        [&](Fixup const &fixup, std::span<std::int64_t> operands) {
+            operands[fixup.slot] = label_value(
+                section.offset,
+                fixup.offset,
+                fixup.is_relative,
+                instruction_size()
+            );
+
+            InstructionWord &word =
+                section.held_words[(fixup.offset - section.held_offset) / instruction_size()];
+            scratch.issues.clear();
+            InstructionClass const &instruction_class = isa().classes[fixup.class_index];
+            std::uint32_t const slot = fixup.slot;
+            if (check_label_conditions(level, instruction_class, slot, operands, scratch.issues)) {
+                encoder_.patch(instruction_class, slot, operands, word, scratch.issues);
+            }
+            for (EncodeIssue const &issue : scratch.issues) {
+                if (issue.kind == EncodeIssue::ConditionViolated) {
+                    sink.report(parser.create_diag(
+                        statement.range,
+                        issue.level,
+                        issue.message,
+                        fmt::format(
+                            "violates a condition of type `{}` for the instruction at offset "
+                            "{:#x}",
+                            issue.subject,
+                            fixup.offset
+                        )
+                    ));
+                } else {
+                    sink.report(parser.create_diag(
+                        statement.range,
+                        DiagLevel::Error,
+                        fmt::format("Cannot patch the label into field `{}`", issue.subject),
+                        fmt::format(
+                            "{} for the instruction at offset {:#x}",
+                            issue.message,
+                            fixup.offset
+                        )
+                    ));
+                }
+                success &= issue.level != DiagLevel::Error;
+            }
+        }
+    );
+
+    if (section.labels.pending_fixup_count() == 0) {
+        for (InstructionWord const &word : section.held_words) {
+            sink.emit(word);
+        }
+        section.held_words.clear();
+    }
+    return success;
+}
+
+void Assembler::finish_section(SassParser &parser, SectionSink &output, Scratch &scratch) const {
+    SectionState &section = scratch.section;
+
+    // The instructions waiting for the labels of other sections keep their placeholder targets
+    // until the linker patches them.
+    for (InstructionWord const &word : section.held_words) {
+        output.emit(word);
+    }
+
+    FinishedSection finished;
+    if (section.name.starts_with(".text.")) {
+        finished.symbols.push_back({ section.name.substr(6), 0 });
+    }
+    for (std::uint32_t index = 0; index != section.labels.size(); ++index) {
+        if (auto const offset = section.labels[index].offset) {
+            finished.symbols.push_back({ std::string(section.labels.name(index)), *offset });
+        }
+    }
+
+    auto const defer = [&](std::uint32_t index, ants::AnnotatedSource reference) {
+        FinishedSection::DeferredLabel &label = finished.labels.emplace_back(
+            std::string(section.labels.name(index)),
+            std::move(reference),
+            std::vector<FinishedSection::DeferredFixup>()
+        );
+        section.labels.for_each_fixup(
+            index,
+            [&label](Fixup const &fixup, std::span<std::int64_t const> operands) {
+                label.fixups.push_back({ fixup, { operands.begin(), operands.end() } });
+            }
+        );
+    };
+    // The labels referenced in previous chunks come first in the source.
+    for (auto &[index, first_reference] : section.undefined_labels) {
+        if (!section.labels[index].offset) {
+            defer(index, std::move(first_reference));
+        }
+    }
+    for (std::uint32_t const index : section.chunk_references) {
+        if (!section.labels[index].offset) {
+            defer(index, reference(parser, section, index));
+        }
+    }
+    output.end_section(std::move(finished));
+
+    section.name.clear();
+    section.labels.clear();
+    section.offset = 0;
+    section.held_words.clear();
+    section.chunk_references.clear();
+    section.undefined_labels.clear();
+}
+
+void Assembler::Linker::end_section(FinishedSection section) {
+    if (!offset_) {
+        for (FinishedSection::DeferredLabel &label : section.labels) {
+            sink_.report(
+                Diag(DiagLevel::Error, "Undefined label")
+                    .with_source(std::move(label.reference))
+                    .with_sub_diag_entry(
+                        DiagLevel::Note,
+                        "the sections of a cubin are placed independently, and it has no "
+                        "relocations to refer to the labels of other sections with"
+                    )
+            );
+            success_ = false;
+        }
+        return;
+    }
+
+    Section ended = std::exchange(current_, Section());
+    // Nothing precedes the first section of most files.
+    if (!ended.name && ended.words.empty() && section.symbols.empty()) {
+        return;
+    }
+    ended.id = section_count_++;
+    ended.symbols = std::move(section.symbols);
+    ended.labels = std::move(section.labels);
+    add_symbols(ended);
+    held_.push_back(std::move(ended));
+    place_ready();
+}
+
+auto Assembler::Linker::finish() -> bool {
+    if (offset_) {
+        std::uint64_t base = *offset_;
+        for (Section const &section : held_) {
+            place_symbols(section, base);
+            base += section.words.size() * assembler_.instruction_size();
+        }
+        for (Section &section : held_) {
+            link(section);
+        }
+        held_.clear();
+    }
+    return success_;
+}
+
+void Assembler::Linker::add_symbols(Section const &section) {
+    for (IncrementalState::Symbol const &symbol : section.symbols) {
+        Symbol const entry { .offset = std::nullopt, .section = section.id };
+        auto const [iter, is_new] = symbols_.try_emplace(symbol.name, entry);
+        if (is_new || iter->second.section == section.id) {
+            continue;
+        }
+        // Labels are local to their sections, so a name defined in several sections is only a
+        // problem if another section refers to it.
+        if (iter->second.is_referenced && !iter->second.is_duplicate) {
+            sink_.report(Diag(
+                DiagLevel::Error,
+                fmt::format(
+                    "`{}` is defined in more than one section, but a reference from another "
+                    "section has already been resolved to its first definition",
+                    symbol.name
+                )
+            ));
+            success_ = false;
+        }
+        iter->second.is_duplicate = true;
+    }
+}
+
+auto Assembler::Linker::is_ready(Section &section) -> bool {
+    bool is_ready = true;
+    for (auto label = section.labels.begin(); label != section.labels.end();) {
+        auto const symbol = symbols_.find(label->name);
+        if (symbol != symbols_.end() && symbol->second.is_duplicate) {
+            report_duplicate(*label);
+            label = section.labels.erase(label);
+            continue;
+        }
+        is_ready &= symbol != symbols_.end()
+                 && (symbol->second.offset || symbol->second.section == section.id);
+        ++label;
+    }
+    return is_ready;
+}
+
+void Assembler::Linker::place_ready() {
+    for (std::size_t i = 0; i != held_.size();) {
+        if (!is_ready(held_[i])) {
+            ++i;
+            continue;
+        }
+        Section section = std::move(held_[i]);
+        held_.erase(held_.begin() + static_cast<std::ptrdiff_t>(i));
+        place_symbols(section, *offset_);
+        link(section);
+        // The symbols placed with the section may be all that an earlier one waits for.
+        i = 0;
+    }
+}
+
+void Assembler::Linker::place_symbols(Section const &section, std::uint64_t base) {
+    for (IncrementalState::Symbol const &symbol : section.symbols) {
+        Symbol &entry = symbols_.at(symbol.name);
+        if (entry.section == section.id) {
+            entry.offset = base + symbol.offset;
+        }
+    }
+}
+
+void Assembler::Linker::link(Section &section) {
+    unsigned const size = assembler_.instruction_size();
+    std::uint64_t const base = *offset_;
+    for (FinishedSection::DeferredLabel &label : section.labels) {
+        auto const symbol = symbols_.find(label.name);
+        if (symbol == symbols_.end()) {
+            sink_.report(
+                Diag(DiagLevel::Error, "Undefined label")
+                    .with_source(std::move(label.reference))
+                    .with_sub_diag_entry(DiagLevel::Note, "no other section defines it either")
+            );
+            success_ = false;
+            continue;
+        }
+        if (symbol->second.is_duplicate) {
+            report_duplicate(label);
+            continue;
+        }
+
+        symbol->second.is_referenced = true;
+        for (auto &[fixup, operands] : label.fixups) {
+            operands[fixup.slot] =
+                label_value(*symbol->second.offset, base + fixup.offset, fixup.is_relative, size);
+
+            InstructionWord &word = section.words[fixup.offset / size];
+            issues_.clear();
+            InstructionClass const &instruction_class =
+                assembler_.isa().classes[fixup.class_index];
+            bool const is_valid = assembler_.check_label_conditions(
+                level_,
+                instruction_class,
+                fixup.slot,
+                operands,
+                issues_
+            );
+            if (is_valid) {
+                assembler_.encoder_.patch(instruction_class, fixup.slot, operands, word, issues_);
+            }
+            for (EncodeIssue const &issue : issues_) {
+                if (issue.kind == EncodeIssue::ConditionViolated) {
+                    sink_.report(Diag(
+                        issue.level,
+                        fmt::format(
+                            "{}: the instruction at offset {:#x} of its section violates a "
+                            "condition of type `{}` with `{}` as its target",
+                            issue.message,
+                            fixup.offset,
+                            issue.subject,
+                            label.name
+                        )
+                    ));
+                } else {
+                    sink_.report(Diag(
+                        DiagLevel::Error,
+                        fmt::format(
+                            "Cannot patch `{}` into field `{}` of the instruction at offset {:#x} "
+                            "of its section: {}",
+                            label.name,
+                            issue.subject,
+                            fixup.offset,
+                            issue.message
+                        )
+                    ));
+                }
+                success_ &= issue.level != DiagLevel::Error;
+            }
+        }
+    }
+
+    if (section.name) {
+        sink_.begin_section(*section.name);
+    }
+    for (InstructionWord const &word : section.words) {
+        sink_.emit(word);
+    }
+    *offset_ += section.words.size() * size;
+}
+
+void Assembler::Linker::report_duplicate(FinishedSection::DeferredLabel &label) {
+    sink_.report(
+        Diag(DiagLevel::Error, "Duplicate definition")
+            .with_source(std::move(label.reference))
+            .with_sub_diag_entry(
+                DiagLevel::Note,
+                "it is defined in more than one other section, so the reference is ambiguous"
+            )
+    );
+    success_ = false;
+}
+
+auto Assembler::check_label_conditions(
+    ValidationLevel level,
+    InstructionClass const &instruction_class,
+    std::uint32_t slot,
+    std::span<std::int64_t const> operands,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    if (level == ValidationLevel::Trusted) {
+        return true;
+    }
+
+    // The conditions of kind `ConditionType::Error` come first.
+    std::span<Condition const> const conditions = level == ValidationLevel::ErrorsOnly
+                                                    ? instruction_class.error_conditions()
+                                                    : std::span(instruction_class.conditions);
+    bool success = true;
+    for (Condition const &condition : conditions) {
+        if (condition.expr.uses_operand(slot)) {
+            success &= encoder_.check_condition(condition, operands, issues);
+        }
+    }
+    return success;
+}
+
+auto Assembler::reference(
+    SassParser &parser,
+    SectionState const &section,
+    std::uint32_t index
+) -> ants::AnnotatedSource {
+    return parser.annotate(
+        section.labels[index].reference,
+        fmt::format("`{}` is not defined in this section", section.labels.name(index))
+    );
+}
+
+void Assembler::emit(InstructionWord const &word, AssemblySink &sink, SectionState &section) const {
+    if (section.labels.pending_fixup_count() == 0) {
+        sink.emit(word);
+    } else {
+        if (section.held_words.empty()) {
+            section.held_offset = section.offset;
+        }
+        section.held_words.push_back(word);
+    }
+    section.offset += instruction_size();
+}
+
+auto Assembler::assemble_instruction(
+    SassParser &parser,
+    SassStatement const &statement,
+    std::span<SassToken const> tokens,
+    ValidationLevel level,
+    AssemblySink &sink,
+    Scratch &scratch
+) const -> bool {
+    StageClock clock(scratch.match_time, scratch.encode_time);
+    SectionState &section = scratch.section;
+
+    bool const is_memoizable = std::ranges::none_of(tokens, [](SassToken const &token) {
+        return token.kind == SassToken::Label;
+    });
+    if (is_memoizable) {
+        memo_key(statement, tokens, scratch.memo_key);
+        if (InstructionWord const *const word = scratch.memo.find(scratch.memo_key)) {
+            Metrics::add(Counter::MemoHits);
+            emit(*word, sink, section);
+            Metrics::add(Counter::Instructions);
+            return true;
+        }
+        Metrics::add(Counter::MemoMisses);
+    }
+
+    std::size_t mnemonic_size = 0;
+    auto const candidates = matcher_.find_candidates(tokens, mnemonic_size);
+    if (candidates.empty()) {
+        sink.report(parser.create_diag(
+            tokens.front().range,
+            DiagLevel::Error,
+            "Unknown instruction",
+            fmt::format("`{}` is not an opcode of this architecture", tokens.front().text)
+        ));
+        return false;
+    }
+
+    // Try the candidates in order, and use the first one that can encode the instruction. If none
+    // of them can, report the encoding problems of the first class that matches the syntax, or the
+    // syntax error that got the furthest.
+    auto const progress = [](BindFailure const &failure) {
+        return failure.token_index == BindFailure::PREDICATE ? 0 : failure.token_index + 1;
+    };
+
+    std::optional<BindFailure> bind_failure;
+    bool has_encode_failure = false;
+    for (InstructionMatcher::Candidate const candidate : candidates) {
+        BindFailure failure;
+        bool const is_bound = matcher_.bind(
+            candidate,
+            statement,
+            tokens,
+            mnemonic_size,
+            scratch.operands,
+            scratch.labels,
+            failure
+        );
+        if (!is_bound) {
+            if (!bind_failure || progress(failure) > progress(*bind_failure)) {
+                bind_failure = failure;
+            }
+            continue;
+        }
+
+        // Fill in the labels that are already defined. The other ones keep the placeholder value,
+        // and are patched when they are defined.
+        bool has_forward_reference = false;
+        for (LabelOperand const &label : scratch.labels) {
+            std::uint32_t const index = section.labels.intern(tokens[label.token_index].text);
+            if (auto const target = section.labels[index].offset) {
+                scratch.operands[label.slot] =
+                    label_value(*target, section.offset, label.is_relative, instruction_size());
+            } else {
+                has_forward_reference = true;
+            }
+        }
+
+        scratch.issues.clear();
+        InstructionClass const &instruction_class = isa().classes[candidate.class_index];
+        if (auto const word = clock.encoding([&] {
+                return encoder_.encode(level, instruction_class, scratch.operands, scratch.issues);
+            }))
+        {
+            report_issues(parser, statement, scratch.issues, sink);
+            // The issues would have to be reported again for each repetition, so an instruction
+            // with issues is not memoized.
+            if (is_memoizable && scratch.issues.empty()) {
+                scratch.memo.insert(scratch.memo_key, *word);
+            }
+            if (has_forward_reference) {
+                for (LabelOperand const &label : scratch.labels) {
+                    std::uint32_t const index =
+                        section.labels.intern(tokens[label.token_index].text);
+                    LabelTable::Label &entry = section.labels[index];
+                    if (entry.offset) {
+                        continue;
+                    }
+
+                    if (entry.first_fixup == LabelTable::NO_FIXUP) {
+                        entry.reference = tokens[label.token_index].range;
+                        section.chunk_references.push_back(index);
+                    }
+                    Fixup const fixup {
+                        .offset = section.offset,
+                        .class_index = candidate.class_index,
+                        .slot = label.slot,
+                        .is_relative = label.is_relative,
+                    };
+                    section.labels.add_fixup(index, fixup, scratch.operands);
+                }
+            }
+            emit(*word, sink, section);
+            Metrics::add(Counter::Instructions);
+            return true;
+        }
+
+        if (!has_encode_failure) {
+            has_encode_failure = true;
+            std::swap(scratch.failed_issues, scratch.issues);
+        }
+    }
+
+    if (has_encode_failure) {
+        report_issues(parser, statement, scratch.failed_issues, sink);
+        return false;
+    }
+
+    TokenRange range = statement.range;
+    if (bind_failure->token_index == BindFailure::PREDICATE) {
+        // Point at the guard predicate, which is before the mnemonic.
+        range = TokenRange(
+            statement.range.location_begin(),
+            tokens.front().range.location_begin()
+        );
+    } else if (bind_failure->token_index < tokens.size()) {
+        range = tokens[bind_failure->token_index].range;
+    } else {
+        // The instruction ends too early. Point at the `;`.
+        range = TokenRange(statement.range.location_end() - 1, statement.range.location_end());
+    }
+
+    sink.report(parser.create_diag(
+        range,
+        DiagLevel::Error,
+        bind_failure->message,
+        bind_failure->subject.empty() ? std::string()
+                                      : fmt::format("expected `{}`", bind_failure->subject)
+    ));
+    return false;
+}
+
+auto Assembler::report_issues(
+    SassParser &parser,
+    SassStatement const &statement,
+    std::span<EncodeIssue const> issues,
+    AssemblySink &sink
+) -> bool {
+    bool success = true;
+    for (EncodeIssue const &issue : issues) {
+        switch (issue.kind) {
+        case EncodeIssue::ConditionViolated:
+            sink.report(parser.create_diag(
+                statement.range,
+                issue.level,
+                issue.message,
+                fmt::format("violates a condition of type `{}`", issue.subject)
+            ));
+            break;
+
+        case EncodeIssue::ValueOutOfRange:
+            sink.report(parser.create_diag(
+                statement.range,
+                issue.level,
+                fmt::format("Value out of range for field `{}`", issue.subject)
+            ));
+            break;
+
+        case EncodeIssue::EvaluationFailed:
+            sink.report(parser.create_diag(
+                statement.range,
+                issue.level,
+                fmt::format("Cannot compute the value of field `{}`", issue.subject)
+            ));
+            break;
+        }
+
+        success &= issue.level != DiagLevel::Error;
+    }
+
+    return success;
+}
+}  // namespace sassas
@@ -0,0 +1,92 @@
+#include "sassas/assembler/incremental_state.hpp"
+
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/utils/image_io.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+auto IncrementalState::read(std::span<std::byte const> image, std::string context)
+    -> IncrementalState  //
+{
+    IncrementalState state(std::move(context));
+    ImageReader reader(image);
+    if (reader.u32() != MAGIC || reader.u32() != VERSION || reader.string() != state.context_) {
+        return state;
+    }
+
+    std::uint32_t const piece_count = reader.count(8);
+    for (std::uint32_t i = 0; i != piece_count && reader.ok(); ++i) {
+        std::string key = reader.string();
+        std::vector<Run> runs(reader.count(9));
+        for (Run &run : runs) {
+            if (reader.boolean()) {
+                run.name = reader.string();
+            }
+            run.words.resize(reader.count(16));
+            for (InstructionWord &word : run.words) {
+                word.words[0] = reader.u64();
+                word.words[1] = reader.u64();
+            }
+            run.symbols.resize(reader.count(12));
+            for (Symbol &symbol : run.symbols) {
+                symbol.name = reader.string();
+                symbol.offset = reader.u64();
+            }
+        }
+        state.pieces_.emplace(std::move(key), std::move(runs));
+    }
+
+    // A state that is only partially readable is not trusted at all.
+    if (!reader.ok() || !reader.at_end()) {
+        state.pieces_.clear();
+    }
+    return state;
+}
+
+auto IncrementalState::write() const -> std::vector<std::byte> {
+    ImageWriter writer;
+    writer.u32(MAGIC);
+    writer.u32(VERSION);
+    writer.string(context_);
+
+    writer.u32(static_cast<std::uint32_t>(pieces_.size()));
+    for (auto const &[key, runs] : pieces_) {
+        writer.string(key);
+        writer.u32(static_cast<std::uint32_t>(runs.size()));
+        for (Run const &run : runs) {
+            writer.u8(run.name.has_value());
+            if (run.name) {
+                writer.string(*run.name);
+            }
+            writer.u32(static_cast<std::uint32_t>(run.words.size()));
+            for (InstructionWord const &word : run.words) {
+                writer.u64(word.words[0]);
+                writer.u64(word.words[1]);
+            }
+            writer.u32(static_cast<std::uint32_t>(run.symbols.size()));
+            for (Symbol const &symbol : run.symbols) {
+                writer.string(symbol.name);
+                writer.u64(symbol.offset);
+            }
+        }
+    }
+    return writer.take();
+}
+
+auto IncrementalState::find(std::string_view key) const -> std::vector<Run> const * {
+    auto const iter = pieces_.find(key);
+    return iter == pieces_.end() ? nullptr : &iter->second;
+}
+
+void IncrementalState::add(std::string key, std::vector<Run> runs) {
+    pieces_.insert_or_assign(std::move(key), std::move(runs));
+}
+}  // namespace sassas
@@ -0,0 +1,418 @@
+#include "sassas/assembler/instruction_matcher.hpp"
+
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/register.hpp"
+#include "sassas/lexer/token.hpp"
+#include "sassas/parser/sass_parser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// Returns the spelling of the punctuator `kind`, or an empty string if `kind` is not a
+/// punctuator.
+auto punctuator_spelling(Token::TokenKind kind) -> std::string_view {
+    switch (kind) {
+#define SASSAS_PUNCTUATOR(name, spelling) \
+    case Token::Punctuator##name:         \
+        return spelling;
+#include "sassas/lexer/punctuator.def"
+    default:
+        return {};
+    }
+}
+
+auto to_lower(char ch) -> char {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+}
+
+/// Returns the number of tokens starting at `tokens[index]` that are written as one dotted name,
+/// such as `FADD.FTZ` or `F32.F16`. The first token can be a name or a modifier, and the others
+/// must be modifiers that directly follow the previous token and its `.`.
+auto dotted_name_size(std::span<SassToken const> tokens, std::size_t index) -> std::size_t {
+    std::size_t size = 1;
+    while (index + size < tokens.size()) {
+        SassToken const &token = tokens[index + size];
+        if (token.kind != SassToken::Modifier
+            || token.range.location_begin() != tokens[index + size - 1].range.location_end() + 1)
+        {
+            break;
+        }
+        ++size;
+    }
+    return size;
+}
+
+/// Returns the text of the dotted name formed by `tokens[index, index + size)`. The tokens must be
+/// adjacent in the source, as checked by `dotted_name_size()`.
+auto dotted_name(std::span<SassToken const> tokens, std::size_t index, std::size_t size)
+    -> std::string_view  //
+{
+    std::string_view const first = tokens[index].text;
+    std::string_view const last = tokens[index + size - 1].text;
+    return { first.data(), static_cast<std::size_t>(last.data() + last.size() - first.data()) };
+}
+}  // namespace
+
+InstructionMatcher::InstructionMatcher(ISA const &isa) : isa_(isa) {
+    for (auto const &[category, group] : isa.registers) {
+        NameMap names;
+        for (Register const &reg : group.registers()) {
+            std::string name = reg.name;
+            std::ranges::transform(name, name.begin(), to_lower);
+            // `RegisterGroup::find` returns the last register with the given name, so later
+            // registers overwrite the earlier ones here.
+            names.insert_or_assign(std::move(name), reg.value);
+        }
+        name_maps_.emplace(category, std::move(names));
+    }
+
+    item_infos_.reserve(isa.classes.size());
+    for (std::size_t class_index = 0; class_index != isa.classes.size(); ++class_index) {
+        InstructionClass const &instruction_class = isa.classes[class_index];
+
+        for (auto const &[opcode_name, opcode] : instruction_class.opcodes) {
+            // If a class lists the same opcode twice, the last one wins, as in the decoder.
+            std::vector<Candidate> &candidates = candidates_[opcode_name];
+            if (!candidates.empty() && candidates.back().class_index == class_index) {
+                candidates.back().opcode = opcode;
+            } else {
+                candidates.push_back({ static_cast<std::uint32_t>(class_index), opcode });
+            }
+        }
+
+        std::vector<ItemInfo> &infos = item_infos_.emplace_back(instruction_class.format.size());
+        for (std::size_t i = 0; i != instruction_class.format.size(); ++i) {
+            FormatItem const &item = instruction_class.format[i];
+            if (item.kind != FormatItem::Register && item.kind != FormatItem::Modifier) {
+                continue;
+            }
+
+            ItemInfo &info = infos[i];
+            if (auto const iter = name_maps_.find(item.type); iter != name_maps_.end()) {
+                info.names = &iter->second;
+            }
+
+            static constexpr std::string_view prefix_attributes[] = {
+                "@negate",
+                "@absolute",
+                "@not",
+                "@invert",
+            };
+            for (std::size_t prefix = 0; prefix != info.prefix_slots.size(); ++prefix) {
+                if (item.prefixes & (1u << prefix)) {
+                    std::string slot_name = item.name;
+                    slot_name += prefix_attributes[prefix];
+                    if (auto const slot = instruction_class.find_slot(slot_name)) {
+                        info.prefix_slots[prefix] = *slot;
+                    }
+                }
+            }
+        }
+    }
+}
+
+auto InstructionMatcher::find_name(NameMap const &names, std::string_view name)
+    -> std::optional<std::int64_t>  //
+{
+    if (name.size() > MAX_NAME_SIZE) {
+        return std::nullopt;
+    }
+
+    char buffer[MAX_NAME_SIZE];
+    std::ranges::transform(name, buffer, to_lower);
+    if (auto const iter = names.find(std::string_view(buffer, name.size()));
+        iter != names.end())
+    {
+        return iter->second;
+    } else {
+        return std::nullopt;
+    }
+}
+
+auto InstructionMatcher::find_candidates(
+    std::span<SassToken const> tokens,
+    std::size_t &mnemonic_size
+) const -> std::span<Candidate const> {
+    if (tokens.empty() || tokens.front().kind != SassToken::Name) {
+        return {};
+    }
+
+    for (std::size_t size = dotted_name_size(tokens, 0); size != 0; --size) {
+        if (auto const iter = candidates_.find(dotted_name(tokens, 0, size));
+            iter != candidates_.end())
+        {
+            mnemonic_size = size;
+            return iter->second;
+        }
+    }
+
+    return {};
+}
+
+auto InstructionMatcher::bind(
+    Candidate candidate,
+    SassStatement const &statement,
+    std::span<SassToken const> tokens,
+    std::size_t mnemonic_size,
+    std::vector<std::int64_t> &operands,
+    std::vector<LabelOperand> &labels,
+    BindFailure &failure
+) const -> bool {
+    InstructionClass const &instruction_class = isa_.classes[candidate.class_index];
+    std::vector<ItemInfo> const &infos = item_infos_[candidate.class_index];
+    std::span<FormatItem const> const format = instruction_class.format;
+
+    // Start with the default values, so that the operands omitted in the text (including all
+    // scheduling operands) are filled in.
+    operands.assign(instruction_class.slot_names.size(), 0);
+    for (std::size_t i = 0; i != format.size(); ++i) {
+        FormatItem const &item = format[i];
+        if (item.kind == FormatItem::Immediate && item.default_value) {
+            operands[item.slot] = *item.default_value;
+        } else if (item.default_name && infos[i].names) {
+            if (auto const value = find_name(*infos[i].names, *item.default_name)) {
+                operands[item.slot] = *value;
+            }
+        }
+    }
+    operands[InstructionClass::OPCODE_SLOT] = static_cast<std::int64_t>(candidate.opcode);
+    labels.clear();
+
+    auto const fail = [&](std::size_t index, std::string_view message, std::string_view subject) {
+        failure = { .token_index = index, .message = message, .subject = subject };
+        return false;
+    };
+
+    auto const is_punctuator = [&](std::size_t index, Token::TokenKind kind) {
+        return index < tokens.size() && tokens[index].kind == SassToken::Punctuator
+            && tokens[index].punctuator == kind;
+    };
+
+    // Looks up the longest dotted name starting at `tokens[index]` in `names`. Returns the value
+    // and the number of tokens of the name.
+    auto const match_name = [&](NameMap const &names, std::size_t index)
+        -> std::optional<std::pair<std::int64_t, std::size_t>>  //
+    {
+        for (std::size_t size = dotted_name_size(tokens, index); size != 0; --size) {
+            if (auto const value = find_name(names, dotted_name(tokens, index, size))) {
+                return std::pair(*value, size);
+            }
+        }
+        return std::nullopt;
+    };
+
+    // Matches a register operand with its prefixes, such as `-|R2|`.
+    auto const match_register =
+        [&](FormatItem const &item, ItemInfo const &info, std::size_t &pos) {
+            static constexpr Token::TokenKind prefix_punctuators[] = {
+                Token::PunctuatorMinus,
+                Token::PunctuatorPipe,
+                Token::PunctuatorExclaim,
+                Token::PunctuatorTilde,
+            };
+
+            std::array<bool, 4> prefixes {};
+            while (pos < tokens.size()) {
+                auto const prefix = std::ranges::find_if(prefix_punctuators, [&](auto kind) {
+                    return is_punctuator(pos, kind);
+                });
+                if (prefix == std::ranges::end(prefix_punctuators)) {
+                    break;
+                }
+
+                auto const index = static_cast<std::size_t>(prefix - prefix_punctuators);
+                if (info.prefix_slots[index] == NO_SLOT || prefixes[index]) {
+                    return false;
+                }
+                prefixes[index] = true;
+                ++pos;
+            }
+
+            if (pos == tokens.size() || tokens[pos].kind != SassToken::Name || !info.names) {
+                return false;
+            }
+            auto const value = find_name(*info.names, tokens[pos].text);
+            if (!value) {
+                return false;
+            }
+            ++pos;
+
+            // The closing `|` of `|R2|`.
+            if (prefixes[1]) {
+                if (!is_punctuator(pos, Token::PunctuatorPipe)) {
+                    return false;
+                }
+                ++pos;
+            }
+
+            operands[item.slot] = *value;
+            for (std::size_t index = 0; index != prefixes.size(); ++index) {
+                if (prefixes[index]) {
+                    operands[info.prefix_slots[index]] = 1;
+                }
+            }
+            return true;
+        };
+
+    // Matches an item of the format. Returns `false` without consuming any token if the item does
+    // not match.
+    auto const match_item = [&](FormatItem const &item, ItemInfo const &info, std::size_t &pos) {
+        switch (item.kind) {
+        case FormatItem::Modifier: {
+            if (pos == tokens.size() || tokens[pos].kind != SassToken::Modifier || !info.names) {
+                return false;
+            }
+
+            auto const match = match_name(*info.names, pos);
+            if (match) {
+                operands[item.slot] = match->first;
+                pos += match->second;
+            }
+            return match.has_value();
+        }
+
+        case FormatItem::Register: {
+            std::size_t current = pos;
+            if (match_register(item, info, current)) {
+                pos = current;
+                return true;
+            }
+            return false;
+        }
+
+        case FormatItem::Immediate: {
+            if (pos != tokens.size() && tokens[pos].kind == SassToken::Label) {
+                labels.push_back({
+                    .slot = item.slot,
+                    .token_index = static_cast<std::uint32_t>(pos),
+                    .is_relative = item.is_relative_immediate(),
+                });
+                operands[item.slot] = 0;
+                ++pos;
+                return true;
+            }
+            if (pos == tokens.size() || tokens[pos].kind != SassToken::Integer) {
+                return false;
+            }
+
+            // The value must fit into the immediate as either a signed or an unsigned integer. The
+            // encoder checks whether it fits into the field.
+            std::int64_t const value = tokens[pos].value;
+            if (item.bits != 0 && item.bits < 64) {
+                std::int64_t const min = -(std::int64_t(1) << (item.bits - 1));
+                std::int64_t const max = (std::int64_t(1) << item.bits) - 1;
+                if (value < min || value > max) {
+                    return false;
+                }
+            }
+
+            operands[item.slot] = value;
+            ++pos;
+            return true;
+        }
+
+        case FormatItem::Literal: {
+            if (pos == tokens.size()) {
+                return false;
+            }
+
+            SassToken const &token = tokens[pos];
+            bool const matched =
+                token.kind == SassToken::Punctuator
+                    ? punctuator_spelling(token.punctuator) == item.type
+                    : token.kind == SassToken::Name
+                          && std::ranges::equal(token.text, item.type, {}, to_lower, to_lower);
+            if (matched) {
+                ++pos;
+            }
+            return matched;
+        }
+
+        default:
+            return false;
+        }
+    };
+
+    bool has_predicate = false;
+    std::size_t pos = mnemonic_size;
+    for (std::size_t i = 0; i != format.size(); ++i) {
+        FormatItem const &item = format[i];
+        ItemInfo const &info = infos[i];
+        if (item.is_scheduling || item.kind == FormatItem::Opcode) {
+            continue;
+        }
+
+        if (item.is_predicate) {
+            has_predicate = true;
+            if (statement.predicate.empty()) {
+                continue;
+            }
+
+            auto const value =
+                info.names ? find_name(*info.names, statement.predicate) : std::nullopt;
+            std::uint32_t const not_slot = info.prefix_slots[2];
+            if (!value || (statement.is_predicate_negated && not_slot == NO_SLOT)) {
+                return fail(BindFailure::PREDICATE, "Invalid guard predicate", item.type);
+            }
+
+            operands[item.slot] = *value;
+            if (not_slot != NO_SLOT) {
+                operands[not_slot] = statement.is_predicate_negated;
+            }
+            continue;
+        }
+
+        std::size_t const start = pos;
+        if (match_item(item, info, pos) || item.is_optional) {
+            continue;
+        }
+
+        // Modifiers with a default value may be omitted.
+        if (item.kind == FormatItem::Modifier && item.default_name) {
+            continue;
+        }
+
+        // The offset of an address may be omitted together with its `+`, as in `[R2]`.
+        if (item.kind == FormatItem::Literal && item.type == "+" && i + 1 != format.size()
+            && format[i + 1].kind == FormatItem::Immediate && format[i + 1].default_value)
+        {
+            ++i;
+            continue;
+        }
+
+        switch (item.kind) {
+        case FormatItem::Modifier:
+            return fail(start, "Missing modifier", item.type);
+        case FormatItem::Register:
+            return fail(start, "Expected a register", item.type);
+        case FormatItem::Immediate:
+            if (start != tokens.size() && tokens[start].kind == SassToken::Integer) {
+                return fail(start, "Immediate out of range", item.type);
+            }
+            return fail(start, "Expected an immediate", item.type);
+        default:
+            return fail(start, "Expected a literal", item.type);
+        }
+    }
+
+    if (!statement.predicate.empty() && !has_predicate) {
+        return fail(BindFailure::PREDICATE, "The instruction has no guard predicate", {});
+    }
+    if (pos != tokens.size()) {
+        return fail(pos, "Unexpected operand", {});
+    }
+    return true;
+}
+}  // namespace sassas
@@ -0,0 +1,41 @@
+#include "sassas/assembler/instruction_memo.hpp"
+
+#include "sassas/isa/functional_unit.hpp"
+
+#include <cassert>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+auto InstructionMemo::find(std::string_view key) -> InstructionWord const * {
+    auto const iter = index_.find(key);
+    if (iter == index_.end()) {
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return &iter->second->word;
+}
+
+void InstructionMemo::insert(std::string_view key, InstructionWord const &word) {
+    assert(!index_.contains(key) && "The instruction is already memoized");
+    if (capacity_ == 0) {
+        return;
+    }
+    if (entries_.size() < capacity_) {
+        entries_.push_front({ .key = std::string(key), .word = word });
+        index_.emplace(entries_.front().key, entries_.begin());
+        return;
+    }
+
+    // Reuse the least recently used entry, and the node of its index entry.
+    entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+    Entry &entry = entries_.front();
+    auto node = index_.extract(entry.key);
+    entry.key.assign(key);
+    entry.word = word;
+    node.key() = entry.key;
+    index_.insert(std::move(node));
+}
+}  // namespace sassas
@@ -0,0 +1,78 @@
+#include "sassas/assembler/label_table.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+auto LabelTable::intern(std::string_view name) -> std::uint32_t {
+    std::size_t const hash = std::hash<std::string_view>()(name);
+    std::size_t const mask = slots_.size() - 1;
+
+    std::size_t slot = hash & mask;
+    for (; slots_[slot] != NO_LABEL; slot = (slot + 1) & mask) {
+        std::uint32_t const index = slots_[slot];
+        if (labels_[index].hash == hash && this->name(index) == name) {
+            return index;
+        }
+    }
+
+    auto const index = static_cast<std::uint32_t>(labels_.size());
+    labels_.push_back({
+        .name_offset = static_cast<std::uint32_t>(names_.size()),
+        .name_size = static_cast<std::uint32_t>(name.size()),
+        .hash = hash,
+    });
+    names_.insert(names_.end(), name.begin(), name.end());
+    slots_[slot] = index;
+
+    if (labels_.size() * 2 > slots_.size()) {
+        grow();
+    }
+    return index;
+}
+
+void LabelTable::add_fixup(
+    std::uint32_t index,
+    Fixup const &fixup,
+    std::span<std::int64_t const> operands
+) {
+    Label &label = labels_[index];
+    entries_.push_back({
+        .fixup = fixup,
+        .first_operand = static_cast<std::uint32_t>(operands_.size()),
+        .operand_count = static_cast<std::uint32_t>(operands.size()),
+        .next = label.first_fixup,
+    });
+    operands_.insert(operands_.end(), operands.begin(), operands.end());
+
+    label.first_fixup = static_cast<std::uint32_t>(entries_.size() - 1);
+    ++pending_fixup_count_;
+}
+
+void LabelTable::clear() {
+    labels_.clear();
+    std::ranges::fill(slots_, NO_LABEL);
+    names_.clear();
+    entries_.clear();
+    operands_.clear();
+    pending_fixup_count_ = 0;
+}
+
+void LabelTable::grow() {
+    slots_.assign(slots_.size() * 2, NO_LABEL);
+    std::size_t const mask = slots_.size() - 1;
+
+    for (std::uint32_t index = 0; index != labels_.size(); ++index) {
+        std::size_t slot = labels_[index].hash & mask;
+        while (slots_[slot] != NO_LABEL) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = index;
+    }
+}
+}  // namespace sassas
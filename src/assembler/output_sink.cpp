@@ -0,0 +1,75 @@
+#include "sassas/assembler/output_sink.hpp"
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/functional_unit.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+OutputSink::OutputSink(Format format, Writer write, unsigned word_bytes, Reporter report) :
+    format_(format),
+    write_(std::move(write)),
+    report_(std::move(report)),
+    word_bytes_(std::min(word_bytes, 16u)) { }
+
+void OutputSink::begin_section(std::string_view name) {
+    offset_ = 0;
+    if (cubin_) {
+        cubin_->begin_section(name);
+    } else if (format_ == Format::Listing) {
+        line_.clear();
+        fmt::format_to(std::back_inserter(line_), "{}:\n", name);
+        write_(line_);
+    }
+}
+
+void OutputSink::emit(InstructionWord const &word) {
+    if (cubin_) {
+        cubin_->append(word);
+        return;
+    }
+
+    line_.clear();
+    if (format_ == Format::Raw) {
+        for (unsigned i = 0; i != word_bytes_; ++i) {
+            line_.push_back(static_cast<char>(word.words[i / 8] >> (i % 8 * 8)));
+        }
+    } else if (word_bytes_ > 8) {
+        fmt::format_to(
+            std::back_inserter(line_),
+            "    /*{:04x}*/ 0x{:016x}{:016x}\n",
+            offset_,
+            word.words[1],
+            word.words[0]
+        );
+    } else {
+        fmt::format_to(
+            std::back_inserter(line_),
+            "    /*{:04x}*/ 0x{:016x}\n",
+            offset_,
+            word.words[0]
+        );
+    }
+    write_(line_);
+    offset_ += word_bytes_;
+    flat_offset_ += word_bytes_;
+}
+
+void OutputSink::report(Diag diag) {
+    report_(std::move(diag));
+}
+
+auto OutputSink::flat_offset() const -> std::optional<std::uint64_t> {
+    if (cubin_) {
+        return std::nullopt;
+    }
+    return flat_offset_;
+}
+}  // namespace sassas
@@ -0,0 +1,134 @@
+#include "sassas/decoder/binary_disassembler.hpp"
+
+#include "sassas/decoder/disassembler.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/elf/elf.hpp"
+#include "sassas/elf/elf_reader.hpp"
+#include "sassas/elf/fatbin_reader.hpp"
+#include "sassas/isa/isa.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace sassas {
+auto BinaryDisassembler::disassemble(
+    std::string_view name,
+    std::span<std::byte const> image,
+    unsigned thread_count,
+    Writer const &write,
+    Reporter const &report
+) -> bool {
+    std::string_view error;
+    if (auto const elf = ElfReader::read(image, error); elf && elf->machine() != elf::EM_CUDA) {
+        auto const sections = elf->sections();
+        auto const fatbin =
+            std::ranges::find(sections, std::string_view(".nv_fatbin"), &ElfSectionView::name);
+        if (fatbin != sections.end()) {
+            image = fatbin->data;
+        }
+    }
+
+    if (!FatbinReader::is_fatbin(image)) {
+        return disassemble_cubin(name, image, thread_count, write, report);
+    }
+
+    std::optional<FatbinReader> const fatbin = FatbinReader::read(image, error);
+    if (!fatbin) {
+        report(Diag(DiagLevel::Error, fmt::format("{} is not a valid fatbin: {}", name, error)));
+        return false;
+    }
+
+    bool success = true;
+    for (FatbinImage const &cubin : fatbin->images()) {
+        if (!cubin.is_cubin()) {
+            continue;
+        }
+        if (cubin.is_compressed) {
+            report(Diag(
+                DiagLevel::Warning,
+                fmt::format("Skipping the compressed sm_{} cubin of {}", cubin.sm_version, name)
+            ));
+            continue;
+        }
+
+        write(fmt::format("// {}: sm_{}\n", name, cubin.sm_version));
+        success &= disassemble_cubin(
+            fmt::format("The sm_{} cubin of {}", cubin.sm_version, name),
+            cubin.data,
+            thread_count,
+            write,
+            report
+        );
+    }
+    return success;
+}
+
+auto BinaryDisassembler::get(std::uint32_t sm_version) -> std::shared_ptr<Disassembler const> {
+    // The current version of the ISA is looked up every time, since it may have been replaced.
+    // Loading it must not hold up the other architectures.
+    std::shared_ptr<LoadedISA const> isa = registry_.get(fmt::format("sm_{}", sm_version));
+    if (!isa) {
+        return nullptr;
+    }
+    // The disassembler shares the ownership of its entry, which holds the ISA.
+    auto const disassembler_of = [](std::shared_ptr<VersionDisassembler const> const &entry) {
+        return std::shared_ptr<Disassembler const>(entry, &entry->disassembler);
+    };
+
+    {
+        std::scoped_lock const lock(mutex_);
+        if (auto const iter = disassemblers_.find(sm_version);
+            iter != disassemblers_.end() && iter->second->isa == isa)
+        {
+            return disassembler_of(iter->second);
+        }
+    }
+
+    // If another thread creates the same one in the meantime, its disassembler is kept. The one of
+    // another version is replaced, and freed once its binaries are done.
+    auto created = std::make_shared<VersionDisassembler const>(std::move(isa));
+
+    std::scoped_lock const lock(mutex_);
+    auto [iter, inserted] = disassemblers_.try_emplace(sm_version, created);
+    if (!inserted && iter->second->isa != created->isa) {
+        iter->second = std::move(created);
+    }
+    return disassembler_of(iter->second);
+}
+
+auto BinaryDisassembler::disassemble_cubin(
+    std::string_view name,
+    std::span<std::byte const> image,
+    unsigned thread_count,
+    Writer const &write,
+    Reporter const &report
+) -> bool {
+    std::string_view error;
+    std::optional<ElfReader> const elf = ElfReader::read(image, error);
+    if (!elf || elf->machine() != elf::EM_CUDA) {
+        report(Diag(
+            DiagLevel::Error,
+            fmt::format("{} is not a cubin: {}", name, elf ? "The machine is not CUDA" : error)
+        ));
+        return false;
+    }
+
+    // The version of the architecture is the low byte of `e_flags`, e.g. `90` for `sm_90`.
+    std::shared_ptr<Disassembler const> const disassembler = get(elf->flags() & 0xff);
+    if (!disassembler) {
+        return false;
+    }
+
+    disassembler->disassemble(*elf, thread_count, write);
+    return true;
+}
+}  // namespace sassas
@@ -0,0 +1,90 @@
+#include "sassas/decoder/decoded_instruction.hpp"
+
+#include "sassas/decoder/decoder.hpp"
+#include "sassas/isa/expression.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace sassas {
+namespace {
+/// Interprets the low `width` bits of `value` as a two's complement integer.
+auto sign_extend(std::uint64_t value, unsigned width) -> std::int64_t {
+    if (width == 0 || width >= 64) {
+        return static_cast<std::int64_t>(value);
+    }
+
+    std::uint64_t const sign_bit = static_cast<std::uint64_t>(1) << (width - 1);
+    return static_cast<std::int64_t>((value ^ sign_bit) - sign_bit);
+}
+}  // namespace
+
+auto DecodedInstruction::operand_value(unsigned slot) const -> std::optional<std::int64_t> {
+    assert(is_valid() && "Accessing the operands of an invalid instruction");
+
+    auto const sources = decoder_->operand_sources(pattern_->class_index);
+    if (slot >= sources.size()) {
+        return std::nullopt;
+    }
+
+    OperandSource const &source = sources[slot];
+    switch (source.kind) {
+    case OperandSource::Opcode:
+        return static_cast<std::int64_t>(opcode());
+
+    case OperandSource::Field: {
+        BitMask const &field = instruction_class().encodings[source.encoding_index].field;
+        std::uint64_t const raw_value = field.extract(word_);
+        std::int64_t const value = source.is_signed ? sign_extend(raw_value, field.width())
+                                                    : static_cast<std::int64_t>(raw_value);
+        return value * source.scale;
+    }
+
+    case OperandSource::TableArgument: {
+        EncodingAssignment const &encoding = instruction_class().encodings[source.encoding_index];
+        auto const table =
+            decoder_->find_table(encoding.value.names()[encoding.value.nodes().back().index]);
+        if (!table) {
+            return std::nullopt;
+        }
+
+        auto const keys = table->find_keys(static_cast<unsigned>(encoding.field.extract(word_)));
+        if (!keys || (*keys)[source.argument_index] == Table::MATCH_ANY) {
+            return std::nullopt;
+        }
+
+        return static_cast<std::int64_t>((*keys)[source.argument_index]);
+    }
+
+    case OperandSource::NotEncoded:
+    default:
+        return std::nullopt;
+    }
+}
+
+auto DecodedInstruction::register_name(FormatItem const &item) const
+    -> std::optional<std::string_view>  //
+{
+    assert(
+        (item.kind == FormatItem::Register || item.kind == FormatItem::Modifier)
+        && "Expected a register or a modifier"
+    );
+
+    auto const value = operand_value(item.slot);
+    if (!value || *value < 0) {
+        return std::nullopt;
+    }
+
+    if (auto const group = decoder_->frozen_isa().find_register_group(item.type)) {
+        if (auto const name = group->find(static_cast<unsigned>(*value))) {
+            return *name;
+        }
+    }
+
+    return std::nullopt;
+}
+}  // namespace sassas
@@ -0,0 +1,397 @@
+#include "sassas/decoder/decoder.hpp"
+
+#include "sassas/isa/expression.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+
+#include "fmt/base.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+namespace {
+auto popcount(InstructionWord const &word) -> int {
+    return std::popcount(word.words[0]) + std::popcount(word.words[1]);
+}
+
+/// Calls `visitor` with each key that `pattern` can produce from the bits in `bits`. A bit that is
+/// not fixed by the pattern can be either 0 or 1, so the pattern produces `2^n` keys, where `n` is
+/// the number of such bits.
+template <class Visitor>
+void for_each_key(
+    DecodePattern const &pattern,
+    std::span<std::uint8_t const> bits,
+    Visitor visitor
+) {
+    unsigned fixed_key = 0;
+    unsigned free_bits = 0;
+    for (std::size_t i = 0; i != bits.size(); ++i) {
+        if (pattern.mask.bit(bits[i])) {
+            fixed_key |= static_cast<unsigned>(pattern.value.bit(bits[i])) << i;
+        } else {
+            free_bits |= 1u << i;
+        }
+    }
+
+    // Enumerate all subsets of `free_bits`.
+    for (unsigned subset = free_bits;; subset = (subset - 1) & free_bits) {
+        visitor(fixed_key | subset);
+        if (subset == 0) {
+            break;
+        }
+    }
+}
+}  // namespace
+
+Decoder::Decoder(ISA const &isa, FrozenISA const &frozen_isa) :
+    isa_(isa), frozen_isa_(frozen_isa) {
+    collect_patterns();
+    collect_operand_sources();
+
+    std::vector<std::uint32_t> candidates(patterns_.size());
+    for (std::size_t i = 0; i != candidates.size(); ++i) {
+        candidates[i] = static_cast<std::uint32_t>(i);
+    }
+
+    std::map<std::vector<std::uint32_t>, std::uint32_t> built_nodes;
+    build_node(candidates, built_nodes);
+}
+
+void Decoder::collect_patterns() {
+    for (std::size_t class_index = 0; class_index != isa_.classes.size(); ++class_index) {
+        InstructionClass const &instruction_class = isa_.classes[class_index];
+
+        // The bits fixed by all opcodes of the class, and the fields that hold the opcode.
+        InstructionWord mask, value;
+        std::vector<BitMask const *> opcode_fields;
+        for (EncodingAssignment const &encoding : instruction_class.encodings) {
+            unsigned const width = encoding.field.width();
+            if (width == 0 || width > 64) {
+                continue;
+            }
+
+            std::uint64_t const ones = width == 64 ? ~static_cast<std::uint64_t>(0)
+                                                   : (static_cast<std::uint64_t>(1) << width) - 1;
+            if (auto const constant = encoding.value.as_integer()) {
+                encoding.field.insert(mask, ones);
+                encoding.field.insert(value, static_cast<std::uint64_t>(*constant));
+            } else if (encoding.value.as_operand() == InstructionClass::OPCODE_SLOT) {
+                opcode_fields.push_back(&encoding.field);
+            }
+        }
+
+        std::size_t const class_begin = patterns_.size();
+        for (std::size_t opcode_index = 0; opcode_index != instruction_class.opcodes.size();
+             ++opcode_index)
+        {
+            DecodePattern pattern {
+                .mask = mask,
+                .value = value,
+                .class_index = static_cast<unsigned>(class_index),
+                .opcode_index = static_cast<unsigned>(opcode_index),
+            };
+
+            for (BitMask const *field : opcode_fields) {
+                field->insert(pattern.mask, ~static_cast<std::uint64_t>(0));
+                field->insert(pattern.value, instruction_class.opcodes[opcode_index].second);
+            }
+
+            if (popcount(pattern.mask) == 0) {
+                // The class has no fixed bits, so we cannot tell its instructions apart from the
+                // others.
+                continue;
+            }
+
+            // The description files list the aliases of an opcode for specific pipelines (such as
+            // `FADD_pipe`) before the plain mnemonic, so a later opcode with the same value
+            // replaces the earlier one.
+            auto const same_bits = [&](DecodePattern const &other) {
+                return other.mask == pattern.mask && other.value == pattern.value;
+            };
+            auto const class_patterns = std::span(patterns_).subspan(class_begin);
+            if (auto const iter = std::ranges::find_if(class_patterns, same_bits);
+                iter != class_patterns.end())
+            {
+                iter->opcode_index = pattern.opcode_index;
+            } else {
+                patterns_.push_back(pattern);
+            }
+        }
+    }
+}
+
+void Decoder::collect_operand_sources() {
+    operand_sources_.reserve(isa_.classes.size());
+    for (InstructionClass const &instruction_class : isa_.classes) {
+        std::vector<OperandSource> &sources =
+            operand_sources_.emplace_back(instruction_class.slot_names.size());
+        sources[InstructionClass::OPCODE_SLOT].kind = OperandSource::Opcode;
+
+        for (std::size_t i = 0; i != instruction_class.encodings.size(); ++i) {
+            auto const encoding_index = static_cast<std::uint32_t>(i);
+            std::vector<Expr::Node> const &nodes = instruction_class.encodings[i].value.nodes();
+
+            if (nodes.size() == 1 && nodes[0].op == Expr::Op::Operand) {
+                // `field = operand;`
+                if (sources[nodes[0].index].kind != OperandSource::Opcode) {
+                    sources[nodes[0].index] = OperandSource {
+                        .kind = OperandSource::Field,
+                        .encoding_index = encoding_index,
+                    };
+                }
+            } else if (nodes.size() == 3 && nodes[0].op == Expr::Op::Operand
+                       && nodes[1].op == Expr::Op::Integer && nodes[1].value > 0
+                       && nodes[2].op == Expr::Op::Scale)
+            {
+                // `field = operand SCALE n;`
+                sources[nodes[0].index] = OperandSource {
+                    .kind = OperandSource::Field,
+                    .encoding_index = encoding_index,
+                    .scale = nodes[1].value,
+                };
+            } else if (!nodes.empty() && nodes.back().op == Expr::Op::TableCall
+                       && static_cast<std::size_t>(nodes.back().value) == nodes.size() - 1)
+            {
+                // `field = TABLE(a, b, ...);`, where all arguments are operands. A direct
+                // assignment of an operand is preferred, since it needs no table lookup.
+                for (std::size_t argument = 0; argument + 1 != nodes.size(); ++argument) {
+                    if (nodes[argument].op != Expr::Op::Operand) {
+                        continue;
+                    }
+
+                    OperandSource &source = sources[nodes[argument].index];
+                    if (source.kind == OperandSource::NotEncoded) {
+                        source = OperandSource {
+                            .kind = OperandSource::TableArgument,
+                            .encoding_index = encoding_index,
+                            .argument_index = static_cast<std::uint32_t>(argument),
+                        };
+                    }
+                }
+            }
+        }
+
+        for (FormatItem const &item : instruction_class.format) {
+            if (item.kind == FormatItem::Immediate && item.is_signed_immediate()) {
+                sources[item.slot].is_signed = true;
+            }
+        }
+    }
+}
+
+auto Decoder::build_node(
+    std::span<std::uint32_t const> candidates,
+    std::map<std::vector<std::uint32_t>, std::uint32_t> &built_nodes
+) -> std::uint32_t {
+    std::vector<std::uint32_t> key(candidates.begin(), candidates.end());
+    if (auto const iter = built_nodes.find(key); iter != built_nodes.end()) {
+        return iter->second;
+    }
+
+    auto const node_index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    built_nodes.emplace(std::move(key), node_index);
+
+    // Choose the bits to test greedily. The cost of a choice is the sum of the squared sizes of
+    // the groups it produces, which approximates the work left to the subtries. A bit is only
+    // considered if some candidates require it to be 0 and others require it to be 1, so that each
+    // group is strictly smaller than `candidates` and the construction terminates.
+    std::vector<std::uint8_t> bits;
+    if (candidates.size() > 1) {
+        std::vector<unsigned> group_sizes;
+        auto const cost_of = [&](std::span<std::uint8_t const> selected_bits) {
+            group_sizes.assign(static_cast<std::size_t>(1) << selected_bits.size(), 0);
+            for (std::uint32_t const candidate : candidates) {
+                for_each_key(patterns_[candidate], selected_bits, [&](unsigned group) {
+                    ++group_sizes[group];
+                });
+            }
+
+            std::uint64_t cost = 0;
+            for (unsigned const size : group_sizes) {
+                cost += static_cast<std::uint64_t>(size) * size;
+            }
+            return cost;
+        };
+
+        std::array<bool, 128> is_splitting_bit {};
+        for (unsigned bit = 0; bit != 128; ++bit) {
+            bool has_zero = false, has_one = false;
+            for (std::uint32_t const candidate : candidates) {
+                DecodePattern const &pattern = patterns_[candidate];
+                if (pattern.mask.bit(bit)) {
+                    (pattern.value.bit(bit) ? has_one : has_zero) = true;
+                }
+            }
+            is_splitting_bit[bit] = has_zero && has_one;
+        }
+
+        std::uint64_t current_cost =
+            static_cast<std::uint64_t>(candidates.size()) * candidates.size();
+        while (bits.size() != MAX_NODE_BITS) {
+            std::optional<std::uint8_t> best_bit;
+            std::uint64_t best_cost = current_cost;
+
+            bits.emplace_back();
+            for (unsigned bit = 0; bit != 128; ++bit) {
+                if (!is_splitting_bit[bit]) {
+                    continue;
+                }
+
+                bits.back() = static_cast<std::uint8_t>(bit);
+                if (auto const cost = cost_of(bits); cost < best_cost) {
+                    best_bit = static_cast<std::uint8_t>(bit);
+                    best_cost = cost;
+                }
+            }
+
+            if (!best_bit) {
+                bits.pop_back();
+                break;
+            }
+
+            bits.back() = *best_bit;
+            is_splitting_bit[*best_bit] = false;
+            current_cost = best_cost;
+        }
+    }
+
+    if (bits.empty()) {
+        // The candidates cannot be told apart by testing bits, so they form a leaf. Order them so
+        // that the more specific patterns are checked first.
+        auto const leaf_begin = leaf_patterns_.size();
+        leaf_patterns_.insert(leaf_patterns_.end(), candidates.begin(), candidates.end());
+        std::ranges::stable_sort(
+            leaf_patterns_.begin() + static_cast<std::ptrdiff_t>(leaf_begin),
+            leaf_patterns_.end(),
+            std::ranges::greater(),
+            [this](std::uint32_t candidate) { return popcount(patterns_[candidate].mask); }
+        );
+
+        nodes_[node_index] = Node {
+            .runs = {},
+            .run_count = 0,
+            .first = static_cast<std::uint32_t>(leaf_begin),
+            .count = static_cast<std::uint32_t>(candidates.size()),
+        };
+        return node_index;
+    }
+
+    // Sort the bits, so that adjacent bits of the instruction are also adjacent in the key.
+    std::ranges::sort(bits);
+
+    std::vector<std::vector<std::uint32_t>> groups(static_cast<std::size_t>(1) << bits.size());
+    for (std::uint32_t const candidate : candidates) {
+        for_each_key(patterns_[candidate], bits, [&](unsigned group) {
+            groups[group].push_back(candidate);
+        });
+    }
+
+    auto const children_begin = static_cast<std::uint32_t>(children_.size());
+    children_.resize(children_.size() + groups.size(), NO_NODE);
+    for (std::size_t group = 0; group != groups.size(); ++group) {
+        if (!groups[group].empty()) {
+            // Do not hold a reference into `children_`, since the recursive call may reallocate it.
+            std::uint32_t const child = build_node(groups[group], built_nodes);
+            children_[children_begin + group] = child;
+        }
+    }
+
+    Node node {
+        .runs = {},
+        .run_count = 0,
+        .first = children_begin,
+        .count = static_cast<std::uint32_t>(groups.size()),
+    };
+    for (std::size_t i = 0; i != bits.size(); ++i) {
+        if (node.run_count != 0) {
+            BitRun &last_run = node.runs[node.run_count - 1];
+            if (last_run.start + last_run.size == bits[i] && bits[i] % 64 != 0) {
+                ++last_run.size;
+                continue;
+            }
+        }
+
+        node.runs[node.run_count++] = BitRun {
+            .start = bits[i],
+            .size = 1,
+            .shift = static_cast<std::uint8_t>(i),
+        };
+    }
+    nodes_[node_index] = node;
+    return node_index;
+}
+
+auto Decoder::decode(InstructionWord const &word) const -> DecodePattern const * {
+    if (nodes_.empty()) {
+        return nullptr;
+    }
+
+    Node const *node = &nodes_.front();
+    while (node->run_count != 0) {
+        std::uint64_t key = 0;
+        for (BitRun const &run : std::span(node->runs).first(node->run_count)) {
+            std::uint64_t const bits = word.words[run.start / 64] >> (run.start % 64);
+            key |= (bits & ((static_cast<std::uint64_t>(1) << run.size) - 1)) << run.shift;
+        }
+
+        std::uint32_t const child = children_[node->first + key];
+        if (child == NO_NODE) {
+            return nullptr;
+        }
+        node = &nodes_[child];
+    }
+
+    for (std::uint32_t const candidate :
+         std::span(leaf_patterns_).subspan(node->first, node->count))
+    {
+        if (DecodePattern const &pattern = patterns_[candidate]; pattern.matches(word)) {
+            return &pattern;
+        }
+    }
+
+    return nullptr;
+}
+
+void Decoder::dump(unsigned indent) const {
+    // Collect the depth of the trie and the sizes of the leaves.
+    unsigned max_depth = 0, leaf_count = 0, max_leaf_size = 0;
+    std::vector<std::pair<std::uint32_t, unsigned>> stack;
+    if (!nodes_.empty()) {
+        stack.emplace_back(0, 1);
+    }
+    while (!stack.empty()) {
+        auto const [node_index, depth] = stack.back();
+        stack.pop_back();
+
+        Node const &node = nodes_[node_index];
+        max_depth = std::ranges::max(max_depth, depth);
+        if (node.run_count == 0) {
+            ++leaf_count;
+            max_leaf_size = std::ranges::max(max_leaf_size, node.count);
+        } else {
+            for (std::uint32_t const child :
+                 std::span(children_).subspan(node.first, node.count))
+            {
+                if (child != NO_NODE) {
+                    stack.emplace_back(child, depth + 1);
+                }
+            }
+        }
+    }
+
+    fmt::println("{:>{}}patterns: {}", "", indent, patterns_.size());
+    fmt::println("{:>{}}nodes: {} ({} leaves)", "", indent, nodes_.size(), leaf_count);
+    fmt::println("{:>{}}max depth: {}", "", indent, max_depth);
+    fmt::println("{:>{}}max leaf size: {}", "", indent, max_leaf_size);
+}
+}  // namespace sassas
@@ -0,0 +1,131 @@
+#include "sassas/decoder/disassembler.hpp"
+
+#include "sassas/decoder/decoded_instruction.hpp"
+#include "sassas/elf/elf_reader.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/utils/parallel.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+namespace {
+// The instruction words are read as they are laid out in memory.
+static_assert(std::endian::native == std::endian::little, "Only little-endian hosts are supported");
+
+/// The space reserved for the text of one instruction. The formatter fails rather than overflow,
+/// and no real instruction comes close to it.
+constexpr std::size_t MAX_INSTRUCTION_TEXT = 256;
+
+/// The number of chunks per thread that are disassembled before their text is passed on. It keeps
+/// the threads busy when the chunks differ in cost, without holding much text in memory.
+constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+/// A range of instructions of a section, which is disassembled by one task.
+struct Chunk {
+    ElfSectionView const *section;
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+}  // namespace
+
+void Disassembler::disassemble(
+    ElfReader const &elf,
+    unsigned thread_count,
+    std::function<void(std::string_view)> const &output
+) const {
+    assert(instruction_size_ != 0 && "The instruction size is not known");
+    std::vector<Chunk> chunks;
+    std::uint64_t const chunk_size = CHUNK_INSTRUCTIONS * instruction_size_;
+    for (ElfSectionView const &section : elf.sections()) {
+        if (!section.is_executable()) {
+            continue;
+        }
+
+        // An empty section still gets a chunk, so that its label is written.
+        std::uint64_t offset = 0;
+        do {
+            std::uint64_t const size = std::min(chunk_size, section.data.size() - offset);
+            chunks.push_back({ .section = &section, .offset = offset, .size = size });
+            offset += size;
+        } while (offset != section.data.size());
+    }
+
+    // The strings keep their capacity from one batch to the next.
+    std::size_t const batch_size = std::max(thread_count, 1u) * CHUNKS_PER_THREAD;
+    std::vector<std::string> texts(std::min(batch_size, chunks.size()));
+    for (std::size_t first = 0; first < chunks.size(); first += batch_size) {
+        std::span<Chunk const> const batch =
+            std::span(chunks).subspan(first, std::min(batch_size, chunks.size() - first));
+
+        parallel_for(thread_count, batch.size(), [&](std::size_t i) {
+            Chunk const &chunk = batch[i];
+            std::string &text = texts[i];
+            text.clear();
+            if (chunk.offset == 0) {
+                fmt::format_to(std::back_inserter(text), "{}:\n", chunk.section->name);
+            }
+            disassemble(chunk.section->data.subspan(chunk.offset, chunk.size), chunk.offset, text);
+        });
+
+        for (std::size_t i = 0; i != batch.size(); ++i) {
+            output(texts[i]);
+        }
+    }
+}
+
+void Disassembler::disassemble(
+    std::span<std::byte const> code,
+    std::uint64_t offset,
+    std::string &text
+) const {
+    for (; code.size() >= instruction_size_; code = code.subspan(instruction_size_)) {
+        InstructionWord word;
+        std::memcpy(word.words.data(), code.data(), std::min<std::size_t>(instruction_size_, 16));
+
+        fmt::format_to(std::back_inserter(text), "        /*{:04x}*/                   ", offset);
+        offset += instruction_size_;
+
+        // Format the instruction in place, at the end of the text.
+        std::size_t const size = text.size();
+        text.resize(size + MAX_INSTRUCTION_TEXT);
+        std::optional<std::size_t> const length = formatter_.format(
+            DecodedInstruction(decoder_, word),
+            std::span(text).subspan(size)
+        );
+        text.resize(size + length.value_or(0));
+
+        if (!length) {
+            fmt::format_to(
+                std::back_inserter(text),
+                "/* 0x{:016x}{:016x} is not a valid instruction */",
+                word.words[1],
+                word.words[0]
+            );
+        }
+        text.push_back('\n');
+    }
+
+    if (!code.empty()) {
+        fmt::format_to(
+            std::back_inserter(text),
+            "        /*{:04x}*/                   /* {} trailing bytes */\n",
+            offset,
+            code.size()
+        );
+    }
+}
+}  // namespace sassas
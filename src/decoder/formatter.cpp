@@ -0,0 +1,338 @@
+#include "sassas/decoder/formatter.hpp"
+
+#include "sassas/decoder/decoded_instruction.hpp"
+#include "sassas/decoder/decoder.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/register.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// Writes text into a fixed buffer. Once the buffer is full, all subsequent writes are dropped and
+/// `overflowed()` returns `true`.
+class BufferWriter {
+public:
+    explicit BufferWriter(std::span<char> buffer) :
+        begin_(buffer.data()), current_(buffer.data()), end_(buffer.data() + buffer.size()) { }
+
+    auto overflowed() const -> bool {
+        return overflowed_;
+    }
+
+    auto size() const -> std::size_t {
+        return static_cast<std::size_t>(current_ - begin_);
+    }
+
+    void write(char ch) {
+        if (current_ == end_) {
+            overflowed_ = true;
+        } else {
+            *current_++ = ch;
+        }
+    }
+
+    void write(std::string_view text) {
+        if (static_cast<std::size_t>(end_ - current_) < text.size()) {
+            overflowed_ = true;
+        } else {
+            std::memcpy(current_, text.data(), text.size());
+            current_ += text.size();
+        }
+    }
+
+    /// Writes `value` in hexadecimal with a `0x` prefix, such as `0x10` and `-0x4`.
+    void write_hex(std::int64_t value) {
+        if (value < 0) {
+            write('-');
+        }
+        write("0x");
+
+        // Negate in the unsigned domain, so that the minimum value does not overflow.
+        std::uint64_t const magnitude = value < 0 ? ~static_cast<std::uint64_t>(value) + 1
+                                                  : static_cast<std::uint64_t>(value);
+        write_integer(magnitude, 16);
+    }
+
+    void write_decimal(std::int64_t value) {
+        if (value < 0) {
+            write('-');
+        }
+
+        std::uint64_t const magnitude = value < 0 ? ~static_cast<std::uint64_t>(value) + 1
+                                                  : static_cast<std::uint64_t>(value);
+        write_integer(magnitude, 10);
+    }
+
+private:
+    char *begin_;
+    char *current_;
+    char *end_;
+    bool overflowed_ = false;
+
+    void write_integer(std::uint64_t value, int base) {
+        if (overflowed_) {
+            return;
+        }
+
+        auto const [end, error] = std::to_chars(current_, end_, value, base);
+        if (error != std::errc()) {
+            overflowed_ = true;
+        } else {
+            current_ = end;
+        }
+    }
+};
+}  // namespace
+
+auto InstructionFormatter::build_name_table(RegisterGroup const &group) -> NameTable {
+    NameTable result;
+
+    unsigned max_value = 0;
+    for (Register const &reg : group.registers()) {
+        max_value = std::ranges::max(max_value, reg.value);
+    }
+    if (group.registers().empty() || max_value > MAX_TABLE_VALUE) {
+        return result;
+    }
+
+    // `RegisterGroup::find` returns the last register with the given value, so later registers
+    // overwrite the earlier ones here.
+    std::vector<std::string_view> names(max_value + 1);
+    for (Register const &reg : group.registers()) {
+        names[reg.value] = reg.name;
+    }
+
+    result.offsets.reserve(names.size() + 1);
+    for (std::string_view const name : names) {
+        result.offsets.push_back(static_cast<std::uint32_t>(result.storage.size()));
+        result.storage += name;
+    }
+    result.offsets.push_back(static_cast<std::uint32_t>(result.storage.size()));
+
+    return result;
+}
+
+InstructionFormatter::InstructionFormatter(Decoder const &decoder) : decoder_(decoder) {
+    ISA const &isa = decoder.isa();
+
+    // Build a name table for each register category that is used by a format item.
+    std::unordered_map<std::string_view, std::uint32_t> table_indices;
+    auto const get_table = [&](std::string const &category) -> std::uint32_t {
+        if (auto const iter = table_indices.find(category); iter != table_indices.end()) {
+            return iter->second;
+        }
+
+        auto const group = isa.registers.find(category);
+        if (group == isa.registers.end()) {
+            return NO_TABLE;
+        }
+
+        auto const index = static_cast<std::uint32_t>(name_tables_.size());
+        name_tables_.push_back(build_name_table(group->second));
+        table_indices.emplace(category, index);
+        return index;
+    };
+
+    item_infos_.reserve(isa.classes.size());
+    for (InstructionClass const &instruction_class : isa.classes) {
+        std::vector<ItemInfo> &infos = item_infos_.emplace_back(instruction_class.format.size());
+
+        for (std::size_t i = 0; i != instruction_class.format.size(); ++i) {
+            FormatItem const &item = instruction_class.format[i];
+            if (item.kind != FormatItem::Register && item.kind != FormatItem::Modifier) {
+                continue;
+            }
+
+            ItemInfo &info = infos[i];
+            info.name_table = get_table(item.type);
+            if (item.default_name) {
+                if (auto const group = isa.registers.find(item.type);
+                    group != isa.registers.end())
+                {
+                    info.default_value = group->second.find(*item.default_name);
+                }
+            }
+
+            static constexpr std::string_view prefix_attributes[] = {
+                "@negate",
+                "@absolute",
+                "@not",
+                "@invert",
+            };
+            for (std::size_t prefix = 0; prefix != info.prefix_slots.size(); ++prefix) {
+                if (item.prefixes & (1u << prefix)) {
+                    std::string slot_name = item.name;
+                    slot_name += prefix_attributes[prefix];
+                    if (auto const slot = instruction_class.find_slot(slot_name)) {
+                        info.prefix_slots[prefix] = *slot;
+                    }
+                }
+            }
+        }
+    }
+}
+
+auto InstructionFormatter::format(DecodedInstruction const &instruction, std::span<char> buffer)
+    const -> std::optional<std::size_t>  //
+{
+    if (!instruction.is_valid()) {
+        return std::nullopt;
+    }
+
+    InstructionClass const &instruction_class = instruction.instruction_class();
+    std::vector<ItemInfo> const &infos = item_infos_[instruction.class_index()];
+
+    BufferWriter writer(buffer);
+    // Whether a space must be written before the next operand, i.e. after the opcode and after
+    // each `,`.
+    bool need_space = false;
+
+    auto const has_prefix = [&](ItemInfo const &info, FormatItem::Prefix prefix) {
+        std::uint32_t const slot =
+            info.prefix_slots[std::countr_zero(static_cast<unsigned>(prefix))];
+        if (slot == NO_SLOT) {
+            return false;
+        }
+
+        auto const value = instruction.operand_value(slot);
+        return value && *value != 0;
+    };
+
+    auto const write_name = [&](ItemInfo const &info, FormatItem const &item, std::int64_t value) {
+        std::string_view name;
+        if (info.name_table != NO_TABLE) {
+            name = name_tables_[info.name_table].name(value);
+        }
+
+        if (name.empty()) {
+            // There is no register with this value. Write the raw value, so that the information is
+            // not lost.
+            writer.write(item.type);
+            writer.write('(');
+            writer.write_decimal(value);
+            writer.write(')');
+        } else {
+            writer.write(name);
+        }
+    };
+
+    for (std::size_t i = 0; i != instruction_class.format.size(); ++i) {
+        FormatItem const &item = instruction_class.format[i];
+        ItemInfo const &info = infos[i];
+        if (item.is_scheduling) {
+            continue;
+        }
+
+        switch (item.kind) {
+        case FormatItem::Opcode:
+            writer.write(instruction.opcode_name());
+            need_space = true;
+            break;
+
+        case FormatItem::Modifier: {
+            auto const value = instruction.operand_value(item.slot);
+            if (value && value != info.default_value) {
+                writer.write('.');
+                write_name(info, item, *value);
+            }
+            break;
+        }
+
+        case FormatItem::Register: {
+            auto const value = instruction.operand_value(item.slot);
+            bool const is_not = has_prefix(info, FormatItem::Not);
+            if (item.is_predicate) {
+                // The guard predicate is omitted if it is the default one, i.e. `PT`.
+                if (value && (value != info.default_value || is_not)) {
+                    writer.write('@');
+                    if (is_not) {
+                        writer.write('!');
+                    }
+                    write_name(info, item, *value);
+                    writer.write(' ');
+                }
+                break;
+            }
+
+            if (need_space) {
+                writer.write(' ');
+                need_space = false;
+            }
+
+            bool const is_absolute = has_prefix(info, FormatItem::Absolute);
+            if (has_prefix(info, FormatItem::Negate)) {
+                writer.write('-');
+            }
+            if (is_not) {
+                writer.write('!');
+            }
+            if (has_prefix(info, FormatItem::Invert)) {
+                writer.write('~');
+            }
+            if (is_absolute) {
+                writer.write('|');
+            }
+
+            if (value) {
+                write_name(info, item, *value);
+            } else {
+                writer.write(item.type);
+            }
+
+            if (is_absolute) {
+                writer.write('|');
+            }
+            break;
+        }
+
+        case FormatItem::Immediate:
+            if (need_space) {
+                writer.write(' ');
+                need_space = false;
+            }
+
+            if (auto const value = instruction.operand_value(item.slot)) {
+                writer.write_hex(*value);
+            } else {
+                writer.write_hex(item.default_value.value_or(0));
+            }
+            break;
+
+        case FormatItem::Literal:
+            if (item.type == ",") {
+                writer.write(',');
+                need_space = true;
+            } else {
+                if (need_space) {
+                    writer.write(' ');
+                    need_space = false;
+                }
+                writer.write(item.type);
+            }
+            break;
+        }
+    }
+
+    writer.write(" ;");
+
+    if (writer.overflowed()) {
+        return std::nullopt;
+    } else {
+        return writer.size();
+    }
+}
+}  // namespace sassas
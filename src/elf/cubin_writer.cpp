@@ -0,0 +1,148 @@
+#include "sassas/elf/cubin_writer.hpp"
+
+#include "sassas/elf/elf_writer.hpp"
+#include "sassas/isa/functional_unit.hpp"
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// The `EI_ABIVERSION` of the cubins emitted by recent CUDA toolkits.
+constexpr std::uint8_t CUDA_ABI_VERSION = 7;
+/// The bits of `e_flags` besides the architecture versions: `EF_CUDA_TEXMODE_UNIFIED` and
+/// `EF_CUDA_64BIT_ADDRESS`.
+constexpr std::uint32_t CUDA_FLAGS = 0x100 | 0x400;
+/// The `st_other` bit that marks a kernel entry point.
+constexpr std::uint8_t STO_CUDA_ENTRY = 0x10;
+/// The alignment of the code sections.
+constexpr std::uint64_t CODE_ALIGNMENT = 128;
+
+// The sections that precede the code sections.
+constexpr std::uint32_t STRTAB_INDEX = 1;
+constexpr std::uint32_t SYMTAB_INDEX = 2;
+constexpr std::uint32_t FIRST_CODE_INDEX = 3;
+}  // namespace
+
+auto CubinWriter::parse_sm_version(std::string_view arch) -> std::optional<unsigned> {
+    if (!arch.starts_with("sm_")) {
+        return std::nullopt;
+    }
+    std::string_view const version = arch.substr(3);
+    unsigned sm_version = 0;
+    auto const [end, error] =
+        std::from_chars(version.data(), version.data() + version.size(), sm_version);
+    if (error != std::errc()) {
+        return std::nullopt;
+    }
+    return sm_version;
+}
+
+void CubinWriter::begin_section(std::string_view name) {
+    std::string_view function_name = name;
+    if (function_name.starts_with(".text.")) {
+        function_name.remove_prefix(std::string_view(".text.").size());
+    }
+
+    sections_.push_back({
+        .name = std::string(name),
+        .symbol = symbol_names_.add(function_name),
+        .code = {},
+    });
+}
+
+void CubinWriter::append(InstructionWord const &word) {
+    if (sections_.empty()) {
+        begin_section(".text");
+    }
+
+    std::vector<std::byte> &code = sections_.back().code;
+    for (unsigned i = 0; i != instruction_size_; ++i) {
+        code.push_back(static_cast<std::byte>(word.words[i / 8] >> (i % 8 * 8)));
+    }
+}
+
+auto CubinWriter::write(char const *path) -> bool {
+    return lay_out([&](ElfWriter const &writer) { return writer.write(path); });
+}
+
+void CubinWriter::write(std::vector<std::byte> &output) {
+    lay_out([&](ElfWriter const &writer) {
+        writer.write(output);
+        return true;
+    });
+}
+
+auto CubinWriter::lay_out(std::function<bool(ElfWriter const &)> const &write) -> bool {
+    symbol_names_.finalize();
+
+    // The symbol table starts with the null symbol and the section symbols, which are local, and
+    // ends with the function symbols.
+    std::vector<elf::Symbol> symbols(1 + 2 * sections_.size());
+    auto const first_global = static_cast<std::uint32_t>(1 + sections_.size());
+    for (std::size_t i = 0; i != sections_.size(); ++i) {
+        Section const &section = sections_[i];
+        auto const section_index = static_cast<std::uint16_t>(FIRST_CODE_INDEX + i);
+
+        symbols[1 + i] = {
+            .name = 0,
+            .info = elf::STB_LOCAL << 4 | elf::STT_SECTION,
+            .other = 0,
+            .section_index = section_index,
+            .value = 0,
+            .size = 0,
+        };
+        symbols[first_global + i] = {
+            .name = symbol_names_.offset(section.symbol),
+            .info = elf::STB_GLOBAL << 4 | elf::STT_FUNC,
+            .other = STO_CUDA_ENTRY,
+            .section_index = section_index,
+            .value = 0,
+            .size = section.code.size(),
+        };
+    }
+
+    ElfWriter writer(
+        elf::EM_CUDA,
+        elf::ELFOSABI_CUDA,
+        CUDA_ABI_VERSION,
+        sm_version_ << 16 | CUDA_FLAGS | sm_version_
+    );
+    writer.add_section({
+        .name = ".strtab",
+        .type = elf::SHT_STRTAB,
+        .data = symbol_names_.bytes(),
+    });
+    writer.add_section({
+        .name = ".symtab",
+        .type = elf::SHT_SYMTAB,
+        .link = STRTAB_INDEX,
+        .info = first_global,
+        .alignment = 8,
+        .entry_size = sizeof(elf::Symbol),
+        .data = std::as_bytes(std::span(symbols)),
+    });
+    for (std::size_t i = 0; i != sections_.size(); ++i) {
+        // For code sections, `sh_info` is the index of the function symbol.
+        writer.add_section({
+            .name = sections_[i].name,
+            .type = elf::SHT_PROGBITS,
+            .flags = elf::SHF_ALLOC | elf::SHF_EXECINSTR,
+            .link = SYMTAB_INDEX,
+            .info = static_cast<std::uint32_t>(first_global + i),
+            .alignment = CODE_ALIGNMENT,
+            .data = sections_[i].code,
+        });
+    }
+
+    return write(writer);
+}
+}  // namespace sassas
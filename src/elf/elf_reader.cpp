@@ -0,0 +1,135 @@
+#include "sassas/elf/elf_reader.hpp"
+
+#include "sassas/elf/elf.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace sassas {
+namespace {
+// The headers are read as they are laid out in memory.
+static_assert(std::endian::native == std::endian::little, "Only little-endian hosts are supported");
+
+constexpr std::uint32_t SHT_NOBITS = 8;
+
+/// Reads a header at `offset` of `image`. The image may not be suitably aligned for `Header`, so
+/// the header is copied out instead of being accessed in place.
+template <class Header>
+auto read_header(std::span<std::byte const> image, std::uint64_t offset) -> Header {
+    static_assert(std::is_trivially_copyable_v<Header>);
+    Header header;
+    std::memcpy(&header, image.data() + offset, sizeof(Header));
+    return header;
+}
+
+/// Returns whether `[offset, offset + size)` is inside `image`, without overflowing.
+auto is_in_bounds(std::span<std::byte const> image, std::uint64_t offset, std::uint64_t size)
+    -> bool {
+    return offset <= image.size() && size <= image.size() - offset;
+}
+}  // namespace
+
+auto ElfReader::read(std::span<std::byte const> image, std::string_view &error)
+    -> std::optional<ElfReader> {
+    if (image.size() < sizeof(elf::FileHeader)) {
+        error = "The file is too small to be an ELF file";
+        return std::nullopt;
+    }
+
+    auto const header = read_header<elf::FileHeader>(image, 0);
+    if (header.ident[0] != 0x7f || header.ident[1] != 'E' || header.ident[2] != 'L'
+        || header.ident[3] != 'F') {
+        error = "The file is not an ELF file";
+        return std::nullopt;
+    }
+    if (header.ident[4] != /*ELFCLASS64*/ 2 || header.ident[5] != /*ELFDATA2LSB*/ 1) {
+        error = "Only little-endian 64-bit ELF files are supported";
+        return std::nullopt;
+    }
+    if (header.section_header_size != sizeof(elf::SectionHeader)) {
+        error = "The size of the section headers is invalid";
+        return std::nullopt;
+    }
+
+    std::uint64_t const table_offset = header.section_header_offset;
+    if (table_offset == 0 || !is_in_bounds(image, table_offset, sizeof(elf::SectionHeader))) {
+        error = "The file has no section header table";
+        return std::nullopt;
+    }
+
+    // With extended numbering, the number of sections and the index of the section header string
+    // table are stored in the null section.
+    auto const null_section = read_header<elf::SectionHeader>(image, table_offset);
+    std::uint64_t const section_count =
+        header.section_header_count != 0 ? header.section_header_count : null_section.size;
+    std::uint32_t const name_index = header.section_name_index != /*SHN_XINDEX*/ 0xffff
+        ? header.section_name_index
+        : null_section.link;
+
+    if (section_count > (image.size() - table_offset) / sizeof(elf::SectionHeader)) {
+        error = "The section header table is truncated";
+        return std::nullopt;
+    }
+    if (name_index == 0 || name_index >= section_count) {
+        error = "The file has no section header string table";
+        return std::nullopt;
+    }
+
+    auto const section_header = [&](std::uint64_t index) {
+        return read_header<elf::SectionHeader>(
+            image,
+            table_offset + index * sizeof(elf::SectionHeader)
+        );
+    };
+
+    auto const names_header = section_header(name_index);
+    if (names_header.type != elf::SHT_STRTAB
+        || !is_in_bounds(image, names_header.offset, names_header.size)) {
+        error = "The section header string table is invalid";
+        return std::nullopt;
+    }
+    std::string_view const names(
+        reinterpret_cast<char const *>(image.data() + names_header.offset),
+        names_header.size
+    );
+
+    ElfReader reader;
+    reader.machine_ = header.machine;
+    reader.flags_ = header.flags;
+    reader.sections_.reserve(section_count - 1);
+    for (std::uint64_t i = 1; i != section_count; ++i) {
+        auto const section = section_header(i);
+
+        std::size_t const name_end = names.find('\0', section.name);
+        if (section.name >= names.size() || name_end == std::string_view::npos) {
+            error = "The name of a section is invalid";
+            return std::nullopt;
+        }
+
+        // A `SHT_NOBITS` section (such as `.bss`) occupies no space in the file.
+        std::span<std::byte const> data;
+        if (section.type != SHT_NOBITS) {
+            if (!is_in_bounds(image, section.offset, section.size)) {
+                error = "The contents of a section are outside of the file";
+                return std::nullopt;
+            }
+            data = image.subspan(section.offset, section.size);
+        }
+
+        reader.sections_.push_back({
+            .name = names.substr(section.name, name_end - section.name),
+            .type = section.type,
+            .flags = section.flags,
+            .data = data,
+        });
+    }
+    return reader;
+}
+}  // namespace sassas
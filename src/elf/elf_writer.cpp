@@ -0,0 +1,189 @@
+#include "sassas/elf/elf_writer.hpp"
+
+#include "sassas/utils/gathered_write.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+namespace {
+// The headers are written as they are laid out in memory.
+static_assert(std::endian::native == std::endian::little, "Only little-endian hosts are supported");
+
+/// The source of the padding between sections.
+constexpr std::array<std::byte, 256> zeros {};
+
+auto align_to(std::uint64_t offset, std::uint64_t alignment) -> std::uint64_t {
+    return alignment <= 1 ? offset : (offset + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+auto ElfStringTable::add(std::string_view str) -> Id {
+    assert(offsets_.empty() && "The string table is already finalized");
+    if (auto const iter = ids_.find(str); iter != ids_.end()) {
+        return iter->second;
+    }
+
+    auto const id = static_cast<Id>(strings_.size());
+    std::string_view const stored = storage_.emplace_back(str);
+    strings_.push_back(stored);
+    ids_.emplace(stored, id);
+    return id;
+}
+
+void ElfStringTable::finalize() {
+    std::vector<Id> order(strings_.size());
+    std::iota(order.begin(), order.end(), Id(0));
+    std::ranges::sort(order, [&](Id lhs, Id rhs) {
+        return std::ranges::lexicographical_compare(
+            strings_[rhs] | std::views::reverse,
+            strings_[lhs] | std::views::reverse
+        );
+    });
+
+    data_.assign(1, '\0');
+    offsets_.assign(strings_.size(), 0);
+    // The last string stored in the table. The strings that are its suffixes come right after it.
+    std::string_view stored;
+    std::uint32_t stored_offset = 0;
+    for (Id const id : order) {
+        std::string_view const str = strings_[id];
+        if (str.empty()) {
+            // The empty string is the first byte of the table.
+            offsets_[id] = 0;
+        } else if (stored.ends_with(str)) {
+            offsets_[id] = stored_offset + static_cast<std::uint32_t>(stored.size() - str.size());
+        } else {
+            stored = str;
+            stored_offset = static_cast<std::uint32_t>(data_.size());
+            offsets_[id] = stored_offset;
+            data_.append(str);
+            data_.push_back('\0');
+        }
+    }
+}
+
+auto ElfWriter::write(char const *path) const -> bool {
+    return lay_out([&](std::span<std::span<std::byte const> const> buffers) {
+        return write_file(path, buffers);
+    });
+}
+
+void ElfWriter::write(std::vector<std::byte> &output) const {
+    lay_out([&](std::span<std::span<std::byte const> const> buffers) {
+        for (std::span<std::byte const> const buffer : buffers) {
+            output.insert(output.end(), buffer.begin(), buffer.end());
+        }
+        return true;
+    });
+}
+
+auto ElfWriter::lay_out(
+    std::function<bool(std::span<std::span<std::byte const> const>)> const &write
+) const -> bool {
+    // The section header string table is added after the other sections.
+    ElfStringTable names;
+    std::vector<ElfStringTable::Id> name_ids;
+    name_ids.reserve(sections_.size() + 1);
+    for (ElfSection const &section : sections_) {
+        name_ids.push_back(names.add(section.name));
+    }
+    name_ids.push_back(names.add(".shstrtab"));
+    names.finalize();
+
+    std::vector<elf::SectionHeader> headers(sections_.size() + 2);
+    for (std::size_t i = 0; i != sections_.size(); ++i) {
+        ElfSection const &section = sections_[i];
+        headers[i + 1] = {
+            .name = names.offset(name_ids[i]),
+            .type = section.type,
+            .flags = section.flags,
+            .address = 0,
+            .offset = 0,
+            .size = 0,
+            .link = section.link,
+            .info = section.info,
+            .alignment = section.alignment,
+            .entry_size = section.entry_size,
+        };
+    }
+    auto const name_index = static_cast<std::uint16_t>(headers.size() - 1);
+    headers.back() = {
+        .name = names.offset(name_ids.back()),
+        .type = elf::SHT_STRTAB,
+        .flags = 0,
+        .address = 0,
+        .offset = 0,
+        .size = 0,
+        .link = 0,
+        .info = 0,
+        .alignment = 1,
+        .entry_size = 0,
+    };
+
+    // Lay out the file: the file header, the contents of the sections, and the section header
+    // table. The buffers refer to the contents, which are not copied.
+    elf::FileHeader header {};
+    std::vector<std::span<std::byte const>> buffers;
+    buffers.reserve(sections_.size() * 2 + 4);
+    buffers.push_back(std::as_bytes(std::span(&header, 1)));
+    std::uint64_t offset = sizeof(elf::FileHeader);
+
+    auto const pad_to = [&](std::uint64_t alignment) {
+        std::uint64_t padding = align_to(offset, alignment) - offset;
+        offset += padding;
+        while (padding != 0) {
+            std::size_t const size = std::min<std::uint64_t>(padding, zeros.size());
+            buffers.push_back(std::span(zeros).first(size));
+            padding -= size;
+        }
+    };
+
+    auto const place = [&](elf::SectionHeader &section_header, std::span<std::byte const> data) {
+        pad_to(section_header.alignment);
+        section_header.offset = offset;
+        section_header.size = data.size();
+        buffers.push_back(data);
+        offset += data.size();
+    };
+
+    for (std::size_t i = 0; i != sections_.size(); ++i) {
+        place(headers[i + 1], sections_[i].data);
+    }
+    place(headers.back(), names.bytes());
+
+    pad_to(alignof(elf::SectionHeader));
+    std::uint64_t const section_header_offset = offset;
+    buffers.push_back(std::as_bytes(std::span(headers)));
+
+    header = {
+        .ident = { 0x7f, 'E', 'L', 'F', /*ELFCLASS64*/ 2, /*ELFDATA2LSB*/ 1, /*EV_CURRENT*/ 1,
+                   os_abi_, abi_version_ },
+        .type = elf::ET_EXEC,
+        .machine = machine_,
+        .version = 1,
+        .entry = 0,
+        .program_header_offset = 0,
+        .section_header_offset = section_header_offset,
+        .flags = flags_,
+        .header_size = sizeof(elf::FileHeader),
+        .program_header_size = 0,
+        .program_header_count = 0,
+        .section_header_size = sizeof(elf::SectionHeader),
+        .section_header_count = static_cast<std::uint16_t>(headers.size()),
+        .section_name_index = name_index,
+    };
+
+    return write(buffers);
+}
+}  // namespace sassas
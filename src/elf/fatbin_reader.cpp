@@ -0,0 +1,104 @@
+#include "sassas/elf/fatbin_reader.hpp"
+
+#include "sassas/elf/fatbin.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+namespace {
+// The headers are read as they are laid out in memory.
+static_assert(std::endian::native == std::endian::little, "Only little-endian hosts are supported");
+
+/// Reads a header at `offset` of `image`, which must be in bounds. The image may not be suitably
+/// aligned for `Header`, so the header is copied out instead of being accessed in place.
+template <class Header>
+auto read_header(std::span<std::byte const> image, std::uint64_t offset) -> Header {
+    Header header;
+    std::memcpy(&header, image.data() + offset, sizeof(Header));
+    return header;
+}
+}  // namespace
+
+auto FatbinReader::is_fatbin(std::span<std::byte const> image) -> bool {
+    return image.size() >= sizeof(fatbin::ContainerHeader)
+        && read_header<fatbin::ContainerHeader>(image, 0).magic == fatbin::MAGIC;
+}
+
+auto FatbinReader::read(std::span<std::byte const> image, std::string_view &error)
+    -> std::optional<FatbinReader> {
+    if (!is_fatbin(image)) {
+        error = "The file is not a fatbin";
+        return std::nullopt;
+    }
+
+    FatbinReader reader;
+    // The containers are back to back, and may be followed by padding.
+    while (image.size() >= sizeof(fatbin::ContainerHeader)) {
+        auto const container = read_header<fatbin::ContainerHeader>(image, 0);
+        if (container.magic != fatbin::MAGIC) {
+            break;
+        }
+        if (container.header_size < sizeof(fatbin::ContainerHeader)
+            || container.header_size > image.size()
+            || container.size > image.size() - container.header_size) {
+            error = "The fatbin is truncated";
+            return std::nullopt;
+        }
+
+        std::span<std::byte const> images = image.subspan(container.header_size, container.size);
+        image = image.subspan(container.header_size + container.size);
+
+        while (!images.empty()) {
+            if (images.size() < sizeof(fatbin::ImageHeader)) {
+                error = "The header of an image of the fatbin is truncated";
+                return std::nullopt;
+            }
+
+            auto const header = read_header<fatbin::ImageHeader>(images, 0);
+            if (header.header_size < sizeof(fatbin::ImageHeader)
+                || header.header_size > images.size()
+                || header.size > images.size() - header.header_size) {
+                error = "An image of the fatbin is truncated";
+                return std::nullopt;
+            }
+
+            bool const is_compressed = (header.flags & fatbin::FLAG_COMPRESSED) != 0;
+            // Padding follows the contents of a compressed image.
+            std::uint64_t const data_size =
+                is_compressed && header.compressed_size != 0 && header.compressed_size < header.size
+                ? header.compressed_size
+                : header.size;
+            reader.images_.push_back({
+                .kind = header.kind,
+                .sm_version = header.sm_version,
+                .is_compressed = is_compressed,
+                .data = images.subspan(header.header_size, data_size),
+            });
+            images = images.subspan(header.header_size + header.size);
+        }
+    }
+    return reader;
+}
+
+auto FatbinReader::cubin_architectures() const -> std::vector<std::uint32_t> {
+    std::vector<std::uint32_t> architectures;
+    for (FatbinImage const &image : images_) {
+        if (image.is_cubin()) {
+            architectures.push_back(image.sm_version);
+        }
+    }
+
+    std::ranges::sort(architectures);
+    auto const [first, last] = std::ranges::unique(architectures);
+    architectures.erase(first, last);
+    return architectures;
+}
+}  // namespace sassas
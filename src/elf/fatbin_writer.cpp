@@ -0,0 +1,68 @@
+#include "sassas/elf/fatbin_writer.hpp"
+
+#include "sassas/elf/fatbin.hpp"
+#include "sassas/utils/gathered_write.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sassas {
+namespace {
+// The headers are written as they are laid out in memory.
+static_assert(std::endian::native == std::endian::little, "Only little-endian hosts are supported");
+
+/// The contents of the images are padded to a multiple of this size.
+constexpr std::size_t IMAGE_ALIGNMENT = 8;
+
+/// The source of the padding after the images.
+constexpr std::array<std::byte, IMAGE_ALIGNMENT> zeros {};
+}  // namespace
+
+auto FatbinWriter::write(char const *path) const -> bool {
+    std::vector<fatbin::ImageHeader> headers;
+    headers.reserve(cubins_.size());
+    std::vector<std::span<std::byte const>> buffers;
+    buffers.reserve(1 + cubins_.size() * 3);
+
+    fatbin::ContainerHeader container {
+        .magic = fatbin::MAGIC,
+        .version = 1,
+        .header_size = sizeof(fatbin::ContainerHeader),
+        .size = 0,
+    };
+    buffers.push_back(std::as_bytes(std::span(&container, 1)));
+
+    for (Cubin const &cubin : cubins_) {
+        std::size_t const padding = (IMAGE_ALIGNMENT - cubin.image.size() % IMAGE_ALIGNMENT)
+            % IMAGE_ALIGNMENT;
+        headers.push_back({
+            .kind = fatbin::KIND_CUBIN,
+            .unknown0 = 0x0101,
+            .header_size = sizeof(fatbin::ImageHeader),
+            .size = cubin.image.size() + padding,
+            .compressed_size = 0,
+            .unknown1 = 0,
+            .minor_version = 0,
+            .major_version = 0,
+            .sm_version = cubin.sm_version,
+            .name_offset = 0,
+            .name_size = 0,
+            .flags = fatbin::FLAG_64BIT,
+            .unknown2 = 0,
+            .uncompressed_size = 0,
+        });
+        container.size += sizeof(fatbin::ImageHeader) + headers.back().size;
+
+        // `headers` does not grow beyond its reserved size, so the header stays in place.
+        buffers.push_back(std::as_bytes(std::span(&headers.back(), 1)));
+        buffers.push_back(cubin.image);
+        buffers.push_back(std::span(zeros).first(padding));
+    }
+
+    return write_file(path, buffers);
+}
+}  // namespace sassas
@@ -0,0 +1,219 @@
+#include "sassas/encoder/encoder.hpp"
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/utils/unreachable.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+auto validation_level_from_string(std::string_view str) -> std::optional<ValidationLevel> {
+    for (auto const level :
+         { ValidationLevel::Full, ValidationLevel::ErrorsOnly, ValidationLevel::Trusted })
+    {
+        if (str == display_string(level)) {
+            return level;
+        }
+    }
+
+    return std::nullopt;
+}
+
+namespace {
+auto diag_level(ConditionType::Kind kind) -> DiagLevel {
+    switch (kind) {
+    case ConditionType::Error:
+        return DiagLevel::Error;
+    case ConditionType::Warning:
+        return DiagLevel::Warning;
+    case ConditionType::Info:
+        return DiagLevel::Note;
+    default:
+        unreachable();
+    }
+}
+
+/// Returns whether `value` can be stored in a field of `width` bits. Negative values are accepted
+/// if they can be represented as a `width`-bit two's complement integer. Only 0 fits into a field
+/// without bits.
+auto fits_into(std::int64_t value, unsigned width) -> bool {
+    if (width == 0) {
+        return value == 0;
+    } else if (width >= 64) {
+        return true;
+    } else if (value >= 0) {
+        return static_cast<std::uint64_t>(value) < (static_cast<std::uint64_t>(1) << width);
+    } else {
+        return value >= -(static_cast<std::int64_t>(1) << (width - 1));
+    }
+}
+}  // namespace
+
+auto Encoder::check_conditions(
+    std::span<Condition const> conditions,
+    std::span<std::int64_t const> operands,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    bool success = true;
+    for (Condition const &condition : conditions) {
+        success &= check_condition(condition, operands, issues);
+    }
+
+    return success;
+}
+
+auto Encoder::check_condition(
+    Condition const &condition,
+    std::span<std::int64_t const> operands,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    auto const value = condition.expr.evaluate(operands, [this](std::string_view name) {
+        return find_table(name);
+    });
+
+    // If the condition cannot be evaluated (e.g. it depends on the compilation environment), we
+    // cannot prove that it is violated, so we let it pass.
+    if (value && *value == 0) {
+        issues.push_back(
+            EncodeIssue {
+                .kind = EncodeIssue::ConditionViolated,
+                .level = diag_level(condition.kind),
+                .message = condition.message,
+                .subject = condition.type_name,
+            }
+        );
+
+        return condition.kind != ConditionType::Error;
+    }
+
+    return true;
+}
+
+auto Encoder::encode_field(
+    EncodingAssignment const &encoding,
+    std::span<std::int64_t const> operands,
+    InstructionWord &word,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    auto const value = encoding.value.evaluate(operands, [this](std::string_view name) {
+        return find_table(name);
+    });
+
+    if (!value) {
+        issues.push_back(
+            EncodeIssue {
+                .kind = EncodeIssue::EvaluationFailed,
+                .level = DiagLevel::Error,
+                .message = "the value of the field cannot be computed",
+                .subject = encoding.field_name,
+            }
+        );
+
+        return false;
+    } else if (!fits_into(*value, encoding.field.width())) {
+        issues.push_back(
+            EncodeIssue {
+                .kind = EncodeIssue::ValueOutOfRange,
+                .level = DiagLevel::Error,
+                .message = "the value does not fit into the field",
+                .subject = encoding.field_name,
+            }
+        );
+
+        return false;
+    } else {
+        encoding.field.insert(word, static_cast<std::uint64_t>(*value));
+        return true;
+    }
+}
+
+template <ValidationLevel Level>
+auto Encoder::encode(
+    InstructionClass const &instruction_class,
+    std::span<std::int64_t const> operands,
+    std::vector<EncodeIssue> &issues
+) const -> std::optional<InstructionWord> {
+    if constexpr (Level == ValidationLevel::Full) {
+        if (!check_conditions(instruction_class.conditions, operands, issues)) {
+            return std::nullopt;
+        }
+    } else if constexpr (Level == ValidationLevel::ErrorsOnly) {
+        if (!check_conditions(instruction_class.error_conditions(), operands, issues)) {
+            return std::nullopt;
+        }
+    }
+
+    bool success = true;
+    InstructionWord result;
+    for (EncodingAssignment const &encoding : instruction_class.encodings) {
+        success &= encode_field(encoding, operands, result, issues);
+    }
+
+    if (success) {
+        return result;
+    } else {
+        return std::nullopt;
+    }
+}
+
+template auto Encoder::encode<ValidationLevel::Full>(
+    InstructionClass const &,
+    std::span<std::int64_t const>,
+    std::vector<EncodeIssue> &
+) const -> std::optional<InstructionWord>;
+template auto Encoder::encode<ValidationLevel::ErrorsOnly>(
+    InstructionClass const &,
+    std::span<std::int64_t const>,
+    std::vector<EncodeIssue> &
+) const -> std::optional<InstructionWord>;
+template auto Encoder::encode<ValidationLevel::Trusted>(
+    InstructionClass const &,
+    std::span<std::int64_t const>,
+    std::vector<EncodeIssue> &
+) const -> std::optional<InstructionWord>;
+
+auto Encoder::encode(
+    ValidationLevel level,
+    InstructionClass const &instruction_class,
+    std::span<std::int64_t const> operands,
+    std::vector<EncodeIssue> &issues
+) const -> std::optional<InstructionWord> {
+    switch (level) {
+    case ValidationLevel::Full:
+        return encode<ValidationLevel::Full>(instruction_class, operands, issues);
+    case ValidationLevel::ErrorsOnly:
+        return encode<ValidationLevel::ErrorsOnly>(instruction_class, operands, issues);
+    case ValidationLevel::Trusted:
+        return encode<ValidationLevel::Trusted>(instruction_class, operands, issues);
+    default:
+        unreachable();
+    }
+}
+
+auto Encoder::patch(
+    InstructionClass const &instruction_class,
+    unsigned slot,
+    std::span<std::int64_t const> operands,
+    InstructionWord &word,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    bool success = true;
+    InstructionWord result = word;
+    for (EncodingAssignment const &encoding : instruction_class.encodings) {
+        if (encoding.value.uses_operand(slot)) {
+            success &= encode_field(encoding, operands, result, issues);
+        }
+    }
+
+    if (success) {
+        word = result;
+    }
+    return success;
+}
+}  // namespace sassas
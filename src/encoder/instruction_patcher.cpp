@@ -0,0 +1,191 @@
+#include "sassas/encoder/instruction_patcher.hpp"
+
+#include "sassas/decoder/decoded_instruction.hpp"
+#include "sassas/elf/elf.hpp"
+#include "sassas/elf/elf_reader.hpp"
+#include "sassas/encoder/encoder.hpp"
+#include "sassas/isa/expression.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+auto InstructionPatcher::prepare(
+    std::span<std::byte const> instruction,
+    std::string_view operand,
+    std::string_view &error
+) const -> std::optional<OperandPatch> {
+    std::optional<InstructionWord> const word = read_word(instruction);
+    if (!word) {
+        error = "The instruction is truncated";
+        return std::nullopt;
+    }
+    DecodedInstruction const decoded(decoder_, *word);
+    if (!decoded.is_valid()) {
+        error = "The instruction does not match any instruction class";
+        return std::nullopt;
+    }
+    InstructionClass const &instruction_class = decoded.instruction_class();
+    std::optional<unsigned> const slot = instruction_class.find_slot(operand);
+    if (!slot) {
+        error = "The instruction has no such operand";
+        return std::nullopt;
+    }
+    if (*slot == InstructionClass::OPCODE_SLOT) {
+        error = "The opcode cannot be patched";
+        return std::nullopt;
+    }
+
+    OperandPatch patch {
+        .instruction_class = &instruction_class,
+        .slot = *slot,
+        .operands = std::vector<std::int64_t>(instruction_class.slot_names.size()),
+        .conditions = {},
+    };
+    // The other operands whose values cannot be recovered from the instruction.
+    std::vector<unsigned> unknown;
+    for (unsigned i = 0; i != patch.operands.size(); ++i) {
+        if (std::optional<std::int64_t> const value = decoded.operand_value(i)) {
+            patch.operands[i] = *value;
+        } else if (i != *slot) {
+            unknown.push_back(i);
+        }
+    }
+    auto const uses_unknown = [&unknown](Expr const &expr) {
+        return std::ranges::any_of(unknown, [&expr](unsigned i) { return expr.uses_operand(i); });
+    };
+
+    bool is_encoded = false;
+    for (EncodingAssignment const &encoding : instruction_class.encodings) {
+        if (encoding.value.uses_operand(*slot)) {
+            // The field would be written with a made-up value for the other operand.
+            if (uses_unknown(encoding.value)) {
+                error = "The operand shares a field with an operand that cannot be recovered";
+                return std::nullopt;
+            }
+            is_encoded = true;
+        }
+    }
+    if (!is_encoded) {
+        error = "The operand is not encoded in the instruction";
+        return std::nullopt;
+    }
+
+    for (unsigned i = 0; i != instruction_class.conditions.size(); ++i) {
+        Expr const &expr = instruction_class.conditions[i].expr;
+        if (expr.uses_operand(*slot) && !uses_unknown(expr)) {
+            patch.conditions.push_back(i);
+        }
+    }
+    return patch;
+}
+
+auto InstructionPatcher::register_value(OperandPatch const &patch, std::string_view name) const
+    -> std::optional<std::int64_t>  //
+{
+    std::vector<FormatItem> const &format = patch.instruction_class->format;
+    auto const item = std::ranges::find_if(format, [&patch](FormatItem const &candidate) {
+        return candidate.slot == patch.slot
+            && (candidate.kind == FormatItem::Register || candidate.kind == FormatItem::Modifier);
+    });
+    if (item == format.end()) {
+        return std::nullopt;
+    }
+    auto const group = isa().registers.find(item->type);
+    if (group == isa().registers.end()) {
+        return std::nullopt;
+    }
+    if (std::optional<unsigned> const value = group->second.find(name)) {
+        return *value;
+    }
+    return std::nullopt;
+}
+
+auto InstructionPatcher::apply(
+    OperandPatch const &patch,
+    std::int64_t value,
+    ValidationLevel level,
+    InstructionWord &word,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    InstructionClass const &instruction_class = *patch.instruction_class;
+    // The patch stays as prepared, so that it can be applied again with other values.
+    std::vector<std::int64_t> operands = patch.operands;
+    operands[patch.slot] = value;
+
+    bool success = true;
+    if (level != ValidationLevel::Trusted) {
+        for (unsigned const index : patch.conditions) {
+            // The conditions of kind `ConditionType::Error` come first.
+            if (level == ValidationLevel::ErrorsOnly
+                && index >= instruction_class.error_condition_count)
+            {
+                break;
+            }
+            Condition const &condition = instruction_class.conditions[index];
+            success &= encoder_.check_condition(condition, operands, issues);
+        }
+    }
+    return success && encoder_.patch(instruction_class, patch.slot, operands, word, issues);
+}
+
+auto InstructionPatcher::apply(
+    OperandPatch const &patch,
+    std::int64_t value,
+    ValidationLevel level,
+    std::span<std::byte> instruction,
+    std::vector<EncodeIssue> &issues
+) const -> bool {
+    std::optional<InstructionWord> word = read_word(instruction);
+    if (!word || !apply(patch, value, level, *word, issues)) {
+        return false;
+    }
+    std::memcpy(instruction.data(), word->words.data(), std::min(instruction_size_, 16u));
+    return true;
+}
+
+auto InstructionPatcher::read_word(std::span<std::byte const> instruction) const
+    -> std::optional<InstructionWord>  //
+{
+    if (instruction.size() < instruction_size_) {
+        return std::nullopt;
+    }
+    InstructionWord word {};
+    std::memcpy(word.words.data(), instruction.data(), std::min(instruction_size_, 16u));
+    return word;
+}
+
+auto find_cubin_code(std::span<std::byte> image, std::string_view section, std::string_view &error)
+    -> std::optional<std::span<std::byte>>  //
+{
+    std::optional<ElfReader> const elf = ElfReader::read(image, error);
+    if (!elf) {
+        return std::nullopt;
+    }
+    if (elf->machine() != elf::EM_CUDA) {
+        error = "The machine is not CUDA";
+        return std::nullopt;
+    }
+
+    for (ElfSectionView const &view : elf->sections()) {
+        if (view.name == section && view.is_executable()) {
+            if (view.data.empty()) {
+                return std::span<std::byte>();
+            }
+            // The sections are views of the image, so the same bytes can be written through it.
+            auto const offset = static_cast<std::size_t>(view.data.data() - image.data());
+            return image.subspan(offset, view.data.size());
+        }
+    }
+    error = "The cubin has no such code section";
+    return std::nullopt;
+}
+}  // namespace sassas
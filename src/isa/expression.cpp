@@ -0,0 +1,211 @@
+#include "sassas/isa/expression.hpp"
+
+#include "sassas/utils/unreachable.hpp"
+
+#include "fmt/base.h"
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+auto Expr::arity(Op op) -> unsigned {
+    switch (op) {
+    case Op::Integer:
+    case Op::Operand:
+    case Op::TableCall:
+    case Op::Unresolved:
+        return 0;
+
+    case Op::Negate:
+    case Op::LogicalNot:
+    case Op::BitwiseNot:
+        return 1;
+
+    case Op::Conditional:
+        return 3;
+
+    default:
+        return 2;
+    }
+}
+
+auto Expr::apply(Op op, std::int64_t lhs, std::int64_t rhs) -> std::optional<std::int64_t> {
+    // Use unsigned arithmetic for the operations that may overflow, so that the result wraps
+    // around instead of invoking undefined behavior.
+    auto const ulhs = static_cast<std::uint64_t>(lhs);
+    auto const urhs = static_cast<std::uint64_t>(rhs);
+
+    switch (op) {
+    case Op::Negate:
+        return static_cast<std::int64_t>(-ulhs);
+    case Op::LogicalNot:
+        return lhs == 0;
+    case Op::BitwiseNot:
+        return ~lhs;
+
+    case Op::Add:
+        return static_cast<std::int64_t>(ulhs + urhs);
+    case Op::Sub:
+        return static_cast<std::int64_t>(ulhs - urhs);
+    case Op::Mul:
+        return static_cast<std::int64_t>(ulhs * urhs);
+    case Op::Div:
+    case Op::Scale:
+    case Op::Rem:
+        if (rhs == 0 || (lhs == INT64_MIN && rhs == -1)) {
+            return std::nullopt;
+        }
+        return op == Op::Rem ? lhs % rhs : lhs / rhs;
+    case Op::Shl:
+        return urhs >= 64 ? 0 : static_cast<std::int64_t>(ulhs << urhs);
+    case Op::Shr:
+        return urhs >= 64 ? (lhs < 0 ? -1 : 0) : lhs >> urhs;
+    case Op::BitAnd:
+        return lhs & rhs;
+    case Op::BitOr:
+        return lhs | rhs;
+    case Op::LogicalAnd:
+        return lhs != 0 && rhs != 0;
+    case Op::LogicalOr:
+        return lhs != 0 || rhs != 0;
+    case Op::Equal:
+        return lhs == rhs;
+    case Op::NotEqual:
+        return lhs != rhs;
+    case Op::Less:
+        return lhs < rhs;
+    case Op::LessEqual:
+        return lhs <= rhs;
+    case Op::Greater:
+        return lhs > rhs;
+    case Op::GreaterEqual:
+        return lhs >= rhs;
+    case Op::Implies:
+        return lhs == 0 || rhs != 0;
+
+    default:
+        unreachable();
+    }
+}
+
+namespace {
+auto operator_spelling(Expr::Op op) -> char const * {
+    switch (op) {
+    case Expr::Op::Negate:
+        return "-";
+    case Expr::Op::LogicalNot:
+        return "!";
+    case Expr::Op::BitwiseNot:
+        return "~";
+    case Expr::Op::Add:
+        return "+";
+    case Expr::Op::Sub:
+        return "-";
+    case Expr::Op::Mul:
+        return "*";
+    case Expr::Op::Div:
+        return "/";
+    case Expr::Op::Rem:
+        return "%";
+    case Expr::Op::Shl:
+        return "<<";
+    case Expr::Op::Shr:
+        return ">>";
+    case Expr::Op::BitAnd:
+        return "&";
+    case Expr::Op::BitOr:
+        return "|";
+    case Expr::Op::LogicalAnd:
+        return "&&";
+    case Expr::Op::LogicalOr:
+        return "||";
+    case Expr::Op::Equal:
+        return "==";
+    case Expr::Op::NotEqual:
+        return "!=";
+    case Expr::Op::Less:
+        return "<";
+    case Expr::Op::LessEqual:
+        return "<=";
+    case Expr::Op::Greater:
+        return ">";
+    case Expr::Op::GreaterEqual:
+        return ">=";
+    case Expr::Op::Implies:
+        return "->";
+    case Expr::Op::Scale:
+        return "SCALE";
+    default:
+        return "?";
+    }
+}
+}  // namespace
+
+void Expr::dump() const {
+    // Rebuild the infix form from the postfix nodes. Every sub-expression is parenthesized, so we
+    // do not need to care about precedence.
+    std::vector<std::string> stack;
+    auto const pop_arguments = [&](std::size_t count) {
+        std::vector<std::string> arguments(
+            std::make_move_iterator(stack.end() - static_cast<std::ptrdiff_t>(count)),
+            std::make_move_iterator(stack.end())
+        );
+        stack.resize(stack.size() - count);
+        return arguments;
+    };
+
+    for (Node const &node : nodes_) {
+        switch (node.op) {
+        case Op::Integer:
+            stack.push_back(fmt::format("{}", node.value));
+            break;
+
+        case Op::Operand:
+            stack.push_back(fmt::format("${}", node.index));
+            break;
+
+        case Op::TableCall:
+        case Op::Unresolved: {
+            std::vector<std::string> const arguments =
+                pop_arguments(static_cast<std::size_t>(node.value));
+            stack.push_back(fmt::format(
+                "{}{}({})",
+                node.op == Op::Unresolved ? "?" : "",
+                names_[node.index],
+                fmt::join(arguments, ", ")
+            ));
+            break;
+        }
+
+        case Op::Conditional: {
+            std::vector<std::string> const arguments = pop_arguments(3);
+            stack.push_back(
+                fmt::format("({} ? {} : {})", arguments[0], arguments[1], arguments[2])
+            );
+            break;
+        }
+
+        default:
+            if (arity(node.op) == 1) {
+                stack.back() = fmt::format("{}{}", operator_spelling(node.op), stack.back());
+            } else {
+                std::vector<std::string> const arguments = pop_arguments(2);
+                stack.push_back(fmt::format(
+                    "({} {} {})",
+                    arguments[0],
+                    operator_spelling(node.op),
+                    arguments[1]
+                ));
+            }
+            break;
+        }
+    }
+
+    fmt::print("{}", fmt::join(stack, " "));
+}
+}  // namespace sassas
@@ -0,0 +1,280 @@
+#include "sassas/isa/frozen_isa.hpp"
+
+#include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/register.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// Folds the case of an ASCII letter, as `std::tolower()` does in the "C" locale, without
+/// consulting the locale.
+auto to_lower(char c) -> char {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+auto less_ignoring_case(std::string_view lhs, std::string_view rhs) -> bool {
+    return std::ranges::lexicographical_compare(lhs, rhs, std::ranges::less(), to_lower, to_lower);
+}
+
+auto equal_ignoring_case(std::string_view lhs, std::string_view rhs) -> bool {
+    return std::ranges::equal(lhs, rhs, std::ranges::equal_to(), to_lower, to_lower);
+}
+
+/// Converts a size or an offset into a 32-bit index of the frozen ISA.
+auto to_index(std::size_t value) -> std::uint32_t {
+    assert(value <= std::numeric_limits<std::uint32_t>::max() && "The ISA is too large to freeze");
+    return static_cast<std::uint32_t>(value);
+}
+}  // namespace
+
+auto FrozenISA::RegisterGroupView::name(std::uint32_t index) const -> std::string_view {
+    StringRef const ref = registers_[index].name;
+    return std::string_view(strings_.data() + ref.offset, ref.size);
+}
+
+auto FrozenISA::RegisterGroupView::find(std::string_view name) const -> std::optional<unsigned> {
+    auto const iter = std::ranges::lower_bound(
+        by_name_,
+        name,
+        less_ignoring_case,
+        [this](std::uint32_t index) { return this->name(index); }
+    );
+    if (iter != by_name_.end() && equal_ignoring_case(this->name(*iter), name)) {
+        return registers_[*iter].value;
+    }
+    return std::nullopt;
+}
+
+auto FrozenISA::RegisterGroupView::find(unsigned value) const -> std::optional<std::string_view> {
+    auto const value_of = [this](std::uint32_t index) { return registers_[index].value; };
+    auto const iter = std::ranges::lower_bound(by_value_, value, std::ranges::less(), value_of);
+    if (iter != by_value_.end() && registers_[*iter].value == value) {
+        return name(*iter);
+    }
+    return std::nullopt;
+}
+
+template <class Entry>
+void FrozenISA::build_index(NameMap<Entry> &map) const {
+    auto const name_of = [this](Entry const &entry) { return string(entry.name); };
+    std::ranges::stable_sort(map.entries, std::ranges::less(), name_of);
+
+    map.slots.assign(std::bit_ceil(map.entries.size() * 2 + 1), 0);
+    std::size_t const mask = map.slots.size() - 1;
+    for (std::size_t i = 0; i != map.entries.size(); ++i) {
+        std::string_view const name = name_of(map.entries[i]);
+        std::size_t slot = std::hash<std::string_view>()(name) & mask;
+        for (; map.slots[slot] != 0; slot = (slot + 1) & mask) {
+            if (name_of(map.entries[map.slots[slot] - 1]) == name) {
+                break;
+            }
+        }
+        if (map.slots[slot] == 0) {
+            map.slots[slot] = to_index(i + 1);
+        }
+    }
+}
+
+auto FrozenISA::freeze(ISA const &isa) -> FrozenISA {
+    FrozenISA frozen;
+
+    // Identical strings, such as register names that appear in several categories, are stored
+    // once. The keys point into `isa`, which outlives this function.
+    std::unordered_map<std::string_view, StringRef> interned;
+    auto const intern = [&](std::string_view str) {
+        auto const [iter, inserted] = interned.try_emplace(str);
+        if (inserted) {
+            iter->second = {
+                .offset = to_index(frozen.strings_.size()),
+                .size = to_index(str.size()),
+            };
+            frozen.strings_.insert(frozen.strings_.end(), str.begin(), str.end());
+        }
+        return iter->second;
+    };
+    frozen.architecture_name_ = intern(isa.architecture.name);
+    frozen.functional_unit_name_ = intern(isa.functional_unit.name());
+    frozen.encoding_width_ = isa.functional_unit.encoding_width();
+
+    for (auto const &[name, value] : isa.parameters) {
+        frozen.parameters_.entries.push_back({ .name = intern(name), .value = value });
+    }
+    frozen.build_index(frozen.parameters_);
+
+    for (auto const &[name, value] : isa.constants) {
+        frozen.constants_.entries.push_back({ .name = intern(name), .value = value });
+    }
+    frozen.build_index(frozen.constants_);
+
+    for (auto const &[key, value] : isa.string_map) {
+        frozen.string_map_.entries.push_back({ .name = intern(key), .value = intern(value) });
+    }
+    frozen.build_index(frozen.string_map_);
+
+    for (ConditionType const &condition_type : isa.condition_types) {
+        frozen.condition_types_.entries.push_back(
+            { .name = intern(condition_type.name), .kind = condition_type.kind }
+        );
+    }
+    frozen.build_index(frozen.condition_types_);
+
+    for (auto const &[category, group] : isa.registers) {
+        auto const first = to_index(frozen.registers_.size());
+        std::vector<Register> const &registers = group.registers();
+        for (Register const &reg : registers) {
+            frozen.registers_.push_back({ .name = intern(reg.name), .value = reg.value });
+        }
+        frozen.register_groups_.entries.push_back(
+            { .name = intern(category), .first = first, .size = to_index(registers.size()) }
+        );
+
+        // The lookups return the last matching register, so ties are broken by descending index.
+        std::vector<std::uint32_t> indices(registers.size());
+        std::iota(indices.begin(), indices.end(), 0u);
+        std::ranges::sort(indices, [&](std::uint32_t lhs, std::uint32_t rhs) {
+            if (less_ignoring_case(registers[lhs].name, registers[rhs].name)) {
+                return true;
+            } else if (less_ignoring_case(registers[rhs].name, registers[lhs].name)) {
+                return false;
+            }
+            return lhs > rhs;
+        });
+        frozen.registers_by_name_.insert(
+            frozen.registers_by_name_.end(),
+            indices.begin(),
+            indices.end()
+        );
+
+        std::ranges::sort(indices, [&](std::uint32_t lhs, std::uint32_t rhs) {
+            if (registers[lhs].value != registers[rhs].value) {
+                return registers[lhs].value < registers[rhs].value;
+            }
+            return lhs > rhs;
+        });
+        frozen.registers_by_value_.insert(
+            frozen.registers_by_value_.end(),
+            indices.begin(),
+            indices.end()
+        );
+    }
+    frozen.build_index(frozen.register_groups_);
+
+    for (auto const &[name, table] : isa.tables) {
+        std::span<unsigned const> const items = table.view().items();
+        frozen.tables_.entries.push_back({
+            .name = intern(name),
+            .key_size = table.key_size(),
+            .first = to_index(frozen.table_items_.size()),
+            .size = to_index(items.size()),
+        });
+        frozen.table_items_.insert(frozen.table_items_.end(), items.begin(), items.end());
+    }
+    frozen.build_index(frozen.tables_);
+
+    for (auto const &[name, bitmask] : isa.functional_unit.bitmasks()) {
+        frozen.bitmasks_.entries.push_back({
+            .name = intern(name),
+            .first = to_index(frozen.bit_ranges_.size()),
+            .size = to_index(bitmask.size()),
+        });
+        frozen.bit_ranges_.insert(frozen.bit_ranges_.end(), bitmask.begin(), bitmask.end());
+    }
+    frozen.build_index(frozen.bitmasks_);
+
+    return frozen;
+}
+
+template <class Entry>
+auto FrozenISA::find_entry(NameMap<Entry> const &map, std::string_view name) const
+    -> Entry const *  //
+{
+    std::size_t const mask = map.slots.size() - 1;
+    for (std::size_t slot = std::hash<std::string_view>()(name) & mask; map.slots[slot] != 0;
+         slot = (slot + 1) & mask)
+    {
+        Entry const &entry = map.entries[map.slots[slot] - 1];
+        if (string(entry.name) == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+auto FrozenISA::find_parameter(std::string_view name) const -> std::optional<int> {
+    if (Constant const *const entry = find_entry(parameters_, name)) {
+        return entry->value;
+    }
+    return std::nullopt;
+}
+
+auto FrozenISA::find_constant(std::string_view name) const -> std::optional<int> {
+    if (Constant const *const entry = find_entry(constants_, name)) {
+        return entry->value;
+    }
+    return std::nullopt;
+}
+
+auto FrozenISA::find_string(std::string_view key) const -> std::optional<std::string_view> {
+    if (StringMapping const *const entry = find_entry(string_map_, key)) {
+        return string(entry->value);
+    }
+    return std::nullopt;
+}
+
+auto FrozenISA::find_condition_type(std::string_view name) const
+    -> std::optional<ConditionType::Kind>  //
+{
+    if (auto const *const entry = find_entry(condition_types_, name)) {
+        return entry->kind;
+    }
+    return std::nullopt;
+}
+
+auto FrozenISA::find_register_group(std::string_view category) const
+    -> std::optional<RegisterGroupView>  //
+{
+    auto const *const entry = find_entry(register_groups_, category);
+    if (!entry) {
+        return std::nullopt;
+    }
+    return RegisterGroupView(
+        strings_,
+        std::span(registers_).subspan(entry->first, entry->size),
+        std::span(registers_by_name_).subspan(entry->first, entry->size),
+        std::span(registers_by_value_).subspan(entry->first, entry->size)
+    );
+}
+
+auto FrozenISA::find_table(std::string_view name) const -> std::optional<TableView> {
+    if (FrozenTable const *const entry = find_entry(tables_, name)) {
+        auto const items = std::span(table_items_).subspan(entry->first, entry->size);
+        return TableView(items, entry->key_size);
+    }
+    return std::nullopt;
+}
+
+auto FrozenISA::find_bitmask(std::string_view name) const
+    -> std::optional<std::span<BitRange const>>  //
+{
+    if (FrozenBitMask const *const entry = find_entry(bitmasks_, name)) {
+        return std::span(bit_ranges_).subspan(entry->first, entry->size);
+    }
+    return std::nullopt;
+}
+}  // namespace sassas
@@ -3,6 +3,8 @@
 #include "fmt/base.h"
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <iterator>
 #include <ranges>
 #include <string_view>
@@ -22,6 +24,73 @@ BitMask::BitMask(std::string_view str_description, char zero, char one) {
     }
 }
 
+namespace {
+/// Returns `size` bits of `word` starting at bit `start`. The range may cross the boundary between
+/// the two 64-bit words.
+auto read_bits(InstructionWord const &word, unsigned start, unsigned size) -> std::uint64_t {
+    assert(size != 0 && size <= 64 && start + size <= 128 && "Invalid bit range");
+
+    std::uint64_t const mask =
+        size == 64 ? ~static_cast<std::uint64_t>(0) : (static_cast<std::uint64_t>(1) << size) - 1;
+    unsigned const index = start / 64;
+    unsigned const offset = start % 64;
+
+    std::uint64_t result = word.words[index] >> offset;
+    if (offset != 0 && offset + size > 64) {
+        // The range spans both words. Fetch the remaining high bits from the next word.
+        result |= word.words[index + 1] << (64 - offset);
+    }
+
+    return result & mask;
+}
+
+/// Writes the low `size` bits of `value` into `word`, starting at bit `start`.
+void write_bits(InstructionWord &word, unsigned start, unsigned size, std::uint64_t value) {
+    assert(size != 0 && size <= 64 && start + size <= 128 && "Invalid bit range");
+
+    std::uint64_t const mask =
+        size == 64 ? ~static_cast<std::uint64_t>(0) : (static_cast<std::uint64_t>(1) << size) - 1;
+    unsigned const index = start / 64;
+    unsigned const offset = start % 64;
+
+    value &= mask;
+    word.words[index] = (word.words[index] & ~(mask << offset)) | (value << offset);
+    if (offset != 0 && offset + size > 64) {
+        unsigned const shift = 64 - offset;
+        word.words[index + 1] = (word.words[index + 1] & ~(mask >> shift)) | (value >> shift);
+    }
+}
+}  // namespace
+
+auto BitMask::width() const -> unsigned {
+    unsigned result = 0;
+    for (BitRange const &range : *this) {
+        result += range.size;
+    }
+
+    return result;
+}
+
+auto BitMask::extract(InstructionWord const &word) const -> std::uint64_t {
+    std::uint64_t result = 0;
+    for (BitRange const &range : *this) {
+        // The first range holds the most significant bits, so we shift the previous result to
+        // make room for the current range.
+        result = (range.size == 64 ? 0 : result << range.size)
+            | read_bits(word, range.start, range.size);
+    }
+
+    return result;
+}
+
+void BitMask::insert(InstructionWord &word, std::uint64_t value) const {
+    // The last range holds the least significant bits, so we consume `value` from the back.
+    for (BitRange const &range : *this | std::views::reverse) {
+        write_bits(word, range.start, range.size, value);
+        value = range.size == 64 ? 0 : value >> range.size;
+    }
+}
+
 void BitMask::dump() const {
     if (empty()) {
         fmt::print("[Empty]");
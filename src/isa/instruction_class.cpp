@@ -0,0 +1,91 @@
+#include "sassas/isa/instruction_class.hpp"
+
+#include "fmt/base.h"
+#include "fmt/format.h"
+
+#include <string>
+
+namespace sassas {
+namespace {
+auto format_item_string(FormatItem const &item) -> std::string {
+    switch (item.kind) {
+    case FormatItem::Opcode:
+        return "Opcode";
+    case FormatItem::Literal:
+        return fmt::format("'{}'", item.type);
+    default:
+        break;
+    }
+
+    std::string result;
+    if (item.is_predicate) {
+        result += "@";
+    }
+    if (item.kind == FormatItem::Modifier) {
+        result += "/";
+    }
+    if (item.prefixes & FormatItem::Negate) {
+        result += "[-]";
+    }
+    if (item.prefixes & FormatItem::Absolute) {
+        result += "[||]";
+    }
+    if (item.prefixes & FormatItem::Not) {
+        result += "[!]";
+    }
+    if (item.prefixes & FormatItem::Invert) {
+        result += "[~]";
+    }
+
+    result += item.type;
+    if (item.kind == FormatItem::Immediate) {
+        result += fmt::format("({}", item.bits);
+        if (item.default_value) {
+            result += fmt::format("/{}", *item.default_value);
+        }
+        result += ")";
+    } else if (item.default_name) {
+        result += fmt::format("({})", *item.default_name);
+    }
+
+    return fmt::format("{}:{}", result, item.name);
+}
+}  // namespace
+
+void InstructionClass::dump(unsigned indent) const {
+    fmt::println("{:>{}}{}CLASS \"{}\"", "", indent, is_alternate ? "ALTERNATE " : "", name);
+
+    fmt::print("{:>{}}FORMAT", "", indent + 4);
+    for (FormatItem const &item : format) {
+        fmt::print(
+            " {}{}{}{}",
+            item.is_scheduling ? "$" : "",
+            item.is_optional ? "{" : "",
+            format_item_string(item),
+            item.is_optional ? "}" : ""
+        );
+    }
+    fmt::println("");
+
+    fmt::println("{:>{}}CONDITIONS", "", indent + 4);
+    for (Condition const &condition : conditions) {
+        fmt::print("{:>{}}{} ", "", indent + 8, condition.type_name);
+        condition.expr.dump();
+        fmt::println(" : \"{}\"", condition.message);
+    }
+
+    fmt::println("{:>{}}OPCODES", "", indent + 4);
+    for (auto const &[opcode_name, value] : opcodes) {
+        fmt::println("{:>{}}{} = {:#b}", "", indent + 8, opcode_name, value);
+    }
+
+    fmt::println("{:>{}}ENCODING", "", indent + 4);
+    for (EncodingAssignment const &encoding : encodings) {
+        fmt::print("{:>{}}{} ", "", indent + 8, encoding.field_name);
+        encoding.field.dump();
+        fmt::print(" = ");
+        encoding.value.dump();
+        fmt::println("");
+    }
+}
+}  // namespace sassas
@@ -2,6 +2,7 @@
 
 #include "sassas/isa/architecture.hpp"
 #include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/instruction_class.hpp"
 
 #include "fmt/base.h"
 #include "fmt/format.h"
@@ -128,5 +129,11 @@ void ISA::dump() const {
     fmt::println("Functional Unit\n================");
     functional_unit.dump(4);
     fmt::println("");
+
+    fmt::println("Instruction Classes\n===================");
+    for (InstructionClass const &instruction_class : classes) {
+        instruction_class.dump(4);
+        fmt::println("");
+    }
 }
 }  // namespace sassas
@@ -0,0 +1,396 @@
+#include "sassas/isa/isa_image.hpp"
+
+#include "sassas/isa/architecture.hpp"
+#include "sassas/isa/condition_type.hpp"
+#include "sassas/isa/expression.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/register.hpp"
+#include "sassas/isa/table.hpp"
+#include "sassas/utils/image_io.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+namespace {
+void write_bitmask(ImageWriter &writer, BitMask const &bitmask) {
+    writer.u32(static_cast<std::uint32_t>(bitmask.size()));
+    for (BitRange const &range : bitmask) {
+        writer.u32(range.start);
+        writer.u32(range.size);
+    }
+}
+
+auto read_bitmask(ImageReader &reader) -> BitMask {
+    std::vector<BitRange> ranges(reader.count(8));
+    for (BitRange &range : ranges) {
+        unsigned const start = reader.u32();
+        unsigned const size = reader.u32();
+        if (size == 0 || start > 128 || size > 128 - start) {
+            reader.fail();
+            return BitMask();
+        }
+        range = BitRange(start, size);
+    }
+    return BitMask(std::move(ranges));
+}
+
+void write_strings(ImageWriter &writer, std::vector<std::string> const &strings) {
+    writer.u32(static_cast<std::uint32_t>(strings.size()));
+    for (std::string const &string : strings) {
+        writer.string(string);
+    }
+}
+
+auto read_strings(ImageReader &reader) -> std::vector<std::string> {
+    std::vector<std::string> strings(reader.count(4));
+    for (std::string &string : strings) {
+        string = reader.string();
+    }
+    return strings;
+}
+}  // namespace
+
+auto ISAImage::write(ISA const &isa) -> std::vector<std::byte> {
+    ImageWriter writer;
+    writer.u32(MAGIC);
+    writer.u32(VERSION);
+
+    auto const write_expr = [&](Expr const &expr) {
+        writer.u32(static_cast<std::uint32_t>(expr.nodes().size()));
+        for (Expr::Node const &node : expr.nodes()) {
+            writer.u8(static_cast<std::uint8_t>(node.op));
+            writer.u32(node.index);
+            writer.i64(node.value);
+        }
+        write_strings(writer, expr.names());
+    };
+
+    writer.string(isa.architecture.name);
+    writer.u32(static_cast<std::uint32_t>(isa.architecture.details.size()));
+    for (ArchitectureDetail const &detail : isa.architecture.details) {
+        writer.string(detail.name);
+        writer.string(detail.value);
+    }
+
+    writer.u32(static_cast<std::uint32_t>(isa.condition_types.size()));
+    for (ConditionType const &condition_type : isa.condition_types) {
+        writer.u8(static_cast<std::uint8_t>(condition_type.kind));
+        writer.string(condition_type.name);
+    }
+
+    for (ISA::ConstantMap const *const map : { &isa.parameters, &isa.constants }) {
+        writer.u32(static_cast<std::uint32_t>(map->size()));
+        for (auto const &[name, value] : *map) {
+            writer.string(name);
+            writer.i64(value);
+        }
+    }
+
+    writer.u32(static_cast<std::uint32_t>(isa.string_map.size()));
+    for (auto const &[key, value] : isa.string_map) {
+        writer.string(key);
+        writer.string(value);
+    }
+
+    writer.u32(static_cast<std::uint32_t>(isa.registers.size()));
+    for (auto const &[category, group] : isa.registers) {
+        writer.string(category);
+        writer.u32(static_cast<std::uint32_t>(group.registers().size()));
+        for (Register const &reg : group.registers()) {
+            writer.string(reg.name);
+            writer.u32(reg.value);
+        }
+    }
+
+    writer.u32(static_cast<std::uint32_t>(isa.tables.size()));
+    for (auto const &[name, table] : isa.tables) {
+        writer.string(name);
+        writer.u32(table.key_size());
+        std::span<unsigned const> const items = table.view().items();
+        writer.u32(static_cast<std::uint32_t>(items.size()));
+        for (unsigned const item : items) {
+            writer.u32(item);
+        }
+    }
+
+    write_strings(writer, isa.operation_properties);
+    write_strings(writer, isa.operation_predicates);
+
+    writer.string(isa.functional_unit.name());
+    writer.u32(isa.functional_unit.encoding_width());
+    writer.u32(static_cast<std::uint32_t>(isa.functional_unit.bitmasks().size()));
+    for (auto const &[name, bitmask] : isa.functional_unit.bitmasks()) {
+        writer.string(name);
+        write_bitmask(writer, bitmask);
+    }
+
+    writer.u32(static_cast<std::uint32_t>(isa.classes.size()));
+    for (InstructionClass const &instruction_class : isa.classes) {
+        writer.string(instruction_class.name);
+        writer.u8(instruction_class.is_alternate);
+
+        writer.u32(static_cast<std::uint32_t>(instruction_class.format.size()));
+        for (FormatItem const &item : instruction_class.format) {
+            writer.u8(item.kind);
+            writer.u8(item.prefixes);
+            writer.u8(item.is_optional);
+            writer.u8(item.is_scheduling);
+            writer.u8(item.is_predicate);
+            writer.string(item.type);
+            writer.string(item.name);
+            writer.u8(item.default_name.has_value());
+            writer.string(item.default_name.value_or(""));
+            writer.u8(item.default_value.has_value());
+            writer.i64(item.default_value.value_or(0));
+            writer.u32(item.bits);
+            writer.u32(item.slot);
+        }
+
+        write_strings(writer, instruction_class.slot_names);
+
+        writer.u32(static_cast<std::uint32_t>(instruction_class.conditions.size()));
+        for (Condition const &condition : instruction_class.conditions) {
+            writer.u8(static_cast<std::uint8_t>(condition.kind));
+            writer.string(condition.type_name);
+            write_expr(condition.expr);
+            writer.string(condition.message);
+        }
+        writer.u32(instruction_class.error_condition_count);
+
+        writer.u32(static_cast<std::uint32_t>(instruction_class.opcodes.size()));
+        for (auto const &[name, value] : instruction_class.opcodes) {
+            writer.string(name);
+            writer.u64(value);
+        }
+
+        writer.u32(static_cast<std::uint32_t>(instruction_class.encodings.size()));
+        for (EncodingAssignment const &encoding : instruction_class.encodings) {
+            writer.string(encoding.field_name);
+            write_bitmask(writer, encoding.field);
+            write_expr(encoding.value);
+        }
+    }
+
+    return writer.take();
+}
+
+auto ISAImage::read(std::span<std::byte const> image, std::string_view &error)
+    -> std::optional<ISA>  //
+{
+    ImageReader reader(image);
+    if (reader.u32() != MAGIC || reader.u32() != VERSION) {
+        error = "The image is not an ISA image of this version";
+        return std::nullopt;
+    }
+
+    auto const read_kind = [&]() {
+        std::uint8_t const kind = reader.u8();
+        if (kind > ConditionType::Info) {
+            reader.fail();
+        }
+        return static_cast<ConditionType::Kind>(kind);
+    };
+
+    // The nodes are replayed through `push_node()`, which tracks the depth of the value stack.
+    // An expression that would pop more values than it pushed is rejected, since evaluating it
+    // would read outside the stack, and so is a reference to an operand slot past `slot_count`,
+    // since the decoder and the matcher index their operand vectors with it unchecked.
+    auto const read_expr = [&](std::size_t slot_count) {
+        Expr expr;
+        std::vector<Expr::Node> nodes(reader.count(13));
+        for (Expr::Node &node : nodes) {
+            std::uint8_t const op = reader.u8();
+            if (op > static_cast<std::uint8_t>(Expr::Op::Conditional)) {
+                reader.fail();
+            }
+            node = {
+                .op = static_cast<Expr::Op>(op),
+                .index = reader.u32(),
+                .value = reader.i64(),
+            };
+        }
+        expr.names_ = read_strings(reader);
+
+        for (Expr::Node const &node : nodes) {
+            if (node.op == Expr::Op::Operand && node.index >= slot_count) {
+                reader.fail();
+                break;
+            }
+            int stack_effect = 1 - static_cast<int>(Expr::arity(node.op));
+            if (node.op == Expr::Op::TableCall || node.op == Expr::Op::Unresolved) {
+                if (node.index >= expr.names_.size() || node.value < 0
+                    || node.value > expr.depth_)
+                {
+                    reader.fail();
+                    break;
+                }
+                stack_effect = 1 - static_cast<int>(node.value);
+            }
+            if (expr.depth_ + stack_effect < 1) {
+                reader.fail();
+                break;
+            }
+            expr.push_node(node, stack_effect);
+        }
+        return expr;
+    };
+
+    ISA isa;
+    isa.architecture.name = reader.string();
+    isa.architecture.details.resize(reader.count(8));
+    for (ArchitectureDetail &detail : isa.architecture.details) {
+        detail.name = reader.string();
+        detail.value = reader.string();
+    }
+
+    for (std::uint32_t count = reader.count(5); count != 0; --count) {
+        ConditionType::Kind const kind = read_kind();
+        isa.condition_types.push_back(ConditionType(kind, reader.string()));
+    }
+
+    for (ISA::ConstantMap *const map : { &isa.parameters, &isa.constants }) {
+        for (std::uint32_t count = reader.count(12); count != 0; --count) {
+            std::string name = reader.string();
+            (*map)[std::move(name)] = static_cast<int>(reader.i64());
+        }
+    }
+
+    for (std::uint32_t count = reader.count(8); count != 0; --count) {
+        std::string key = reader.string();
+        isa.string_map[std::move(key)] = reader.string();
+    }
+
+    for (std::uint32_t count = reader.count(8); count != 0; --count) {
+        RegisterGroup &group = isa.registers[reader.string()];
+        for (std::uint32_t register_count = reader.count(8); register_count != 0;
+             --register_count)
+        {
+            std::string name = reader.string();
+            group.append_register(std::move(name), reader.u32());
+        }
+    }
+
+    for (std::uint32_t count = reader.count(12); count != 0; --count) {
+        std::string name = reader.string();
+        std::uint32_t const key_size = reader.u32();
+        std::vector<unsigned> items(reader.count(4));
+        for (unsigned &item : items) {
+            item = reader.u32();
+        }
+        if (key_size == std::numeric_limits<std::uint32_t>::max()
+            || items.size() % (key_size + 1) != 0)
+        {
+            reader.fail();
+            break;
+        }
+        Table table(key_size);
+        for (std::size_t i = 0; i != items.size(); i += key_size + 1) {
+            table.append_item(
+                std::span(items).subspan(i, key_size),
+                items[i + key_size]
+            );
+        }
+        isa.tables.insert_or_assign(std::move(name), std::move(table));
+    }
+
+    isa.operation_properties = read_strings(reader);
+    isa.operation_predicates = read_strings(reader);
+
+    isa.functional_unit.set_name(reader.string());
+    isa.functional_unit.set_encoding_width(reader.u32());
+    for (std::uint32_t count = reader.count(8); count != 0; --count) {
+        std::string name = reader.string();
+        isa.functional_unit.add_bitmask(std::move(name), read_bitmask(reader));
+    }
+
+    isa.classes.resize(reader.count(8));
+    for (InstructionClass &instruction_class : isa.classes) {
+        instruction_class.name = reader.string();
+        instruction_class.is_alternate = reader.boolean();
+
+        instruction_class.format.resize(reader.count(31));
+        for (FormatItem &item : instruction_class.format) {
+            std::uint8_t const kind = reader.u8();
+            if (kind > FormatItem::Literal) {
+                reader.fail();
+            }
+            item.kind = static_cast<FormatItem::Kind>(kind);
+            item.prefixes = reader.u8();
+            item.is_optional = reader.boolean();
+            item.is_scheduling = reader.boolean();
+            item.is_predicate = reader.boolean();
+            item.type = reader.string();
+            item.name = reader.string();
+            bool const has_default_name = reader.boolean();
+            if (std::string default_name = reader.string(); has_default_name) {
+                item.default_name = std::move(default_name);
+            }
+            bool const has_default_value = reader.boolean();
+            if (std::int64_t const default_value = reader.i64(); has_default_value) {
+                item.default_value = default_value;
+            }
+            item.bits = reader.u32();
+            item.slot = reader.u32();
+        }
+
+        instruction_class.slot_names = read_strings(reader);
+        // The operands are written into vectors of `slot_names.size()` values, and the opcode
+        // always has its slot.
+        std::size_t const slot_count = instruction_class.slot_names.size();
+        if (slot_count <= InstructionClass::OPCODE_SLOT
+            || std::ranges::any_of(instruction_class.format, [slot_count](FormatItem const &item) {
+                   return item.slot >= slot_count;
+               }))
+        {
+            reader.fail();
+            break;
+        }
+
+        instruction_class.conditions.resize(reader.count(14));
+        for (Condition &condition : instruction_class.conditions) {
+            condition.kind = read_kind();
+            condition.type_name = reader.string();
+            condition.expr = read_expr(slot_count);
+            condition.message = reader.string();
+        }
+        instruction_class.error_condition_count = reader.u32();
+        if (instruction_class.error_condition_count > instruction_class.conditions.size()) {
+            reader.fail();
+        }
+
+        instruction_class.opcodes.resize(reader.count(12));
+        for (auto &[name, value] : instruction_class.opcodes) {
+            name = reader.string();
+            value = reader.u64();
+        }
+
+        instruction_class.encodings.resize(reader.count(12));
+        for (EncodingAssignment &encoding : instruction_class.encodings) {
+            encoding.field_name = reader.string();
+            encoding.field = read_bitmask(reader);
+            encoding.value = read_expr(slot_count);
+        }
+
+        if (!reader.ok()) {
+            break;
+        }
+    }
+
+    if (!reader.ok() || !reader.at_end()) {
+        error = "The ISA image is truncated or corrupted";
+        return std::nullopt;
+    }
+    return isa;
+}
+}  // namespace sassas
@@ -0,0 +1,118 @@
+#include "sassas/isa/isa_registry.hpp"
+
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/structure_pool.hpp"
+#include "sassas/utils/metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+ISARegistry::ISARegistry(Loader loader) :
+    loader_(std::move(loader)), snapshot_(std::make_shared<Snapshot const>()) { }
+
+auto ISARegistry::get(std::string_view arch) -> std::shared_ptr<LoadedISA const> {
+    if (std::optional<std::shared_ptr<LoadedISA const>> isa = find_entry(arch)) {
+        Metrics::add(Counter::ISACacheHits);
+        return std::move(*isa);
+    }
+
+    Slot &slot = get_slot(arch);
+
+    // Only one thread loads the architecture. The others wait here until it is done, without
+    // holding the lock, so that other architectures can be loaded in the meantime.
+    bool loaded = false;
+    std::call_once(slot.once, [&] {
+        loaded = true;
+        std::optional<ISA> isa = loader_(arch);
+        std::shared_ptr<LoadedISA const> loaded_isa = isa ? prepare(std::move(*isa)) : nullptr;
+
+        std::lock_guard const lock(mutex_);
+        publish(arch, std::move(loaded_isa));
+    });
+    Metrics::add(loaded ? Counter::ISACacheMisses : Counter::ISACacheHits);
+    // The ISA may have been replaced since it was loaded, so the current version is looked up.
+    return find(arch);
+}
+
+auto ISARegistry::replace(std::string_view arch, ISA isa) -> std::shared_ptr<LoadedISA const> {
+    std::shared_ptr<LoadedISA const> replacement = prepare(std::move(isa));
+
+    // Wait for a load in progress, or make sure that the architecture is never loaded.
+    Slot &slot = get_slot(arch);
+    std::call_once(slot.once, [] { });
+
+    // The previous version lives on as long as someone uses it.
+    std::lock_guard const lock(mutex_);
+    publish(arch, replacement);
+    return replacement;
+}
+
+auto ISARegistry::find(std::string_view arch) const -> std::shared_ptr<LoadedISA const> {
+    std::optional<std::shared_ptr<LoadedISA const>> isa = find_entry(arch);
+    return isa ? std::move(*isa) : nullptr;
+}
+
+auto ISARegistry::find_by_architecture_name(std::string_view name) const
+    -> std::shared_ptr<LoadedISA const>  //
+{
+    std::shared_ptr<Snapshot const> const snapshot = snapshot_.load(std::memory_order_acquire);
+    auto const iter = std::ranges::find_if(*snapshot, [&](Entry const &entry) {
+        return entry.isa && entry.isa->isa.architecture.name == name;
+    });
+    return iter != snapshot->end() ? iter->isa : nullptr;
+}
+
+auto ISARegistry::get_slot(std::string_view arch) -> Slot & {
+    std::lock_guard const lock(mutex_);
+    auto iter = slots_.find(arch);
+    if (iter == slots_.end()) {
+        iter = slots_.emplace(std::string(arch), std::make_unique<Slot>()).first;
+    }
+    return *iter->second;
+}
+
+void ISARegistry::publish(std::string_view arch, std::shared_ptr<LoadedISA const> isa) {
+    auto snapshot = std::make_shared<Snapshot>(*snapshot_.load(std::memory_order_relaxed));
+    auto const position = std::ranges::lower_bound(*snapshot, arch, {}, [](Entry const &entry) {
+        return std::string_view(entry.arch);
+    });
+    if (position != snapshot->end() && position->arch == arch) {
+        position->isa = std::move(isa);
+    } else {
+        snapshot->insert(position, Entry { .arch = std::string(arch), .isa = std::move(isa) });
+    }
+
+    // The previous snapshot is freed once the readers that loaded it are done.
+    snapshot_.store(std::move(snapshot), std::memory_order_release);
+}
+
+auto ISARegistry::prepare(ISA isa) -> std::shared_ptr<LoadedISA const> {
+    pool_.intern(isa);
+    FrozenISA frozen = FrozenISA::freeze(isa);
+    return std::make_shared<LoadedISA const>(
+        LoadedISA { .isa = std::move(isa), .frozen = std::move(frozen) }
+    );
+}
+
+auto ISARegistry::find_entry(std::string_view arch) const
+    -> std::optional<std::shared_ptr<LoadedISA const>>  //
+{
+    std::shared_ptr<Snapshot const> const snapshot = snapshot_.load(std::memory_order_acquire);
+    auto const iter = std::ranges::lower_bound(*snapshot, arch, {}, [](Entry const &entry) {
+        return std::string_view(entry.arch);
+    });
+    if (iter == snapshot->end() || iter->arch != arch) {
+        return std::nullopt;
+    }
+    return iter->isa;
+}
+}  // namespace sassas
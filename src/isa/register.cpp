@@ -11,10 +11,11 @@
 #include <ranges>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace sassas {
 auto RegisterGroup::find(std::string_view name) const -> std::optional<unsigned> {
-    for (auto const &[reg_name, reg_value] : registers_ | std::views::reverse) {
+    for (auto const &[reg_name, reg_value] : *registers_ | std::views::reverse) {
         // Case-insensitive comparison of the register name with the given name.
         //
         // We found that there are case-insensitive references to register names in TABLES, such
@@ -38,7 +39,7 @@ auto RegisterGroup::find(std::string_view name) const -> std::optional<unsigned>
 auto RegisterGroup::find(unsigned value) const
     -> std::optional<std::reference_wrapper<std::string const>>  //
 {
-    for (auto const &[reg_name, reg_value] : registers_ | std::views::reverse) {
+    for (auto const &[reg_name, reg_value] : *registers_ | std::views::reverse) {
         if (reg_value == value) {
             return std::cref(reg_name);
         }
@@ -47,15 +48,24 @@ auto RegisterGroup::find(unsigned value) const
     return std::nullopt;
 }
 
+auto RegisterGroup::hash() const -> std::size_t {
+    std::size_t result = 0;
+    for (auto const &[reg_name, reg_value] : *registers_) {
+        result = (result * 31 + std::hash<std::string>()(reg_name)) * 31 + reg_value;
+    }
+    return result;
+}
+
 void RegisterGroup::dump(unsigned indent) const {
+    std::vector<Register> const &registers = *registers_;
     // Collect the maximum length of the register names.
     std::size_t column_widths[5] {};
-    for (std::size_t i = 0; i != registers_.size(); ++i) {
-        column_widths[i % 5] = std::ranges::max(column_widths[i % 5], registers_[i].name.size());
+    for (std::size_t i = 0; i != registers.size(); ++i) {
+        column_widths[i % 5] = std::ranges::max(column_widths[i % 5], registers[i].name.size());
     }
 
     // Dump the register names and values.
-    for (std::size_t i = 0; i != registers_.size(); ++i) {
+    for (std::size_t i = 0; i != registers.size(); ++i) {
         if (i % 5 == 0) {
             if (i != 0) {
                 fmt::println("");
@@ -66,9 +76,9 @@ void RegisterGroup::dump(unsigned indent) const {
 
         fmt::print(
             "{:<{}} {:<5} ",
-            registers_[i].name,
+            registers[i].name,
             column_widths[i % 5],
-            fmt::format("({})", registers_[i].value)
+            fmt::format("({})", registers[i].value)
         );
     }
 }
@@ -0,0 +1,177 @@
+#include "sassas/isa/shared_isa.hpp"
+
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/isa_image.hpp"
+#include "sassas/utils/content_hash.hpp"
+
+#include "fmt/format.h"
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+    #include <atomic>
+    #include <cstddef>
+    #include <cstdint>
+    #include <cstring>
+    #include <ctime>
+    #include <span>
+    #include <vector>
+
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_SHARED_MEMORY 1
+#endif
+
+namespace sassas {
+#ifdef SASSAS_HAS_SHARED_MEMORY
+namespace {
+/// The header of a shared ISA object, which is followed by the image.
+struct SharedHeader {
+    std::uint32_t magic;
+    /// Becomes `READY` once the image is complete. It is only accessed atomically.
+    std::uint32_t state;
+    std::uint64_t image_size;
+};
+
+constexpr std::uint32_t SHARED_MAGIC = 0x4d485353;  // "SSHM"
+constexpr std::uint32_t READY = 1;
+
+/// An object that is still not ready after this many seconds was abandoned by a process that
+/// crashed while publishing it, so it is removed to let the next process publish it again.
+constexpr std::time_t ABANDONED_AFTER_SECONDS = 60;
+
+/// Returns the name of the shared object of the description `description` of `arch`.
+auto object_name(std::string_view arch, std::string_view description) -> std::string {
+    ContentHash hash;
+    hash.add(ISAImage::VERSION);
+    hash.add(description);
+
+    // The name must be a single path component.
+    std::string safe_arch(arch);
+    for (char &c : safe_arch) {
+        if (!(c >= '0' && c <= '9') && !(c >= 'a' && c <= 'z') && !(c >= 'A' && c <= 'Z')) {
+            c = '_';
+        }
+    }
+    return fmt::format("/sassas-{}-{}", safe_arch, hash.hex());
+}
+
+/// Reads the ISA from the shared object `name`, if it exists and is ready. A ready object whose
+/// image cannot be read, or an object that was abandoned before it became ready, is removed.
+auto read_published(char const *name) -> std::optional<ISA> {
+    int const fd = ::shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    // Another user could otherwise plant an ISA of their choosing.
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || status.st_uid != ::geteuid()
+        || static_cast<std::size_t>(status.st_size) < sizeof(SharedHeader))
+    {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    auto const size = static_cast<std::size_t>(status.st_size);
+    void *const data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return std::nullopt;
+    }
+
+    auto *const header = static_cast<SharedHeader *>(data);
+    // The mapping is read-only, but an atomic load does not write.
+    std::uint32_t const state =
+        std::atomic_ref<std::uint32_t>(header->state).load(std::memory_order_acquire);
+
+    std::optional<ISA> isa;
+    bool remove = false;
+    if (state != READY) {
+        remove = std::time(nullptr) - status.st_mtime > ABANDONED_AFTER_SECONDS;
+    } else if (header->magic == SHARED_MAGIC
+               && header->image_size <= size - sizeof(SharedHeader))
+    {
+        std::span const image(
+            static_cast<std::byte const *>(data) + sizeof(SharedHeader),
+            header->image_size
+        );
+        std::string_view error;
+        isa = ISAImage::read(image, error);
+        remove = !isa;
+    } else {
+        remove = true;
+    }
+
+    ::munmap(data, size);
+    if (remove) {
+        ::shm_unlink(name);
+    }
+    return isa;
+}
+
+/// Publishes `image` as the shared object `name`, unless another process is already publishing
+/// it. If the object cannot be completed, it is removed again.
+void publish(char const *name, std::span<std::byte const> image) {
+    int const fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return;
+    }
+
+    std::size_t const size = sizeof(SharedHeader) + image.size();
+    bool published = false;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        void *const data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED) {
+            // The object is zero-filled, so `state` is not `READY` until it is set below.
+            auto *const header = static_cast<SharedHeader *>(data);
+            header->magic = SHARED_MAGIC;
+            header->image_size = image.size();
+            std::memcpy(
+                static_cast<std::byte *>(data) + sizeof(SharedHeader),
+                image.data(),
+                image.size()
+            );
+            std::atomic_ref<std::uint32_t>(header->state).store(READY, std::memory_order_release);
+            ::munmap(data, size);
+            published = true;
+        }
+    }
+
+    ::close(fd);
+    if (!published) {
+        ::shm_unlink(name);
+    }
+}
+}  // namespace
+#endif
+
+auto load_shared_isa(
+    std::string_view arch,
+    std::string_view description,
+    std::function<std::optional<ISA>()> const &parse
+) -> std::optional<ISA> {
+#ifdef SASSAS_HAS_SHARED_MEMORY
+    std::string const name = object_name(arch, description);
+    if (std::optional<ISA> isa = read_published(name.c_str())) {
+        return isa;
+    }
+
+    std::optional<ISA> isa = parse();
+    if (isa) {
+        std::vector<std::byte> const image = ISAImage::write(*isa);
+        publish(name.c_str(), image);
+    }
+    return isa;
+#else
+    static_cast<void>(arch);
+    static_cast<void>(description);
+    return parse();
+#endif
+}
+}  // namespace sassas
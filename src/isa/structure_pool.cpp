@@ -0,0 +1,58 @@
+#include "sassas/isa/structure_pool.hpp"
+
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/register.hpp"
+#include "sassas/isa/table.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// Makes `object` share the storage of an equal object in `pool`, or adds it to the pool if there
+/// is none. `share(object, other)` makes `object` share the storage of `other`.
+template <class T, class Share>
+void intern_object(std::unordered_map<std::size_t, std::vector<T>> &pool, T &object, Share share) {
+    std::vector<T> &candidates = pool[object.hash()];
+    if (auto const iter = std::ranges::find(candidates, object); iter != candidates.end()) {
+        share(object, *iter);
+    } else {
+        candidates.push_back(object);
+    }
+}
+
+/// Removes the objects of `pool` whose storage is only used by the pool. Nothing else can share it
+/// afterwards, since the storage is only handed out by `intern_object()`.
+template <class T>
+void prune(std::unordered_map<std::size_t, std::vector<T>> &pool) {
+    for (auto iter = pool.begin(); iter != pool.end();) {
+        std::erase_if(iter->second, [](T const &object) { return !object.is_shared(); });
+        iter = iter->second.empty() ? pool.erase(iter) : std::next(iter);
+    }
+}
+}  // namespace
+
+void StructurePool::intern(ISA &isa) {
+    std::lock_guard const lock(mutex_);
+    prune(tables_);
+    prune(register_groups_);
+    for (auto &[name, table] : isa.tables) {
+        intern_object(tables_, table, [](Table &table, Table const &other) {
+            table.share_items_with(other);
+        });
+    }
+    for (auto &[name, group] : isa.registers) {
+        intern_object(
+            register_groups_,
+            group,
+            [](RegisterGroup &group, RegisterGroup const &other) {
+                group.share_registers_with(other);
+            }
+        );
+    }
+}
+}  // namespace sassas
@@ -1,10 +1,13 @@
 #include "sassas/isa/table.hpp"
 
+#include "sassas/utils/metrics.hpp"
+
 #include "fmt/format.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <functional>
 #include <iterator>
 #include <optional>
 #include <ranges>
@@ -13,8 +16,9 @@
 #include <vector>
 
 namespace sassas {
-auto Table::get_value(std::span<unsigned const> keys) const -> std::optional<unsigned> {
+auto TableView::get_value(std::span<unsigned const> keys) const -> std::optional<unsigned> {
     assert(keys.size() == key_size_ && "Key size mismatch");
+    Metrics::add(Counter::TableLookups);
 
     for (auto iter = content_.begin(); iter != content_.end();
          std::ranges::advance(iter, key_size_ + 1))
@@ -22,7 +26,7 @@ auto Table::get_value(std::span<unsigned const> keys) const -> std::optional<uns
         bool const match = std::ranges::equal(
             std::views::counted(iter, key_size_),
             keys,
-            [](unsigned lhs, unsigned rhs) { return lhs == rhs || lhs == MATCH_ANY; }
+            [](unsigned lhs, unsigned rhs) { return lhs == rhs || lhs == Table::MATCH_ANY; }
         );
 
         if (match) {
@@ -35,10 +39,31 @@ auto Table::get_value(std::span<unsigned const> keys) const -> std::optional<uns
     return std::nullopt;
 }
 
+auto TableView::find_keys(unsigned value) const -> std::optional<std::span<unsigned const>> {
+    for (auto iter = content_.begin(); iter != content_.end();
+         std::ranges::advance(iter, key_size_ + 1))
+    {
+        if (*std::ranges::next(iter, key_size_) == value) {
+            return std::span(iter, key_size_);
+        }
+    }
+
+    // No match found.
+    return std::nullopt;
+}
+
+auto Table::hash() const -> std::size_t {
+    std::size_t result = std::hash<unsigned>()(key_size_);
+    for (unsigned const item : *content_) {
+        result = result * 31 + std::hash<unsigned>()(item);
+    }
+    return result;
+}
+
 void Table::dump(unsigned indent) const {
     // The content of the table.
-    std::vector<std::string> content_str(content_.size());
-    std::ranges::transform(content_, content_str.begin(), [](unsigned value) {
+    std::vector<std::string> content_str(content_->size());
+    std::ranges::transform(*content_, content_str.begin(), [](unsigned value) {
         return value == MATCH_ANY ? "Any" : fmt::format("{}", value);
     });
 
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cstddef>
+#include <iterator>
 #include <string_view>
 #include <unordered_map>
 
@@ -54,15 +56,39 @@ auto lex_string_literal(
 }
 }  // namespace
 
+void Lexer::skip_whitespace() {
+    while (true) {
+        // clang-format off
+        current_ = std::ranges::find_if_not(
+            current_,
+            source_.end(),
+            static_cast<int (*)(int)>(std::isspace)
+        );
+        // clang-format on
+
+        if (!skip_comments_ || std::ranges::distance(current_, source_.end()) < 2
+            || *current_ != '/')
+        {
+            return;
+        }
+
+        std::string_view const rest(current_, source_.end());
+        if (rest.starts_with("//")) {
+            current_ = std::ranges::find(current_, source_.end(), '\n');
+        } else if (rest.starts_with("/*")) {
+            auto const comment_end = rest.find("*/", 2);
+            current_ = comment_end == std::string_view::npos
+                ? source_.end()
+                : std::ranges::next(current_, static_cast<std::ptrdiff_t>(comment_end + 2));
+        } else {
+            return;
+        }
+    }
+}
+
 auto Lexer::next_token() -> Token const & {
     // Consume whitespace.
-    // clang-format off
-    current_ = std::ranges::find_if_not(
-        current_,
-        source_.end(),
-        static_cast<int (*)(int)>(std::isspace)
-    );
-    // clang-format on
+    skip_whitespace();
 
     if (current_ == source_.end()) {
         return cur_token_ = form_token(Token::End, current_);
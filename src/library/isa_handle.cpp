@@ -0,0 +1,310 @@
+#include "sassas/library/isa_handle.hpp"
+
+#include "sassas/assembler/assembler.hpp"
+#include "sassas/assembler/output_sink.hpp"
+#include "sassas/decoder/disassembler.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/elf/elf.hpp"
+#include "sassas/elf/elf_reader.hpp"
+#include "sassas/encoder/instruction_patcher.hpp"
+#include "sassas/isa/frozen_isa.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/isa_image.hpp"
+#include "sassas/parser/isa_parser.hpp"
+
+#include "fmt/format.h"
+
+#include "annotate_snippets/renderer/human_renderer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+/// The ISA of a handle, its frozen form, and the assembler, disassembler and patcher that refer to
+/// them. It is never moved, so the references stay valid. They are created on first use, since a
+/// handle is often used only in one direction and the decode tables are not free to build.
+struct ISAHandle::State {
+    explicit State(ISA isa) : isa(std::move(isa)) { }
+
+    State(State const &) = delete;
+    auto operator=(State const &) -> State & = delete;
+
+    ISA const isa;
+    /// The frozen form of the ISA, which the assembler, disassembler and patcher share.
+    mutable std::once_flag frozen_isa_once;
+    mutable std::optional<FrozenISA> frozen_isa;
+    mutable std::once_flag assembler_once;
+    mutable std::optional<Assembler> assembler;
+    mutable std::once_flag disassembler_once;
+    mutable std::optional<Disassembler> disassembler;
+    mutable std::once_flag patcher_once;
+    mutable std::optional<InstructionPatcher> patcher;
+
+    auto get_frozen_isa() const -> FrozenISA const & {
+        std::call_once(frozen_isa_once, [this] { frozen_isa.emplace(FrozenISA::freeze(isa)); });
+        return *frozen_isa;
+    }
+
+    auto get_assembler() const -> Assembler const & {
+        std::call_once(assembler_once, [this] { assembler.emplace(isa, get_frozen_isa()); });
+        return *assembler;
+    }
+
+    auto get_disassembler() const -> Disassembler const & {
+        std::call_once(disassembler_once, [this] { disassembler.emplace(isa, get_frozen_isa()); });
+        return *disassembler;
+    }
+
+    auto get_patcher() const -> InstructionPatcher const & {
+        std::call_once(patcher_once, [this] { patcher.emplace(isa, get_frozen_isa()); });
+        return *patcher;
+    }
+};
+
+namespace {
+/// Appends `diag` to `diagnostics` as the command line renders it.
+void render_diag(std::string &diagnostics, Diag diag) {
+    std::ostringstream text;
+    ants::HumanRenderer().render_diag(text, std::move(diag), style_sheet);
+    diagnostics += std::move(text).str();
+}
+
+/// Copies `bytes` to the start of `output` if it fits, and records the outcome in `result`.
+template <class T>
+void copy_output(std::span<char const> bytes, std::span<T> output, OutputResult &result) {
+    result.size = bytes.size();
+    if (result.success && bytes.size() <= output.size()) {
+        std::memcpy(output.data(), bytes.data(), bytes.size());
+        result.written = true;
+    }
+}
+}  // namespace
+
+auto ISAHandle::load_file(char const *path, std::string &diagnostics) -> std::optional<ISAHandle> {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        render_diag(
+            diagnostics,
+            Diag(DiagLevel::Error, fmt::format("Failed to open {}: {}", path, std::strerror(errno)))
+        );
+        return std::nullopt;
+    }
+
+    // clang-format off
+    std::string const source(
+        (std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>()
+    );
+    // clang-format on
+    return load_description(source, path, diagnostics);
+}
+
+auto ISAHandle::load_description(
+    std::string_view description,
+    std::string_view origin,
+    std::string &diagnostics
+) -> std::optional<ISAHandle> {
+    ISAParser parser(origin, description);
+    std::optional<ISA> isa = parser.parse();
+    if (!isa) {
+        for (Diag &diag : parser.take_diagnostics()) {
+            render_diag(diagnostics, std::move(diag));
+        }
+        return std::nullopt;
+    }
+    return adopt(std::move(*isa));
+}
+
+auto ISAHandle::load_image(std::span<std::byte const> image, std::string &diagnostics)
+    -> std::optional<ISAHandle>  //
+{
+    std::string_view error;
+    std::optional<ISA> isa = ISAImage::read(image, error);
+    if (!isa) {
+        render_diag(
+            diagnostics,
+            Diag(DiagLevel::Error, fmt::format("Failed to read the ISA image: {}", error))
+        );
+        return std::nullopt;
+    }
+    return adopt(std::move(*isa));
+}
+
+auto ISAHandle::adopt(ISA isa) -> ISAHandle {
+    return ISAHandle(std::make_shared<State const>(std::move(isa)));
+}
+
+auto ISAHandle::isa() const -> ISA const & {
+    return state_->isa;
+}
+
+auto ISAHandle::instruction_size() const -> unsigned {
+    return state_->isa.functional_unit.encoding_width() / 8;
+}
+
+auto ISAHandle::image() const -> std::vector<std::byte> {
+    return ISAImage::write(state_->isa);
+}
+
+auto ISAHandle::assemble(
+    std::string_view source,
+    std::string_view origin,
+    std::span<std::byte> output,
+    ValidationLevel level,
+    unsigned thread_count
+) const -> OutputResult {
+    OutputResult result;
+    std::string words;
+    OutputSink sink(
+        OutputSink::Format::Raw,
+        [&words](std::string_view bytes) { words += bytes; },
+        instruction_size(),
+        [&result](Diag diag) { render_diag(result.diagnostics, std::move(diag)); }
+    );
+
+    result.success = state_->get_assembler().assemble_parallel(
+        source,
+        origin,
+        level,
+        sink,
+        std::max(thread_count, 1u)
+    );
+    copy_output(std::span<char const>(words), output, result);
+    return result;
+}
+
+auto ISAHandle::disassemble(
+    std::span<std::byte const> code,
+    std::uint64_t offset,
+    std::span<char> output
+) const -> OutputResult {
+    OutputResult result;
+    result.success = true;
+
+    std::string text;
+    state_->get_disassembler().disassemble(code, offset, text);
+    copy_output(std::span<char const>(text), output, result);
+    return result;
+}
+
+auto ISAHandle::disassemble_cubin(
+    std::span<std::byte const> image,
+    std::span<char> output,
+    unsigned thread_count
+) const -> OutputResult {
+    OutputResult result;
+
+    std::string_view error;
+    std::optional<ElfReader> const elf = ElfReader::read(image, error);
+    if (!elf || elf->machine() != elf::EM_CUDA) {
+        render_diag(
+            result.diagnostics,
+            Diag(
+                DiagLevel::Error,
+                fmt::format("The image is not a cubin: {}", elf ? "The machine is not CUDA" : error)
+            )
+        );
+        return result;
+    }
+
+    std::string text;
+    auto const write = [&text](std::string_view piece) {
+        text += piece;
+    };
+    state_->get_disassembler().disassemble(*elf, std::max(thread_count, 1u), write);
+    result.success = true;
+    copy_output(std::span<char const>(text), output, result);
+    return result;
+}
+
+auto ISAHandle::patch_cubin(
+    std::span<std::byte> image,
+    std::string_view section,
+    std::uint64_t offset,
+    std::string_view operand,
+    std::int64_t value,
+    ValidationLevel level
+) const -> OutputResult {
+    OutputResult result;
+    InstructionPatcher const &patcher = state_->get_patcher();
+    result.size = patcher.instruction_size();
+    auto const fail = [&result](std::string message) {
+        render_diag(result.diagnostics, Diag(DiagLevel::Error, std::move(message)));
+        return result;
+    };
+
+    std::string_view error;
+    std::optional<std::span<std::byte>> const code = find_cubin_code(image, section, error);
+    if (!code) {
+        return fail(fmt::format("Cannot patch section `{}`: {}", section, error));
+    }
+    if (offset % result.size != 0 || offset >= code->size()
+        || code->size() - offset < result.size)
+    {
+        return fail(fmt::format("No instruction starts at offset {:#x} of `{}`", offset, section));
+    }
+    std::span<std::byte> const instruction = code->subspan(offset, result.size);
+
+    std::optional<OperandPatch> const patch = patcher.prepare(instruction, operand, error);
+    if (!patch) {
+        return fail(fmt::format("Cannot patch `{}` at offset {:#x}: {}", operand, offset, error));
+    }
+    std::vector<EncodeIssue> issues;
+    result.written = patcher.apply(*patch, value, level, instruction, issues);
+    result.success = result.written;
+    for (EncodeIssue const &issue : issues) {
+        switch (issue.kind) {
+        case EncodeIssue::ConditionViolated:
+            render_diag(
+                result.diagnostics,
+                Diag(
+                    issue.level,
+                    fmt::format(
+                        "{} (a condition of type `{}` on `{}`)",
+                        issue.message,
+                        issue.subject,
+                        operand
+                    )
+                )
+            );
+            break;
+
+        case EncodeIssue::ValueOutOfRange:
+            render_diag(
+                result.diagnostics,
+                Diag(issue.level, fmt::format("Value out of range for field `{}`", issue.subject))
+            );
+            break;
+
+        case EncodeIssue::EvaluationFailed:
+            render_diag(
+                result.diagnostics,
+                Diag(
+                    issue.level,
+                    fmt::format("Cannot compute the value of field `{}`", issue.subject)
+                )
+            );
+            break;
+        }
+    }
+    return result;
+}
+
+auto ISAHandle::patcher() const -> InstructionPatcher const & {
+    return state_->get_patcher();
+}
+}  // namespace sassas
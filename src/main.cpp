@@ -1,34 +1,117 @@
+#include "sassas/assembler/assembler.hpp"
+#include "sassas/assembler/incremental_state.hpp"
+#include "sassas/assembler/output_sink.hpp"
+#include "sassas/decoder/binary_disassembler.hpp"
 #include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/elf/cubin_writer.hpp"
+#include "sassas/elf/fatbin_writer.hpp"
+#include "sassas/encoder/encoder.hpp"
+#include "sassas/isa/functional_unit.hpp"
 #include "sassas/isa/isa.hpp"
+#include "sassas/isa/isa_image.hpp"
+#include "sassas/isa/isa_registry.hpp"
+#include "sassas/isa/shared_isa.hpp"
 #include "sassas/parser/isa_parser.hpp"
+#include "sassas/server/description_watcher.hpp"
+#include "sassas/server/protocol.hpp"
+#include "sassas/server/server.hpp"
+#include "sassas/server/service.hpp"
+#include "sassas/utils/gathered_write.hpp"
+#include "sassas/utils/mapped_file.hpp"
+#include "sassas/utils/metrics.hpp"
+#include "sassas/utils/output_cache.hpp"
+#include "sassas/utils/parallel.hpp"
+
+#ifdef SASSAS_EMBEDDED_ISAS
+    #include "sassas/isa/embedded_isa.hpp"
+#endif
 
 #include "fmt/format.h"
+#include "fmt/ranges.h"
 
 #include "annotate_snippets/renderer/human_renderer.hpp"
 
+#include <algorithm>
 #include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
-auto main() -> int {
-    char const *file_name = "instruction_description/sm_90_instructions.txt";
+namespace {
+/// The directory of the instruction description files.
+constexpr std::string_view DESCRIPTION_DIRECTORY = "instruction_description";
+
+/// How often `--metrics-file` is rewritten.
+constexpr std::chrono::seconds METRICS_FILE_INTERVAL(10);
+
+/// Serializes `render_diag()`, which is called from the worker threads of parallel assembly and
+/// disassembly, of the server and of the description watcher.
+std::mutex diag_mutex;
+/// The number of diagnostics printed so far. It is guarded by `diag_mutex`.
+unsigned diag_count = 0;
+
+void render_diag(sassas::Diag diag) {
+    std::scoped_lock const lock(diag_mutex);
+    ++diag_count;
+    ants::HumanRenderer().render_diag(std::cout, std::move(diag), sassas::style_sheet);
+}
+
+/// Returns the path of the instruction description file of architecture `arch`.
+auto description_path(std::string_view arch) -> std::string {
+    return fmt::format(
+        "{}/{}{}",
+        DESCRIPTION_DIRECTORY,
+        arch,
+        sassas::DescriptionWatcher::FILE_SUFFIX
+    );
+}
+
+/// Loads the instruction description of architecture `arch`, such as `sm_90`. If `shared` is set,
+/// the parsed description is shared with other `sassas` processes (see `load_shared_isa()`).
+///
+/// In builds with embedded descriptions, the embedded image of `arch` is read instead, without
+/// touching the filesystem; only the architectures that are not embedded are loaded from files.
+auto load_isa(std::string_view arch, bool shared) -> std::optional<sassas::ISA> {
+#ifdef SASSAS_EMBEDDED_ISAS
+    if (auto const image = sassas::find_embedded_isa(arch)) {
+        std::string_view error;
+        std::optional<sassas::ISA> isa = sassas::ISAImage::read(*image, error);
+        if (!isa) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("The embedded description of {} is corrupted: {}", arch, error)
+            ));
+        }
+        return isa;
+    }
+#endif
+
+    std::string const file_name = description_path(arch);
 
     std::ifstream input(file_name);
     if (!input) {
-        ants::HumanRenderer().render_diag(
-            std::cout,
-            sassas::Diag(
-                sassas::DiagLevel::Error,
-                fmt::format("Failed to open {}: {}", file_name, std::strerror(errno))
-            ),
-            sassas::style_sheet
-        );
-        return 1;
+        render_diag(sassas::Diag(
+            sassas::DiagLevel::Error,
+            fmt::format("Failed to open {}: {}", file_name, std::strerror(errno))
+        ));
+        return std::nullopt;
     }
 
     // clang-format off
@@ -37,14 +120,818 @@ auto main() -> int {
         std::istreambuf_iterator<char>()
     );
     // clang-format on
-    sassas::ISAParser parser(file_name, source);
+    auto const parse = [&]() {
+        sassas::ISAParser parser(file_name, source);
+
+        std::optional<sassas::ISA> isa = parser.parse();
+        if (!isa) {
+            std::vector<sassas::Diag> diags = parser.take_diagnostics();
+            for (auto &diag : diags) {
+                render_diag(std::move(diag));
+            }
+        }
+        return isa;
+    };
+
+    return shared ? sassas::load_shared_isa(arch, source, parse) : parse();
+}
+
+/// Disassembles the cubins in `inputs` and writes the text to `output`. An input is either a cubin,
+/// or a fatbin (on its own or as the `.nv_fatbin` section of a host executable), of which all
+/// uncompressed cubins are disassembled. Returns whether all inputs were disassembled.
+auto disassemble(
+    sassas::ISARegistry &registry,
+    std::span<std::string_view const> inputs,
+    std::FILE *output,
+    unsigned jobs
+) -> bool {
+    sassas::BinaryDisassembler disassembler(registry);
+    auto const write = [output](std::string_view text) {
+        std::fwrite(text.data(), 1, text.size(), output);
+    };
+
+    bool success = true;
+    for (std::string_view const name : inputs) {
+        std::optional<sassas::MappedFile> const file =
+            sassas::MappedFile::open(std::string(name).c_str());
+        if (!file) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to open {}: {}", name, std::strerror(errno))
+            ));
+            success = false;
+            continue;
+        }
+        success &= disassembler.disassemble(name, file->bytes(), jobs, write, render_diag);
+    }
+    return success;
+}
+
+/// An input file, together with the validation level that was in effect when it was named on the
+/// command line.
+struct InputFile {
+    std::string_view name;
+    sassas::ValidationLevel level;
+};
+
+/// Returns the version of the architecture `arch`, e.g. `90` for `sm_90` and `sm_90a`, or reports
+/// that no cubin can be written for it.
+auto require_sm_version(std::string_view arch) -> std::optional<unsigned> {
+    std::optional<unsigned> const sm_version = sassas::CubinWriter::parse_sm_version(arch);
+    if (!sm_version) {
+        render_diag(sassas::Diag(
+            sassas::DiagLevel::Error,
+            fmt::format("Cannot write a cubin for architecture `{}`", arch)
+        ));
+    }
+    return sm_version;
+}
+
+/// Assembles `inputs` for each architecture in `archs`. Each input is read and parsed once, and
+/// then encoded for all architectures on `jobs` threads. If `output_name` ends with `.fatbin`, the
+/// cubins are bundled into one fatbin; otherwise it must end with `.cubin`, and the cubin of each
+/// architecture is written next to it, e.g. `out.sm_90.cubin` for `out.cubin`. Returns whether all
+/// inputs were assembled and written.
+auto assemble_for_architectures(
+    sassas::ISARegistry &registry,
+    std::span<std::string_view const> archs,
+    std::span<InputFile const> inputs,
+    char const *output_name,
+    unsigned jobs
+) -> bool {
+    std::string_view const output = output_name ? output_name : "";
+    bool const is_fatbin = output.ends_with(".fatbin");
+    if (!is_fatbin && !output.ends_with(".cubin")) {
+        render_diag(sassas::Diag(
+            sassas::DiagLevel::Error,
+            "Assembling for several architectures requires a `.cubin` or `.fatbin` output file"
+        ));
+        return false;
+    }
+
+    std::vector<unsigned> sm_versions;
+    for (std::string_view const arch : archs) {
+        std::optional<unsigned> const sm_version = require_sm_version(arch);
+        if (!sm_version) {
+            return false;
+        }
+        sm_versions.push_back(*sm_version);
+    }
+
+    // The instruction descriptions are independent, so they are loaded concurrently.
+    std::vector<std::shared_ptr<sassas::LoadedISA const>> isas(archs.size());
+    sassas::parallel_for(jobs, archs.size(), [&](std::size_t i) {
+        isas[i] = registry.get(archs[i]);
+    });
+    if (std::ranges::find(isas, nullptr) != isas.end()) {
+        return false;
+    }
+
+    // The sinks point to the cubin writers, so neither vector may grow after it is filled.
+    std::vector<sassas::CubinWriter> cubins;
+    std::vector<sassas::Assembler> assemblers;
+    std::vector<sassas::OutputSink> sinks;
+    cubins.reserve(archs.size());
+    assemblers.reserve(archs.size());
+    sinks.reserve(archs.size());
+    std::vector<sassas::Assembler::Target> targets;
+    for (std::size_t i = 0; i != archs.size(); ++i) {
+        unsigned const word_bytes = isas[i]->isa.functional_unit.encoding_width() / 8;
+        cubins.emplace_back(sm_versions[i], word_bytes);
+        assemblers.emplace_back(isas[i]->isa, isas[i]->frozen);
+        sinks.emplace_back(cubins.back(), render_diag);
+        targets.push_back({ .assembler = &assemblers.back(), .sink = &sinks.back() });
+    }
+
+    bool success = true;
+    for (auto const &[name, file_level] : inputs) {
+        std::ifstream input(std::string(name), std::ios::binary);
+        if (!input) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to open {}: {}", name, std::strerror(errno))
+            ));
+            success = false;
+            continue;
+        }
+
+        // clang-format off
+        std::string const source(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+        // clang-format on
+        success &= sassas::Assembler::assemble_targets(source, name, file_level, targets, jobs);
+    }
+    if (!success) {
+        return false;
+    }
+
+    auto const report_write_error = [](std::string_view path) {
+        render_diag(sassas::Diag(
+            sassas::DiagLevel::Error,
+            fmt::format("Failed to write {}: {}", path, std::strerror(errno))
+        ));
+    };
 
-    if (std::optional<sassas::ISA> const isa = parser.parse()) {
-        isa->dump();
+    if (is_fatbin) {
+        // The fatbin writer references the images, so they are all laid out before it writes.
+        std::vector<std::vector<std::byte>> images(cubins.size());
+        sassas::FatbinWriter fatbin;
+        for (std::size_t i = 0; i != cubins.size(); ++i) {
+            cubins[i].write(images[i]);
+            fatbin.add_cubin(sm_versions[i], images[i]);
+        }
+        if (!fatbin.write(output_name)) {
+            report_write_error(output);
+            return false;
+        }
+        return true;
+    }
+
+    std::string_view const stem = output.substr(0, output.rfind(".cubin"));
+    for (std::size_t i = 0; i != cubins.size(); ++i) {
+        std::string const path = fmt::format("{}.{}.cubin", stem, archs[i]);
+        if (!cubins[i].write(path.c_str())) {
+            report_write_error(path);
+            success = false;
+        }
+    }
+    return success;
+}
+
+/// Reads the whole file `name` into `contents`, or reports that it cannot be read.
+auto read_file(std::string_view name, std::string &contents) -> bool {
+    std::ifstream input(std::string(name), std::ios::binary);
+    if (!input) {
+        render_diag(sassas::Diag(
+            sassas::DiagLevel::Error,
+            fmt::format("Failed to open {}: {}", name, std::strerror(errno))
+        ));
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/// Adds the instruction description of `arch` to `key`, as it is, without parsing it. Returns
+/// `false` if it cannot be read.
+auto add_description(std::string_view arch, sassas::ContentHash &key) -> bool {
+    key.add(arch);
+#ifdef SASSAS_EMBEDDED_ISAS
+    if (auto const image = sassas::find_embedded_isa(arch)) {
+        key.add(std::string_view(reinterpret_cast<char const *>(image->data()), image->size()));
+    } else
+#endif
+    {
+        std::ifstream input(description_path(arch), std::ios::binary);
+        if (!input) {
+            return false;
+        }
+        // clang-format off
+        std::string const description(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+        // clang-format on
+        key.add(description);
+    }
+    return true;
+}
+
+/// Returns the key of the output of assembling `sources` (the contents of `inputs`) for `arch`
+/// into a cubin or raw instruction words, or `std::nullopt` if the instruction description of
+/// `arch` cannot be read. The description is hashed without parsing it, so a cache hit never loads
+/// the ISA.
+auto output_cache_key(
+    std::string_view arch,
+    bool is_cubin,
+    std::span<InputFile const> inputs,
+    std::span<std::string const> sources
+) -> std::optional<sassas::ContentHash> {
+    sassas::ContentHash key;
+    key.add(sassas::OutputCache::VERSION);
+    key.add(is_cubin ? 1 : 0);
+    if (!add_description(arch, key)) {
+        return std::nullopt;
+    }
+
+    // The names of the inputs only appear in diagnostics, and outputs with diagnostics are never
+    // cached, so only the contents and the validation levels matter.
+    for (std::size_t i = 0; i != inputs.size(); ++i) {
+        key.add(static_cast<std::uint64_t>(inputs[i].level));
+        key.add(sources[i]);
+    }
+    return key;
+}
+
+/// Prints the console output of `response`, and writes its output file, if any, to
+/// `output_name`. Returns the exit status.
+auto finish(sassas::ServiceResponse const &response, char const *output_name) -> int {
+    std::fwrite(response.console.data(), 1, response.console.size(), stdout);
+
+    bool success = response.success;
+    if (response.file && output_name) {
+        std::ofstream output(output_name, std::ios::binary);
+        output.write(response.file->data(), static_cast<std::streamsize>(response.file->size()));
+        if (!output.flush()) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to write {}: {}", output_name, std::strerror(errno))
+            ));
+            success = false;
+        }
+    }
+    return success ? 0 : 1;
+}
+
+/// Sends `request`, with the contents of `inputs` added to it, to the daemon at `socket_path`, and
+/// writes the response as the one-shot command line would. Returns the exit status, or
+/// `std::nullopt` if the daemon cannot be reached, in which case nothing has been written and the
+/// caller does the work itself.
+auto call_daemon(
+    char const *socket_path,
+    sassas::ServiceRequest request,
+    std::span<InputFile const> inputs,
+    char const *output_name
+) -> std::optional<int> {
+    std::optional<sassas::ServiceClient> client = sassas::ServiceClient::connect(socket_path);
+    if (!client) {
+        return std::nullopt;
+    }
+
+    bool read_all = true;
+    for (auto const &[name, file_level] : inputs) {
+        sassas::ServiceInput &input = request.inputs.emplace_back();
+        input.name = name;
+        input.level = file_level;
+        if (!read_file(name, input.contents)) {
+            request.inputs.pop_back();
+            read_all = false;
+        }
+    }
+
+    std::string_view error;
+    std::optional<sassas::ServiceResponse> const response = client->call(request, error);
+    if (!response) {
+        return std::nullopt;
+    }
+    int const status = finish(*response, output_name);
+    return read_all ? status : 1;
+}
+}  // namespace
+
+/// Usage: sassas [--arch=sm_XX[,sm_YY...]] [-o output] [--jobs=N] [--validation=LEVEL]
+///               [--shared-isa] [--connect=SOCKET] [--cache-dir=DIR] [--cache-size=MB]
+///               [--incremental] file.sass...
+///        sassas [-o output] [--jobs=N] [--shared-isa] [--connect=SOCKET]
+///               --disassemble file.cubin|file.fatbin...
+///        sassas [--arch=sm_XX] [--connect=SOCKET] --query[=OPCODE]
+///        sassas [--cache-dir=DIR] --cache-stats
+///        sassas [--jobs=N] [--shared-isa] [--metrics-socket=SOCKET] [--metrics-file=FILE]
+///               [--watch] --serve=SOCKET
+///
+/// Without input files, the instruction description is dumped. With `--disassemble`, the code
+/// sections of the cubins are disassembled into SASS text, which is written to the output file or
+/// the standard output; the cubins are mapped into memory, and each one is disassembled on N
+/// threads. The architecture of each cubin is read from the cubin, and only the instruction
+/// descriptions of the architectures that are present are loaded. If the output file name ends with
+/// `.cubin`, the sections are written as a cubin (an ELF file); otherwise `-o` writes the raw
+/// instruction words, and without `-o` they are printed as text.
+///
+/// With several architectures, or if the output file name ends with `.fatbin`, each file is parsed
+/// once and encoded for all architectures concurrently. The output is then either a fatbin with the
+/// cubins of all architectures, or one cubin per architecture named after the `.cubin` output, as
+/// in `out.sm_80.cubin` and `out.sm_90.cubin` for `-o out.cubin`.
+///
+/// If `sassas` is built with `SASSAS_EMBED_DESCRIPTIONS`, the parsed instruction descriptions are
+/// compiled into the executable, so they are neither read nor parsed at startup; the files in
+/// `instruction_description/` are only used for the architectures that are not embedded.
+///
+/// With `--shared-isa`, the first process to load an instruction description publishes the parsed
+/// form in shared memory, and later processes on the same host use it instead of parsing the
+/// description again. This helps when a build launches many short-lived `sassas` processes at once.
+///
+/// With `--serve`, `sassas` runs as a daemon that keeps the instruction descriptions, assemblers
+/// and disassemblers loaded, and answers requests on the Unix domain socket `SOCKET` on N worker
+/// threads (one per core by default). With `--connect`, the work is sent to that daemon instead,
+/// with the same output and exit status as without it, which saves loading the instruction
+/// description on every invocation. If no daemon is reachable, or when assembling for several
+/// architectures, the work is done locally as usual.
+///
+/// With `--watch`, the daemon watches the instruction description files of the architectures it
+/// has loaded, and reloads one when it changes: only the sections of the file whose text changed
+/// are parsed again, and the new ISA is published atomically. Requests in flight finish with the
+/// ISA they started with, and later ones use the new one; if the new version has errors, they are
+/// printed and the old one stays in use. The descriptions are then always read from the files,
+/// even if they are embedded or `--shared-isa` is given.
+///
+/// The daemon keeps counters of its requests, ISA cache and table lookups, and histograms of the
+/// time spent in each stage, in the Prometheus text format. `--metrics-socket` serves them on
+/// another Unix domain socket, which answers every connection with the current values, and
+/// `--metrics-file` rewrites them into a file every few seconds, for a node exporter to pick up.
+///
+/// With `--cache-dir` (or the environment variable `SASSAS_CACHE_DIR`), the output file of
+/// assembling for one architecture is cached in `DIR`, keyed by a hash of the inputs, their
+/// validation levels, the architecture, its instruction description and the output format. When
+/// the same inputs are assembled again, the output is copied (or cloned, where the filesystem
+/// supports it) from the cache, without loading the description or assembling anything. Only
+/// outputs that were assembled without any diagnostic are cached. The cache is limited to
+/// `--cache-size` megabytes (1024 by default), beyond which the least recently used outputs are
+/// removed; `--cache-stats` prints its hits, misses and size.
+///
+/// With `--incremental`, the encoded functions are saved next to the output file, in
+/// `OUTPUT.sassas-state`, and the next run with the same output only parses and encodes the
+/// functions whose text changed; the others are taken from the saved state. The output file itself
+/// is always laid out again.
+///
+/// `--query` describes the ISA of the architecture, and `--query=OPCODE` lists the instruction
+/// classes of an opcode with its encoding.
+///
+/// `--validation` applies to the input files after it, so different files can be assembled with
+/// different levels in one invocation.
+/// With `--jobs=N` (N > 1, or 0 for one thread per core), each file is read into memory and its
+/// functions are assembled on N threads; otherwise the files are streamed.
+auto main(int argc, char **argv) -> int {
+    std::vector<std::string_view> archs;
+    char const *output_name = nullptr;
+    sassas::ValidationLevel level = sassas::ValidationLevel::Full;
+    unsigned jobs = 1;
+    bool jobs_given = false;
+    bool disassembling = false;
+    bool shared_isa = false;
+    char const *serve_path = nullptr;
+    char const *metrics_socket = nullptr;
+    char const *metrics_file = nullptr;
+    char const *connect_path = nullptr;
+    char const *cache_dir = std::getenv("SASSAS_CACHE_DIR");
+    std::uint64_t cache_size_mb = sassas::OutputCache::DEFAULT_MAX_SIZE >> 20;
+    bool cache_stats = false;
+    bool incremental = false;
+    bool watch = false;
+    std::optional<std::string_view> query;
+    std::vector<InputFile> inputs;
+
+    for (int i = 1; i != argc; ++i) {
+        std::string_view const arg = argv[i];
+        if (arg.starts_with("--arch=")) {
+            std::string_view list = arg.substr(std::string_view("--arch=").size());
+            archs.clear();
+            while (!list.empty()) {
+                std::size_t const comma = std::min(list.find(','), list.size());
+                if (comma != 0) {
+                    archs.push_back(list.substr(0, comma));
+                }
+                list.remove_prefix(std::min(comma + 1, list.size()));
+            }
+        } else if (arg.starts_with("--validation=")) {
+            std::string_view const value = arg.substr(std::string_view("--validation=").size());
+            if (auto const parsed = sassas::validation_level_from_string(value)) {
+                level = *parsed;
+            } else {
+                render_diag(sassas::Diag(
+                    sassas::DiagLevel::Error,
+                    fmt::format(
+                        "Unknown validation level `{}`, expected one of: {}",
+                        value,
+                        fmt::join(sassas::get_validation_levels(), ", ")
+                    )
+                ));
+                return 1;
+            }
+        } else if (arg.starts_with("--jobs=")) {
+            std::string_view const value = arg.substr(std::string_view("--jobs=").size());
+            char const *const value_end = value.data() + value.size();
+            auto const [end, error] = std::from_chars(value.data(), value_end, jobs);
+            if (error != std::errc() || end != value_end) {
+                render_diag(sassas::Diag(
+                    sassas::DiagLevel::Error,
+                    fmt::format("Invalid number of jobs `{}`", value)
+                ));
+                return 1;
+            }
+            if (jobs == 0) {
+                jobs = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            jobs_given = true;
+        } else if (arg == "--disassemble") {
+            disassembling = true;
+        } else if (arg == "--shared-isa") {
+            shared_isa = true;
+        } else if (arg.starts_with("--serve=")) {
+            serve_path = argv[i] + std::string_view("--serve=").size();
+        } else if (arg == "--watch") {
+            watch = true;
+        } else if (arg.starts_with("--metrics-socket=")) {
+            metrics_socket = argv[i] + std::string_view("--metrics-socket=").size();
+        } else if (arg.starts_with("--metrics-file=")) {
+            metrics_file = argv[i] + std::string_view("--metrics-file=").size();
+        } else if (arg.starts_with("--connect=")) {
+            connect_path = argv[i] + std::string_view("--connect=").size();
+        } else if (arg.starts_with("--cache-dir=")) {
+            cache_dir = argv[i] + std::string_view("--cache-dir=").size();
+        } else if (arg.starts_with("--cache-size=")) {
+            std::string_view const value = arg.substr(std::string_view("--cache-size=").size());
+            char const *const value_end = value.data() + value.size();
+            auto const [end, error] = std::from_chars(value.data(), value_end, cache_size_mb);
+            if (error != std::errc() || end != value_end) {
+                render_diag(sassas::Diag(
+                    sassas::DiagLevel::Error,
+                    fmt::format("Invalid cache size `{}`", value)
+                ));
+                return 1;
+            }
+        } else if (arg == "--cache-stats") {
+            cache_stats = true;
+        } else if (arg == "--incremental") {
+            incremental = true;
+        } else if (arg == "--query") {
+            query = "";
+        } else if (arg.starts_with("--query=")) {
+            query = arg.substr(std::string_view("--query=").size());
+        } else if (arg == "-o" && i + 1 != argc) {
+            output_name = argv[++i];
+        } else if (arg.starts_with('-')) {
+            render_diag(
+                sassas::Diag(sassas::DiagLevel::Error, fmt::format("Unknown option `{}`", arg))
+            );
+            return 1;
+        } else {
+            inputs.push_back({ arg, level });
+        }
+    }
+
+    // Only the daemon watches the descriptions.
+    std::optional<sassas::DescriptionWatcher> watcher;
+    if (watch && serve_path) {
+        watcher.emplace(std::string(DESCRIPTION_DIRECTORY), render_diag);
+    }
+    sassas::ISARegistry registry([shared_isa, &watcher](std::string_view arch) {
+        return watcher ? watcher->load(arch) : load_isa(arch, shared_isa);
+    });
+    if (archs.empty()) {
+        archs.push_back("sm_90");
+    }
+
+    std::optional<sassas::OutputCache> cache;
+    if (cache_dir && *cache_dir) {
+        cache = sassas::OutputCache::open(cache_dir, cache_size_mb << 20);
+        if (!cache) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Warning,
+                fmt::format("Failed to open the cache {}, which is not used", cache_dir)
+            ));
+        }
+    }
+    if (cache_stats) {
+        if (!cache) {
+            render_diag(sassas::Diag(sassas::DiagLevel::Error, "No cache directory is given"));
+            return 1;
+        }
+        sassas::OutputCache::Statistics const statistics = cache->statistics();
+        fmt::print(
+            "hits: {}\nmisses: {}\nentries: {}\nsize: {} bytes\n",
+            statistics.hits,
+            statistics.misses,
+            statistics.entries,
+            statistics.size
+        );
+        return 0;
+    }
+
+    if (serve_path) {
+        auto const report_failure = [](char const *path) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to serve on {}: {}", path, std::strerror(errno))
+            ));
+        };
+        std::optional<sassas::UnixListener> listener = sassas::UnixListener::open(serve_path);
+        if (!listener) {
+            report_failure(serve_path);
+            return 1;
+        }
+
+        sassas::Metrics::enable();
+        if (metrics_socket) {
+            std::optional<sassas::UnixListener> metrics = sassas::UnixListener::open(metrics_socket);
+            if (!metrics) {
+                report_failure(metrics_socket);
+                return 1;
+            }
+            std::thread([metrics = std::move(*metrics)]() mutable {
+                sassas::serve_metrics(metrics);
+            }).detach();
+        }
+        if (metrics_file) {
+            std::thread([metrics_file] {
+                while (true) {
+                    std::this_thread::sleep_for(METRICS_FILE_INTERVAL);
+                    sassas::Metrics::write_file(metrics_file);
+                }
+            }).detach();
+        }
+
+        if (watcher) {
+            std::thread([&watcher, &registry] {
+                if (!watcher->watch(registry)) {
+                    render_diag(sassas::Diag(
+                        sassas::DiagLevel::Warning,
+                        fmt::format(
+                            "Stopped watching {}: {}",
+                            DESCRIPTION_DIRECTORY,
+                            std::strerror(errno)
+                        )
+                    ));
+                }
+            }).detach();
+        }
+
+        sassas::Service service(registry);
+        unsigned const thread_count =
+            jobs_given ? jobs : std::max(std::thread::hardware_concurrency(), 1u);
+        // Only returns if the listening socket fails.
+        sassas::serve(service, *listener, thread_count);
+        report_failure(serve_path);
+        return 1;
+    }
+
+    if (query) {
+        sassas::ServiceRequest const request {
+            .command = sassas::ServiceCommand::Query,
+            .arch = std::string(archs.front()),
+            .output = sassas::ServiceOutput::Console,
+            .inputs = {},
+            .opcode = std::string(*query),
+        };
+        if (connect_path) {
+            if (auto const status = call_daemon(connect_path, request, {}, output_name)) {
+                return *status;
+            }
+        }
+        sassas::Service service(registry);
+        return finish(service.handle(request), output_name);
+    }
+
+    // The daemon assembles for one architecture at a time, so the other invocations are always
+    // handled locally.
+    bool const is_fatbin = output_name && std::string_view(output_name).ends_with(".fatbin");
+    bool const is_multi_arch = !disassembling && !inputs.empty() && (archs.size() > 1 || is_fatbin);
+
+    // The output of assembling for one architecture is looked up in the cache before anything else
+    // is done. The inputs are read into memory to hash them, and are then assembled from there.
+    // Incremental assembly needs the inputs in memory as well.
+    std::optional<sassas::ContentHash> cache_key;
+    std::vector<std::string> sources;
+    bool const is_local_output = output_name && !disassembling && !inputs.empty() && !is_multi_arch;
+    if (is_local_output && (cache || incremental)) {
+        for (InputFile const &input : inputs) {
+            if (!read_file(input.name, sources.emplace_back())) {
+                return 1;
+            }
+        }
+    }
+    if (is_local_output && cache) {
+        bool const is_cubin = std::string_view(output_name).ends_with(".cubin");
+        cache_key = output_cache_key(archs.front(), is_cubin, inputs, sources);
+        if (cache_key && cache->fetch(*cache_key, output_name)) {
+            return 0;
+        }
+    }
+
+    if (connect_path && !inputs.empty() && !is_multi_arch) {
+        sassas::ServiceOutput output = sassas::ServiceOutput::Console;
+        if (output_name) {
+            output = !disassembling && std::string_view(output_name).ends_with(".cubin")
+                       ? sassas::ServiceOutput::Cubin
+                       : sassas::ServiceOutput::File;
+        }
+        sassas::ServiceRequest const request {
+            .command = disassembling ? sassas::ServiceCommand::Disassemble
+                                     : sassas::ServiceCommand::Assemble,
+            .arch = std::string(archs.front()),
+            .output = output,
+            .inputs = {},
+            .opcode = {},
+        };
+        if (auto const status = call_daemon(connect_path, request, inputs, output_name)) {
+            return *status;
+        }
+    }
+
+    if (disassembling) {
+        std::FILE *output = stdout;
+        if (output_name && !(output = std::fopen(output_name, "w"))) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to open {}: {}", output_name, std::strerror(errno))
+            ));
+            return 1;
+        }
+
+        std::vector<std::string_view> names;
+        for (InputFile const &input : inputs) {
+            names.push_back(input.name);
+        }
+        bool success = disassemble(registry, names, output, jobs);
+        if (output != stdout && std::fclose(output) != 0) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to write {}: {}", output_name, std::strerror(errno))
+            ));
+            success = false;
+        }
+        return success ? 0 : 1;
+    }
+
+    if (is_multi_arch) {
+        return assemble_for_architectures(registry, archs, inputs, output_name, jobs) ? 0 : 1;
+    }
+
+    std::string_view const arch = archs.front();
+    std::shared_ptr<sassas::LoadedISA const> const loaded_isa = registry.get(arch);
+    if (!loaded_isa) {
+        return 1;
+    }
+    sassas::ISA const &isa = loaded_isa->isa;
+
+    if (inputs.empty()) {
+        isa.dump();
+        return 0;
+    }
+
+    std::optional<sassas::CubinWriter> cubin;
+    std::ofstream output;
+    if (output_name && std::string_view(output_name).ends_with(".cubin")) {
+        std::optional<unsigned> const sm_version = require_sm_version(arch);
+        if (!sm_version) {
+            return 1;
+        }
+        cubin.emplace(*sm_version, isa.functional_unit.encoding_width() / 8);
+    } else if (output_name) {
+        output.open(output_name, std::ios::binary);
+        if (!output) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to open {}: {}", output_name, std::strerror(errno))
+            ));
+            return 1;
+        }
+    }
+
+    unsigned const word_bytes = isa.functional_unit.encoding_width() / 8;
+    sassas::Assembler const assembler(isa, loaded_isa->frozen);
+    std::optional<sassas::OutputSink> sink;
+    if (cubin) {
+        sink.emplace(*cubin, render_diag);
+    } else if (output.is_open()) {
+        sink.emplace(
+            sassas::OutputSink::Format::Raw,
+            [&output](std::string_view bytes) {
+                output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            },
+            word_bytes,
+            render_diag
+        );
     } else {
-        std::vector<sassas::Diag> diags = parser.take_diagnostics();
-        for (auto &diag : diags) {
-            ants::HumanRenderer().render_diag(std::cout, std::move(diag), sassas::style_sheet);
+        sink.emplace(
+            sassas::OutputSink::Format::Listing,
+            [](std::string_view text) { std::fwrite(text.data(), 1, text.size(), stdout); },
+            word_bytes,
+            render_diag
+        );
+    }
+
+    // The state of the previous run is only used if it was made with the same description, by an
+    // assembler that encodes the same way.
+    std::optional<sassas::IncrementalState> previous_state;
+    std::optional<sassas::IncrementalState> next_state;
+    std::string const state_path = fmt::format("{}.sassas-state", output_name ? output_name : "");
+    if (incremental && is_local_output) {
+        sassas::ContentHash context;
+        context.add(sassas::Assembler::VERSION);
+        if (add_description(arch, context)) {
+            std::optional<sassas::MappedFile> const file =
+                sassas::MappedFile::open(state_path.c_str());
+            previous_state = sassas::IncrementalState::read(
+                file ? file->bytes() : std::span<std::byte const>(),
+                context.hex()
+            );
+            next_state.emplace(context.hex());
+        }
+    }
+
+    bool success = true;
+    for (std::size_t i = 0; i != inputs.size(); ++i) {
+        auto const &[name, file_level] = inputs[i];
+        if (next_state) {
+            success &= assembler.assemble_incremental(
+                sources[i],
+                name,
+                file_level,
+                *sink,
+                jobs,
+                *previous_state,
+                *next_state
+            );
+            continue;
+        }
+        if (!sources.empty()) {
+            success &= assembler.assemble_parallel(sources[i], name, file_level, *sink, jobs);
+            continue;
+        }
+
+        std::ifstream input(std::string(name), std::ios::binary);
+        if (!input) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Error,
+                fmt::format("Failed to open {}: {}", name, std::strerror(errno))
+            ));
+            success = false;
+            continue;
+        }
+
+        if (jobs > 1) {
+            // clang-format off
+            std::string const source(
+                (std::istreambuf_iterator<char>(input)),
+                std::istreambuf_iterator<char>()
+            );
+            // clang-format on
+            success &= assembler.assemble_parallel(source, name, file_level, *sink, jobs);
+        } else {
+            success &= assembler.assemble(input, name, file_level, *sink);
         }
     }
+
+    if (cubin && success && !cubin->write(output_name)) {
+        render_diag(sassas::Diag(
+            sassas::DiagLevel::Error,
+            fmt::format("Failed to write {}: {}", output_name, std::strerror(errno))
+        ));
+        success = false;
+    }
+
+    if (next_state) {
+        std::vector<std::byte> const image = next_state->write();
+        std::span<std::byte const> const buffers[] = { image };
+        if (!sassas::write_file(state_path.c_str(), buffers)) {
+            render_diag(sassas::Diag(
+                sassas::DiagLevel::Warning,
+                fmt::format("Failed to write {}: {}", state_path, std::strerror(errno))
+            ));
+        }
+    }
+
+    // Outputs with diagnostics are not cached, since a cache hit would not print them again.
+    if (cache_key && success && diag_count == 0) {
+        if (output.is_open()) {
+            output.close();
+        }
+        if (output) {
+            cache->store(*cache_key, output_name);
+        }
+    }
+
+    return success ? 0 : 1;
 }
@@ -0,0 +1,167 @@
+#include "sassas/parser/incremental_isa_parser.hpp"
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/lexer/lexer.hpp"
+#include "sassas/lexer/token.hpp"
+#include "sassas/parser/isa_parser.hpp"
+#include "sassas/utils/content_hash.hpp"
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// A top-level section of an instruction description.
+struct Section {
+    std::string_view text;
+    bool is_class;
+};
+
+/// Returns whether `token` starts a top-level section, as the sections are dispatched in
+/// `ISAParser::parse()`. The keywords inside a class (`FORMAT`, `CONDITIONS`, ...) do not.
+auto starts_section(Token const &token) -> bool {
+    switch (token.kind()) {
+    case Token::KeywordArchitecture:
+    case Token::KeywordCondition:
+    case Token::KeywordParameters:
+    case Token::KeywordConstants:
+    case Token::KeywordStringMap:
+    case Token::KeywordRegisters:
+    case Token::KeywordTables:
+    case Token::KeywordOperation:
+    case Token::KeywordFUnit:
+    case Token::KeywordNopEncoding:
+    case Token::KeywordClass:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Splits `source` into its top-level sections by lexing it, which is much cheaper than parsing.
+/// A section runs from its keyword (or the `ALTERNATE` before `CLASS`) to the next one.
+auto split_sections(std::string_view source) -> std::vector<Section> {
+    std::vector<Section> sections;
+    Lexer lexer(source);
+    unsigned begin = 0;
+    bool is_class = false;
+    bool after_alternate = false;
+    unsigned alternate_begin = 0;
+    for (lexer.next_token(); lexer.current_token().is_not(Token::End); lexer.next_token()) {
+        Token const &token = lexer.current_token();
+        if (starts_section(token)) {
+            unsigned const section_begin =
+                token.is(Token::KeywordClass) && after_alternate ? alternate_begin
+                                                                  : token.location_begin();
+            if (section_begin != begin) {
+                sections.push_back({ source.substr(begin, section_begin - begin), is_class });
+                begin = section_begin;
+            }
+            is_class = token.is(Token::KeywordClass);
+        }
+        after_alternate = token.is(Token::Identifier) && token.content() == "ALTERNATE";
+        alternate_begin = token.location_begin();
+    }
+    if (begin != source.size()) {
+        sections.push_back({ source.substr(begin), is_class });
+    }
+    return sections;
+}
+}  // namespace
+
+auto IncrementalISAParser::parse(std::string_view source, Reporter const &report)
+    -> std::optional<ISA>  //
+{
+    if (std::optional<ISA> isa = parse_sections(source)) {
+        return isa;
+    }
+
+    // Parse the whole file again, so that the diagnostics (if any) are reported as usual.
+    headers_.clear();
+    classes_.clear();
+    ISAParser parser(origin_, source);
+    std::optional<ISA> isa = parser.parse();
+    if (!isa) {
+        for (Diag &diag : parser.take_diagnostics()) {
+            report(std::move(diag));
+        }
+    }
+    statistics_.parsed = statistics_.sections;
+    return isa;
+}
+
+auto IncrementalISAParser::parse_sections(std::string_view source) -> std::optional<ISA> {
+    std::vector<Section> const sections = split_sections(source);
+    statistics_ = { .sections = sections.size(), .parsed = 0 };
+
+    // The sections of this version, taken from the previous version or parsed.
+    std::map<std::string, ISA, std::less<>> headers;
+    std::map<std::string, InstructionClass, std::less<>> classes;
+
+    // The sections before the current one that are not classes. While `reused` is set, `isa` is
+    // stale and the sections are those of `*reused`; it is only copied when a section is parsed.
+    ISA isa;
+    ISA const *reused = nullptr;
+    auto const current = [&]() -> ISA & {
+        if (reused) {
+            isa = *reused;
+            reused = nullptr;
+        }
+        return isa;
+    };
+    // The hash of the sections before the current one that are not classes.
+    ContentHash context;
+    std::vector<InstructionClass> result_classes;
+
+    for (Section const &section : sections) {
+        if (section.is_class) {
+            ContentHash key = context;
+            key.add(section.text);
+            std::string hex = key.hex();
+            auto iter = classes.find(hex);
+            if (iter == classes.end()) {
+                if (auto node = classes_.extract(hex)) {
+                    iter = classes.insert(std::move(node)).position;
+                } else {
+                    ISA &header = current();
+                    ISAParser parser(origin_, section.text);
+                    if (!parser.parse_single_section(header)) {
+                        return std::nullopt;
+                    }
+                    ++statistics_.parsed;
+                    iter = classes.emplace(std::move(hex), std::move(header.classes.back())).first;
+                    header.classes.pop_back();
+                }
+            }
+            result_classes.push_back(iter->second);
+            continue;
+        }
+
+        context.add(section.text);
+        std::string hex = context.hex();
+        if (auto node = headers_.extract(hex)) {
+            reused = &headers.insert(std::move(node)).position->second;
+            continue;
+        }
+        ISA &header = current();
+        ISAParser parser(origin_, section.text);
+        if (!parser.parse_single_section(header)) {
+            return std::nullopt;
+        }
+        ++statistics_.parsed;
+        headers.emplace(std::move(hex), header);
+    }
+
+    headers_ = std::move(headers);
+    classes_ = std::move(classes);
+    ISA &result = current();
+    result.classes = std::move(result_classes);
+    return std::move(result);
+}
+}  // namespace sassas
@@ -34,96 +34,132 @@ auto ISAParser::parse() -> std::optional<ISA> {
     bool has_errors = false;
     ISA result;
     while (lexer_.current_token().is_not(Token::End)) {
-        // Check that the current token is a keyword.
-        if (!lexer_.current_token().is_keyword()) {
-            diagnostics_.push_back(create_diag_at_token(
-                lexer_.current_token(),
-                DiagLevel::Error,
-                "Unexpected token",
-                add_string(
-                    fmt::format(
-                        "expected a keyword, but got `{}`",
-                        lexer_.current_token().kind_description()
-                    )
-                )
-            ));
+        switch (parse_section(result)) {
+        case SectionStatus::Parsed:
+            continue;
+
+        case SectionStatus::Failed:
+            // The parsing of the current section failed. We need to recover until the next
+            // keyword.
+            has_errors = true;
+            lexer_.lex_until(&Token::is_keyword, /*consume=*/false);
+            continue;
+
+        case SectionStatus::Aborted:
             return std::nullopt;
+
+        case SectionStatus::Finished:
+            // If there were any errors during parsing, return std::nullopt.
+            return has_errors ? std::nullopt : std::optional(std::move(result));
         }
+    }
+
+    if (has_errors) {
+        // If there were any errors during parsing, return std::nullopt.
+        return std::nullopt;
+    } else {
+        return result;
+    }
+}
+
+auto ISAParser::parse_single_section(ISA &isa) -> bool {
+    lexer_.next_token();
+    return parse_section(isa) == SectionStatus::Parsed && lexer_.current_token().is(Token::End);
+}
+
+auto ISAParser::parse_section(ISA &result) -> SectionStatus {
+    // `ALTERNATE CLASS` introduces an alternative form of an instruction class. `ALTERNATE` is not
+    // a keyword, since it only appears in this position.
+    bool const is_alternate = lexer_.current_token().is(Token::Identifier)
+        && lexer_.current_token().content() == "ALTERNATE";
+    if (is_alternate && expect_next_token(Token::KeywordClass)) {
+        return SectionStatus::Aborted;
+    }
+
+    // Check that the current token is a keyword.
+    if (!lexer_.current_token().is_keyword()) {
+        diagnostics_.push_back(create_diag_at_token(
+            lexer_.current_token(),
+            DiagLevel::Error,
+            "Unexpected token",
+            add_string(
+                fmt::format(
+                    "expected a keyword, but got `{}`",
+                    lexer_.current_token().kind_description()
+                )
+            )
+        ));
+        return SectionStatus::Aborted;
+    }
 
-        // NOLINTBEGIN(bugprone-macro-parentheses)
+    // NOLINTBEGIN(bugprone-macro-parentheses)
 #define PARSE_SECTION(keyword, sec_name)                                                           \
     case Token::Keyword##keyword:                                                                  \
         if (auto sec_name = parse_##sec_name()) {                                                  \
             result.sec_name = std::move(*(sec_name));                                              \
-            continue;                                                                              \
+            return SectionStatus::Parsed;                                                          \
         }                                                                                          \
-        break;
-        // NOLINTEND(bugprone-macro-parentheses)
+        return SectionStatus::Failed;
+    // NOLINTEND(bugprone-macro-parentheses)
 
-        switch (lexer_.current_token().kind()) {
-            PARSE_SECTION(Architecture, architecture)
-            PARSE_SECTION(Parameters, parameters)
-            PARSE_SECTION(Constants, constants)
-            PARSE_SECTION(StringMap, string_map)
-            PARSE_SECTION(Registers, registers)
-            PARSE_SECTION(FUnit, functional_unit)
-
-        case Token::KeywordCondition:
-            if (!expect_next_token(Token::KeywordTypes)) {
-                if (auto condition_types = parse_condition_types()) {
-                    result.condition_types = std::move(*condition_types);
-                    continue;
-                }
+    switch (lexer_.current_token().kind()) {
+        PARSE_SECTION(Architecture, architecture)
+        PARSE_SECTION(Parameters, parameters)
+        PARSE_SECTION(Constants, constants)
+        PARSE_SECTION(StringMap, string_map)
+        PARSE_SECTION(Registers, registers)
+        PARSE_SECTION(FUnit, functional_unit)
+
+    case Token::KeywordCondition:
+        if (!expect_next_token(Token::KeywordTypes)) {
+            if (auto condition_types = parse_condition_types()) {
+                result.condition_types = std::move(*condition_types);
+                return SectionStatus::Parsed;
             }
-            break;
+        }
+        return SectionStatus::Failed;
 
-        case Token::KeywordTables:
-            if (auto tables = parse_tables(result.registers)) {
-                result.tables = std::move(*tables);
-                continue;
-            }
-            break;
+    case Token::KeywordTables:
+        if (auto tables = parse_tables(result.registers)) {
+            result.tables = std::move(*tables);
+            return SectionStatus::Parsed;
+        }
+        return SectionStatus::Failed;
 
-        case Token::KeywordOperation:
-            if (!expect_next_token(Token::KeywordProperties, Token::KeywordPredicates)) {
-                if (lexer_.current_token().is(Token::KeywordProperties)) {
-                    if (auto properties = parse_operation_properties()) {
-                        result.operation_properties = std::move(*properties);
-                        continue;
-                    }
-                } else {
-                    if (auto predicates = parse_operation_predicates()) {
-                        result.operation_predicates = std::move(*predicates);
-                        continue;
-                    }
+    case Token::KeywordClass:
+        if (auto instruction_class = parse_instruction_class(result, is_alternate)) {
+            result.classes.push_back(std::move(*instruction_class));
+            return SectionStatus::Parsed;
+        }
+        return SectionStatus::Failed;
+
+    case Token::KeywordNopEncoding:
+        // We do not interpret the `NOP_ENCODING` section yet. Skip it.
+        skip_section();
+        return SectionStatus::Parsed;
+
+    case Token::KeywordOperation:
+        if (!expect_next_token(Token::KeywordProperties, Token::KeywordPredicates)) {
+            if (lexer_.current_token().is(Token::KeywordProperties)) {
+                if (auto properties = parse_operation_properties()) {
+                    result.operation_properties = std::move(*properties);
+                    return SectionStatus::Parsed;
                 }
-            }
-            break;
-
-        default:
-            // We meet a keyword that we cannot parse. Just finish the parsing.
-            if (has_errors) {
-                // If there were any errors during parsing, return std::nullopt.
-                return std::nullopt;
             } else {
-                return result;
+                if (auto predicates = parse_operation_predicates()) {
+                    result.operation_predicates = std::move(*predicates);
+                    return SectionStatus::Parsed;
+                }
             }
         }
+        return SectionStatus::Failed;
 
-        // If we reach here, it means that the parsing of the current section failed. We need to
-        // recover until the next keyword.
-        has_errors = true;
-        lexer_.lex_until(&Token::is_keyword, /*consume=*/false);
-
-#undef PARSE_SECTION
+    default:
+        // We meet a keyword that we cannot parse. Just finish the parsing.
+        return SectionStatus::Finished;
     }
 
-    if (has_errors) {
-        // If there were any errors during parsing, return std::nullopt.
-        return std::nullopt;
-    } else {
-        return result;
-    }
+#undef PARSE_SECTION
 }
 
 auto ISAParser::recover_until(Token::TokenKind expected_kind, bool consume) -> std::nullopt_t {
@@ -1069,4 +1105,1057 @@ auto ISAParser::parse_functional_unit() -> std::optional<FunctionalUnit> {
         return result;
     }
 }
+
+auto ISAParser::parse_format_operand(ISA const &isa, bool is_modifier)
+    -> std::optional<FormatItem>  //
+{
+    assert(lexer_.current_token().is(Token::Identifier) && "Expected an operand category");
+
+    Token const type_token = lexer_.current_token();
+    FormatItem result;
+    result.kind = is_modifier ? FormatItem::Modifier : FormatItem::Register;
+    result.type = type_token.content();
+    result.name = type_token.content();
+    // Whether the parenthesized part contains integers, which means that this is an immediate.
+    bool has_integer_arguments = false;
+
+    if (lexer_.next_token().is(Token::PunctuatorLeftParen)) {
+        switch (lexer_.next_token().kind()) {
+        case Token::Integer: {
+            // Cases like `SImm(24)`, `UImm(3/0x7)` and `UImm(5/0*)`.
+            has_integer_arguments = true;
+
+            auto const bits = expect_integer_constant(lexer_.current_token(), 32, false);
+            if (!bits) {
+                return std::nullopt;
+            }
+            result.bits = static_cast<unsigned>(*bits);
+
+            if (lexer_.next_token().is(Token::PunctuatorSlash)) {
+                auto const default_value =
+                    expect_integer_constant(lexer_.next_token(), 64, false);
+                if (!default_value) {
+                    return std::nullopt;
+                }
+                result.default_value = static_cast<std::int64_t>(*default_value);
+
+                if (lexer_.next_token().is(Token::PunctuatorStar)) {
+                    // Consume the `*` without doing anything with it. Currently we don't know its
+                    // meaning.
+                    lexer_.next_token();
+                }
+            }
+            break;
+        }
+
+        case Token::Identifier:
+        case Token::String:
+            // Cases like `Predicate(PT)` and `USCHED_INFO("DRAIN")`.
+            if (auto const default_name = get_identifier_or_string(lexer_.current_token())) {
+                result.default_name = static_cast<std::string>(*default_name);
+            } else {
+                return std::nullopt;
+            }
+            lexer_.next_token();
+            break;
+
+        default:
+            break;
+        }
+
+        if (expect_current_token(Token::PunctuatorRightParen)) {
+            return std::nullopt;
+        }
+        lexer_.next_token();
+    }
+
+    if (lexer_.current_token().is(Token::PunctuatorStar)) {
+        // Consume the `*` without doing anything with it, as we do for register names.
+        lexer_.next_token();
+    }
+
+    if (lexer_.current_token().is(Token::PunctuatorColon)) {
+        if (expect_next_token(Token::Identifier)) {
+            return std::nullopt;
+        }
+
+        result.name = static_cast<std::string>(lexer_.current_token().content());
+        lexer_.next_token();
+    }
+
+    // Determine the kind of the item.
+    if (isa.registers.contains(result.type)) {
+        // It is a register or a modifier. The kind has already been set.
+    } else if (!is_modifier
+               && (has_integer_arguments || result.type.ends_with("Imm")
+                   || result.type == "BITSET"))
+    {
+        result.kind = FormatItem::Immediate;
+        if (!has_integer_arguments) {
+            result.bits = 32;
+        }
+    } else if (!is_modifier && lexer_.current_token().is(Token::PunctuatorLeftSquare)) {
+        // The prefix of a constant bank reference, such as `C:Sb[...]`.
+        result.kind = FormatItem::Literal;
+        result.name.clear();
+    } else {
+        diagnostics_.push_back(create_diag_at_token(
+            type_token,
+            DiagLevel::Error,
+            "Unknown operand type",
+            "expected a register category or an immediate type"
+        ));
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+auto ISAParser::parse_format(InstructionClass &instruction_class, ISA const &isa)
+    -> std::optional<std::vector<FormatItem>>  //
+{
+    assert(
+        lexer_.current_token().is(Token::KeywordFormat)
+        && "Expected `FORMAT` keyword at the beginning"
+    );
+
+    std::vector<FormatItem> result;
+    // The nesting depth of `{...}`.
+    unsigned optional_depth = 0;
+    // Whether we are inside `$(...)$`.
+    bool in_scheduling = false;
+    // The prefixes and the `PREDICATE @` marker seen before the next operand.
+    std::uint8_t pending_prefixes = FormatItem::NoPrefix;
+    bool pending_predicate = false;
+
+    // A helper function that creates a literal item.
+    auto const make_literal = [](std::string_view text) {
+        FormatItem item;
+        item.kind = FormatItem::Literal;
+        item.type = text;
+        return item;
+    };
+
+    // A helper function that adds `item` to the result and allocates the operand slots for it.
+    auto const add_item = [&](FormatItem item) {
+        item.is_optional = optional_depth != 0;
+        item.is_scheduling = in_scheduling;
+
+        if (item.kind == FormatItem::Opcode) {
+            item.slot = InstructionClass::OPCODE_SLOT;
+        } else if (item.kind != FormatItem::Literal) {
+            item.prefixes = pending_prefixes;
+            item.is_predicate = pending_predicate;
+            item.slot = instruction_class.get_or_add_slot(item.name);
+
+            static constexpr std::pair<FormatItem::Prefix, std::string_view> prefix_attributes[] = {
+                { FormatItem::Negate, "negate" },
+                { FormatItem::Absolute, "absolute" },
+                { FormatItem::Not, "not" },
+                { FormatItem::Invert, "invert" },
+            };
+            for (auto const &[prefix, attribute] : prefix_attributes) {
+                if (item.prefixes & prefix) {
+                    instruction_class.get_or_add_slot(fmt::format("{}@{}", item.name, attribute));
+                }
+            }
+
+            pending_prefixes = FormatItem::NoPrefix;
+            pending_predicate = false;
+        }
+
+        result.push_back(std::move(item));
+    };
+
+    lexer_.next_token();
+    while (lexer_.current_token().is_not(Token::PunctuatorSemi)) {
+        Token const token = lexer_.current_token();
+
+        switch (token.kind()) {
+        case Token::KeywordPredicate:
+            // `PREDICATE @[!]Predicate(PT):Pg`.
+            if (expect_next_token(Token::PunctuatorAt)) {
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+            pending_predicate = true;
+            lexer_.next_token();
+            break;
+
+        case Token::PunctuatorLeftBrace:
+            ++optional_depth;
+            lexer_.next_token();
+            break;
+
+        case Token::PunctuatorRightBrace:
+            if (optional_depth == 0) {
+                diagnostics_.push_back(
+                    create_diag_at_token(token, DiagLevel::Error, "Unmatched `}`")
+                );
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+            --optional_depth;
+            lexer_.next_token();
+            break;
+
+        case Token::PunctuatorDollar:
+            // The beginning of `$(...)$`.
+            if (expect_next_token(Token::PunctuatorLeftParen)) {
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+            in_scheduling = true;
+            lexer_.next_token();
+            break;
+
+        case Token::PunctuatorRightParen:
+            // The end of `$(...)$`.
+            if (!in_scheduling) {
+                diagnostics_.push_back(
+                    create_diag_at_token(token, DiagLevel::Error, "Unmatched `)`")
+                );
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+            if (expect_next_token(Token::PunctuatorDollar)) {
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+            in_scheduling = false;
+            lexer_.next_token();
+            break;
+
+        case Token::PunctuatorLeftSquare: {
+            // Either a prefix like `[-]` or `[||]`, or a `[` of an address.
+            Lexer const saved_lexer = lexer_;
+
+            std::uint8_t const prefix = [&] {
+                switch (lexer_.next_token().kind()) {
+                case Token::PunctuatorMinus:
+                    return FormatItem::Negate;
+                case Token::PunctuatorPipePipe:
+                    return FormatItem::Absolute;
+                case Token::PunctuatorExclaim:
+                    return FormatItem::Not;
+                case Token::PunctuatorTilde:
+                    return FormatItem::Invert;
+                default:
+                    return FormatItem::NoPrefix;
+                }
+            }();
+
+            if (prefix != FormatItem::NoPrefix
+                && lexer_.next_token().is(Token::PunctuatorRightSquare))
+            {
+                pending_prefixes |= prefix;
+                lexer_.next_token();
+            } else {
+                lexer_ = saved_lexer;
+                add_item(make_literal("["));
+                lexer_.next_token();
+            }
+            break;
+        }
+
+        case Token::PunctuatorRightSquare:
+        case Token::PunctuatorPlus:
+        case Token::PunctuatorComma:
+            add_item(make_literal(token.content()));
+            if (lexer_.next_token().is(Token::PunctuatorStar)
+                && token.is(Token::PunctuatorRightSquare))
+            {
+                // Cases like `C:Sb[UImm(5/0*):Sb_bank]*`. Consume the `*` without doing anything
+                // with it, as we do for operands.
+                lexer_.next_token();
+            }
+            break;
+
+        case Token::String:
+            if (auto const literal = get_string_literal(token)) {
+                add_item(make_literal(*literal));
+                lexer_.next_token();
+                break;
+            } else {
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+        case Token::PunctuatorSlash:
+        case Token::Identifier: {
+            if (token.is(Token::Identifier) && token.content() == "Opcode") {
+                FormatItem opcode = make_literal("Opcode");
+                opcode.kind = FormatItem::Opcode;
+                opcode.name = "Opcode";
+                add_item(std::move(opcode));
+                lexer_.next_token();
+                break;
+            }
+
+            bool const is_modifier = token.is(Token::PunctuatorSlash);
+            if (is_modifier && expect_next_token(Token::Identifier)) {
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+
+            if (auto item = parse_format_operand(isa, is_modifier)) {
+                add_item(std::move(*item));
+                break;
+            } else {
+                return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+            }
+        }
+
+        case Token::End:
+            return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+
+        default:
+            diagnostics_.push_back(create_diag_at_token(
+                token,
+                DiagLevel::Error,
+                "Unexpected token",
+                add_string(
+                    fmt::format(
+                        "{} is not allowed in the instruction format",
+                        token.kind_description()
+                    )
+                )
+            ));
+            return recover_until(Token::PunctuatorSemi, /*consume=*/true);
+        }
+    }
+
+    // Eat the `;`.
+    lexer_.next_token();
+
+    if (optional_depth != 0 || in_scheduling) {
+        diagnostics_.push_back(create_diag_at_token(
+            lexer_.current_token(),
+            DiagLevel::Error,
+            "Unterminated group in the instruction format"
+        ));
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+namespace {
+/// Returns the precedence and the operator of a binary operator token. Returns a precedence of 0
+/// if the token is not a binary operator.
+auto binary_operator(Token::TokenKind kind) -> std::pair<unsigned, Expr::Op> {
+    switch (kind) {
+    case Token::PunctuatorArrow:
+        return { 1, Expr::Op::Implies };
+    case Token::PunctuatorPipePipe:
+        return { 2, Expr::Op::LogicalOr };
+    case Token::PunctuatorAmpAmp:
+        return { 3, Expr::Op::LogicalAnd };
+    case Token::PunctuatorPipe:
+        return { 4, Expr::Op::BitOr };
+    case Token::PunctuatorAmp:
+        return { 5, Expr::Op::BitAnd };
+    case Token::PunctuatorEqualEqual:
+        return { 6, Expr::Op::Equal };
+    case Token::PunctuatorExclaimEqual:
+        return { 6, Expr::Op::NotEqual };
+    case Token::PunctuatorLess:
+        return { 7, Expr::Op::Less };
+    case Token::PunctuatorLessEqual:
+        return { 7, Expr::Op::LessEqual };
+    case Token::PunctuatorGreater:
+        return { 7, Expr::Op::Greater };
+    case Token::PunctuatorGreaterEqual:
+        return { 7, Expr::Op::GreaterEqual };
+    case Token::PunctuatorLessLess:
+        return { 8, Expr::Op::Shl };
+    case Token::PunctuatorGreaterGreater:
+        return { 8, Expr::Op::Shr };
+    case Token::PunctuatorPlus:
+        return { 9, Expr::Op::Add };
+    case Token::PunctuatorMinus:
+        return { 9, Expr::Op::Sub };
+    case Token::PunctuatorStar:
+        return { 10, Expr::Op::Mul };
+    case Token::PunctuatorSlash:
+        return { 10, Expr::Op::Div };
+    case Token::PunctuatorPercent:
+        return { 10, Expr::Op::Rem };
+    default:
+        return { 0, Expr::Op::Integer };
+    }
+}
+
+/// Looks up `name` in the `PARAMETERS` and `CONSTANTS` sections. `prefer_constants` decides which
+/// section is searched first.
+auto find_constant(ISA const &isa, std::string const &name, bool prefer_constants)
+    -> std::optional<int>  //
+{
+    ISA::ConstantMap const &first = prefer_constants ? isa.constants : isa.parameters;
+    ISA::ConstantMap const &second = prefer_constants ? isa.parameters : isa.constants;
+
+    if (auto const iter = first.find(name); iter != first.end()) {
+        return iter->second;
+    } else if (auto const iter = second.find(name); iter != second.end()) {
+        return iter->second;
+    } else {
+        return std::nullopt;
+    }
+}
+}  // namespace
+
+auto ISAParser::parse_unary_expression(
+    InstructionClass const &instruction_class,
+    ISA const &isa,
+    Expr &expr
+) -> bool {
+    Token const token = lexer_.current_token();
+
+    switch (token.kind()) {
+    case Token::PunctuatorMinus:
+    case Token::PunctuatorExclaim:
+    case Token::PunctuatorTilde: {
+        lexer_.next_token();
+        if (parse_unary_expression(instruction_class, isa, expr)) {
+            return true;
+        }
+
+        expr.push_operator(
+            token.is(Token::PunctuatorMinus)       ? Expr::Op::Negate
+                : token.is(Token::PunctuatorTilde) ? Expr::Op::BitwiseNot
+                                                   : Expr::Op::LogicalNot
+        );
+        return false;
+    }
+
+    case Token::PunctuatorPlus:
+        lexer_.next_token();
+        return parse_unary_expression(instruction_class, isa, expr);
+
+    case Token::Integer:
+        if (auto const value = get_integer_constant(token, 64, false)) {
+            expr.push_integer(static_cast<std::int64_t>(*value));
+            lexer_.next_token();
+            return false;
+        } else {
+            return true;
+        }
+
+    case Token::PunctuatorLeftParen:
+        lexer_.next_token();
+        if (parse_expression_impl(instruction_class, isa, expr, 0)
+            || expect_current_token(Token::PunctuatorRightParen))
+        {
+            return true;
+        }
+
+        lexer_.next_token();
+        return false;
+
+    case Token::PunctuatorPercent:
+    case Token::PunctuatorDollar: {
+        // `%NAME` and `$NAME`.
+        if (expect_next_token(Token::Identifier)) {
+            return true;
+        }
+
+        std::string name(lexer_.current_token().content());
+        if (auto const value = find_constant(isa, name, token.is(Token::PunctuatorDollar))) {
+            expr.push_integer(*value);
+        } else {
+            expr.push_unresolved(fmt::format("{}{}", token.content(), name), 0);
+        }
+
+        lexer_.next_token();
+        return false;
+    }
+
+    case Token::PunctuatorBackTick: {
+        // `` `Category@Name ``.
+        if (expect_next_token(Token::Identifier)) {
+            return true;
+        }
+
+        Token const category_token = lexer_.current_token();
+        if (expect_next_token(Token::PunctuatorAt)) {
+            return true;
+        }
+
+        auto const register_name = expect_identifier_or_string(lexer_.next_token());
+        if (!register_name) {
+            return true;
+        }
+
+        auto const iter = isa.registers.find(static_cast<std::string>(category_token.content()));
+        if (iter == isa.registers.end()) {
+            diagnostics_.push_back(create_diag_at_token(
+                category_token,
+                DiagLevel::Error,
+                "Unknown register category"
+            ));
+            return true;
+        }
+
+        if (auto const value = iter->second.find(*register_name)) {
+            expr.push_integer(*value);
+        } else {
+            diagnostics_.push_back(create_diag_at_token(
+                lexer_.current_token(),
+                DiagLevel::Error,
+                "Unknown register name"
+            ));
+            return true;
+        }
+
+        lexer_.next_token();
+        return false;
+    }
+
+    case Token::PunctuatorStar:
+        // Some operands are written as `*name`. Currently we don't know the meaning of `*`, so we
+        // ignore it.
+        if (expect_next_token(Token::Identifier)) {
+            return true;
+        }
+        [[fallthrough]];
+
+    case Token::Identifier: {
+        std::string name(lexer_.current_token().content());
+
+        switch (lexer_.next_token().kind()) {
+        case Token::PunctuatorLeftParen: {
+            // A function call.
+            unsigned argument_count = 0;
+            if (lexer_.next_token().is_not(Token::PunctuatorRightParen)) {
+                while (true) {
+                    if (parse_expression_impl(instruction_class, isa, expr, 0)) {
+                        return true;
+                    }
+                    ++argument_count;
+
+                    if (lexer_.current_token().is_not(Token::PunctuatorComma)) {
+                        break;
+                    }
+                    lexer_.next_token();
+                }
+            }
+
+            if (expect_current_token(Token::PunctuatorRightParen)) {
+                return true;
+            }
+            lexer_.next_token();
+
+            if (isa.tables.contains(name)) {
+                expr.push_table_call(std::move(name), argument_count);
+            } else {
+                expr.push_unresolved(std::move(name), argument_count);
+            }
+            return false;
+        }
+
+        case Token::PunctuatorAt: {
+            // `name@attribute` or `Category@Name`.
+            auto const attribute = expect_identifier_or_string(lexer_.next_token());
+            if (!attribute) {
+                return true;
+            }
+            lexer_.next_token();
+
+            std::string const slot_name = fmt::format("{}@{}", name, *attribute);
+            if (auto const slot = instruction_class.find_slot(slot_name)) {
+                expr.push_operand(*slot);
+            } else if (auto const iter = isa.registers.find(name); iter != isa.registers.end()) {
+                if (auto const value = iter->second.find(*attribute)) {
+                    expr.push_integer(*value);
+                } else {
+                    expr.push_unresolved(slot_name, 0);
+                }
+            } else {
+                expr.push_unresolved(slot_name, 0);
+            }
+            return false;
+        }
+
+        default:
+            if (auto const slot = instruction_class.find_slot(name)) {
+                expr.push_operand(*slot);
+            } else if (auto const value = find_constant(isa, name, /*prefer_constants=*/false)) {
+                expr.push_integer(*value);
+            } else {
+                expr.push_unresolved(std::move(name), 0);
+            }
+            return false;
+        }
+    }
+
+    default:
+        diagnostics_.push_back(create_diag_at_token(
+            token,
+            DiagLevel::Error,
+            "Expected an expression",
+            add_string(fmt::format("got {}", token.kind_description()))
+        ));
+        return true;
+    }
+}
+
+auto ISAParser::parse_expression_impl(
+    InstructionClass const &instruction_class,
+    ISA const &isa,
+    Expr &expr,
+    unsigned min_precedence
+) -> bool {
+    if (parse_unary_expression(instruction_class, isa, expr)) {
+        return true;
+    }
+
+    while (true) {
+        auto const [precedence, op] = binary_operator(lexer_.current_token().kind());
+        if (precedence == 0 || precedence < min_precedence) {
+            break;
+        }
+
+        lexer_.next_token();
+        // `->` is right-associative. All other operators are left-associative.
+        unsigned const rhs_precedence = op == Expr::Op::Implies ? precedence : precedence + 1;
+        if (parse_expression_impl(instruction_class, isa, expr, rhs_precedence)) {
+            return true;
+        }
+
+        expr.push_operator(op);
+    }
+
+    // The conditional operator has the lowest precedence, so we only handle it at the top level.
+    if (min_precedence == 0 && lexer_.current_token().is(Token::PunctuatorQuestion)) {
+        lexer_.next_token();
+        if (parse_expression_impl(instruction_class, isa, expr, 0)
+            || expect_current_token(Token::PunctuatorColon))
+        {
+            return true;
+        }
+
+        lexer_.next_token();
+        if (parse_expression_impl(instruction_class, isa, expr, 0)) {
+            return true;
+        }
+
+        expr.push_operator(Expr::Op::Conditional);
+    }
+
+    return false;
+}
+
+auto ISAParser::parse_expression(InstructionClass const &instruction_class, ISA const &isa)
+    -> std::optional<Expr>  //
+{
+    Expr result;
+    if (parse_expression_impl(instruction_class, isa, result, 0)) {
+        return std::nullopt;
+    } else {
+        return result;
+    }
+}
+
+auto ISAParser::parse_conditions(InstructionClass const &instruction_class, ISA const &isa)
+    -> std::optional<std::vector<Condition>>  //
+{
+    assert(
+        lexer_.current_token().is(Token::KeywordConditions)
+        && "Expected `CONDITIONS` keyword at the beginning"
+    );
+
+    bool has_errors = false;
+    std::vector<Condition> result;
+
+    while (lexer_.next_token().is(Token::Identifier)) {
+        // The name of the condition type.
+        Token const type_token = lexer_.current_token();
+        auto const type_iter = std::ranges::find(
+            isa.condition_types,
+            type_token.content(),
+            &ConditionType::name
+        );
+
+        if (type_iter == isa.condition_types.end()) {
+            diagnostics_.push_back(create_diag_at_token(
+                type_token,
+                DiagLevel::Error,
+                "Unknown condition type",
+                {},
+                "condition types are declared in the `CONDITION TYPES` section"
+            ));
+
+            // Skip the expression and the message.
+            has_errors = true;
+            recover_until(Token::String, /*consume=*/false);
+            continue;
+        }
+
+        lexer_.next_token();
+        std::optional<Expr> expr = parse_expression(instruction_class, isa);
+        if (!expr || expect_current_token(Token::PunctuatorColon)) {
+            has_errors = true;
+            recover_until(Token::String, /*consume=*/false);
+            continue;
+        }
+
+        if (auto const message = expect_string_literal(lexer_.next_token())) {
+            result.push_back(
+                Condition {
+                    .kind = type_iter->kind,
+                    .type_name = type_iter->name,
+                    .expr = std::move(*expr),
+                    .message = static_cast<std::string>(*message),
+                }
+            );
+        } else {
+            has_errors = true;
+        }
+    }
+
+    if (has_errors) {
+        return std::nullopt;
+    } else {
+        return result;
+    }
+}
+
+auto ISAParser::parse_opcodes()
+    -> std::optional<std::vector<std::pair<std::string, std::uint64_t>>>  //
+{
+    assert(
+        lexer_.current_token().is(Token::KeywordOpcodes)
+        && "Expected `OPCODES` keyword at the beginning"
+    );
+
+    bool has_errors = false;
+    std::vector<std::pair<std::string, std::uint64_t>> result;
+
+    while (lexer_.next_token().is(Token::Identifier)) {
+        std::string name(lexer_.current_token().content());
+
+        if (expect_next_token(Token::PunctuatorEqual)) {
+            has_errors = true;
+            recover_until(Token::PunctuatorSemi, /*consume=*/false);
+            continue;
+        }
+
+        auto const value = expect_integer_constant(lexer_.next_token(), 64, false);
+        if (!value || expect_next_token(Token::PunctuatorSemi)) {
+            has_errors = true;
+            recover_until(Token::PunctuatorSemi, /*consume=*/false);
+            continue;
+        }
+
+        result.emplace_back(std::move(name), *value);
+    }
+
+    if (has_errors) {
+        return std::nullopt;
+    } else {
+        return result;
+    }
+}
+
+auto ISAParser::parse_encoding(InstructionClass const &instruction_class, ISA const &isa)
+    -> std::optional<std::vector<EncodingAssignment>>  //
+{
+    assert(
+        lexer_.current_token().is(Token::KeywordEncoding)
+        && "Expected `ENCODING` keyword at the beginning"
+    );
+
+    bool has_errors = false;
+    std::vector<EncodingAssignment> result;
+
+    // A helper function that looks up the bitmask named by the current token. If it does not
+    // exist, it generates diagnostic information.
+    auto const find_field = [&]() -> std::optional<BitMask> {
+        Token const field_token = lexer_.current_token();
+        auto const field =
+            isa.functional_unit.find_bitmask(static_cast<std::string>(field_token.content()));
+
+        if (field) {
+            return field->get();
+        } else {
+            diagnostics_.push_back(create_diag_at_token(
+                field_token,
+                DiagLevel::Error,
+                "Unknown bitmask",
+                {},
+                "bitmasks are declared in the `FUNIT` section"
+            ));
+            return std::nullopt;
+        }
+    };
+
+    while (lexer_.next_token().is(Token::Identifier)
+           || lexer_.current_token().is(Token::PunctuatorExclaim))
+    {
+        if (lexer_.current_token().content() == "ALTERNATE") {
+            // The beginning of the next class.
+            break;
+        }
+
+        if (lexer_.current_token().is(Token::PunctuatorExclaim)) {
+            // `!field;`, which means the field must be zero.
+            if (expect_next_token(Token::Identifier)) {
+                has_errors = true;
+                recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                continue;
+            }
+
+            std::string field_name(lexer_.current_token().content());
+            std::optional<BitMask> field = find_field();
+            if (!field || expect_next_token(Token::PunctuatorSemi)) {
+                has_errors = true;
+                recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                continue;
+            }
+
+            Expr zero;
+            zero.push_integer(0);
+            result.push_back(
+                EncodingAssignment {
+                    .field_name = std::move(field_name),
+                    .field = std::move(*field),
+                    .value = std::move(zero),
+                }
+            );
+            continue;
+        }
+
+        // Parse the list of fields on the left-hand side.
+        std::vector<std::pair<std::string, BitMask>> fields;
+        bool field_error = false;
+        while (true) {
+            if (std::optional<BitMask> field = find_field()) {
+                fields.emplace_back(lexer_.current_token().content(), std::move(*field));
+            } else {
+                field_error = true;
+            }
+
+            if (lexer_.next_token().is_not(Token::PunctuatorComma)) {
+                break;
+            }
+
+            if (expect_next_token(Token::Identifier)) {
+                field_error = true;
+                break;
+            }
+        }
+
+        if (field_error || expect_current_token(Token::PunctuatorEqual)) {
+            has_errors = true;
+            recover_until(Token::PunctuatorSemi, /*consume=*/false);
+            continue;
+        }
+        lexer_.next_token();
+
+        if (fields.size() == 1) {
+            std::optional<Expr> value = parse_expression(instruction_class, isa);
+            if (!value) {
+                has_errors = true;
+                recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                continue;
+            }
+
+            if (lexer_.current_token().is(Token::Identifier)
+                && lexer_.current_token().content() == "SCALE")
+            {
+                // `field = expression SCALE factor;`.
+                auto const factor = expect_integer_constant(lexer_.next_token(), 32, false);
+                if (!factor) {
+                    has_errors = true;
+                    recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                    continue;
+                }
+
+                value->push_integer(static_cast<std::int64_t>(*factor));
+                value->push_operator(Expr::Op::Scale);
+                lexer_.next_token();
+            }
+
+            result.push_back(
+                EncodingAssignment {
+                    .field_name = std::move(fields.front().first),
+                    .field = std::move(fields.front().second),
+                    .value = std::move(*value),
+                }
+            );
+        } else {
+            // `field1, field2 = Function(argument1, argument2);`.
+            Token const function_token = lexer_.current_token();
+            if (expect_current_token(Token::Identifier)
+                || expect_next_token(Token::PunctuatorLeftParen))
+            {
+                has_errors = true;
+                recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                continue;
+            }
+
+            std::vector<Expr> arguments;
+            bool argument_error = false;
+            do {
+                lexer_.next_token();
+                if (std::optional<Expr> argument = parse_expression(instruction_class, isa)) {
+                    arguments.push_back(std::move(*argument));
+                } else {
+                    argument_error = true;
+                    break;
+                }
+            } while (lexer_.current_token().is(Token::PunctuatorComma));
+
+            if (argument_error || expect_current_token(Token::PunctuatorRightParen)) {
+                has_errors = true;
+                recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                continue;
+            }
+            lexer_.next_token();
+
+            if (arguments.size() != fields.size()) {
+                diagnostics_.push_back(create_diag_at_token(
+                    function_token,
+                    DiagLevel::Error,
+                    add_string(
+                        fmt::format(
+                            "Expected {} arguments for {} fields, but got {}",
+                            fields.size(),
+                            fields.size(),
+                            arguments.size()
+                        )
+                    )
+                ));
+
+                has_errors = true;
+                recover_until(Token::PunctuatorSemi, /*consume=*/false);
+                continue;
+            }
+
+            for (std::size_t i = 0; i != fields.size(); ++i) {
+                result.push_back(
+                    EncodingAssignment {
+                        .field_name = std::move(fields[i].first),
+                        .field = std::move(fields[i].second),
+                        .value = std::move(arguments[i]),
+                    }
+                );
+            }
+        }
+
+        if (expect_current_token(Token::PunctuatorSemi)) {
+            has_errors = true;
+            recover_until(Token::PunctuatorSemi, /*consume=*/false);
+        }
+    }
+
+    if (has_errors) {
+        return std::nullopt;
+    } else {
+        return result;
+    }
+}
+
+void ISAParser::skip_section() {
+    lexer_.next_token();
+    lexer_.lex_until(
+        [](Token const &token) {
+            return token.is_keyword()
+                || (token.is(Token::Identifier) && token.content() == "ALTERNATE");
+        },
+        /*consume=*/false
+    );
+}
+
+auto ISAParser::parse_instruction_class(ISA const &isa, bool is_alternate)
+    -> std::optional<InstructionClass>  //
+{
+    assert(
+        lexer_.current_token().is(Token::KeywordClass)
+        && "Expected `CLASS` keyword at the beginning"
+    );
+
+    bool has_errors = false;
+    InstructionClass result;
+    result.is_alternate = is_alternate;
+    // The opcode always occupies the first slot.
+    result.get_or_add_slot("Opcode");
+
+    if (auto const class_name = expect_string_literal(lexer_.next_token())) {
+        result.name = *class_name;
+    } else {
+        has_errors = true;
+    }
+
+    lexer_.next_token();
+    while (true) {
+        switch (lexer_.current_token().kind()) {
+        case Token::KeywordFormat:
+            if (auto format = parse_format(result, isa)) {
+                result.format = std::move(*format);
+            } else {
+                has_errors = true;
+            }
+            continue;
+
+        case Token::KeywordConditions:
+            if (auto conditions = parse_conditions(result, isa)) {
+                // Move the error conditions to the front, so that they can be checked without
+                // looking at the other ones.
+                auto const first_non_error = std::ranges::stable_partition(
+                    *conditions,
+                    [](Condition const &condition) {
+                        return condition.kind == ConditionType::Error;
+                    }
+                );
+
+                result.error_condition_count = static_cast<unsigned>(
+                    std::ranges::distance(conditions->begin(), first_non_error.begin())
+                );
+                result.conditions = std::move(*conditions);
+            } else {
+                has_errors = true;
+            }
+            continue;
+
+        case Token::KeywordOpcodes:
+            if (auto opcodes = parse_opcodes()) {
+                result.opcodes = std::move(*opcodes);
+            } else {
+                has_errors = true;
+            }
+            continue;
+
+        case Token::KeywordEncoding:
+            if (auto encodings = parse_encoding(result, isa)) {
+                result.encodings = std::move(*encodings);
+            } else {
+                has_errors = true;
+            }
+            continue;
+
+        case Token::KeywordProperties:
+        case Token::KeywordPredicates:
+            skip_section();
+            continue;
+
+        default:
+            break;
+        }
+
+        break;
+    }
+
+    if (has_errors) {
+        // Skip the rest of the class, so that the parsing can continue from the next one.
+        lexer_.lex_until(
+            [](Token const &token) {
+                return token.is(Token::KeywordClass)
+                    || (token.is(Token::Identifier) && token.content() == "ALTERNATE");
+            },
+            /*consume=*/false
+        );
+        return std::nullopt;
+    } else {
+        return result;
+    }
+}
 }  // namespace sassas
@@ -33,20 +33,22 @@ auto Parser::add_string(std::string_view content) -> std::string_view {
     return { string_pool_.back().get(), content.size() };
 }
 
+auto Parser::annotate_source(unsigned begin, unsigned end, std::string_view label)
+    -> ants::AnnotatedSource  //
+{
+    return ants::AnnotatedSource(lexer_.source(), origin_)
+        .with_primary_annotation(begin, end, label);
+}
+
 auto Parser::create_diag_at_token(
     TokenRange target_range,
     DiagLevel level,
     std::string_view message,
     std::string_view label,
     std::string_view note
-) const -> Diag {
-    auto source =  //
-        ants::AnnotatedSource(lexer_.source(), origin_)
-            .with_primary_annotation(
-                target_range.location_begin(),
-                target_range.location_end(),
-                label
-            );
+) -> Diag {
+    auto source =
+        annotate_source(target_range.location_begin(), target_range.location_end(), label);
 
     auto diag = Diag(level, message).with_source(std::move(source));
     if (!note.empty()) {
@@ -444,7 +446,11 @@ auto Parser::get_integer_constant(Token const &token, unsigned bits, bool signed
     -> std::optional<std::uint64_t>  //
 {
     IntegerParser parser(token, bits, signedness);
-    Diag diag = create_diag_at_token(token, DiagLevel::Error, "Invalid integer constant");
+    // The diagnostic is only created on failure, since creating it may not be cheap (see
+    // `annotate_source()`).
+    auto const make_diag = [&] {
+        return create_diag_at_token(token, DiagLevel::Error, "Invalid integer constant");
+    };
 
     parser.parse_sign();
     parser.parse_base();
@@ -454,12 +460,9 @@ auto Parser::get_integer_constant(Token const &token, unsigned bits, bool signed
         (note = parser.check_separator()) || (note = parser.check_digit()))
     {
         diagnostics_.push_back(
-            std::move(diag).with_sub_diag_entry(
+            make_diag().with_sub_diag_entry(
                 ants::DiagEntry(DiagLevel::Note, add_string(note->message))
-                    .with_source(
-                        ants::AnnotatedSource(lexer_.source(), origin_)
-                            .with_primary_annotation(note->annotation_begin, note->annotation_end)
-                    )
+                    .with_source(annotate_source(note->annotation_begin, note->annotation_end))
             )
         );
 
@@ -488,7 +491,7 @@ auto Parser::get_integer_constant(Token const &token, unsigned bits, bool signed
         }();
 
         diagnostics_.push_back(
-            std::move(diag)
+            make_diag()
                 .with_sub_diag_entry(DiagLevel::Note, "because the integer constant overflows")
                 .with_sub_diag_entry(DiagLevel::Note, note)
         );
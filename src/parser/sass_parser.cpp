@@ -0,0 +1,435 @@
+#include "sassas/parser/sass_parser.hpp"
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/lexer/lexer.hpp"
+#include "sassas/lexer/token.hpp"
+
+#include "fmt/format.h"
+
+#include "annotate_snippets/annotated_source.hpp"
+#include "annotate_snippets/diag.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// Returns whether `token` can be used as a name. The keywords of the instruction description
+/// files have no special meaning in SASS, so they are names as well.
+auto is_name(Token const &token) -> bool {
+    return token.is(Token::Identifier) || token.is_keyword();
+}
+
+/// Returns whether there is a line break in `source` between `begin` and `end`.
+auto has_line_break(std::string_view source, unsigned begin, unsigned end) -> bool {
+    return source.substr(begin, end - begin).find('\n') != std::string_view::npos;
+}
+}  // namespace
+
+auto SassParser::parse_chunk(
+    std::string_view chunk,
+    unsigned first_line,
+    bool is_last,
+    ParsedChunk &result
+) -> std::size_t {
+    lexer_ = Lexer(chunk, /*skip_comments=*/true);
+    first_line_ = first_line;
+    known_line_begin_ = 0;
+    known_line_ = first_line;
+    result.clear();
+
+    std::size_t consumed = 0;
+    lexer_.next_token();
+    while (lexer_.current_token().is_not(Token::End)) {
+        Token const token = lexer_.current_token();
+        std::size_t const token_count = result.tokens.size();
+
+        std::optional<unsigned> end;
+        if (token.is(Token::PunctuatorAt)) {
+            end = parse_instruction(result, is_last);
+        } else if (is_name(token)) {
+            // Either a label like `main:`, or an instruction.
+            Lexer const saved_lexer = lexer_;
+            bool const is_label = lexer_.next_token().is(Token::PunctuatorColon);
+            lexer_ = saved_lexer;
+
+            end = is_label ? parse_label(result, is_last) : parse_instruction(result, is_last);
+        } else if (token.is(Token::PunctuatorDot)) {
+            end = parse_dot_statement(result, is_last);
+        } else {
+            // Skip the line first, since the token may be the beginning of a comment cut by the end
+            // of the chunk (e.g. the `/` of `/*`).
+            end = skip_line(is_last);
+            if (end) {
+                diagnostics_.push_back(create_diag_at_token(
+                    token,
+                    DiagLevel::Error,
+                    "Unexpected token",
+                    "expected an instruction, a label or a directive"
+                ));
+            }
+        }
+
+        if (!end) {
+            // The statement is cut by the end of the chunk. Drop the part we have parsed, so that
+            // it is parsed again with the next chunk.
+            result.tokens.resize(token_count);
+            break;
+        }
+        consumed = *end;
+    }
+
+    if (is_last) {
+        consumed = chunk.size();
+    }
+    return consumed;
+}
+
+auto SassParser::parse_instruction(ParsedChunk &result, bool is_last) -> std::optional<unsigned> {
+    SassStatement statement { .kind = SassStatement::Instruction };
+    unsigned const begin = lexer_.current_token().location_begin();
+    bool is_valid = true;
+
+    // The guard predicate, such as `@P0` or `@!P0`.
+    if (lexer_.current_token().is(Token::PunctuatorAt)) {
+        if (lexer_.next_token().is(Token::PunctuatorExclaim)) {
+            statement.is_predicate_negated = true;
+            lexer_.next_token();
+        }
+
+        Token const &predicate = lexer_.current_token();
+        if (predicate.is(Token::End) && !is_last) {
+            return std::nullopt;
+        }
+        if (is_name(predicate)) {
+            statement.predicate = predicate.content();
+            lexer_.next_token();
+        } else {
+            expect_token(predicate, Token::Identifier);
+            is_valid = false;
+        }
+    }
+
+    // The mnemonic and the operands.
+    statement.first_token = static_cast<std::uint32_t>(result.tokens.size());
+    // Whether we are still in the mnemonic, i.e. all tokens so far are the name of the instruction
+    // and its modifiers.
+    bool in_mnemonic = true;
+    while (lexer_.current_token().is_not(Token::PunctuatorSemi)) {
+        Token const &token = lexer_.current_token();
+        if (token.is(Token::End)) {
+            if (!is_last) {
+                return std::nullopt;
+            }
+
+            diagnostics_.push_back(create_diag_at_token(
+                token,
+                DiagLevel::Error,
+                "Unterminated instruction",
+                "expected `;`"
+            ));
+            return token.location_end();
+        }
+
+        if (result.tokens.size() == statement.first_token && !is_name(token)) {
+            expect_token(token, Token::Identifier);
+            is_valid = false;
+            lexer_.next_token();
+            continue;
+        }
+
+        bool is_operand_start = false;
+        if (result.tokens.size() != statement.first_token) {
+            SassToken const &previous = result.tokens.back();
+            in_mnemonic = in_mnemonic
+                       && (result.tokens.size() == statement.first_token + 1
+                           || previous.kind == SassToken::Modifier);
+            is_operand_start =
+                in_mnemonic
+                || (previous.kind == SassToken::Punctuator
+                    && previous.punctuator != Token::PunctuatorRightSquare
+                    && previous.punctuator != Token::PunctuatorRightParen
+                    && previous.punctuator != Token::PunctuatorPipe);
+        }
+
+        if (!append_token(result.tokens, is_operand_start)) {
+            is_valid = false;
+        }
+    }
+
+    unsigned const end = lexer_.current_token().location_end();
+    lexer_.next_token();
+
+    statement.range = TokenRange(begin, end);
+    statement.token_count =
+        static_cast<std::uint32_t>(result.tokens.size() - statement.first_token);
+    if (is_valid) {
+        result.statements.push_back(statement);
+    } else {
+        result.tokens.resize(statement.first_token);
+    }
+    return end;
+}
+
+auto SassParser::parse_label(ParsedChunk &result, bool /*is_last*/) -> std::optional<unsigned> {
+    // The caller has checked that the name is followed by a `:`.
+    Token const name = lexer_.current_token();
+    unsigned const end = lexer_.next_token().location_end();
+    lexer_.next_token();
+
+    result.statements.push_back({
+        .kind = SassStatement::Label,
+        .range = TokenRange(name.location_begin(), end),
+        .name = name.content(),
+    });
+    return end;
+}
+
+auto SassParser::parse_dot_statement(ParsedChunk &result, bool is_last)
+    -> std::optional<unsigned>  //
+{
+    Token const dot = lexer_.current_token();
+    Lexer const saved_lexer = lexer_;
+
+    // A label such as `.L_x_0:`, or a section such as `.text.kernel:`. The `.` must be attached to
+    // the name.
+    Token const name = lexer_.next_token();
+    if (name.is(Token::End) && !is_last) {
+        return std::nullopt;
+    }
+    if (is_name(name) && name.location_begin() == dot.location_end()) {
+        Token const colon = lexer_.next_token();
+        if (colon.is(Token::End) && !is_last) {
+            return std::nullopt;
+        }
+
+        if (colon.is(Token::PunctuatorColon)) {
+            std::string_view const full_name = lexer_.source().substr(
+                dot.location_begin(),
+                name.location_end() - dot.location_begin()
+            );
+            bool const is_section = name.content().starts_with("text.");
+
+            lexer_.next_token();
+            result.statements.push_back({
+                .kind = is_section ? SassStatement::Section : SassStatement::Label,
+                .range = TokenRange(dot.location_begin(), colon.location_end()),
+                .name = full_name,
+            });
+            return colon.location_end();
+        }
+    }
+
+    // A directive such as `.headerflags @"EF_CUDA_SM90"`, which extends to the end of the line.
+    lexer_ = saved_lexer;
+    return skip_line(is_last);
+}
+
+auto SassParser::append_token(std::vector<SassToken> &tokens, bool is_operand_start) -> bool {
+    Token const token = lexer_.current_token();
+
+    // Splits a name like `FADD.FTZ` into the name `FADD` and the modifier `FTZ`. If `is_modifier`
+    // is `true`, all parts are modifiers.
+    auto const append_name = [&](Token const &name, bool is_modifier) {
+        std::string_view const content = name.content();
+        std::size_t part_begin = 0;
+        while (part_begin <= content.size()) {
+            std::size_t const part_end = std::min(content.find('.', part_begin), content.size());
+            if (part_end != part_begin) {
+                auto const location = name.location_begin() + static_cast<unsigned>(part_begin);
+                tokens.push_back({
+                    .kind = is_modifier ? SassToken::Modifier : SassToken::Name,
+                    .text = content.substr(part_begin, part_end - part_begin),
+                    .range = TokenRange(location, location + (part_end - part_begin)),
+                });
+            }
+
+            is_modifier = true;
+            part_begin = part_end + 1;
+        }
+    };
+
+    auto const append_integer = [&](Token const &integer) {
+        auto const value = get_integer_constant(integer, 64, true);
+        if (value) {
+            tokens.push_back({
+                .kind = SassToken::Integer,
+                .text = integer.content(),
+                .value = static_cast<std::int64_t>(*value),
+                .range = integer.token_range(),
+            });
+        }
+        return value.has_value();
+    };
+
+    if (is_name(token)) {
+        append_name(token, /*is_modifier=*/false);
+        lexer_.next_token();
+        return true;
+    }
+
+    switch (token.kind()) {
+    case Token::Integer: {
+        lexer_.next_token();
+        return append_integer(token);
+    }
+
+    case Token::PunctuatorDot: {
+        // A modifier separated from its name, as in `R2 .reuse`.
+        Token const &name = lexer_.next_token();
+        if (is_name(name) && name.location_begin() == token.location_end()) {
+            append_name(name, /*is_modifier=*/true);
+            lexer_.next_token();
+            return true;
+        }
+        break;
+    }
+
+    case Token::PunctuatorBackTick:
+        return append_label_reference(tokens);
+
+    case Token::PunctuatorMinus:
+    case Token::PunctuatorPlus: {
+        // A signed integer such as `-0x10`.
+        Token const &integer = lexer_.next_token();
+        if (is_operand_start && integer.is(Token::Integer)) {
+            Token const merged = token.merge(integer, Token::Integer);
+            lexer_.next_token();
+            return append_integer(merged);
+        }
+        break;
+    }
+
+    default:
+        if (!token.is_punctuator()) {
+            diagnostics_.push_back(create_diag_at_token(
+                token,
+                DiagLevel::Error,
+                "Unexpected token in instruction",
+                "expected a name, an integer or a punctuator"
+            ));
+            lexer_.next_token();
+            return false;
+        }
+
+        lexer_.next_token();
+        break;
+    }
+
+    // The token is a punctuator by itself. The lexer has moved past it.
+    tokens.push_back({
+        .kind = SassToken::Punctuator,
+        .punctuator = token.kind(),
+        .text = token.content(),
+        .range = token.token_range(),
+    });
+    return true;
+}
+
+auto SassParser::append_label_reference(std::vector<SassToken> &tokens) -> bool {
+    Token const backtick = lexer_.current_token();
+    Token token = lexer_.next_token();
+    bool is_valid = token.is(Token::PunctuatorLeftParen);
+
+    unsigned name_begin = 0;
+    if (is_valid) {
+        token = lexer_.next_token();
+        name_begin = token.location_begin();
+        // The `.` of a name like `.L_x_0` is a token by itself, which must be attached to the rest
+        // of the name.
+        if (token.is(Token::PunctuatorDot)) {
+            unsigned const dot_end = token.location_end();
+            token = lexer_.next_token();
+            is_valid = token.location_begin() == dot_end;
+        }
+        is_valid = is_valid && is_name(token);
+    }
+
+    unsigned const name_end = token.location_end();
+    if (is_valid) {
+        token = lexer_.next_token();
+        is_valid = token.is(Token::PunctuatorRightParen);
+    }
+
+    if (token.is(Token::End)) {
+        // The reference is cut by the end of the chunk, or the instruction is not terminated. The
+        // caller handles both cases.
+        return true;
+    }
+    if (!is_valid) {
+        // Leave the offending token to the caller, since it may be the `;` of the instruction.
+        diagnostics_.push_back(create_diag_at_token(
+            token,
+            DiagLevel::Error,
+            "Invalid label reference",
+            "expected a label reference of the form `(name)"
+        ));
+        return false;
+    }
+
+    lexer_.next_token();
+    tokens.push_back({
+        .kind = SassToken::Label,
+        .text = lexer_.source().substr(name_begin, name_end - name_begin),
+        .range = TokenRange(backtick.location_begin(), token.location_end()),
+    });
+    return true;
+}
+
+auto SassParser::skip_line(bool is_last) -> std::optional<unsigned> {
+    std::string_view const source = lexer_.source();
+    unsigned end = lexer_.current_token().location_end();
+
+    while (true) {
+        Token const &token = lexer_.next_token();
+        if (has_line_break(source, end, token.location_begin())) {
+            return end;
+        }
+        if (token.is(Token::End)) {
+            return is_last ? std::optional(end) : std::nullopt;
+        }
+        end = token.location_end();
+    }
+}
+
+auto SassParser::annotate_source(unsigned begin, unsigned end, std::string_view label)
+    -> ants::AnnotatedSource  //
+{
+    std::string_view const source = lexer_.source();
+    begin = std::min<unsigned>(begin, source.size());
+
+    // Find the line containing the beginning of the range, and copy it into the string pool, since
+    // the chunk will be discarded before the diagnostic is rendered.
+    std::size_t const line_break = begin == 0 ? std::string_view::npos
+                                              : source.rfind('\n', begin - 1);
+    std::size_t const line_begin = line_break == std::string_view::npos ? 0 : line_break + 1;
+    std::size_t const line_end = std::min(source.find('\n', begin), source.size());
+    std::string_view const line = add_string(source.substr(line_begin, line_end - line_begin));
+
+    // Diagnostics are mostly created in the order of the source, so count the lines from the
+    // previous diagnostic if possible.
+    if (line_begin < known_line_begin_) {
+        known_line_begin_ = 0;
+        known_line_ = first_line_;
+    }
+    known_line_ += static_cast<unsigned>(std::ranges::count(
+        source.substr(known_line_begin_, line_begin - known_line_begin_),
+        '\n'
+    ));
+    known_line_begin_ = line_begin;
+    std::string_view const origin = add_string(fmt::format("{}:{}", origin_, known_line_));
+
+    // The annotation is clamped to the line.
+    end = static_cast<unsigned>(std::clamp<std::size_t>(end, begin, line_end));
+    return ants::AnnotatedSource(line, origin).with_primary_annotation(
+        static_cast<unsigned>(begin - line_begin),
+        static_cast<unsigned>(end - line_begin),
+        label
+    );
+}
+}  // namespace sassas
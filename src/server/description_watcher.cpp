@@ -0,0 +1,199 @@
+#include "sassas/server/description_watcher.hpp"
+
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/isa/isa_registry.hpp"
+#include "sassas/parser/incremental_isa_parser.hpp"
+#include "sassas/utils/metrics.hpp"
+
+#include "fmt/format.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/inotify.h>) && __has_include(<unistd.h>)
+    #include <sys/inotify.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_INOTIFY 1
+#else
+    #include <chrono>
+    #include <thread>
+    #include <vector>
+#endif
+
+namespace sassas {
+#ifndef SASSAS_HAS_INOTIFY
+namespace {
+/// How often the modification times of the descriptions are polled without inotify.
+constexpr std::chrono::seconds POLL_INTERVAL(1);
+}  // namespace
+#endif
+
+auto DescriptionWatcher::load(std::string_view arch) -> std::optional<ISA> {
+    Description *description;
+    {
+        std::scoped_lock const lock(mutex_);
+        auto iter = descriptions_.find(arch);
+        if (iter == descriptions_.end()) {
+            auto created = std::make_unique<Description>(path(arch));
+            iter = descriptions_.emplace(std::string(arch), std::move(created)).first;
+        }
+        description = iter->second.get();
+    }
+
+    std::scoped_lock const lock(description->mutex);
+    return parse(arch, *description);
+}
+
+auto DescriptionWatcher::watch(ISARegistry &registry) -> bool {
+#ifdef SASSAS_HAS_INOTIFY
+    int const fd = ::inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // Editors either write the file in place or rename a new file over it.
+    if (::inotify_add_watch(fd, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        int const error = errno;
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t const size = ::read(fd, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        } else if (size <= 0) {
+            int const error = size < 0 ? errno : EIO;
+            ::close(fd);
+            errno = error;
+            return false;
+        }
+
+        // Saving a file may raise several events, so each file of a batch is reloaded once.
+        std::set<std::string, std::less<>> changed;
+        for (ssize_t offset = 0; offset < size;) {
+            inotify_event event;
+            std::memcpy(&event, buffer + offset, sizeof(event));
+            if (event.len != 0) {
+                // The name is padded with null characters.
+                std::string_view const name(buffer + offset + sizeof(event));
+                if (std::optional<std::string_view> const arch = arch_of(name)) {
+                    changed.emplace(*arch);
+                }
+            }
+            offset += static_cast<ssize_t>(sizeof(event) + event.len);
+        }
+        for (std::string const &arch : changed) {
+            reload(registry, arch);
+        }
+    }
+#else
+    while (true) {
+        std::this_thread::sleep_for(POLL_INTERVAL);
+
+        std::vector<std::string> changed;
+        {
+            std::scoped_lock const lock(mutex_);
+            for (auto const &[arch, description] : descriptions_) {
+                // A description that is being parsed is looked at in the next round.
+                std::unique_lock const parsing(description->mutex, std::try_to_lock);
+                std::error_code error;
+                auto const modified = std::filesystem::last_write_time(path(arch), error);
+                if (parsing && !error && modified != description->modified) {
+                    changed.push_back(arch);
+                }
+            }
+        }
+        for (std::string const &arch : changed) {
+            reload(registry, arch);
+        }
+    }
+#endif
+}
+
+auto DescriptionWatcher::path(std::string_view arch) const -> std::string {
+    return fmt::format("{}/{}{}", directory_, arch, FILE_SUFFIX);
+}
+
+auto DescriptionWatcher::arch_of(std::string_view name) -> std::optional<std::string_view> {
+    if (name.size() <= FILE_SUFFIX.size() || !name.ends_with(FILE_SUFFIX)) {
+        return std::nullopt;
+    }
+    return name.substr(0, name.size() - FILE_SUFFIX.size());
+}
+
+auto DescriptionWatcher::find(std::string_view arch) -> Description * {
+    std::scoped_lock const lock(mutex_);
+    auto const iter = descriptions_.find(arch);
+    return iter != descriptions_.end() ? iter->second.get() : nullptr;
+}
+
+auto DescriptionWatcher::parse(std::string_view arch, Description &description)
+    -> std::optional<ISA>  //
+{
+    std::string const file_name = path(arch);
+    std::error_code error;
+    description.modified = std::filesystem::last_write_time(file_name, error);
+
+    std::ifstream input(file_name);
+    if (!input) {
+        report_(Diag(
+            DiagLevel::Error,
+            fmt::format("Failed to open {}: {}", file_name, std::strerror(errno))
+        ));
+        return std::nullopt;
+    }
+    // clang-format off
+    std::string const source(
+        (std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>()
+    );
+    // clang-format on
+    return description.parser.parse(source, report_);
+}
+
+void DescriptionWatcher::reload(ISARegistry &registry, std::string_view arch) {
+    // Only the architectures that have been asked for are reloaded.
+    Description *const description = find(arch);
+    if (!description) {
+        return;
+    }
+
+    std::scoped_lock const lock(description->mutex);
+    std::optional<ISA> isa = parse(arch, *description);
+    IncrementalISAParser::Statistics const statistics = description->parser.last_statistics();
+    if (!isa) {
+        report_(Diag(
+            DiagLevel::Warning,
+            fmt::format("The description of {} has errors, so it is not reloaded", arch)
+        ));
+        return;
+    }
+
+    registry.replace(arch, std::move(*isa));
+    Metrics::add(Counter::ISAReloads);
+    Metrics::add(Counter::ReparsedSections, statistics.parsed);
+    report_(Diag(
+        DiagLevel::Note,
+        fmt::format(
+            "Reloaded {}, parsing {} of its {} sections",
+            arch,
+            statistics.parsed,
+            statistics.sections
+        )
+    ));
+}
+}  // namespace sassas
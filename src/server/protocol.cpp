@@ -0,0 +1,278 @@
+#include "sassas/server/protocol.hpp"
+
+#include "sassas/encoder/encoder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<sys/socket.h>) && __has_include(<unistd.h>)
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_SOCKETS 1
+#endif
+
+namespace sassas {
+namespace {
+/// Appends integers and strings to a message.
+class MessageWriter {
+public:
+    void u8(std::uint8_t value) {
+        bytes_.push_back(static_cast<char>(value));
+    }
+
+    void u32(std::uint32_t value) {
+        for (unsigned i = 0; i != 4; ++i) {
+            u8(static_cast<std::uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    void string(std::string_view value) {
+        u32(static_cast<std::uint32_t>(value.size()));
+        bytes_.append(value);
+    }
+
+    auto take() -> std::string {
+        return std::move(bytes_);
+    }
+
+private:
+    std::string bytes_;
+};
+
+/// Reads integers and strings from a message. Reading past the end of the message yields zeros and
+/// empty strings, and marks the reader as failed, so a whole message can be read before checking
+/// `ok()` once.
+class MessageReader {
+public:
+    explicit MessageReader(std::string_view bytes) : bytes_(bytes) { }
+
+    /// Returns whether the whole message was read without error.
+    auto ok() const -> bool {
+        return ok_ && bytes_.empty();
+    }
+
+    void fail() {
+        ok_ = false;
+        bytes_ = {};
+    }
+
+    auto u8() -> std::uint8_t {
+        if (bytes_.empty()) {
+            fail();
+            return 0;
+        }
+        auto const value = static_cast<std::uint8_t>(bytes_.front());
+        bytes_.remove_prefix(1);
+        return value;
+    }
+
+    auto u32() -> std::uint32_t {
+        std::uint32_t value = 0;
+        for (unsigned i = 0; i != 4; ++i) {
+            value |= static_cast<std::uint32_t>(u8()) << (i * 8);
+        }
+        return value;
+    }
+
+    /// Reads an enumerator whose values range up to `last`.
+    template <class Enum>
+    auto enumerator(Enum last) -> Enum {
+        std::uint8_t const value = u8();
+        if (value > static_cast<std::uint8_t>(last)) {
+            fail();
+            return Enum();
+        }
+        return static_cast<Enum>(value);
+    }
+
+    auto string() -> std::string {
+        std::uint32_t const size = u32();
+        if (size > bytes_.size()) {
+            fail();
+            return {};
+        }
+        std::string value(bytes_.substr(0, size));
+        bytes_.remove_prefix(size);
+        return value;
+    }
+
+    /// Reads the number of elements of a sequence, each of which takes at least `min_size` bytes.
+    auto count(std::size_t min_size) -> std::uint32_t {
+        std::uint32_t const value = u32();
+        if (value > bytes_.size() / min_size) {
+            fail();
+            return 0;
+        }
+        return value;
+    }
+
+private:
+    std::string_view bytes_;
+    bool ok_ = true;
+};
+
+#ifdef SASSAS_HAS_SOCKETS
+/// Reads exactly `size` bytes into `data`. Returns `false` at the end of the stream or on error.
+auto read_exactly(int fd, char *data, std::size_t size) -> bool {
+    while (size != 0) {
+        ssize_t const result = ::read(fd, data, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            return false;
+        }
+        data += result;
+        size -= static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+/// Writes all of `header` followed by all of `body`. They are sent together, so that the peer is
+/// woken up once per message rather than once for the length and again for the body. A peer that
+/// has gone away is reported as a failure rather than by `SIGPIPE`, which would kill the daemon.
+auto write_all(int fd, std::string_view header, std::string_view body) -> bool {
+    #ifdef MSG_NOSIGNAL
+    int const flags = MSG_NOSIGNAL;
+    #else
+    int const flags = 0;
+    #endif
+    while (!header.empty() || !body.empty()) {
+        iovec pieces[2] = {
+            { .iov_base = const_cast<char *>(header.data()), .iov_len = header.size() },
+            { .iov_base = const_cast<char *>(body.data()), .iov_len = body.size() },
+        };
+        msghdr message {};
+        message.msg_iov = header.empty() ? pieces + 1 : pieces;
+        message.msg_iovlen = header.empty() ? 1 : 2;
+
+        ssize_t const result = ::sendmsg(fd, &message, flags);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            return false;
+        }
+        auto const sent = static_cast<std::size_t>(result);
+        std::size_t const from_header = std::min(sent, header.size());
+        header.remove_prefix(from_header);
+        body.remove_prefix(sent - from_header);
+    }
+    return true;
+}
+#endif
+}  // namespace
+
+auto ServiceRequest::encode() const -> std::string {
+    MessageWriter writer;
+    writer.u8(static_cast<std::uint8_t>(command));
+    writer.string(arch);
+    writer.u8(static_cast<std::uint8_t>(output));
+    writer.u32(static_cast<std::uint32_t>(inputs.size()));
+    for (ServiceInput const &input : inputs) {
+        writer.string(input.name);
+        writer.u8(static_cast<std::uint8_t>(input.level));
+        writer.string(input.contents);
+    }
+    writer.string(opcode);
+    return writer.take();
+}
+
+auto ServiceRequest::decode(std::string_view message, std::string_view &error)
+    -> std::optional<ServiceRequest>  //
+{
+    MessageReader reader(message);
+    ServiceRequest request;
+    request.command = reader.enumerator(ServiceCommand::Query);
+    request.arch = reader.string();
+    request.output = reader.enumerator(ServiceOutput::Cubin);
+    // An input takes at least its two lengths and its level.
+    request.inputs.resize(reader.count(9));
+    for (ServiceInput &input : request.inputs) {
+        input.name = reader.string();
+        input.level = reader.enumerator(ValidationLevel::Trusted);
+        input.contents = reader.string();
+    }
+    request.opcode = reader.string();
+
+    if (!reader.ok()) {
+        error = "The request is malformed";
+        return std::nullopt;
+    }
+    return request;
+}
+
+auto ServiceResponse::encode() const -> std::string {
+    MessageWriter writer;
+    writer.u8(success);
+    writer.string(console);
+    writer.u8(file.has_value());
+    writer.string(file ? *file : std::string_view());
+    return writer.take();
+}
+
+auto ServiceResponse::decode(std::string_view message, std::string_view &error)
+    -> std::optional<ServiceResponse>  //
+{
+    MessageReader reader(message);
+    ServiceResponse response;
+    response.success = reader.u8() != 0;
+    response.console = reader.string();
+    bool const has_file = reader.u8() != 0;
+    std::string file = reader.string();
+    if (has_file) {
+        response.file = std::move(file);
+    }
+
+    if (!reader.ok()) {
+        error = "The response is malformed";
+        return std::nullopt;
+    }
+    return response;
+}
+
+auto read_message(int fd, std::string &message) -> bool {
+#ifdef SASSAS_HAS_SOCKETS
+    char header[4];
+    if (!read_exactly(fd, header, sizeof(header))) {
+        return false;
+    }
+    std::uint32_t size = 0;
+    for (unsigned i = 0; i != 4; ++i) {
+        size |= static_cast<std::uint32_t>(static_cast<unsigned char>(header[i])) << (i * 8);
+    }
+    if (size > MAX_MESSAGE_SIZE) {
+        return false;
+    }
+
+    message.resize(size);
+    return read_exactly(fd, message.data(), size);
+#else
+    static_cast<void>(fd);
+    static_cast<void>(message);
+    return false;
+#endif
+}
+
+auto write_message(int fd, std::string_view message) -> bool {
+#ifdef SASSAS_HAS_SOCKETS
+    if (message.size() > MAX_MESSAGE_SIZE) {
+        return false;
+    }
+    char header[4];
+    for (unsigned i = 0; i != 4; ++i) {
+        header[i] = static_cast<char>(message.size() >> (i * 8));
+    }
+    return write_all(fd, std::string_view(header, sizeof(header)), message);
+#else
+    static_cast<void>(fd);
+    static_cast<void>(message);
+    return false;
+#endif
+}
+}  // namespace sassas
@@ -0,0 +1,355 @@
+#include "sassas/server/server.hpp"
+
+#include "sassas/server/protocol.hpp"
+#include "sassas/server/service.hpp"
+#include "sassas/utils/metrics.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<sys/socket.h>) && __has_include(<sys/un.h>) && __has_include(<unistd.h>)
+    #include <chrono>
+    #include <condition_variable>
+    #include <cstring>
+    #include <deque>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/time.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_UNIX_SOCKETS 1
+#endif
+
+namespace sassas {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+namespace {
+/// How long a connection may stay idle between requests before its worker gives it up, so that
+/// clients that keep their connections open cannot hold every worker.
+constexpr std::chrono::seconds IDLE_TIMEOUT(10);
+
+/// How long a response may wait for a client that does not read it.
+constexpr std::chrono::seconds SEND_TIMEOUT(5);
+
+/// Sets the timeout of the socket option `option` (`SO_RCVTIMEO` or `SO_SNDTIMEO`) of `fd`. A
+/// read or write that times out fails with `EAGAIN`, which closes the connection.
+void set_timeout(int fd, int option, std::chrono::seconds timeout) {
+    timeval value {};
+    value.tv_sec = static_cast<decltype(value.tv_sec)>(timeout.count());
+    // Without the timeout, the connection is served as before.
+    static_cast<void>(::setsockopt(fd, SOL_SOCKET, option, &value, sizeof(value)));
+}
+
+/// Fills `address` with `path`. Returns `false` if `path` does not fit.
+auto make_address(char const *path, sockaddr_un &address) -> bool {
+    address = {};
+    address.sun_family = AF_UNIX;
+    std::size_t const size = std::strlen(path);
+    if (size >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    std::memcpy(address.sun_path, path, size);
+    return true;
+}
+
+/// Makes `send()` report a peer that has gone away as an error rather than by `SIGPIPE`.
+    #ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+    #else
+constexpr int SEND_FLAGS = 0;
+    #endif
+
+/// Creates a stream socket that is not inherited by child processes.
+auto make_socket() -> int {
+    #ifdef SOCK_CLOEXEC
+    return ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    #else
+    return ::socket(AF_UNIX, SOCK_STREAM, 0);
+    #endif
+}
+
+/// Returns whether a daemon is accepting connections at `address`.
+auto is_serving(sockaddr_un const &address) -> bool {
+    int const fd = make_socket();
+    if (fd < 0) {
+        return false;
+    }
+    bool const connected =
+        ::connect(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) == 0;
+    ::close(fd);
+    return connected;
+}
+
+/// The accepted connections that wait for a worker.
+class ConnectionQueue {
+public:
+    void push(int fd) {
+        {
+            std::scoped_lock const lock(mutex_);
+            connections_.push_back(fd);
+        }
+        ready_.notify_one();
+    }
+
+    /// Returns the next connection, or `std::nullopt` once the queue is closed.
+    auto pop() -> std::optional<int> {
+        std::unique_lock lock(mutex_);
+        ready_.wait(lock, [this] { return !connections_.empty() || closed_; });
+        if (connections_.empty()) {
+            return std::nullopt;
+        }
+        int const fd = connections_.front();
+        connections_.pop_front();
+        return fd;
+    }
+
+    /// Wakes up all workers, which finish the connections that are still queued and then stop.
+    void close() {
+        {
+            std::scoped_lock const lock(mutex_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<int> connections_;
+    bool closed_ = false;
+};
+
+/// Answers the requests of the connection `fd` until the client closes it or leaves it idle for
+/// `IDLE_TIMEOUT`. A request that cannot be decoded closes the connection, since the stream can no
+/// longer be trusted.
+void serve_connection(Service &service, int fd) {
+    set_timeout(fd, SO_RCVTIMEO, IDLE_TIMEOUT);
+    set_timeout(fd, SO_SNDTIMEO, SEND_TIMEOUT);
+    std::string message;
+    while (read_message(fd, message)) {
+        Metrics::Timer request_timer(Stage::Request);
+        auto const request_size = static_cast<std::int64_t>(message.size());
+        Metrics::add(Gauge::RequestBytes, request_size);
+
+        std::string_view error;
+        std::optional<ServiceRequest> const request = ServiceRequest::decode(message, error);
+        bool sent = false;
+        if (request) {
+            std::string const response = service.handle(*request).encode();
+            auto const response_size = static_cast<std::int64_t>(response.size());
+            Metrics::add(Gauge::RequestBytes, response_size);
+
+            Metrics::Timer write_timer(Stage::Write);
+            sent = write_message(fd, response);
+            write_timer.stop();
+            Metrics::add(Gauge::RequestBytes, -response_size);
+        }
+
+        Metrics::add(Gauge::RequestBytes, -request_size);
+        if (!sent) {
+            break;
+        }
+    }
+    ::close(fd);
+}
+}  // namespace
+#endif
+
+auto UnixListener::open(char const *path) -> std::optional<UnixListener> {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        return std::nullopt;
+    }
+    int const fd = make_socket();
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    // Closes the socket if it cannot be set up.
+    UnixListener listener(fd);
+
+    auto const bind = [&] {
+        return ::bind(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) == 0;
+    };
+    if (!bind()) {
+        if (errno != EADDRINUSE) {
+            return std::nullopt;
+        }
+        // The socket of a process that exited without removing it is replaced; a live one is not.
+        if (is_serving(address)) {
+            errno = EADDRINUSE;
+            return std::nullopt;
+        }
+        ::unlink(path);
+        if (!bind()) {
+            return std::nullopt;
+        }
+    }
+    if (::chmod(path, S_IRUSR | S_IWUSR) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        return std::nullopt;
+    }
+    return listener;
+#else
+    static_cast<void>(path);
+    errno = ENOSYS;
+    return std::nullopt;
+#endif
+}
+
+UnixListener::UnixListener(UnixListener &&other) noexcept : fd_(std::exchange(other.fd_, -1)) { }
+
+auto UnixListener::operator=(UnixListener &&other) noexcept -> UnixListener & {
+    std::swap(fd_, other.fd_);
+    return *this;
+}
+
+UnixListener::~UnixListener() {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    if (fd_ >= 0) {
+        int const error = errno;
+        ::close(fd_);
+        errno = error;
+    }
+#endif
+}
+
+auto UnixListener::accept() -> int {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    while (true) {
+        int const fd = ::accept(fd_, nullptr, nullptr);
+        if (fd >= 0) {
+            return fd;
+        } else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+            // Wait for some connections to be closed.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            return -1;
+        }
+    }
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+auto serve(Service &service, UnixListener &listener, unsigned thread_count) -> bool {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    ConnectionQueue queue;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i != std::max(thread_count, 1u); ++i) {
+        workers.emplace_back([&] {
+            while (std::optional<int> const fd = queue.pop()) {
+                serve_connection(service, *fd);
+            }
+        });
+    }
+
+    for (int fd; (fd = listener.accept()) >= 0;) {
+        queue.push(fd);
+    }
+
+    int const error = errno;
+    queue.close();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    errno = error;
+    return false;
+#else
+    static_cast<void>(service);
+    static_cast<void>(listener);
+    static_cast<void>(thread_count);
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+auto serve_metrics(UnixListener &listener) -> bool {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    for (int fd; (fd = listener.accept()) >= 0;) {
+        // A client that does not read would otherwise stop the metrics from being served.
+        set_timeout(fd, SO_SNDTIMEO, SEND_TIMEOUT);
+        std::string const text = Metrics::render();
+        for (std::string_view rest = text; !rest.empty();) {
+            ssize_t const written = ::send(fd, rest.data(), rest.size(), SEND_FLAGS);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written <= 0) {
+                break;
+            }
+            rest.remove_prefix(static_cast<std::size_t>(written));
+        }
+        ::close(fd);
+    }
+    return false;
+#else
+    static_cast<void>(listener);
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+auto ServiceClient::connect(char const *path) -> std::optional<ServiceClient> {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        return std::nullopt;
+    }
+    int const fd = make_socket();
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) != 0) {
+        int const error = errno;
+        ::close(fd);
+        errno = error;
+        return std::nullopt;
+    }
+    return ServiceClient(fd);
+#else
+    static_cast<void>(path);
+    errno = ENOSYS;
+    return std::nullopt;
+#endif
+}
+
+ServiceClient::ServiceClient(ServiceClient &&other) noexcept :
+    fd_(std::exchange(other.fd_, -1)) { }
+
+auto ServiceClient::operator=(ServiceClient &&other) noexcept -> ServiceClient & {
+    std::swap(fd_, other.fd_);
+    return *this;
+}
+
+ServiceClient::~ServiceClient() {
+#ifdef SASSAS_HAS_UNIX_SOCKETS
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+auto ServiceClient::call(ServiceRequest const &request, std::string_view &error)
+    -> std::optional<ServiceResponse>  //
+{
+    std::string message = request.encode();
+    if (!write_message(fd_, message)) {
+        error = "Failed to send the request to the daemon";
+        return std::nullopt;
+    }
+    if (!read_message(fd_, message)) {
+        error = "The daemon closed the connection";
+        return std::nullopt;
+    }
+    return ServiceResponse::decode(message, error);
+}
+}  // namespace sassas
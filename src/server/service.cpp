@@ -0,0 +1,221 @@
+#include "sassas/server/service.hpp"
+
+#include "sassas/assembler/assembler.hpp"
+#include "sassas/assembler/output_sink.hpp"
+#include "sassas/diagnostic/diagnostic.hpp"
+#include "sassas/elf/cubin_writer.hpp"
+#include "sassas/isa/functional_unit.hpp"
+#include "sassas/isa/instruction_class.hpp"
+#include "sassas/isa/isa.hpp"
+#include "sassas/server/protocol.hpp"
+#include "sassas/utils/metrics.hpp"
+
+#include "fmt/format.h"
+
+#include "annotate_snippets/renderer/human_renderer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sassas {
+auto Service::handle(ServiceRequest const &request) -> ServiceResponse {
+    ServiceResponse response;
+    // The diagnostics are rendered as the command line renders them to the standard output.
+    Reporter const report = [&response](Diag diag) {
+        std::ostringstream text;
+        ants::HumanRenderer().render_diag(text, std::move(diag), style_sheet);
+        response.console += std::move(text).str();
+    };
+
+    switch (request.command) {
+    case ServiceCommand::Assemble:
+        Metrics::add(Counter::AssembleRequests);
+        response.success = assemble(request, response, report);
+        break;
+    case ServiceCommand::Disassemble:
+        Metrics::add(Counter::DisassembleRequests);
+        response.success = disassemble(request, response, report);
+        break;
+    case ServiceCommand::Query:
+        Metrics::add(Counter::QueryRequests);
+        response.success = query(request, response, report);
+        break;
+    }
+    if (!response.success) {
+        Metrics::add(Counter::FailedRequests);
+    }
+    return response;
+}
+
+auto Service::get_isa(std::string_view arch, Reporter const &report)
+    -> std::shared_ptr<LoadedISA const>  //
+{
+    std::shared_ptr<LoadedISA const> isa = registry_.get(arch);
+    if (!isa) {
+        report(Diag(
+            DiagLevel::Error,
+            fmt::format("Failed to load the instruction description of `{}`", arch)
+        ));
+    }
+    return isa;
+}
+
+auto Service::get_assembler(std::string_view arch, Reporter const &report)
+    -> std::shared_ptr<Assembler const>  //
+{
+    std::shared_ptr<LoadedISA const> isa = get_isa(arch, report);
+    if (!isa) {
+        return nullptr;
+    }
+    // The assembler shares the ownership of its entry, which holds the ISA.
+    auto const assembler_of = [](std::shared_ptr<VersionAssembler const> const &entry) {
+        return std::shared_ptr<Assembler const>(entry, &entry->assembler);
+    };
+
+    {
+        std::scoped_lock const lock(mutex_);
+        if (auto const iter = assemblers_.find(arch);
+            iter != assemblers_.end() && iter->second->isa == isa)
+        {
+            return assembler_of(iter->second);
+        }
+    }
+
+    // If another thread creates the same assembler in the meantime, its assembler is kept. An
+    // assembler of another version is replaced, and freed once its requests are done.
+    auto created = std::make_shared<VersionAssembler const>(std::move(isa));
+
+    std::scoped_lock const lock(mutex_);
+    auto [iter, inserted] = assemblers_.try_emplace(std::string(arch), created);
+    if (!inserted && iter->second->isa != created->isa) {
+        iter->second = std::move(created);
+    }
+    return assembler_of(iter->second);
+}
+
+auto Service::assemble(
+    ServiceRequest const &request,
+    ServiceResponse &response,
+    Reporter const &report
+) -> bool {
+    std::shared_ptr<Assembler const> const assembler = get_assembler(request.arch, report);
+    if (!assembler) {
+        return false;
+    }
+    unsigned const word_bytes = assembler->isa().functional_unit.encoding_width() / 8;
+
+    std::optional<CubinWriter> cubin;
+    std::optional<OutputSink> sink;
+    std::string file;
+    if (request.output == ServiceOutput::Cubin) {
+        std::optional<unsigned> const sm_version = CubinWriter::parse_sm_version(request.arch);
+        if (!sm_version) {
+            report(Diag(
+                DiagLevel::Error,
+                fmt::format("Cannot write a cubin for architecture `{}`", request.arch)
+            ));
+            return false;
+        }
+        sink.emplace(cubin.emplace(*sm_version, word_bytes), report);
+    } else if (request.output == ServiceOutput::File) {
+        sink.emplace(
+            OutputSink::Format::Raw,
+            [&file](std::string_view bytes) { file += bytes; },
+            word_bytes,
+            report
+        );
+    } else {
+        sink.emplace(
+            OutputSink::Format::Listing,
+            [&response](std::string_view text) { response.console += text; },
+            word_bytes,
+            report
+        );
+    }
+
+    bool success = true;
+    for (ServiceInput const &input : request.inputs) {
+        success &= assembler->assemble_parallel(input.contents, input.name, input.level, *sink, 1);
+    }
+
+    if (cubin) {
+        // As on the command line, no cubin is written if there are errors.
+        if (success) {
+            Metrics::Timer const write_timer(Stage::Write);
+            std::vector<std::byte> image;
+            cubin->write(image);
+            response.file.emplace(reinterpret_cast<char const *>(image.data()), image.size());
+        }
+    } else if (request.output == ServiceOutput::File) {
+        response.file = std::move(file);
+    }
+    return success;
+}
+
+auto Service::disassemble(
+    ServiceRequest const &request,
+    ServiceResponse &response,
+    Reporter const &report
+) -> bool {
+    std::string &text = request.output == ServiceOutput::Console ? response.console
+                                                                  : response.file.emplace();
+    auto const write = [&text](std::string_view piece) {
+        text += piece;
+    };
+
+    bool success = true;
+    for (ServiceInput const &input : request.inputs) {
+        auto const image = std::as_bytes(std::span(input.contents));
+        success &= disassembler_.disassemble(input.name, image, 1, write, report);
+    }
+    return success;
+}
+
+auto Service::query(
+    ServiceRequest const &request,
+    ServiceResponse &response,
+    Reporter const &report
+) -> bool {
+    std::shared_ptr<LoadedISA const> const loaded_isa = get_isa(request.arch, report);
+    if (!loaded_isa) {
+        return false;
+    }
+    ISA const &isa = loaded_isa->isa;
+
+    auto out = std::back_inserter(response.console);
+    if (request.opcode.empty()) {
+        fmt::format_to(out, "arch: {}\n", request.arch);
+        fmt::format_to(out, "architecture: {}\n", isa.architecture.name);
+        fmt::format_to(out, "functional unit: {}\n", isa.functional_unit.name());
+        fmt::format_to(out, "encoding width: {}\n", isa.functional_unit.encoding_width());
+        fmt::format_to(out, "instruction classes: {}\n", isa.classes.size());
+        return true;
+    }
+
+    bool found = false;
+    for (InstructionClass const &instruction_class : isa.classes) {
+        std::optional<std::uint64_t> const value = instruction_class.find_opcode(request.opcode);
+        if (value) {
+            fmt::format_to(out, "{} 0x{:x}\n", instruction_class.name, *value);
+            found = true;
+        }
+    }
+    if (!found) {
+        report(Diag(
+            DiagLevel::Error,
+            fmt::format("`{}` is not an opcode of `{}`", request.opcode, request.arch)
+        ));
+    }
+    return found;
+}
+}  // namespace sassas
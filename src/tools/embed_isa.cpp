@@ -0,0 +1,88 @@
+#include "sassas/library/isa_handle.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Usage: sassas-embed-isa output.cpp [ARCH description_file]...
+///
+/// Parses the instruction description of each architecture, and writes a source file that defines
+/// `sassas::embedded_isas()` (see `sassas/isa/embedded_isa.hpp`) with their `ISAImage`s as
+/// constant arrays. It is run at build time when `SASSAS_EMBED_DESCRIPTIONS` is set.
+auto main(int argc, char **argv) -> int {
+    if (argc < 2 || argc % 2 != 0) {
+        std::fputs("Usage: sassas-embed-isa output.cpp [ARCH description_file]...\n", stderr);
+        return 1;
+    }
+
+    // The images are sorted by architecture, so that they can be looked up by binary search.
+    std::vector<std::pair<std::string_view, std::vector<std::byte>>> images;
+    for (int i = 2; i != argc; i += 2) {
+        std::string diagnostics;
+        std::optional<sassas::ISAHandle> const handle =
+            sassas::ISAHandle::load_file(argv[i + 1], diagnostics);
+        std::fputs(diagnostics.c_str(), stderr);
+        if (!handle) {
+            return 1;
+        }
+        images.emplace_back(argv[i], handle->image());
+    }
+    std::ranges::sort(images, {}, &std::pair<std::string_view, std::vector<std::byte>>::first);
+
+    std::string source = "// Generated by sassas-embed-isa. Do not edit.\n\n"
+                         "#include \"sassas/isa/embedded_isa.hpp\"\n\n"
+                         "#include <cstddef>\n"
+                         "#include <span>\n\n"
+                         "namespace sassas {\n"
+                         "namespace {\n";
+    auto out = std::back_inserter(source);
+    for (std::size_t i = 0; i != images.size(); ++i) {
+        fmt::format_to(out, "// {}\nconstexpr unsigned char IMAGE_{}[] = {{", images[i].first, i);
+        std::vector<std::byte> const &image = images[i].second;
+        for (std::size_t j = 0; j != image.size(); ++j) {
+            std::string_view const separator = j % 16 == 0 ? "\n    " : " ";
+            fmt::format_to(out, "{}0x{:02x},", separator, std::to_integer<unsigned>(image[j]));
+        }
+        source += "\n};\n";
+    }
+    source += "}  // namespace\n\n"
+              "auto embedded_isas() -> std::span<EmbeddedISA const> {\n";
+    if (images.empty()) {
+        source += "    return {};\n";
+    } else {
+        source += "    static EmbeddedISA const isas[] = {\n";
+        for (std::size_t i = 0; i != images.size(); ++i) {
+            fmt::format_to(
+                out,
+                "        {{ \"{}\", std::as_bytes(std::span(IMAGE_{})) }},\n",
+                images[i].first,
+                i
+            );
+        }
+        source += "    };\n"
+                  "    return isas;\n";
+    }
+    source += "}\n"
+              "}  // namespace sassas\n";
+
+    std::FILE *const output = std::fopen(argv[1], "w");
+    if (!output) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    bool const written = std::fwrite(source.data(), 1, source.size(), output) == source.size();
+    if (std::fclose(output) != 0 || !written) {
+        std::perror(argv[1]);
+        std::remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "sassas/utils/content_hash.hpp"
+
+#include "fmt/format.h"
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace sassas {
+void ContentHash::add_bytes(std::string_view bytes) {
+    for (char const c : bytes) {
+        auto const byte = static_cast<unsigned char>(c);
+        low_ = (low_ ^ byte) * 0x100000001b3;
+        high_ = std::rotl(high_ ^ byte, 23) * 0x9e3779b97f4a7c15;
+    }
+}
+
+void ContentHash::add(std::string_view data) {
+    add(static_cast<std::uint64_t>(data.size()));
+    add_bytes(data);
+}
+
+void ContentHash::add(std::uint64_t value) {
+    char bytes[8];
+    for (unsigned i = 0; i != 8; ++i) {
+        bytes[i] = static_cast<char>(value >> (i * 8));
+    }
+    add_bytes(std::string_view(bytes, 8));
+}
+
+auto ContentHash::hex() const -> std::string {
+    return fmt::format("{:016x}{:016x}", high_, low_);
+}
+}  // namespace sassas
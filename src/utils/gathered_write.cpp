@@ -0,0 +1,92 @@
+#include "sassas/utils/gathered_write.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#if __has_include(<sys/uio.h>)
+    #include <fcntl.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_WRITEV 1
+#else
+    #include <fstream>
+    #include <ios>
+#endif
+
+namespace sassas {
+namespace {
+#ifdef SASSAS_HAS_WRITEV
+/// Writes all of `buffers` to `fd`, passing as many buffers as possible to each `writev()` call.
+auto write_all(int fd, std::span<iovec> buffers) -> bool {
+    #ifdef IOV_MAX
+    constexpr std::size_t max_buffers = IOV_MAX;
+    #else
+    constexpr std::size_t max_buffers = 1024;
+    #endif
+
+    while (!buffers.empty()) {
+        auto const count = static_cast<int>(std::min(buffers.size(), max_buffers));
+        ssize_t written = ::writev(fd, buffers.data(), count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        // Skip the buffers that are completely written, and the written part of the next one.
+        while (!buffers.empty() && static_cast<std::size_t>(written) >= buffers.front().iov_len) {
+            written -= static_cast<ssize_t>(buffers.front().iov_len);
+            buffers = buffers.subspan(1);
+        }
+        if (written != 0) {
+            buffers.front().iov_base = static_cast<char *>(buffers.front().iov_base) + written;
+            buffers.front().iov_len -= static_cast<std::size_t>(written);
+        }
+    }
+    return true;
+}
+#endif
+}  // namespace
+
+auto write_file(char const *path, std::span<std::span<std::byte const> const> buffers) -> bool {
+#ifdef SASSAS_HAS_WRITEV
+    std::vector<iovec> vectors;
+    vectors.reserve(buffers.size());
+    for (std::span<std::byte const> const buffer : buffers) {
+        if (!buffer.empty()) {
+            // `writev()` does not modify the buffers, despite the non-const pointer.
+            vectors.push_back({ const_cast<std::byte *>(buffer.data()), buffer.size() });
+        }
+    }
+
+    int const fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool const success = write_all(fd, vectors);
+    int const error = errno;
+    if (::close(fd) != 0 && success) {
+        return false;
+    }
+    errno = error;
+    return success;
+#else
+    // Without `writev()`, the buffers are written one by one. They are still not copied.
+    std::ofstream output(path, std::ios::binary);
+    for (std::span<std::byte const> const buffer : buffers) {
+        output.write(
+            reinterpret_cast<char const *>(buffer.data()),
+            static_cast<std::streamsize>(buffer.size())
+        );
+    }
+    output.close();
+    return static_cast<bool>(output);
+#endif
+}
+}  // namespace sassas
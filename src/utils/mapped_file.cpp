@@ -0,0 +1,99 @@
+#include "sassas/utils/mapped_file.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_MMAP 1
+#else
+    #include <fstream>
+    #include <ios>
+    #include <iterator>
+#endif
+
+namespace sassas {
+auto MappedFile::open(char const *path) -> std::optional<MappedFile> {
+    MappedFile file;
+#ifdef SASSAS_HAS_MMAP
+    int const fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        int const error = errno;
+        ::close(fd);
+        errno = error;
+        return std::nullopt;
+    }
+
+    // An empty file cannot be mapped, and needs no memory anyway.
+    if (status.st_size != 0) {
+        auto const size = static_cast<std::size_t>(status.st_size);
+        void *const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int const error = errno;
+            ::close(fd);
+            errno = error;
+            return std::nullopt;
+        }
+
+        file.data_ = static_cast<std::byte const *>(data);
+        file.size_ = size;
+        file.is_mapped_ = true;
+    }
+
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+#else
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return std::nullopt;
+    }
+
+    for (std::istreambuf_iterator<char> iter(input), end; iter != end; ++iter) {
+        file.buffer_.push_back(static_cast<std::byte>(*iter));
+    }
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+#endif
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)),
+    is_mapped_(std::exchange(other.is_mapped_, false)),
+    buffer_(std::move(other.buffer_)) { }
+
+auto MappedFile::operator=(MappedFile &&other) noexcept -> MappedFile & {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        is_mapped_ = std::exchange(other.is_mapped_, false);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+void MappedFile::release() {
+#ifdef SASSAS_HAS_MMAP
+    if (is_mapped_) {
+        ::munmap(const_cast<std::byte *>(data_), size_);
+    }
+#endif
+    is_mapped_ = false;
+}
+}  // namespace sassas
@@ -0,0 +1,308 @@
+#include "sassas/utils/metrics.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// Adds `value` to a cell that only the calling thread writes. The other threads only read it, so
+/// a relaxed load and store suffice, and no read-modify-write is needed.
+template <class T>
+void bump(std::atomic<T> &cell, T value) {
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct Histogram {
+    /// The observations per bucket. They are made cumulative when rendered.
+    std::array<std::atomic<std::uint64_t>, Metrics::BUCKET_COUNT> buckets {};
+    std::atomic<std::uint64_t> count = 0;
+    std::atomic<std::uint64_t> sum_ns = 0;
+};
+
+/// The metrics recorded by one thread, or the totals of the threads that have exited. It is
+/// aligned to keep the blocks of different threads on different cache lines.
+struct alignas(64) Block {
+    std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters {};
+    std::array<std::atomic<std::int64_t>, GAUGE_COUNT> gauges {};
+    std::array<Histogram, STAGE_COUNT> histograms {};
+
+    /// Adds the metrics of `other` to this block.
+    void merge(Block const &other) {
+        for (std::size_t i = 0; i != COUNTER_COUNT; ++i) {
+            bump(counters[i], other.counters[i].load(std::memory_order_relaxed));
+        }
+        for (std::size_t i = 0; i != GAUGE_COUNT; ++i) {
+            bump(gauges[i], other.gauges[i].load(std::memory_order_relaxed));
+        }
+        for (std::size_t i = 0; i != STAGE_COUNT; ++i) {
+            Histogram &histogram = histograms[i];
+            Histogram const &other_histogram = other.histograms[i];
+            for (std::size_t j = 0; j != Metrics::BUCKET_COUNT; ++j) {
+                bump(
+                    histogram.buckets[j],
+                    other_histogram.buckets[j].load(std::memory_order_relaxed)
+                );
+            }
+            bump(histogram.count, other_histogram.count.load(std::memory_order_relaxed));
+            bump(histogram.sum_ns, other_histogram.sum_ns.load(std::memory_order_relaxed));
+        }
+    }
+};
+
+/// The blocks of the live threads, and the totals of the threads that have exited.
+struct Registry {
+    std::mutex mutex;
+    std::vector<Block const *> live;
+    Block retired;
+};
+
+auto registry() -> Registry & {
+    // It is never destroyed, since threads may still exit after `main()` returns.
+    static Registry *const registry = new Registry();
+    return *registry;
+}
+
+/// The block of the calling thread, which registers itself while the thread lives.
+class LocalBlock {
+public:
+    LocalBlock() {
+        Registry &metrics = registry();
+        std::scoped_lock const lock(metrics.mutex);
+        metrics.live.push_back(&block_);
+    }
+
+    LocalBlock(LocalBlock const &) = delete;
+    auto operator=(LocalBlock const &) -> LocalBlock & = delete;
+
+    ~LocalBlock() {
+        Registry &metrics = registry();
+        std::scoped_lock const lock(metrics.mutex);
+        metrics.retired.merge(block_);
+        std::erase(metrics.live, &block_);
+    }
+
+    auto block() -> Block & {
+        return block_;
+    }
+
+private:
+    Block block_;
+};
+
+auto local_block() -> Block & {
+    thread_local LocalBlock local;
+    return local.block();
+}
+
+/// Returns the bucket of a duration of `ns` nanoseconds, or `BUCKET_COUNT` if it exceeds them all.
+auto bucket_of(std::uint64_t ns) -> std::size_t {
+    std::uint64_t bound_ns = 1000;
+    for (std::size_t i = 0; i != Metrics::BUCKET_COUNT; ++i, bound_ns *= 4) {
+        if (ns <= bound_ns) {
+            return i;
+        }
+    }
+    return Metrics::BUCKET_COUNT;
+}
+
+constexpr std::array<std::string_view, STAGE_COUNT> STAGE_NAMES = {
+    "request",
+    "parse",
+    "match",
+    "encode",
+    "write",
+};
+}  // namespace
+
+std::atomic<bool> Metrics::enabled_ = false;
+
+void Metrics::add_local(Counter counter, std::uint64_t value) {
+    bump(local_block().counters[static_cast<std::size_t>(counter)], value);
+}
+
+void Metrics::add_local(Gauge gauge, std::int64_t delta) {
+    bump(local_block().gauges[static_cast<std::size_t>(gauge)], delta);
+}
+
+void Metrics::observe_local(Stage stage, std::chrono::nanoseconds duration) {
+    auto const ns = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+    Histogram &histogram = local_block().histograms[static_cast<std::size_t>(stage)];
+    if (std::size_t const bucket = bucket_of(ns); bucket != BUCKET_COUNT) {
+        bump(histogram.buckets[bucket], std::uint64_t(1));
+    }
+    bump(histogram.count, std::uint64_t(1));
+    bump(histogram.sum_ns, ns);
+}
+
+auto Metrics::render() -> std::string {
+    Block total;
+    {
+        Registry &metrics = registry();
+        std::scoped_lock const lock(metrics.mutex);
+        total.merge(metrics.retired);
+        for (Block const *const block : metrics.live) {
+            total.merge(*block);
+        }
+    }
+
+    auto const counter = [&total](Counter counter) {
+        return total.counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    };
+
+    std::string text;
+    auto out = std::back_inserter(text);
+    auto const header = [&](std::string_view name, std::string_view type, std::string_view help) {
+        fmt::format_to(out, "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    };
+
+    header("sassas_requests_total", "counter", "Requests served by the daemon, by command.");
+    struct RequestCounter {
+        Counter counter;
+        std::string_view command;
+    };
+    for (auto const [request_counter, command] : {
+             RequestCounter { Counter::AssembleRequests, "assemble" },
+             RequestCounter { Counter::DisassembleRequests, "disassemble" },
+             RequestCounter { Counter::QueryRequests, "query" },
+         })
+    {
+        fmt::format_to(
+            out,
+            "sassas_requests_total{{command=\"{}\"}} {}\n",
+            command,
+            counter(request_counter)
+        );
+    }
+
+    auto const simple_counter = [&](std::string_view name, std::string_view help, Counter value) {
+        header(name, "counter", help);
+        fmt::format_to(out, "{} {}\n", name, counter(value));
+    };
+    simple_counter(
+        "sassas_failed_requests_total",
+        "Requests that reported an error.",
+        Counter::FailedRequests
+    );
+    simple_counter(
+        "sassas_isa_cache_hits_total",
+        "Lookups of an ISA that was already loaded.",
+        Counter::ISACacheHits
+    );
+    simple_counter(
+        "sassas_isa_cache_misses_total",
+        "Lookups of an ISA that had to load it.",
+        Counter::ISACacheMisses
+    );
+    simple_counter(
+        "sassas_table_lookups_total",
+        "Lookups of a key in an ISA table.",
+        Counter::TableLookups
+    );
+    simple_counter(
+        "sassas_instructions_total",
+        "Instructions encoded by the assembler.",
+        Counter::Instructions
+    );
+    simple_counter(
+        "sassas_memo_hits_total",
+        "Instructions whose encoding was reused from an identical instruction.",
+        Counter::MemoHits
+    );
+    simple_counter(
+        "sassas_memo_misses_total",
+        "Instructions without labels that had to be matched and encoded.",
+        Counter::MemoMisses
+    );
+    simple_counter(
+        "sassas_isa_reloads_total",
+        "New versions of an ISA loaded after its instruction description changed.",
+        Counter::ISAReloads
+    );
+    simple_counter(
+        "sassas_reparsed_sections_total",
+        "Sections of instruction descriptions that were parsed again when they changed.",
+        Counter::ReparsedSections
+    );
+
+    header(
+        "sassas_request_bytes",
+        "gauge",
+        "Bytes of the requests and responses held by the daemon."
+    );
+    fmt::format_to(
+        out,
+        "sassas_request_bytes {}\n",
+        total.gauges[static_cast<std::size_t>(Gauge::RequestBytes)].load(std::memory_order_relaxed)
+    );
+
+    header("sassas_stage_duration_seconds", "histogram", "Time spent in each stage of the work.");
+    for (std::size_t i = 0; i != STAGE_COUNT; ++i) {
+        Histogram const &histogram = total.histograms[i];
+        std::uint64_t cumulative = 0;
+        double bound_seconds = 1e-6;
+        for (std::size_t j = 0; j != BUCKET_COUNT; ++j, bound_seconds *= 4) {
+            cumulative += histogram.buckets[j].load(std::memory_order_relaxed);
+            fmt::format_to(
+                out,
+                "sassas_stage_duration_seconds_bucket{{stage=\"{}\",le=\"{}\"}} {}\n",
+                STAGE_NAMES[i],
+                bound_seconds,
+                cumulative
+            );
+        }
+
+        std::uint64_t const count = histogram.count.load(std::memory_order_relaxed);
+        fmt::format_to(
+            out,
+            "sassas_stage_duration_seconds_bucket{{stage=\"{}\",le=\"+Inf\"}} {}\n",
+            STAGE_NAMES[i],
+            count
+        );
+        fmt::format_to(
+            out,
+            "sassas_stage_duration_seconds_sum{{stage=\"{}\"}} {}\n",
+            STAGE_NAMES[i],
+            static_cast<double>(histogram.sum_ns.load(std::memory_order_relaxed)) / 1e9
+        );
+        fmt::format_to(
+            out,
+            "sassas_stage_duration_seconds_count{{stage=\"{}\"}} {}\n",
+            STAGE_NAMES[i],
+            count
+        );
+    }
+    return text;
+}
+
+auto Metrics::write_file(char const *path) -> bool {
+    std::string const text = render();
+    std::string const temporary = fmt::format("{}.tmp", path);
+
+    std::FILE *const file = std::fopen(temporary.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    bool const written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (std::fclose(file) != 0 || !written || std::rename(temporary.c_str(), path) != 0) {
+        int const error = errno;
+        std::remove(temporary.c_str());
+        errno = error;
+        return false;
+    }
+    return true;
+}
+}  // namespace sassas
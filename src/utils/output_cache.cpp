@@ -0,0 +1,284 @@
+#include "sassas/utils/output_cache.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/file.h>) && __has_include(<unistd.h>)
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <unistd.h>
+    #define SASSAS_HAS_FLOCK 1
+#endif
+
+#if defined(SASSAS_HAS_FLOCK) && __has_include(<linux/fs.h>) && __has_include(<sys/ioctl.h>)
+    #include <linux/fs.h>
+    #include <sys/ioctl.h>
+    #ifdef FICLONE
+        #define SASSAS_HAS_FICLONE 1
+    #endif
+#endif
+
+namespace sassas {
+namespace {
+namespace fs = std::filesystem;
+
+/// The name of the file that holds the hits, the misses and the running size of the entries.
+constexpr std::string_view STATS_FILE = "stats";
+/// The suffix of the temporary files that entries are written to before they are renamed.
+constexpr std::string_view TEMPORARY_SUFFIX = ".tmp";
+
+/// Makes the file at `to` a copy of the file at `from`, sharing its blocks if the filesystem
+/// supports it.
+auto clone_file(char const *from, char const *to) -> bool {
+#ifdef SASSAS_HAS_FICLONE
+    if (int const source = ::open(from, O_RDONLY | O_CLOEXEC); source >= 0) {
+        int const target = ::open(to, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        bool const cloned = target >= 0 && ::ioctl(target, FICLONE, source) == 0;
+        if (target >= 0) {
+            ::close(target);
+        }
+        ::close(source);
+        if (cloned) {
+            return true;
+        }
+    }
+#endif
+    std::error_code error;
+    return fs::copy_file(from, to, fs::copy_options::overwrite_existing, error);
+}
+
+/// Parses the contents of the stats file, which are the hits, the misses and the size on three
+/// lines. A counter that is missing, as in the files of older versions, is left alone.
+void parse_counters(std::string_view text, OutputCache::Statistics &statistics) {
+    for (std::uint64_t *const counter :
+         { &statistics.hits, &statistics.misses, &statistics.size })
+    {
+        std::size_t const space = text.find(' ');
+        std::size_t const newline = text.find('\n');
+        if (space == std::string_view::npos || newline == std::string_view::npos || newline < space)
+        {
+            return;
+        }
+        std::from_chars(text.data() + space + 1, text.data() + newline, *counter);
+        text.remove_prefix(newline + 1);
+    }
+}
+
+/// Reads the counters in the stats file at `path`, applies `update` to them and writes them back,
+/// under a lock where the platform provides one. Returns the updated counters.
+template <class Update>
+auto update_counters(std::string const &path, Update const &update) -> OutputCache::Statistics {
+    OutputCache::Statistics statistics;
+    auto const format = [&statistics] {
+        return fmt::format(
+            "hits {}\nmisses {}\nsize {}\n",
+            statistics.hits,
+            statistics.misses,
+            statistics.size
+        );
+    };
+#ifdef SASSAS_HAS_FLOCK
+    int const fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return statistics;
+    }
+    // The lock is released when the file is closed.
+    ::flock(fd, LOCK_EX);
+
+    char buffer[128];
+    ssize_t const size = ::pread(fd, buffer, sizeof(buffer), 0);
+    if (size > 0) {
+        parse_counters(std::string_view(buffer, static_cast<std::size_t>(size)), statistics);
+    }
+    update(statistics);
+
+    std::string const text = format();
+    if (::pwrite(fd, text.data(), text.size(), 0) == static_cast<ssize_t>(text.size())) {
+        static_cast<void>(::ftruncate(fd, static_cast<off_t>(text.size())));
+    }
+    ::close(fd);
+#else
+    // Without a lock, concurrent processes may lose a few updates. That only skews the statistics,
+    // and the size is corrected by the next eviction.
+    {
+        std::ifstream input(path, std::ios::binary);
+        // clang-format off
+        std::string const text(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+        // clang-format on
+        parse_counters(text, statistics);
+    }
+    update(statistics);
+    std::ofstream(path, std::ios::binary) << format();
+#endif
+    return statistics;
+}
+}  // namespace
+
+auto OutputCache::open(std::string directory, std::uint64_t max_size)
+    -> std::optional<OutputCache>  //
+{
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error || !fs::is_directory(directory, error)) {
+        return std::nullopt;
+    }
+    return OutputCache(std::move(directory), max_size);
+}
+
+auto OutputCache::entry_path(ContentHash const &key) const -> std::string {
+    std::string const hex = key.hex();
+    return fmt::format("{}/{}/{}", directory_, hex.substr(0, 2), hex.substr(2));
+}
+
+auto OutputCache::fetch(ContentHash const &key, char const *path) -> bool {
+    std::string const entry = entry_path(key);
+    std::error_code error;
+    bool const hit = fs::is_regular_file(entry, error) && clone_file(entry.c_str(), path);
+    if (hit) {
+        // The modification time of an entry is the time it was last used.
+        fs::last_write_time(entry, fs::file_time_type::clock::now(), error);
+    }
+    count(hit);
+    return hit;
+}
+
+auto OutputCache::store(ContentHash const &key, char const *path) -> bool {
+    std::string const entry = entry_path(key);
+    std::error_code error;
+    fs::create_directories(fs::path(entry).parent_path(), error);
+
+    // A unique temporary name, so that processes storing the same entry do not interfere.
+    std::string const temporary =
+        fmt::format("{}.{:08x}{}", entry, std::random_device()(), TEMPORARY_SUFFIX);
+    if (!clone_file(path, temporary.c_str())) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    // Another process may have stored the same entry first, in which case it is replaced.
+    std::uintmax_t replaced = fs::file_size(entry, error);
+    if (error) {
+        replaced = 0;
+    }
+    fs::rename(temporary, entry, error);
+    if (error) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    std::uintmax_t const stored = fs::file_size(entry, error);
+    if (error) {
+        return true;
+    }
+
+    // The running size saves walking the whole cache on every store. It is only checked against
+    // the directory when it exceeds the maximum size, which also corrects any drift, e.g. from
+    // entries removed by hand.
+    Statistics const updated = update_counters(stats_path(), [&](Statistics &statistics) {
+        statistics.size += stored;
+        statistics.size -= std::min<std::uint64_t>(statistics.size, replaced);
+    });
+    if (updated.size > max_size_) {
+        std::uint64_t const size = evict();
+        update_counters(stats_path(), [size](Statistics &statistics) { statistics.size = size; });
+    }
+    return true;
+}
+
+auto OutputCache::stats_path() const -> std::string {
+    return fmt::format("{}/{}", directory_, STATS_FILE);
+}
+
+void OutputCache::count(bool hit) const {
+    update_counters(stats_path(), [hit](Statistics &statistics) {
+        ++(hit ? statistics.hits : statistics.misses);
+    });
+}
+
+auto OutputCache::statistics() const -> Statistics {
+    Statistics statistics;
+    {
+        std::ifstream input(stats_path(), std::ios::binary);
+        // clang-format off
+        std::string const text(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+        // clang-format on
+        parse_counters(text, statistics);
+    }
+
+    // The size is that of the entries as they are, rather than the running size.
+    statistics.size = 0;
+    std::error_code error;
+    for (fs::recursive_directory_iterator iter(directory_, error), end; !error && iter != end;
+         iter.increment(error))
+    {
+        std::string const name = iter->path().filename().string();
+        if (iter->is_regular_file(error) && iter.depth() == 1
+            && !name.ends_with(TEMPORARY_SUFFIX))
+        {
+            ++statistics.entries;
+            statistics.size += iter->file_size(error);
+        }
+    }
+    return statistics;
+}
+
+auto OutputCache::evict() const -> std::uint64_t {
+    struct Entry {
+        fs::file_time_type last_used;
+        std::uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t total_size = 0;
+
+    std::error_code error;
+    for (fs::recursive_directory_iterator iter(directory_, error), end; !error && iter != end;
+         iter.increment(error))
+    {
+        // Only the entries count; the temporary files of other processes are about to become
+        // entries, or are removed by them.
+        std::string const name = iter->path().filename().string();
+        if (!iter->is_regular_file(error) || iter.depth() != 1
+            || name.ends_with(TEMPORARY_SUFFIX))
+        {
+            continue;
+        }
+        std::uint64_t const size = iter->file_size(error);
+        entries.push_back({ iter->last_write_time(error), size, iter->path() });
+        total_size += size;
+    }
+    if (total_size <= max_size_) {
+        return total_size;
+    }
+
+    std::ranges::sort(entries, {}, &Entry::last_used);
+    for (Entry const &entry : entries) {
+        if (total_size <= max_size_) {
+            break;
+        }
+        if (fs::remove(entry.path, error)) {
+            total_size -= entry.size;
+        }
+    }
+    return total_size;
+}
+}  // namespace sassas
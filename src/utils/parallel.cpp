@@ -0,0 +1,107 @@
+#include "sassas/utils/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace sassas {
+namespace {
+/// The tasks that are still to be run by one thread. The owner takes tasks from the front, and the
+/// other threads steal from the back.
+struct WorkRange {
+    std::mutex mutex;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+};
+}  // namespace
+
+void parallel_for(
+    unsigned thread_count,
+    std::size_t task_count,
+    std::function<void(std::size_t)> const &task
+) {
+    thread_count = static_cast<unsigned>(std::min<std::size_t>(thread_count, task_count));
+    if (thread_count <= 1) {
+        for (std::size_t i = 0; i != task_count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::vector<WorkRange> ranges(thread_count);
+    for (unsigned i = 0; i != thread_count; ++i) {
+        ranges[i].begin = task_count * i / thread_count;
+        ranges[i].end = task_count * (i + 1) / thread_count;
+    }
+
+    // Steals the back half of the largest range of the other threads into the range of `self`.
+    // Returns `false` if there is nothing left to steal.
+    auto const steal = [&](unsigned self) {
+        while (true) {
+            unsigned victim = self;
+            std::size_t largest = 0;
+            for (unsigned i = 0; i != thread_count; ++i) {
+                if (i != self) {
+                    std::scoped_lock const lock(ranges[i].mutex);
+                    if (ranges[i].end - ranges[i].begin > largest) {
+                        largest = ranges[i].end - ranges[i].begin;
+                        victim = i;
+                    }
+                }
+            }
+            if (victim == self) {
+                return false;
+            }
+
+            std::size_t begin = 0, end = 0;
+            {
+                std::scoped_lock const lock(ranges[victim].mutex);
+                std::size_t const remaining = ranges[victim].end - ranges[victim].begin;
+                if (remaining == 0) {
+                    // The victim has finished its range in the meantime. Look again.
+                    continue;
+                }
+
+                end = ranges[victim].end;
+                begin = end - (remaining + 1) / 2;
+                ranges[victim].end = begin;
+            }
+
+            std::scoped_lock const lock(ranges[self].mutex);
+            ranges[self].begin = begin;
+            ranges[self].end = end;
+            return true;
+        }
+    };
+
+    auto const worker = [&](unsigned self) {
+        do {
+            while (true) {
+                std::optional<std::size_t> next;
+                {
+                    std::scoped_lock const lock(ranges[self].mutex);
+                    if (ranges[self].begin != ranges[self].end) {
+                        next = ranges[self].begin++;
+                    }
+                }
+
+                if (!next) {
+                    break;
+                }
+                task(*next);
+            }
+        } while (steal(self));
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(thread_count - 1);
+    for (unsigned i = 1; i != thread_count; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+}
+}  // namespace sassas